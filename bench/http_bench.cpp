@@ -0,0 +1,147 @@
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <httplib.h>
+
+#include "typed_scanner/http_server.hpp"
+
+namespace fs = std::filesystem;
+using clk = std::chrono::steady_clock;
+
+struct Args {
+  int port = 18080;
+  int requests = 2000;
+  int clients = 4;
+  std::size_t html_kib = 64;
+  std::size_t js_kib = 1024;  // ~ vega.min.js
+  std::size_t big_mib = 256;  // exported artifact, streamed
+  int reports = 5000;         // extra slugs for the index
+};
+
+static Args parse_args(int argc, char** argv) {
+  Args a;
+  for (int i=1;i<argc;++i){
+    std::string s(argv[i]);
+    auto eq = s.find('=');
+    auto key = s.substr(0, eq);
+    auto val = (eq==std::string::npos) ? "" : s.substr(eq+1);
+    if (key=="--port") a.port = std::stoi(val);
+    else if (key=="--requests") a.requests = std::stoi(val);
+    else if (key=="--clients") a.clients = std::stoi(val);
+    else if (key=="--html-kib") a.html_kib = std::stoull(val);
+    else if (key=="--js-kib") a.js_kib = std::stoull(val);
+    else if (key=="--big-mib") a.big_mib = std::stoull(val);
+    else if (key=="--reports") a.reports = std::stoi(val);
+    else if (key=="--help" || key=="-h") {
+      std::cout <<
+        "Usage: ts_bench_http [--port=P] [--requests=N] [--clients=C] [--html-kib=K] [--js-kib=K] [--big-mib=M] [--reports=N]\n"
+        "Serves a synthetic report and measures requests/sec for report.html and\n"
+        "vega.min.js with the file cache off, on, and with If-None-Match (304),\n"
+        "plus MiB/s for a streamed download of a big artifact and 64 KiB ranges of it,\n"
+        "and GET / and /api/reports over N report directories.\n";
+      std::exit(0);
+    }
+  }
+  return a;
+}
+
+static void write_file(const fs::path& p, std::size_t kib, char fill) {
+  std::ofstream out(p, std::ios::binary);
+  out << std::string(kib * 1024, fill);
+}
+
+// `clients` keep-alive connections issuing `requests` GETs in total.
+static double run_clients(const Args& a, const std::string& path, const httplib::Headers& hdrs,
+                          int expect_status) {
+  std::vector<std::thread> th;
+  std::vector<int> bad(a.clients, 0);
+  const auto t0 = clk::now();
+  for (int c = 0; c < a.clients; ++c) {
+    th.emplace_back([&, c]{
+      httplib::Client cli("127.0.0.1", a.port);
+      cli.set_keep_alive(true);
+      for (int i = c; i < a.requests; i += a.clients) {
+        auto r = cli.Get(path, hdrs);
+        if (!r || r->status != expect_status) ++bad[c];
+      }
+    });
+  }
+  for (auto& t : th) t.join();
+  const double sec = std::chrono::duration<double>(clk::now() - t0).count();
+  int errors = 0;
+  for (int b : bad) errors += b;
+  if (errors) std::cerr << "  (" << errors << " unexpected responses for " << path << ")\n";
+  return a.requests / sec;
+}
+
+int main(int argc, char** argv){
+  Args a = parse_args(argc, argv);
+  const fs::path root = fs::temp_directory_path() / "ts_bench_http";
+  fs::create_directories(root / "bench");
+  write_file(root / "bench" / "report.html", a.html_kib, 'h');
+  write_file(root / "bench" / "vega.min.js", a.js_kib, 'v');
+  write_file(root / "bench" / "export.bin", a.big_mib * 1024, 'x');
+  for (int i = 0; i < a.reports; ++i) {
+    const fs::path d = root / ("r" + std::to_string(i));
+    fs::create_directories(d);
+    std::ofstream(d / "report.html") << "<html></html>";
+  }
+
+  std::cout << "[http] report.html=" << a.html_kib << " KiB vega.min.js=" << a.js_kib << " KiB"
+            << " requests=" << a.requests << " clients=" << a.clients << "\n";
+
+  for (const std::size_t cache_bytes : {std::size_t(0), std::size_t(64u << 20)}) {
+    ts::HttpServer::Config cfg;
+    cfg.artifact_root = root.string();
+    cfg.port = a.port;
+    cfg.cache_bytes = cache_bytes;
+    ts::HttpServer server(cfg);
+    std::thread srv([&]{ (void)server.run(); });
+    {
+      httplib::Client probe("127.0.0.1", a.port);
+      for (int i = 0; i < 200 && !probe.Get("/"); ++i) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    std::string etag;
+    {
+      httplib::Client cli("127.0.0.1", a.port);
+      if (auto r = cli.Get("/reports/bench/vega.min.js")) etag = r->get_header_value("ETag");
+    }
+    const double html = run_clients(a, "/reports/bench/report.html", {}, 200);
+    const double js = run_clients(a, "/reports/bench/vega.min.js", {}, 200);
+    const double revalidate = run_clients(a, "/reports/bench/vega.min.js", {{"If-None-Match", etag}}, 304);
+    std::cout << "  cache=" << (cache_bytes ? "on " : "off")
+              << "  report.html: " << html << " req/s"
+              << "  vega.min.js: " << js << " req/s"
+              << "  304: " << revalidate << " req/s\n";
+
+    // Streamed: whole file (read in a fixed buffer, RSS stays flat) and slices.
+    {
+      httplib::Client cli("127.0.0.1", a.port);
+      std::size_t got = 0;
+      const auto t0 = clk::now();
+      auto r = cli.Get("/reports/bench/export.bin", [&](const char*, std::size_t n){ got += n; return true; });
+      const double sec = std::chrono::duration<double>(clk::now() - t0).count();
+      if (!r || r->status != 200 || got != a.big_mib << 20) std::cerr << "  (export.bin download failed)\n";
+      std::cout << "           export.bin: " << (got / 1048576.0) / sec << " MiB/s";
+    }
+    const double ranges = run_clients(a, "/reports/bench/export.bin", {{"Range", "bytes=65536-131071"}}, 206);
+    std::cout << "  Range 64 KiB: " << ranges << " req/s\n";
+
+    const double index = run_clients(a, "/?page=3", {}, 200);
+    const double api = run_clients(a, "/api/reports?sort=time&order=desc&limit=100", {}, 200);
+    std::cout << "           index (" << a.reports + 1 << " reports): " << index << " req/s"
+              << "  /api/reports: " << api << " req/s\n";
+
+    server.stop();
+    srv.join();
+  }
+  fs::remove_all(root);
+  return 0;
+}
@@ -0,0 +1,102 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "typed_scanner/mustache_renderer.hpp"
+
+using clk = std::chrono::steady_clock;
+
+struct Args {
+  std::size_t reports = 2000;
+  std::vector<unsigned> threads{1, 4};
+  std::size_t ctx_kib = 32;  // run.json embedded per report
+  std::string template_dir =
+#ifdef TS_DEFAULT_TEMPLATE_DIR
+      TS_DEFAULT_TEMPLATE_DIR;
+#else
+      "templates";
+#endif
+};
+
+static Args parse_args(int argc, char** argv) {
+  Args a;
+  for (int i=1;i<argc;++i){
+    std::string s(argv[i]);
+    auto eq = s.find('=');
+    auto key = s.substr(0, eq);
+    auto val = (eq==std::string::npos) ? "" : s.substr(eq+1);
+    if (key=="--reports") a.reports = std::stoull(val);
+    else if (key=="--ctx-kib") a.ctx_kib = std::stoull(val);
+    else if (key=="--templates") a.template_dir = val;
+    else if (key=="--threads") {
+      a.threads.clear();
+      for (std::size_t pos = 0; pos <= val.size();) {
+        const auto comma = val.find(',', pos);
+        a.threads.push_back(static_cast<unsigned>(std::stoul(val.substr(pos, comma - pos))));
+        if (comma == std::string::npos) break;
+        pos = comma + 1;
+      }
+    }
+    else if (key=="--help" || key=="-h") {
+      std::cout <<
+        "Usage: ts_bench_render [--reports=N] [--threads=1,4] [--ctx-kib=K] [--templates=DIR]\n"
+        "Renders report.mustache N times into memory and prints reports/sec with the\n"
+        "template cache off (read + inline partials + parse per report) and on.\n";
+      std::exit(0);
+    }
+  }
+  return a;
+}
+
+static std::string make_ctx(std::size_t kib) {
+  std::string ctx = "{\"file\":\"bench.csv\",\"rows\":1000,\"columns\":[";
+  for (int c = 0; ctx.size() < kib * 1024; ++c) {
+    if (c) ctx += ',';
+    ctx += "{\"name\":\"col" + std::to_string(c) + "\",\"kind\":\"float\",\"nulls\":0,\"min\":0.5,\"max\":99.5}";
+  }
+  ctx += "]}";
+  return ctx;
+}
+
+// `threads` workers, one renderer each, rendering `reports` in total.
+static double run(const Args& a, unsigned threads, bool cache, const std::string& ctx) {
+  std::vector<std::thread> th;
+  std::vector<int> bad(threads, 0);
+  const auto t0 = clk::now();
+  for (unsigned t = 0; t < threads; ++t) {
+    th.emplace_back([&, t]{
+      ts::MustacheRenderer::Config cfg;
+      cfg.template_dir = a.template_dir;
+      cfg.partials_dir = a.template_dir + "/partials";
+      cfg.cache_templates = cache;
+      ts::MustacheRenderer r(cfg);
+      std::string out;
+      for (std::size_t i = t; i < a.reports; i += threads) {
+        if (!r.render_to_string("report.mustache", ctx, out) || out.empty()) ++bad[t];
+      }
+    });
+  }
+  for (auto& t : th) t.join();
+  const double sec = std::chrono::duration<double>(clk::now() - t0).count();
+  int errors = 0;
+  for (int b : bad) errors += b;
+  if (errors) std::cerr << "  (" << errors << " failed renders)\n";
+  return a.reports / sec;
+}
+
+int main(int argc, char** argv){
+  const Args a = parse_args(argc, argv);
+  const std::string ctx = make_ctx(a.ctx_kib);
+  std::cout << "[render] template_dir=" << a.template_dir << " reports=" << a.reports
+            << " ctx=" << ctx.size() / 1024 << " KiB\n";
+  for (const unsigned t : a.threads) {
+    const double cold = run(a, t, false, ctx);
+    const double warm = run(a, t, true, ctx);
+    std::cout << "  threads=" << t << "  cache=off: " << cold << " reports/s"
+              << "  cache=on: " << warm << " reports/s  (x" << warm / cold << ")\n";
+  }
+  return 0;
+}
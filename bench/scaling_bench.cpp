@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "typed_scanner/path_utils.hpp"
+#include "typed_scanner/scan_job.hpp"
+#include "typed_scanner/task_pool.hpp"
+
+namespace fs = std::filesystem;
+using clk = std::chrono::steady_clock;
+
+static std::string make_synth_csv(const std::string& name, std::size_t rows, std::size_t cols) {
+  fs::path p = fs::temp_directory_path() / name;
+  std::ofstream out(p, std::ios::binary);
+  for (size_t c = 0; c < cols; ++c) { out << "col" << c; if (c+1<cols) out << ","; }
+  out << "\n";
+  for (size_t r = 0; r < rows; ++r) {
+    for (size_t c = 0; c < cols; ++c) {
+      out << (r%10) << "." << (c*37%1000);
+      if (c+1<cols) out << ",";
+    }
+    out << "\n";
+  }
+  out.flush();
+  return p.string();
+}
+
+struct Args {
+  std::string csv_path;            // if empty -> synth
+  std::size_t rows = 2'000'000;    // big synth file
+  std::size_t cols = 8;
+  std::size_t files = 64;          // small-file batch
+  std::size_t file_rows = 20'000;
+  std::vector<unsigned> threads{1, 2, 4, 8, 16};
+  int iters = 3;
+  bool pin = false;
+};
+
+static Args parse_args(int argc, char** argv) {
+  Args a;
+  for (int i=1;i<argc;++i){
+    std::string s(argv[i]);
+    auto eq = s.find('=');
+    auto key = s.substr(0, eq);
+    auto val = (eq==std::string::npos) ? "" : s.substr(eq+1);
+    if (key=="--csv") a.csv_path = val;
+    else if (key=="--rows") a.rows = std::stoull(val);
+    else if (key=="--cols") a.cols = std::stoull(val);
+    else if (key=="--files") a.files = std::stoull(val);
+    else if (key=="--file-rows") a.file_rows = std::stoull(val);
+    else if (key=="--iters") a.iters = std::stoi(val);
+    else if (key=="--pin") a.pin = true;
+    else if (key=="--threads") {
+      a.threads.clear();
+      std::stringstream ss(val);
+      for (std::string t; std::getline(ss, t, ',');) a.threads.push_back(static_cast<unsigned>(std::stoul(t)));
+    }
+    else if (key=="--help" || key=="-h") {
+      std::cout <<
+        "Usage: ts_bench_scaling [--csv=path] [--rows=N] [--cols=M] [--files=F] [--file-rows=R]\n"
+        "                        [--threads=1,2,4,8,16] [--iters=K] [--pin]\n"
+        "Measures one large file split into byte ranges, and a batch of small files,\n"
+        "on a TaskPool of each size. Reports best-of-K MiB/s and speedup vs the first size.\n";
+      std::exit(0);
+    }
+  }
+  return a;
+}
+
+int main(int argc, char** argv){
+  Args a = parse_args(argc, argv);
+
+  std::string big = a.csv_path;
+  if (big.empty() || !fs::exists(big)) big = make_synth_csv("ts_bench_scaling_big.csv", a.rows, a.cols);
+  std::vector<std::string> small;
+  for (std::size_t i = 0; i < a.files; ++i) {
+    small.push_back(make_synth_csv("ts_bench_scaling_" + std::to_string(i) + ".csv", a.file_rows, a.cols));
+  }
+  std::uint64_t small_bytes = 0;
+  for (auto& f : small) small_bytes += fs::file_size(f);
+
+  std::cout << "[scaling] big=" << big << " (" << fs::file_size(big) / (1024*1024) << " MiB)"
+            << " small=" << small.size() << " files (" << small_bytes / (1024*1024) << " MiB)"
+            << " hw_threads=" << std::thread::hardware_concurrency() << "\n";
+
+  double base_big = 0.0, base_small = 0.0;
+  for (unsigned n : a.threads) {
+    ts::TaskPool::Config pcfg;
+    pcfg.threads = n;
+    pcfg.pin_threads = a.pin;
+    ts::TaskPool pool(pcfg);
+
+    ts::TokenizeOptions opts;
+    opts.pool = &pool;
+    opts.min_range_bytes = 1 << 20;
+
+    double best_big = 0.0, best_small = 0.0;
+    std::uint64_t rows = 0;
+    unsigned ranges = 0;
+    for (int k = 0; k < a.iters; ++k) {
+      // (1) one file, newline-aligned ranges
+      auto t0 = clk::now();
+      const ts::TokenizeStats st = ts::tokenize_file(big, ts::FileFormat::CSV, opts);
+      double sec = std::chrono::duration<double>(clk::now() - t0).count();
+      rows = st.rows;
+      ranges = st.ranges;
+      best_big = std::max(best_big, (st.bytes / (1024.0*1024.0)) / sec);
+
+      // (2) many files, one task each
+      ts::TokenizeOptions one = opts;
+      one.pool = nullptr;
+      t0 = clk::now();
+      ts::parallel_for(pool, small.size(), [&](std::size_t i){
+        (void)ts::tokenize_file(small[i], ts::FileFormat::CSV, one);
+      });
+      sec = std::chrono::duration<double>(clk::now() - t0).count();
+      best_small = std::max(best_small, (small_bytes / (1024.0*1024.0)) / sec);
+    }
+    if (base_big == 0.0) { base_big = best_big; base_small = best_small; }
+
+    std::cout << "  threads=" << n
+              << "  big: " << best_big << " MiB/s (x" << best_big / base_big
+              << ", ranges=" << ranges << ", rows=" << rows << ")"
+              << "  small: " << best_small << " MiB/s (x" << best_small / base_small << ")\n";
+  }
+  return 0;
+}
@@ -13,6 +13,7 @@
 #include "typed_scanner/token_csv_fsm.hpp"
 #include "typed_scanner/record_view.hpp"
 #include "typed_scanner/arena.hpp"
+#include "typed_scanner/sys_counters.hpp"
 
 #if defined(TS_ENABLE_JSONL) && TS_ENABLE_JSONL
   #include "typed_scanner/token_jsonl_simdjson.hpp"
@@ -63,6 +64,7 @@ struct Args {
   std::size_t rows = 200'000;  // for synth
   std::size_t cols = 8;        // for synth
   int iters = 3;
+  bool perf = true;            // print cycles/byte when perf_event_open is allowed
 };
 
 static Args parse_args(int argc, char** argv) {
@@ -77,9 +79,10 @@ static Args parse_args(int argc, char** argv) {
     else if (key=="--rows") a.rows = std::stoull(val);
     else if (key=="--cols") a.cols = std::stoull(val);
     else if (key=="--iters") a.iters = std::stoi(val);
+    else if (key=="--no-perf") a.perf = false;
     else if (key=="--help" || key=="-h") {
       std::cout <<
-        "Usage: ts_bench_tokenizer [--csv=path] [--jsonl=path] [--rows=N] [--cols=M] [--iters=K]\n"
+        "Usage: ts_bench_tokenizer [--csv=path] [--jsonl=path] [--rows=N] [--cols=M] [--iters=K] [--no-perf]\n"
         "If paths are omitted, synthetic CSV/JSONL are generated.\n";
       std::exit(0);
     }
@@ -87,6 +90,24 @@ static Args parse_args(int argc, char** argv) {
   return a;
 }
 
+// Hardware counters around each iteration (disabled via --no-perf or when
+// the kernel refuses perf_event_open).
+static bool g_perf = true;
+
+static ts::PerfSample perf_now() {
+  if (!g_perf) return {};
+  return ts::PerfCounterGroup::this_thread().read();
+}
+
+static std::string perf_suffix(const ts::PerfSample& d, std::uint64_t bytes) {
+  if (!d.valid || bytes == 0) return {};
+  char buf[128];
+  std::snprintf(buf, sizeof(buf), "  cycles/byte=%.3f  IPC=%.2f  br_miss/KB=%.2f",
+                double(d.cycles) / double(bytes), d.ipc(),
+                double(d.branch_misses) * 1024.0 / double(bytes));
+  return buf;
+}
+
 static void bench_csv(const std::string& path, int iters) {
   std::cout << "\n[CSV] file=" << path << " iters=" << iters << "\n";
   for (int k=1;k<=iters;++k) {
@@ -96,6 +117,7 @@ static void bench_csv(const std::string& path, int iters) {
     ts::ChunkReader rd(path, {});
     std::uint64_t nrec=0;
 
+    const auto c0 = perf_now();
     auto t0 = clk::now();
     rd.for_each_line([&](std::string_view s){
       (void)csv.feed(s, [&](const ts::RecordView&){ ++nrec; if((nrec%20000)==0) rows.reset();});
@@ -103,6 +125,7 @@ static void bench_csv(const std::string& path, int iters) {
     });
     csv.finish([&](const ts::RecordView&){ ++nrec; });
     auto t1 = clk::now();
+    const auto dc = perf_now() - c0;
 
     const double sec = std::chrono::duration<double>(t1-t0).count();
     const double mib = rd.bytes_read() / (1024.0*1024.0);
@@ -111,7 +134,8 @@ static void bench_csv(const std::string& path, int iters) {
               << " bytes=" << rd.bytes_read()
               << " time=" << sec << "s"
               << "  throughput=" << (mib/sec) << " MiB/s"
-              << "  rows/s=" << (nrec/sec) << "\n";
+              << "  rows/s=" << (nrec/sec)
+              << perf_suffix(dc, rd.bytes_read()) << "\n";
   }
 }
 
@@ -125,12 +149,14 @@ static void bench_jsonl(const std::string& path, int iters) {
     ts::ChunkReader rd(path, {});
     std::uint64_t nrec=0;
 
+    const auto c0 = perf_now();
     auto t0 = clk::now();
     rd.for_each_line([&](std::string_view s){
       (void)tok.feed_line(s, [&](const ts::RecordView&){ ++nrec; if((nrec%40000)==0) rows.reset();});
       return true;
     });
     auto t1 = clk::now();
+    const auto dc = perf_now() - c0;
 
     const double sec = std::chrono::duration<double>(t1-t0).count();
     const double mib = rd.bytes_read() / (1024.0*1024.0);
@@ -139,13 +165,19 @@ static void bench_jsonl(const std::string& path, int iters) {
               << " bytes=" << rd.bytes_read()
               << " time=" << sec << "s"
               << "  throughput=" << (mib/sec) << " MiB/s"
-              << "  rows/s=" << (nrec/sec) << "\n";
+              << "  rows/s=" << (nrec/sec)
+              << perf_suffix(dc, rd.bytes_read()) << "\n";
   }
 }
 #endif
 
 int main(int argc, char** argv){
   Args a = parse_args(argc, argv);
+  g_perf = a.perf;
+  if (g_perf && !ts::PerfCounterGroup::this_thread().available()) {
+    std::cout << "[perf] " << ts::PerfCounterGroup::this_thread().error() << " (cycles/byte skipped)\n";
+    g_perf = false;
+  }
 
   std::string csv = a.csv_path;
   if (csv.empty() || !fs::exists(csv)) csv = make_synth_csv(a.rows, a.cols);
@@ -3,6 +3,7 @@ set -euo pipefail
 SCANNER_BIN="${SCANNER_BIN:-/opt/typed-scanner/bin/typed-scanner}"
 PORT="${PORT:-8080}"
 SCAN_INTERVAL="${SCAN_INTERVAL:-15}"
+SCAN_MODE="${SCAN_MODE:-poll}"   # poll (mirror+scan every SCAN_INTERVAL) | watch (inotify, --watch)
 
 # Resolve artifact root (one place of truth)
 if [[ -n "${ART_ROOT:-}" ]]; then
@@ -22,7 +23,7 @@ ARTIFACTS_BUCKET="${ARTIFACTS_BUCKET:-artifacts-typed-scanners}"
 
 echo "[entrypoint] SCANNER_BIN=${SCANNER_BIN}"
 echo "[entrypoint] ART_ROOT=${ART_ROOT}"
-echo "[entrypoint] PORT=${PORT}"
+echo "[entrypoint] PORT=${PORT}  SCAN_MODE=${SCAN_MODE}"
 echo "[entrypoint] SLUG_MODE=${SLUG_MODE}  SLUG_LEN=${SLUG_LEN}"
 echo "[entrypoint] PUSH_TO_MINIO=${PUSH_TO_MINIO}  ARTIFACTS_BUCKET=${ARTIFACTS_BUCKET}"
 
@@ -42,21 +43,6 @@ ensure_writable_art_root() {
 }
 ensure_writable_art_root
 
-copy_assets() {
-  local dst="$1"
-  [[ -d "$dst" ]] || { echo "[assets] skip (no dir): $dst"; return 0; }
-  for a in /work/web/css/report.css \
-           /work/web/js/vega.min.js \
-           /work/web/js/vega-lite.min.js \
-           /work/web/js/vega-embed.min.js; do
-    if [[ -s "$a" ]]; then
-      cp -f "$a" "$dst/" 2>/dev/null || echo "[assets] WARN cp failed: $a -> $dst"
-    else
-      echo "[assets] missing or empty: $a"
-    fi
-  done
-}
-
 write_root_redirect_to() {
   local dst="$1"
   local rel="${dst#$ART_ROOT}"; [[ -z "$rel" ]] && rel="/"
@@ -83,6 +69,27 @@ RUN_THESE=(
   ts_test_parse_policy
   ts_test_record_view
   ts_test_run_json
+  ts_test_histogram
+  ts_test_metrics_registry
+  ts_test_scan_scheduler
+  ts_test_task_pool
+  ts_test_config
+  ts_test_pipeline
+  ts_test_etag_state
+  ts_test_resume
+  ts_test_dir_watcher
+  ts_test_decompress
+  ts_test_stream_input
+  ts_test_sniff
+  ts_test_file_cache
+  ts_test_precompress
+  ts_test_report_index
+  ts_test_asset_store
+  ts_test_template_cache
+  ts_test_json_writer
+  ts_test_live_scan
+  ts_test_scan_jobs
+  ts_test_trace
 )
 
 # Auto-discover any integration tests that were installed (ts_it_*)
@@ -133,20 +140,34 @@ else
 fi
 
 # -------- start HTTP server --------
+HAVE_MINIO=false
+if [[ -n "${MINIO_ENDPOINT:-}" && -n "${MINIO_BUCKET:-}" && -n "${MINIO_ROOT_USER:-}" && -n "${MINIO_ROOT_PASSWORD:-}" ]]; then
+  HAVE_MINIO=true
+fi
+INCOMING_DIR="/work/incoming"
+
 read -r -a ARGS <<< "${SCANNER_ARGS:-}"
 has_root=false; for a in "${ARGS[@]:-}"; do [[ "$a" == --artifact-root=* ]] && has_root=true; done
 has_port=false; for a in "${ARGS[@]:-}"; do [[ "$a" == --port=* ]] && has_port=true; done
 $has_root || ARGS+=(--artifact-root="${ART_ROOT}")
 $has_port || ARGS+=(--port="${PORT}")
+if [[ "$SCAN_MODE" == "watch" && "$HAVE_MINIO" == "true" ]]; then
+  # The server scans files under INCOMING_DIR itself as they land.
+  mkdir -p "${INCOMING_DIR}"
+  ARGS+=(--config=/work/configs/config.toml
+         --slug-mode="${SLUG_MODE}" --slug-len="${SLUG_LEN}"
+         --max-parallel="${MAX_PARALLEL:-2}"
+         --max-inflight-bytes="${MAX_INFLIGHT_BYTES:-1073741824}"
+         --watch="${INCOMING_DIR}")
+fi
 
 echo "[entrypoint] starting server: ${SCANNER_BIN} ${ARGS[*]}"
 "${SCANNER_BIN}" "${ARGS[@]}" &
 SERVER_PID=$!
 
 # -------- MinIO mirror + scan loop --------
-if [[ -n "${MINIO_ENDPOINT:-}" && -n "${MINIO_BUCKET:-}" && -n "${MINIO_ROOT_USER:-}" && -n "${MINIO_ROOT_PASSWORD:-}" ]]; then
+if [[ "$HAVE_MINIO" == "true" ]]; then
   echo "[entrypoint] MinIO mirror+scan -> ${MINIO_ENDPOINT}/${MINIO_BUCKET}"
-  INCOMING_DIR="/work/incoming"
   mkdir -p "${INCOMING_DIR}"
 
   for i in {1..20}; do
@@ -160,46 +181,61 @@ if [[ -n "${MINIO_ENDPOINT:-}" && -n "${MINIO_BUCKET:-}" && -n "${MINIO_ROOT_USE
     mc mb --ignore-existing "local/${ARTIFACTS_BUCKET}" >/dev/null 2>&1 || true
   fi
 
+  if [[ "$SCAN_MODE" == "watch" ]]; then
+    # Bucket changes stream into INCOMING_DIR; the server's --watch does the rest.
+    ( mc mirror --watch --overwrite --remove "local/${MINIO_BUCKET}" "${INCOMING_DIR}" || true ) &
+    if [[ "$PUSH_TO_MINIO" == "true" ]]; then
+      ( while true; do sleep "${SCAN_INTERVAL}"; push_dir_to_minio; done ) &
+    fi
+  else
   (
     while true; do
       echo "[mirror] syncing bucket -> ${INCOMING_DIR} ..."
       mc mirror --overwrite --remove "local/${MINIO_BUCKET}" "${INCOMING_DIR}" || true
 
       mapfile -d '' files < <(find "${INCOMING_DIR}" -type f \
-        \( -iname '*.csv' -o -iname '*.jsonl' -o -iname '*.ndjson' \) -print0)
+        \( -iname '*.csv' -o -iname '*.jsonl' -o -iname '*.ndjson' \
+           -o -iname '*.csv.gz' -o -iname '*.jsonl.gz' -o -iname '*.ndjson.gz' \
+           -o -iname '*.csv.zst' -o -iname '*.jsonl.zst' -o -iname '*.ndjson.zst' \) -print0)
       echo "[scan] found ${#files[@]} candidate file(s)"
 
-      for ((i=0; i<${#files[@]}; ++i)); do
-        f="${files[$i]}"
-        echo "[scan] ($((i+1))/${#files[@]}) $f"
+      if (( ${#files[@]} > 0 )); then
+        # One process for the whole batch: the scanner schedules files itself
+        # (largest first, bounded by MAX_PARALLEL / MAX_INFLIGHT_BYTES).
+        scan_args=()
+        for f in "${files[@]}"; do scan_args+=(--scan "$f"); done
         mark="${ART_ROOT}/.start.$(date +%s%N)"
         : > "$mark" || true
 
-        if "${SCANNER_BIN}" \
+        if ! "${SCANNER_BIN}" \
               --config=/work/configs/config.toml \
               --artifact-root="${ART_ROOT}" \
               --slug-mode="${SLUG_MODE}" \
               --slug-len="${SLUG_LEN}" \
-              --scan "$f"; then
-          new_report="$(find "${ART_ROOT}" -type f -name 'report.html' -newer "$mark" -print | sort | tail -n1 || true)"
-          rm -f "$mark" || true
-          if [[ -n "$new_report" && -f "$new_report" ]]; then
-            outdir="$(dirname "$new_report")"
-            echo "[post] artifact: ${outdir}"
-            copy_assets "${outdir}"
-            write_root_redirect_to "${outdir}"
-          else
-            echo "[post] WARN: no new report found after scanning $f"
-          fi
+              --max-parallel="${MAX_PARALLEL:-2}" \
+              --max-inflight-bytes="${MAX_INFLIGHT_BYTES:-1073741824}" \
+              "${scan_args[@]}"; then
+          echo "[scan] ERROR: scanner exited non-zero"
+        fi
+
+        mapfile -t new_reports < <(find "${ART_ROOT}" -type f -name 'report.html' -newer "$mark" -print | sort)
+        rm -f "$mark" || true
+        # CSS/JS are linked from the shared ${ART_ROOT}/.static/<hash>/ store.
+        for new_report in "${new_reports[@]}"; do
+          echo "[post] artifact: $(dirname "$new_report")"
+        done
+        if (( ${#new_reports[@]} > 0 )); then
+          write_root_redirect_to "$(dirname "${new_reports[-1]}")"
         else
-          echo "[scan] ERROR scanning $f"
+          echo "[post] WARN: no new reports after scanning ${#files[@]} file(s)"
         fi
-      done
+      fi
 
       push_dir_to_minio
       sleep "${SCAN_INTERVAL}"
     done
   ) &
+  fi
 else
   echo "[entrypoint] MinIO variables not set; skipping mirror+scan loop."
 fi
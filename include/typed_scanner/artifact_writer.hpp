@@ -1,16 +1,43 @@
 #pragma once
+#include "typed_scanner/precompress.hpp"
+#include <functional>
+#include <iterator>
 #include <string>
+#include <vector>
 
 namespace ts {
 
+struct ReportDirOptions {
+  // [render] precompress: <file>.br/.zst/.gz next to report.html, run.json
+  // and the shared static assets, for HttpServer to send as-is.
+  std::vector<Encoding> precompress = {std::begin(kAllEncodings), std::end(kAllEncodings)};
+  // Streams run.json into the open fd instead of writing run_json_str,
+  // which then only feeds the template (e.g. with a thinned series).
+  std::function<bool(int fd, std::string* err_out)> write_run_json;
+};
+
 // Build run.json (outside) and hand it to this helper.
 // It writes:
 //   artifacts/typed-scanner/<slug>/report.html
-//   + co-located CSS/JS (vega, vega-lite, vega-embed)
 //   + run.json (for debugging/inspection)
+// and makes sure the CSS/JS (vega, vega-lite, vega-embed) are in the shared
+// store, artifacts/typed-scanner/.static/<hash>/ (see asset_store.hpp).
+bool write_report_dir(const std::string& artifact_root,
+                      const std::string& slug,
+                      const std::string& run_json_str,
+                      std::string* err_out = nullptr);
 bool write_report_dir(const std::string& artifact_root,
                       const std::string& slug,
                       const std::string& run_json_str,
+                      const ReportDirOptions& opts,
                       std::string* err_out = nullptr);
 
+// report.mustache rendered with `ctx_json` into a string, linking the shared
+// static store (used for the live page of an in-flight scan). False when
+// the store or the template is unavailable.
+bool render_report_html(const std::string& artifact_root,
+                        const std::string& ctx_json,
+                        std::string& html_out,
+                        std::string* err_out = nullptr);
+
 } 
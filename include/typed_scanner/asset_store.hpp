@@ -0,0 +1,32 @@
+#pragma once
+#include "typed_scanner/precompress.hpp"
+#include <string>
+#include <vector>
+
+namespace ts {
+
+// Shared, content-addressed home for the report CSS/JS:
+//   <artifact_root>/.static/<hash>/<name>   served as   /static/<hash>/<name>
+// <hash> is the first 16 hex digits of the file's XXH3, so a URL never
+// changes meaning and HttpServer can mark it immutable. Every report links
+// the same copy instead of carrying its own.
+inline constexpr const char* kStaticDirName = ".static";
+
+struct StaticAsset {
+  std::string name; // e.g. "vega.min.js"
+  std::string hash; // 16 hex digits
+  std::string url;  // "/static/<hash>/<name>"
+};
+
+// Make sure each source is in the store (written once, atomically, then
+// precompressed with `encs`) and return its URL. Sources are looked up as
+// given, then under TS_DEFAULT_STATIC_DIR. Hashes are memoized per process
+// by (path, size, mtime), so repeat calls only stat. A missing source is
+// skipped and named in err_out; false only if the store cannot be written.
+bool publish_assets(const std::string& artifact_root,
+                    const std::vector<std::string>& sources,
+                    const std::vector<Encoding>& encs,
+                    std::vector<StaticAsset>& out,
+                    std::string* err_out = nullptr);
+
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ts {
+
+class TaskPool;
+
+enum class Compression { None, Gzip, Zstd };
+
+const char* compression_name(Compression c); // none|gzip|zstd
+
+// Magic bytes first (1f 8b = gzip, 28 b5 2f fd = zstd), then the extension
+// (.gz/.gzip, .zst/.zstd). None if the file cannot be read. Only regular
+// files are peeked at; a pipe goes by its name.
+Compression detect_compression(const std::string& path);
+Compression compression_from_magic(std::string_view head);
+
+// Whether this build links the decoder (TS_HAVE_ZLIB / TS_HAVE_ZSTD).
+bool compression_supported(Compression c);
+
+// Sequential byte stream that ChunkReader reads its blocks from.
+class ByteSource {
+public:
+  virtual ~ByteSource() = default;
+  // Up to n bytes; 0 at the end of the stream or on error (see error()).
+  virtual std::size_t read(char* dst, std::size_t n) = 0;
+  // Bytes consumed from the underlying file so far (compressed size).
+  virtual std::uint64_t raw_bytes() const = 0;
+  // Nanoseconds spent decoding (0 for plain files).
+  virtual std::uint64_t decode_ns() const { return 0; }
+  const std::string& error() const { return err_; }
+
+protected:
+  std::string err_;
+};
+
+// Reader over `f` (owned, closed by the source) for the given codec, or
+// null with err_out when the codec is not compiled in. `head` holds bytes
+// already read from a stream that cannot seek back (the sniffed magic);
+// they are replayed first.
+std::unique_ptr<ByteSource> open_byte_source(FILE* f, Compression c, std::string* err_out = nullptr,
+                                             std::string head = {});
+
+// An independently decodable piece of a compressed file: a BGZF block or
+// a zstd frame whose header carries its decoded size.
+struct CompressedFrame {
+  std::uint64_t raw_offset = 0; // in the file
+  std::uint64_t raw_size = 0;
+  std::uint64_t out_offset = 0; // in the decoded stream
+  std::uint64_t out_size = 0;
+};
+
+// Frame table of a BGZF (gzip members with a "BC" extra field) or zstd
+// file, read from the frame headers without decoding. False without an
+// error when the file is not framed that way (plain gzip, a zstd frame of
+// unknown size): such files can only be decoded front to back.
+bool index_frames(const std::string& path, Compression c, std::vector<CompressedFrame>& out,
+                  std::string* err_out = nullptr);
+
+// Run `inner` as tasks on `pool` (null = TaskPool::global()), `depth`
+// blocks of `block_bytes` ahead of the reader, so decoding block N+1
+// overlaps with tokenizing block N.
+std::unique_ptr<ByteSource> make_prefetch_source(std::unique_ptr<ByteSource> inner,
+                                                 std::size_t block_bytes, std::size_t depth = 4,
+                                                 TaskPool* pool = nullptr);
+
+}
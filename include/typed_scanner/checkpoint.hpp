@@ -0,0 +1,50 @@
+#pragma once
+#include "typed_scanner/pipeline.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ts {
+
+// What a finished scan leaves behind so the next scan of a file that only
+// grew can tokenize just the appended bytes and merge them into these
+// totals. Lives in <artifact_root>/<slug>/checkpoint.txt.
+struct ScanCheckpoint {
+  std::string format;            // csv|jsonl
+  std::string settings;          // hash of the options that shape the results
+  std::uint64_t offset = 0;      // end of the last complete line scanned
+  std::uint64_t rows = 0;
+  std::uint64_t head_hash = 0;   // XXH3 of the first block of [0, offset)
+  std::uint64_t tail_hash = 0;   // XXH3 of the last block of [0, offset)
+  std::vector<FieldKind> kinds;  // partial schema from policy_parse
+  std::vector<ColumnStats> columns;
+  std::unordered_map<std::string, std::uint64_t> errors_by_field;
+};
+
+inline constexpr std::size_t kCheckpointBlock = 64 * 1024;
+
+// A missing file is an error here; callers treat it as "scan everything".
+bool load_checkpoint(const std::string& path, ScanCheckpoint& out, std::string* err_out = nullptr);
+// Written to a temp file and renamed into place.
+bool save_checkpoint(const std::string& path, const ScanCheckpoint& cp, std::string* err_out = nullptr);
+
+// Head/tail block hashes of the prefix [0, offset) of `path`.
+bool checkpoint_hashes(const std::string& path, std::uint64_t offset,
+                       std::uint64_t& head, std::uint64_t& tail, std::string* err_out = nullptr);
+
+// True when `path` is at least cp.offset bytes long and both blocks still
+// hash the same, i.e. the file was (at most) appended to.
+bool checkpoint_matches(const ScanCheckpoint& cp, const std::string& path);
+
+// Etag for a file that checkpoint_matches(): "append-<size>-<head><tail>",
+// the head/tail block hashes of [0, size). Two block reads instead of the
+// whole file; like a sampled fingerprint it misses in-place edits between
+// the blocks. Empty on error.
+std::string checkpoint_etag(const std::string& path, std::uint64_t size, std::string* err_out = nullptr);
+
+// Offset just past the last '\n' in [0, size) of `path`; 0 when there is none.
+std::uint64_t last_line_end(const std::string& path, std::uint64_t size, std::string* err_out = nullptr);
+
+}
@@ -1,4 +1,6 @@
 #pragma once
+#include "typed_scanner/byte_source.hpp"
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
@@ -7,6 +9,8 @@
 
 namespace ts {
 
+class TaskPool;
+
 class ChunkReader {
 public:
   struct Config {
@@ -14,6 +18,28 @@ public:
     std::size_t max_record_bytes = 8 * 1024 * 1024; // 8 MiB guard per line
     bool        strip_cr         = true;            // trim trailing '\r' (CRLF)
     bool        drop_oversize    = true;            // drop lines exceeding guard
+    bool        strip_bom        = true;            // drop a leading UTF-8 BOM
+    // Optional byte range [begin_offset, end_offset) for parallel readers:
+    // yields the lines that *start* inside it (end_offset 0 = EOF), so
+    // adjacent ranges cover every line exactly once.
+    std::uint64_t begin_offset   = 0;
+    std::uint64_t end_offset     = 0;
+    // gzip/zstd input (detected by magic bytes) is decoded while reading,
+    // ahead of the reader as tasks on `pool` (null = TaskPool::global())
+    // unless decompress_thread is off.
+    bool decompress              = true;
+    bool decompress_thread       = true;
+    TaskPool*     pool           = nullptr;
+    // Compressed ranges: offsets are in the decoded stream, and decoding
+    // starts at frame_offset, the file offset of a frame (see index_frames)
+    // whose output begins at begin_offset. Lines belong to the range that
+    // holds the newline before them, so no byte before the frame is needed.
+    std::uint64_t frame_offset   = 0;
+    // Checked before every block: once set, for_each_line() stops and
+    // returns false with error() "cancelled".
+    const std::atomic<bool>* cancel = nullptr;
+    // The same for a consumer that gave up on the records (error() "stopped").
+    const std::atomic<bool>* stop = nullptr;
   };
 
   explicit ChunkReader(std::string path);      // uses default Config{}
@@ -23,11 +49,20 @@ public:
 
   using LineCallback = std::function<void(std::string_view)>;
 
+  // Called after every block's lines were dispatched: block size and the
+  // nanoseconds spent in the line callbacks for it (i.e. tokenize time).
+  using ChunkCallback = std::function<void(std::uint64_t bytes, std::uint64_t dispatch_ns)>;
+  void on_chunk(ChunkCallback cb);
+
   ~ChunkReader();
 
   bool for_each_line(const LineCallback& cb);
   int  last_error() const noexcept;
-  std::uint64_t bytes_read() const noexcept;
+  std::uint64_t bytes_read() const noexcept; // bytes handed to the line splitter (decoded)
+  std::uint64_t raw_bytes_read() const noexcept; // bytes read from the file (compressed)
+  Compression compression() const noexcept;      // known once for_each_line() ran
+  std::uint64_t decompress_ns() const noexcept;  // time spent decoding
+  const std::string& error() const noexcept;     // decoder/range error, if any
 
 private:
   struct Impl; Impl* p_;
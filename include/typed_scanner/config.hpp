@@ -0,0 +1,84 @@
+#pragma once
+#include "typed_scanner/chunk_reader.hpp"
+#include "typed_scanner/http_server.hpp"
+#include "typed_scanner/parse_policy.hpp"
+#include "typed_scanner/token_csv_fsm.hpp"
+#include "typed_scanner/token_jsonl_simdjson.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ts {
+
+// Typed view of configs/config.toml and configs/pipeline.toml. Every field
+// starts at the built-in default; files and overrides only replace the keys
+// they set, so later sources win (config.toml, pipeline.toml, --set, flags).
+struct AppConfig {
+  // [project] / [server]
+  std::string artifact_root = "artifacts/typed-scanner";
+  HttpServer::Config server;
+
+  // [scanner]
+  unsigned    reader_threads = 0;          // TaskPool size; 0 = all cores
+  std::size_t arena_bytes    = 16u << 20;  // row arena per tokenizer
+  unsigned    max_errors_per_field = 0;   // per-field parse errors; 0 = no cap
+  ChunkReader::Config reader;              // chunk_bytes
+
+  // [csv] / [jsonl]
+  CsvConfig   csv;
+  bool        csv_sniff = true;            // format/dialect from content (see sniff.hpp)
+  JsonlConfig jsonl;
+  std::string jsonl_encoding = "utf-8";    // only utf-8 is supported
+  std::vector<std::string> null_values = {"", "NA", "null", "NULL", "NaN"};
+
+  // [render] content codings written next to report files (br|zstd|gzip)
+  std::vector<std::string> precompress = {"br", "zstd", "gzip"};
+  int series_interval_ms = 250;            // run.json series sampling; 0 = off
+
+  // [sync]
+  std::string on_create = "build";            // build|skip
+  std::string on_update = "rebuild";          // rebuild|skip
+  std::string on_delete = "delete_artifacts"; // delete_artifacts|keep
+  bool idempotency_use_etag = true;          // skip inputs whose etag is unchanged
+  std::string fingerprint = "xxh3";           // xxh3|sampled
+  bool resume_appends = false;                // rescan only appended lines
+
+  // pipeline.toml [sources]: what --watch=DIR reacts to
+  std::vector<std::string> include = {"**/*.csv", "**/*.jsonl", "**/*.ndjson",
+                                      "**/*.csv.gz", "**/*.jsonl.gz", "**/*.ndjson.gz",
+                                      "**/*.csv.zst", "**/*.jsonl.zst", "**/*.ndjson.zst"};
+  std::vector<std::string> exclude = {"**/.*", "**/*.tmp"};
+  unsigned watch_debounce_ms = 500;
+
+  // [limits] (either file)
+  unsigned      max_parallel = 2;
+  std::uint64_t max_inflight_bytes = 1ull << 30;
+
+  // pipeline.toml: [dag], [stages.policy_parse], [mapping]
+  std::vector<std::string> stages = {"tokenize", "policy_parse", "metrics", "render"};
+  ParsePolicy::OnError on_error = ParsePolicy::OnError::Null;
+  DatePolicy  date_policy;
+  BoolPolicy  bool_policy;
+  std::string slug_rule = "hashprefix";    // hashprefix|basename|keypath
+  int         slug_len  = 8;
+
+  // Policy wired to date_policy/bool_policy/null_values above; valid while
+  // this config is alive and not moved.
+  ParsePolicy parse_policy();
+};
+
+// Apply one TOML file (config.toml or pipeline.toml; sections that are not
+// ours are ignored). Returns false with "file:line: key: message" on a parse
+// or type error; cfg may then be partially updated.
+bool load_config_file(const std::string& path, AppConfig& cfg, std::string* err_out);
+
+// Apply "section.key=value" (e.g. scanner.chunk_bytes=1048576). The value is
+// TOML; a bare word that is not valid TOML is taken as a string.
+bool apply_config_override(std::string_view assignment, AppConfig& cfg, std::string* err_out);
+
+// Range and enum checks; one message per problem, empty when valid.
+std::vector<std::string> validate_config(const AppConfig& cfg);
+
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ts {
+
+// Recursive directory watcher for --watch (inotify; Linux only).
+//
+// Reports a file once it has been written and closed (IN_CLOSE_WRITE) or
+// moved in (IN_MOVED_TO), and once it is removed or moved out. Events for
+// the same path are coalesced until it has been quiet for debounce_ms, so
+// a burst of writes or a delete+recreate yields a single callback with the
+// final state. Only paths matching an include glob and no exclude glob
+// (relative to root, '/'-separated) are reported. Callbacks run on the
+// watcher thread; on_batch follows each group of paths that settled
+// together.
+class DirWatcher {
+public:
+  struct Config {
+    std::string root;
+    std::vector<std::string> include = {"**/*.csv", "**/*.jsonl", "**/*.ndjson",
+                                        "**/*.csv.gz", "**/*.jsonl.gz", "**/*.ndjson.gz",
+                                        "**/*.csv.zst", "**/*.jsonl.zst", "**/*.ndjson.zst"};
+    std::vector<std::string> exclude;
+    unsigned debounce_ms = 500;
+    bool initial_scan = true; // report files already present at start()
+    // false: one watch on root alone, reporting the directories directly
+    // under it (created or moved in: Changed; removed or moved out:
+    // Deleted) instead of files. Globs then match directory names.
+    bool recursive = true;
+  };
+
+  enum class Event { Changed, Deleted };
+  using Callback = std::function<void(const std::string& path, Event ev)>;
+  using BatchCallback = std::function<void()>;
+
+  DirWatcher(Config cfg, Callback cb, BatchCallback on_batch = {});
+  ~DirWatcher(); // stop()
+  DirWatcher(const DirWatcher&) = delete;
+  DirWatcher& operator=(const DirWatcher&) = delete;
+
+  // Watch root and its subdirectories (new ones are picked up) on a
+  // background thread. False with err_out when inotify is unavailable.
+  bool start(std::string* err_out = nullptr);
+  // Flush nothing further and join the thread.
+  void stop();
+
+private:
+  struct Impl;
+  Impl* p_;
+};
+
+// Glob over '/'-separated relative paths: '*' and '?' stay within one
+// segment, "**/" matches zero or more directories.
+bool glob_match(std::string_view pattern, std::string_view path);
+
+}
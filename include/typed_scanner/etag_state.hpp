@@ -8,15 +8,30 @@
 namespace ts {
 
 // Keeps track of (slug -> etag) to enable idempotent rebuilds.
+// Optionally backed by a file ("slug<TAB>etag" lines) that survives restarts.
+// set()/erase() only mark the state dirty; callers flush() once per batch
+// of scans, so N files cost one rewrite instead of N.
 class EtagState {
 public:
   void set(std::string slug, std::string etag);
   std::optional<std::string> get(std::string_view slug) const;
   bool matches(std::string_view slug, std::string_view etag) const;
+  void erase(std::string_view slug);
+
+  // Read `path` (a missing file is an empty state) and remember it for save().
+  bool load(const std::string& path, std::string* err_out = nullptr);
+  // Rewrite the backing file atomically (temp file + rename).
+  bool save(std::string* err_out = nullptr);
+  // save() if anything changed since the last load()/save().
+  bool flush(std::string* err_out = nullptr);
 
 private:
   mutable std::mutex mu_;
   std::unordered_map<std::string, std::string> map_;
+  std::string path_;
+  bool dirty_ = false;
+
+  bool save_locked(std::string* err_out);
 };
 
 }
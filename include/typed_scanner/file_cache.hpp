@@ -0,0 +1,73 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace ts {
+
+// A file as HttpServer sends it: body plus HTTP validators. Files above
+// the cache's entry limit are `streamed`: body stays empty and the server
+// reads `path` in slices per response.
+struct CachedFile {
+  std::string body;
+  std::string path;
+  bool streamed = false;
+  std::string etag;          // strong, quoted: "<xxh3 of body>" or "<size>-<mtime>" if streamed
+  std::string last_modified; // IMF-fixdate of the mtime
+  std::int64_t mtime_ns = 0;
+  std::uint64_t size = 0;
+  std::uint64_t inode = 0;
+};
+
+// Bounded LRU of whole files keyed by path (HttpServer passes canonical
+// paths). Every lookup stats the file and reloads an entry whose mtime,
+// size or inode changed, so a rebuilt report is never served stale.
+// Thread-safe; files are read outside the lock.
+class FileCache {
+public:
+  struct Config {
+    std::size_t max_bytes       = 64u << 20; // sum of cached bodies; 0 = off
+    std::size_t max_entry_bytes = 8u << 20;  // larger files are streamed, never read whole
+  };
+
+  struct Stats {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;      // loaded from disk (absent or stale)
+    std::uint64_t evictions = 0;
+    std::size_t bytes = 0;
+    std::size_t entries = 0;
+  };
+
+  explicit FileCache(Config cfg);
+  ~FileCache();
+  FileCache(const FileCache&) = delete;
+  FileCache& operator=(const FileCache&) = delete;
+
+  // The file's current contents (or validators only, if streamed); null
+  // with err_out if it cannot be read.
+  std::shared_ptr<const CachedFile> get(const std::string& path, std::string* err_out = nullptr);
+
+  Stats stats() const;
+
+private:
+  struct Impl;
+  Impl* p_;
+};
+
+// True when a conditional GET for `f` is answered with 304. If-None-Match
+// (weak comparison, "*" matches) takes precedence over If-Modified-Since.
+bool not_modified(const CachedFile& f, std::string_view if_none_match,
+                  std::string_view if_modified_since);
+
+// Whether a Range request for `f` gets its ranges (206) or the whole file
+// (200). If-Range applies the range to the representation it names only
+// (RFC 9110 13.1.5); dates are too coarse for a file rebuilt within the
+// same second, so only an exact strong ETag matches.
+bool range_applies(const CachedFile& f, std::string_view if_range);
+
+// IMF-fixdate, e.g. "Sun, 06 Nov 1994 08:49:37 GMT".
+std::string http_date(std::int64_t unix_seconds);
+
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace ts {
+
+// [sync] fingerprint: how an input's etag is derived.
+//   xxh3    - XXH3-64 over every byte (exact; reads the whole file)
+//   sampled - size + mtime + XXH3 of up to kSampleBlocks spread-out blocks
+//             (constant cost; misses in-place edits outside the samples)
+enum class FingerprintMode { Xxh3, Sampled };
+
+inline constexpr unsigned    kSampleBlocks    = 16;
+inline constexpr std::size_t kSampleBlockSize = 64 * 1024;
+
+bool parse_fingerprint_mode(std::string_view s, FingerprintMode& out);
+
+// Etag such as "xxh3-9f1c0a...": the mode is part of it, so switching
+// modes never matches an old etag. Empty on error (err_out set).
+std::string file_fingerprint(const std::string& path, FingerprintMode mode,
+                             std::string* err_out = nullptr);
+
+// XXH3-64 of bytes [begin, end) of `path` (used by resume checkpoints).
+bool hash_file_range(const std::string& path, std::uint64_t begin, std::uint64_t end,
+                     std::uint64_t& out, std::string* err_out = nullptr);
+
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ts {
+
+// Percentiles + non-empty buckets of one histogram, in milliseconds.
+struct LatencySummary {
+  struct Bucket {
+    double le_ms = 0.0;        // inclusive upper bound of the bucket
+    std::uint64_t count = 0;
+  };
+
+  std::string name;
+  std::uint64_t count = 0;
+  double p50_ms = 0.0;
+  double p90_ms = 0.0;
+  double p99_ms = 0.0;
+  double p999_ms = 0.0;
+  double max_ms = 0.0;
+  double mean_ms = 0.0;
+  std::vector<Bucket> buckets;
+};
+
+// Log-linear latency histogram (HdrHistogram-style) over nanoseconds.
+// Each power of two is split into kSubCount linear sub-buckets, so any value
+// is reported within 1/kSubCount (~3%) of its true value; values below
+// kSubCount ns are exact. Memory is fixed (kBuckets counters, ~15 KiB).
+//
+// record() is wait-free for a single writer: give each thread its own
+// histogram and merge() them; concurrent readers (summaries, percentiles)
+// see relaxed but never torn counts.
+class LatencyHistogram {
+public:
+  static constexpr int kSubBits = 5;
+  static constexpr std::uint64_t kSubCount = 1u << kSubBits;
+  static constexpr std::size_t kBuckets = (64 - kSubBits + 1) * kSubCount;
+
+  LatencyHistogram() = default;
+  LatencyHistogram(const LatencyHistogram& o) { merge(o); }
+  LatencyHistogram& operator=(const LatencyHistogram& o);
+
+  void record(std::uint64_t ns) noexcept {
+    bump(counts_[bucket_index(ns)], 1);
+    bump(count_, 1);
+    bump(sum_ns_, ns);
+    if (ns > max_ns_.load(std::memory_order_relaxed)) max_ns_.store(ns, std::memory_order_relaxed);
+  }
+
+  // Add `o` into this histogram (single writer on `this`).
+  void merge(const LatencyHistogram& o) noexcept;
+  void reset() noexcept;
+
+  std::uint64_t count() const noexcept { return count_.load(std::memory_order_relaxed); }
+  std::uint64_t max_ns() const noexcept { return max_ns_.load(std::memory_order_relaxed); }
+
+  // Value at quantile q in [0,1]: upper bound of the bucket holding it,
+  // clamped to the recorded max.
+  std::uint64_t value_at(double q) const noexcept;
+
+  LatencySummary summarize(std::string name) const;
+
+  static std::size_t bucket_index(std::uint64_t ns) noexcept {
+    if (ns < kSubCount) return static_cast<std::size_t>(ns);
+    const int msb = 63 - std::countl_zero(ns);
+    const int shift = msb - kSubBits;
+    return static_cast<std::size_t>(shift + 1) * kSubCount + ((ns >> shift) - kSubCount);
+  }
+  static std::uint64_t bucket_lower(std::size_t idx) noexcept;
+  static std::uint64_t bucket_upper(std::size_t idx) noexcept;
+
+private:
+  static void bump(std::atomic<std::uint64_t>& c, std::uint64_t n) noexcept {
+    c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+  }
+
+  std::array<std::atomic<std::uint64_t>, kBuckets> counts_{};
+  std::atomic<std::uint64_t> count_{0};
+  std::atomic<std::uint64_t> sum_ns_{0};
+  std::atomic<std::uint64_t> max_ns_{0};
+};
+
+}
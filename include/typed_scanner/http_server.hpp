@@ -1,18 +1,38 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <string>
 #include <string_view>
+#include <vector>
 
 namespace ts {
 
+class ScanJobs;
+
 // Tiny wrapper around cpp-httplib; serves `/` index + `/reports/<slug>/report.html`
+// and `/api/reports` (JSON) from an in-memory ReportIndex, plus the live
+// progress of in-flight scans (`/scans/<slug>`, `/api/scans/<slug>/events`)
+// and, with attach_jobs(), scan submission (`/api/scans`).
 class HttpServer {
 public:
   struct Config {
     std::string artifact_root = "artifacts/typed-scanner";
     std::string index_title   = "Typed Scanner Reports";
     int port = 8080;
-    bool scan_per_request = true; // allow re-scan of artifacts on GET /
+    bool scan_per_request = true; // GET / re-stats the artifact root, rescanning if it changed
+    bool watch_index = true;      // inotify on the artifact root keeps the index current
+    std::size_t index_page_size = 100;
+    // Report files kept in memory (LRU, revalidated by mtime/size on every
+    // request) and sent with ETag/Last-Modified; 0 disables the cache.
+    std::size_t cache_bytes = 64u << 20;
+    // Concurrent /api/scans/<slug>/events streams; each holds a worker
+    // thread for its duration, so this stays well under the pool size.
+    std::size_t max_event_streams = 4;
+    // POST /api/scans?path=...: only files under these directories; empty
+    // refuses local paths (uploads still work).
+    std::vector<std::string> scan_roots;
+    std::uint64_t max_upload_bytes = 1ull << 30; // 413 beyond this
   };
 
   explicit HttpServer(Config cfg);
@@ -27,6 +47,14 @@ public:
   // Stop if running.
   void stop();
 
+  // Serve POST/GET/DELETE /api/scans from `jobs` (not owned; outlives the
+  // server). Call before start(); without it those routes answer 404.
+  void attach_jobs(ScanJobs* jobs);
+
+  // A report under <artifact_root>/<slug> was written or removed; the
+  // index picks it up without waiting for inotify. Thread-safe.
+  void report_updated(const std::string& slug);
+
 private:
   struct Impl;
   Impl* p_;
@@ -0,0 +1,75 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace ts {
+
+// Streaming JSON output, either appended to a caller's std::string or
+// written to an fd through a fixed buffer (the document never has to exist
+// in memory as a whole). Commas between members and elements are inserted
+// automatically. Numbers go through std::to_chars: locale-free, shortest
+// round-trip for doubles; NaN/inf are written as 0 so the output stays
+// valid JSON. Write errors on the fd are sticky: ok() turns false and
+// later output is dropped.
+class JsonWriter {
+public:
+  explicit JsonWriter(std::string& out);
+  // fd is not owned. buffer_bytes is the flush threshold.
+  explicit JsonWriter(int fd, std::size_t buffer_bytes = 64u << 10);
+  ~JsonWriter(); // flush()
+  JsonWriter(const JsonWriter&) = delete;
+  JsonWriter& operator=(const JsonWriter&) = delete;
+
+  JsonWriter& begin_object();
+  JsonWriter& end_object();
+  JsonWriter& begin_array();
+  JsonWriter& end_array();
+  JsonWriter& key(std::string_view k);
+
+  JsonWriter& value(std::string_view s);
+  JsonWriter& value(const char* s) { return value(std::string_view(s)); }
+  JsonWriter& value(const std::string& s) { return value(std::string_view(s)); }
+  JsonWriter& value(double v);
+  JsonWriter& value(bool b);
+  template <class T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>, int> = 0>
+  JsonWriter& value(T v) {
+    if constexpr (std::is_signed_v<T>) return write_int(static_cast<std::int64_t>(v));
+    else return write_uint(static_cast<std::uint64_t>(v));
+  }
+  JsonWriter& null();
+
+  // Bytes copied verbatim, with no comma handling: for splicing already
+  // serialized elements (e.g. RunJsonSeriesSpool) into an open array.
+  JsonWriter& raw(std::string_view json);
+
+  // fd sink: write out the buffer. Always true for the string sink.
+  bool flush();
+  bool ok() const noexcept { return err_.empty(); }
+  const std::string& error() const noexcept { return err_; }
+
+private:
+  JsonWriter& write_int(std::int64_t v);
+  JsonWriter& write_uint(std::uint64_t v);
+  void before_value();
+  void maybe_flush() { if (fd_ >= 0 && out_->size() >= cap_) flush(); }
+
+  static constexpr int kMaxDepth = 64;
+
+  std::string* out_;
+  std::string buf_; // fd sink only
+  int fd_ = -1;
+  std::size_t cap_ = 0;
+  int depth_ = 0;
+  bool first_[kMaxDepth + 1] = {true};
+  bool after_key_ = false;
+  std::string err_;
+};
+
+// `s` as a quoted JSON string ('"', '\\' and control characters escaped).
+// Plain runs are found 8 bytes at a time and copied in one append.
+void append_json_string(std::string& out, std::string_view s);
+
+}
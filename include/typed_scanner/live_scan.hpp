@@ -0,0 +1,76 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ts {
+
+// One progress sample of an in-flight scan.
+struct LiveScanSample {
+  double time_ms = 0.0; // since the scan started
+  std::uint64_t rows = 0;
+  std::uint64_t bytes = 0;
+  double mb_s = 0.0;    // over the last sampling interval
+  double rss_mb = 0.0;
+  std::vector<std::pair<std::string, std::uint64_t>> stage_ms; // open stages included
+};
+
+// Progress of one in-flight scan: scan_file's sampler (on the Ticker thread) publishes,
+// any number of readers (the server's event streams) wait and copy. The
+// scan's tokenizer threads never touch it.
+class LiveScan {
+public:
+  LiveScan(std::string slug, std::string filename);
+
+  const std::string& slug() const noexcept { return slug_; }
+  const std::string& filename() const noexcept { return filename_; }
+
+  void publish(LiveScanSample s);
+  // Last call; wakes all readers.
+  void finish(bool ok, std::string error);
+
+  // Blocks until there is a sample newer than `seen` or the scan is done,
+  // at most `timeout`. Returns the latest sequence number (0 = no sample
+  // yet) and copies the sample when it is newer than `seen`.
+  std::uint64_t wait(std::uint64_t seen, std::chrono::milliseconds timeout, LiveScanSample& out) const;
+
+  bool done() const;
+  bool ok() const;
+  std::string error() const;
+
+private:
+  const std::string slug_;
+  const std::string filename_;
+  mutable std::mutex mu_;
+  mutable std::condition_variable cv_;
+  LiveScanSample last_;
+  std::uint64_t seq_ = 0;
+  bool done_ = false;
+  bool ok_ = false;
+  std::string error_;
+};
+
+// Process-wide table of in-flight scans, by slug. A slug scanned twice at
+// once keeps the newer entry.
+class LiveScans {
+public:
+  static LiveScans& global();
+
+  std::shared_ptr<LiveScan> begin(const std::string& slug, const std::string& filename);
+  // Drops `scan` from the table (readers holding it still see finish()).
+  void end(const std::shared_ptr<LiveScan>& scan);
+  std::shared_ptr<LiveScan> find(const std::string& slug) const;
+  std::vector<std::shared_ptr<LiveScan>> list() const;
+
+private:
+  mutable std::mutex mu_;
+  std::map<std::string, std::shared_ptr<LiveScan>> scans_;
+};
+
+}
@@ -1,8 +1,15 @@
 #pragma once
+#include "typed_scanner/histogram.hpp"
+#include "typed_scanner/sys_counters.hpp"
+#include <array>
+#include <atomic>
 #include <cstdint>
 #include <chrono>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -11,6 +18,7 @@ namespace ts {
 struct StageTiming {
   std::string name;
   std::uint64_t duration_ms = 0;
+  PerfSample perf; // valid only when hardware counters were enabled
 };
 
 struct RunStats {
@@ -26,31 +34,144 @@ struct RunStats {
 
   std::vector<StageTiming> stages;
   std::unordered_map<std::string, std::uint64_t> errors_by_field;
+  std::vector<LatencySummary> latencies;
 };
 
+// Histogram names recorded by the scanner.
+inline constexpr std::string_view kLatencyChunk  = "tokenize_chunk"; // per ChunkReader block
+inline constexpr std::string_view kLatencyRecord = "record";         // per line: tokenize + callback, sampled
+// kLatencyRecord times one line in this many; its count is of sampled lines.
+inline constexpr std::uint32_t kRecordSampleEvery = 64;
+inline constexpr std::string_view kLatencyFile   = "scan_file";      // per input file
+
+// Small integer handles returned by the registration phase.
+using StageId     = std::uint32_t;
+using CounterId   = std::uint32_t;
+using HistogramId = std::uint32_t;
+
+// Metrics are split into one cache-line-aligned shard per (registry, thread).
+// Hot-path calls only touch the calling thread's shard with plain relaxed
+// loads/stores (no locks, no RMW), and snapshot() sums the shards. Register
+// names up front (register_*) and keep the ids in hot loops; the string
+// overloads intern on every call and are meant for cold paths.
 class MetricsRegistry {
 public:
+  static constexpr std::size_t kMaxStages     = 32;
+  static constexpr std::size_t kMaxCounters   = 1024; // field-error counters
+  static constexpr std::size_t kMaxHistograms = 16;
+
+  MetricsRegistry();
+  ~MetricsRegistry();
+  MetricsRegistry(const MetricsRegistry&) = delete;
+  MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+  // --- registration (mutex; idempotent per name) ----------------------------
+  StageId     register_stage(std::string_view name);
+  CounterId   register_field_error(std::string_view field); // overflow folds into "(other)"
+  HistogramId register_histogram(std::string_view name);
+
+  // --- hot path ---------------------------------------------------------------
+  void add_row() noexcept { local().rows.add(1); }
+  void add_rows(std::uint64_t n) noexcept { local().rows.add(n); }
+  void add_bytes(std::uint64_t b) noexcept { local().bytes.add(b); }
+  void add_field_error(CounterId id, std::uint64_t n = 1) noexcept;
+  void record_latency(HistogramId id, std::uint64_t ns);
+
+  // Stages also sample the calling thread's PerfCounterGroup when
+  // perf_counters_enabled(); start/end must run on the same thread.
+  void start_stage(StageId id);
+  void end_stage(StageId id);
+  // Busy time measured elsewhere (e.g. on a helper thread the registry
+  // does not see).
+  void add_stage_ns(StageId id, std::uint64_t ns);
+
+  void set_cpu_pct(double v) noexcept { cpu_pct_.store(v, std::memory_order_relaxed); }
+  void set_peak_rss_mb(double v) noexcept { peak_rss_mb_.store(v, std::memory_order_relaxed); }
+
+  // --- string API (thin wrappers over the id API) -----------------------------
+  void start_stage(std::string_view name) { start_stage(register_stage(name)); }
+  void end_stage(std::string_view name) { end_stage(register_stage(name)); }
+  void add_field_error(std::string_view field) { add_field_error(register_field_error(field)); }
+
+  // Fold a thread-local histogram into the named registry histogram.
+  void merge_latency(std::string_view name, const LatencyHistogram& h);
+  // All threads' samples for `name` merged (empty if never recorded).
+  LatencyHistogram latency(std::string_view name) const;
+
+  // Zero all values; registrations (and ids) stay valid. No concurrent writers.
   void reset();
-  void add_row() noexcept { ++rows_; }
-  void add_bytes(std::uint64_t b) noexcept { bytes_ += b; }
-  void set_cpu_pct(double v) noexcept { cpu_pct_ = v; }
-  void set_peak_rss_mb(double v) noexcept { peak_rss_mb_ = v; }
 
-  void start_stage(std::string_view name);
-  void end_stage(std::string_view name);
+  // Live totals (relaxed reads; safe while scan threads are writing).
+  std::uint64_t rows() const;
+  std::uint64_t bytes() const;
 
-  void add_field_error(std::string_view field);
+  // Progress of a scan that is still running, for a sampler thread. Takes no
+  // lock: it walks the published shards with relaxed loads, so scan threads
+  // never wait on it. Stages in registration order; a stage still open on
+  // some thread counts its elapsed time so far. `perf` is left unset.
+  struct LiveTotals {
+    std::uint64_t rows = 0;
+    std::uint64_t bytes = 0;
+    std::vector<StageTiming> stages;
+  };
+  LiveTotals live() const;
+
+  // p50/p95 come from the kLatencyChunk histogram.
+  RunStats snapshot(double wall_ms, double tokens_per_sec, double allocs_per_sec) const;
   RunStats snapshot(double wall_ms, double tokens_per_sec,
                     double allocs_per_sec, double p50_ms, double p95_ms) const;
 
 private:
-  std::uint64_t rows_{0};
-  std::uint64_t bytes_{0};
-  double cpu_pct_{0.0};
-  double peak_rss_mb_{0.0};
-  std::unordered_map<std::string, std::uint64_t> field_errs_;
-  std::unordered_map<std::string, std::uint64_t> stage_accum_ms_;
-  std::unordered_map<std::string, std::chrono::steady_clock::time_point> stage_starts_;
+  // Single-writer counter: the owning thread updates, snapshot reads.
+  struct Cell {
+    std::atomic<std::uint64_t> v{0};
+    void add(std::uint64_t n) noexcept {
+      v.store(v.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+    std::uint64_t get() const noexcept { return v.load(std::memory_order_relaxed); }
+    void clear() noexcept { v.store(0, std::memory_order_relaxed); }
+  };
+
+  struct StagePerf { Cell cycles, instructions, branch_misses, llc_misses, samples; };
+
+  struct alignas(64) Shard {
+    Cell rows;
+    Cell bytes;
+    std::array<Cell, kMaxStages> stage_ns;
+    std::array<Cell, kMaxStages> stage_hits;
+    std::array<StagePerf, kMaxStages> stage_perf;
+    std::array<Cell, kMaxCounters> field_errs;
+    std::array<std::atomic<LatencyHistogram*>, kMaxHistograms> hist{};
+
+    // Start of the open span per stage (steady_clock ns, 0 = closed); the
+    // owner writes, live() reads.
+    std::array<std::atomic<std::int64_t>, kMaxStages> stage_t0{};
+    // Owner-thread only.
+    std::array<PerfSample, kMaxStages> stage_perf0{};
+
+    Shard* next = nullptr; // live() list; set once before publication
+
+    ~Shard();
+  };
+
+  Shard& local();
+  Shard* make_shard();
+
+  std::uint64_t id_; // process-unique, keys the thread-local shard cache
+  mutable std::mutex mu_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+  std::vector<std::thread::id> shard_owners_;
+  std::atomic<Shard*> shard_head_{nullptr}; // same shards, newest first
+  std::atomic<std::size_t> nstages_{0};     // stage_names_ published to live()
+  std::vector<std::string> stage_names_;
+  std::vector<std::string> counter_names_;
+  std::vector<std::string> hist_names_;
+  std::unordered_map<std::string, StageId> stage_ids_;
+  std::unordered_map<std::string, CounterId> counter_ids_;
+  std::unordered_map<std::string, HistogramId> hist_ids_;
+
+  std::atomic<double> cpu_pct_{0.0};
+  std::atomic<double> peak_rss_mb_{0.0};
 };
 
 }
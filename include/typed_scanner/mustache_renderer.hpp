@@ -1,4 +1,5 @@
 #pragma once
+#include <map>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -12,11 +13,24 @@ public:
     std::string partials_dir = "templates/partials";
     std::vector<std::string> static_js;
     std::vector<std::string> static_css;
+    // Asset file name -> URL (e.g. from publish_assets). Templates see each
+    // asset as {{asset_<name>}} with non-alphanumerics as '_' (report.css ->
+    // asset_report_css); assets without an entry link "./<name>".
+    std::map<std::string, std::string> asset_urls;
+    // Keep templates (partials inlined) and their parsed form in memory,
+    // shared by all renderers and threads; a template or partial whose
+    // mtime/size changed is reloaded on the next render.
+    bool cache_templates = true;
   };
 
   MustacheRenderer();
   explicit MustacheRenderer(Config cfg);
 
+  // Safe to call from many threads at once (one renderer per thread).
+  bool render_to_string(std::string_view template_name,
+                        std::string_view context_json,
+                        std::string& out);
+
   bool render_to_file(std::string_view template_name,
                       std::string_view context_json,
                       std::string_view out_path);
@@ -16,8 +16,13 @@ struct ParsePolicy {
   enum class OnError { Strict, Lenient, Null };
 
   OnError on_error = OnError::Null;
+  // Non-strict modes fail the scan once a field has more errors than
+  // this ([scanner] max_errors_per_field); 0 = no cap.
+  std::uint64_t max_errors_per_field = 0;
   DatePolicy* date_policy = nullptr;
   BoolPolicy* bool_policy = nullptr;
+  // Configured null tokens ([csv] null_values); null = built-in list.
+  const std::vector<std::string>* null_tokens = nullptr;
 
   // Numeric parse (fast_float in .cpp). Returns double for simplicity.
   std::optional<double> parse_number(std::string_view s) const;
@@ -15,9 +15,20 @@ std::filesystem::path join(const std::filesystem::path& a,
 // Ensure parent directories exist; returns false on error.
 bool ensure_parent_dirs(const std::filesystem::path& p);
 
-// Guess format from extension (.csv | .jsonl | .ndjson).
+// Guess format from extension (.csv | .jsonl | .ndjson), looking through a
+// compression suffix (.gz/.gzip/.zst/.zstd).
 FileFormat detect_format(std::string_view path);
 
+// Format of a stream from its first line: JSONL if it opens an object,
+// Unknown if blank, CSV otherwise.
+FileFormat sniff_format(std::string_view first_line);
+// "csv" | "jsonl"/"ndjson" -> format (--format); Unknown otherwise.
+FileFormat parse_format(std::string_view name);
+
+// "-" (stdin) or a path that is not a regular file (pipe, /dev/fd/N,
+// socket): read once, front to back, with no size known up front.
+bool is_stream_path(const std::string& path);
+
 // Slug generation per config: "hashprefix", "basename", or "keypath".
 // We expose a utility that callers give mode + length.
 std::string make_slug(std::string_view key, std::string_view mode, int len);
@@ -0,0 +1,110 @@
+#pragma once
+#include "typed_scanner/parse_policy.hpp"
+#include "typed_scanner/path_utils.hpp"
+#include "typed_scanner/tokenize.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ts {
+
+class MetricsRegistry;
+
+enum class FieldKind : std::uint8_t { Null, Number, Bool, Date, String, Error };
+
+// Up to batch_rows records with their bytes copied out of the tokenizer
+// arenas (which are reset while batches are still queued downstream).
+// policy_parse fills kinds/values, one entry per field.
+struct RecordBatch {
+  std::shared_ptr<const std::vector<std::string>> header; // column names (may be null)
+  unsigned range = 0;               // byte range it was tokenized from
+  std::string data;                 // field bytes back to back
+  std::vector<std::uint32_t> ends;  // end offset in `data` of each field
+  std::vector<std::uint32_t> rows;  // end index in `ends` of each row
+
+  std::vector<FieldKind> kinds;
+  std::vector<double> values;       // Number/Date(ms)/Bool(0|1), else 0
+
+  std::size_t size() const noexcept { return rows.size(); }
+  std::size_t row_begin(std::size_t r) const noexcept { return r ? rows[r - 1] : 0; }
+  std::string_view field(std::size_t i) const noexcept {
+    const std::uint32_t b = i ? ends[i - 1] : 0;
+    return std::string_view(data).substr(b, ends[i] - b);
+  }
+  void add(const RecordView& rv);
+};
+
+// Per-column summary produced by the metrics stage.
+struct ColumnStats {
+  std::string name;
+  std::string type = "string"; // dominant non-null kind
+  std::uint64_t count = 0;
+  std::uint64_t nulls = 0;
+  std::uint64_t errors = 0;
+  std::uint64_t numbers = 0, bools = 0, dates = 0, strings = 0;
+  double min = 0.0, max = 0.0, sum = 0.0; // over Number values
+};
+
+// Add `more` (a later part of the same column) into `into`; type is redone.
+void merge_column_stats(ColumnStats& into, const ColumnStats& more);
+
+struct PipelineOptions {
+  // [dag] stages. "tokenize" is the source and "render" is left to the
+  // caller; the stages in between stream batches as pool tasks.
+  std::vector<std::string> stages = {"tokenize", "policy_parse", "metrics", "render"};
+  ParsePolicy policy;          // [stages.policy_parse]
+  std::size_t batch_rows = 4096;
+  std::size_t batch_bytes = 4u << 20;
+  std::size_t queue_batches = 8; // per edge
+  // Column kinds fixed by an earlier scan of the same file (resume); the
+  // first non-null value in file order decides the remaining columns as
+  // usual (policy_parse holds later ranges back until that is settled, so
+  // it should be the first stage).
+  std::vector<FieldKind> seed_kinds;
+};
+
+struct PipelineResult {
+  TokenizeStats tok;           // ok/error also cover the streaming stages
+  std::vector<ColumnStats> columns;
+  std::vector<FieldKind> kinds;  // policy_parse column kinds (for the next resume)
+};
+
+// One streaming stage; process() calls of one stage never overlap (they
+// may move between pool threads).
+class PipelineStage {
+public:
+  virtual ~PipelineStage() = default;
+  virtual const char* name() const = 0;
+  // false aborts the pipeline with error().
+  virtual bool process(RecordBatch& batch) = 0;
+  virtual void finish(PipelineResult& out) { (void)out; }
+  // First stage only, for results that depend on file order across byte
+  // ranges: a batch it is not ready() for waits, with the rest of its
+  // range, until end_range() of earlier ranges makes it ready. Range 0's
+  // batches must always be ready.
+  virtual bool ready(const RecordBatch& batch) const { (void)batch; return true; }
+  virtual void end_range(unsigned range) { (void)range; } // all its batches processed
+  const std::string& error() const { return err_; }
+
+protected:
+  std::string err_;
+};
+
+// Factory for the streaming stages ("policy_parse", "metrics"; null otherwise).
+std::unique_ptr<PipelineStage> make_pipeline_stage(std::string_view name, const PipelineOptions& opts,
+                                                   MetricsRegistry& metrics);
+
+// tokenize -> stage -> ... through bounded SPSC queues, so tokenizing batch
+// N+1 overlaps with parsing batch N. Byte ranges feed one queue each, which
+// the first stage drains round-robin. Stages run on the tokenizer's pool
+// as SerialTasks: scheduled when a batch arrives, and run by the producer
+// itself when its queue is full and no worker has picked them up. Each stage's busy time is recorded as
+// a MetricsRegistry stage of the same name. Without streaming stages this is
+// plain tokenize_file().
+PipelineResult run_pipeline(const std::string& path, FileFormat fmt, const TokenizeOptions& tok,
+                            const PipelineOptions& opts, MetricsRegistry& metrics);
+
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ts {
+
+// HTTP content codings written next to report artifacts at write time
+// (report.html -> report.html.br / .zst / .gz) and picked by HttpServer
+// from Accept-Encoding. Order = server preference.
+enum class Encoding { Brotli, Zstd, Gzip };
+
+inline constexpr Encoding kAllEncodings[] = {Encoding::Brotli, Encoding::Zstd, Encoding::Gzip};
+
+const char* encoding_name(Encoding e);   // br | zstd | gzip
+const char* encoding_suffix(Encoding e); // .br | .zst | .gz
+std::optional<Encoding> parse_encoding(std::string_view name);
+// False when the codec was not compiled in (TS_HAVE_BROTLI/ZSTD/ZLIB).
+bool encoding_available(Encoding e);
+
+// Codings in an Accept-Encoding header, best first: by q-value, then in
+// server preference order. "*" stands for codings not named; q=0 refuses.
+std::vector<Encoding> accepted_encodings(std::string_view accept_encoding);
+
+// One-shot compression at the fixed artifact levels (brotli 9, zstd 12,
+// gzip 9). False with err_out if the codec is missing or fails.
+bool compress_buffer(Encoding e, std::string_view in, std::string& out,
+                     std::string* err_out = nullptr);
+
+// Write <path><suffix> for each available encoding in `encs` and remove
+// variants that are not listed, unavailable, or would not be smaller.
+// Outputs are memoized by content hash, so the same Vega bundle copied into
+// many reports is compressed once per process. Files below 1 KiB are left
+// alone.
+bool precompress_file(const std::string& path, const std::vector<Encoding>& encs,
+                      std::string* err_out = nullptr);
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ts {
+
+// In-memory list of the reports under an artifact root, so GET / and
+// /api/reports do not walk the directory on every hit. A report is a
+// subdirectory holding report.html; its time is that file's mtime.
+//
+// rescan() builds the list from disk; update(slug) re-stats one report
+// (the scan jobs and HttpServer's inotify watch on the root call it as
+// reports are written or their directories come and go). A directory
+// without report.html yet is kept as pending until recheck_pending() sees
+// it appear or go. Every change bumps generation(), which callers use to
+// key rendered pages. Thread-safe.
+class ReportIndex {
+public:
+  struct Entry {
+    std::string slug;
+    std::int64_t mtime_ns = 0;
+  };
+
+  enum class Sort { Name, Time };
+
+  struct Query {
+    Sort sort = Sort::Name;
+    bool desc = false;
+    std::size_t offset = 0;
+    std::size_t limit = 100;
+  };
+
+  struct Page {
+    std::vector<Entry> items;
+    std::size_t total = 0;
+    std::uint64_t generation = 0;
+  };
+
+  explicit ReportIndex(std::string root);
+  ~ReportIndex();
+  ReportIndex(const ReportIndex&) = delete;
+  ReportIndex& operator=(const ReportIndex&) = delete;
+
+  // Replace the list with what is on disk. False with err_out if the root
+  // cannot be listed (a missing root is an empty index, not an error).
+  bool rescan(std::string* err_out = nullptr);
+
+  // Rescan only if the root directory's mtime moved since the last scan
+  // (one stat; catches slugs added or removed behind our back), then
+  // recheck_pending().
+  void revalidate();
+
+  // Re-stat <root>/<slug>/report.html: add, refresh or drop the entry.
+  void update(const std::string& slug);
+  // update() every directory last seen without a report.html.
+  void recheck_pending();
+
+  Page page(const Query& q) const;
+  std::size_t size() const;
+  std::uint64_t generation() const;
+
+private:
+  struct Impl;
+  Impl* p_;
+};
+
+}
@@ -1,5 +1,8 @@
 #pragma once
+#include "typed_scanner/histogram.hpp"
+#include "typed_scanner/json_writer.hpp"
 #include <cstdint>
+#include <cstdio>
 #include <string>
 #include <string_view>
 #include <unordered_map>
@@ -14,6 +17,37 @@ struct RunJsonSeriesPoint {
   double allocs_per_sec = 0.0;
 };
 
+// Hardware counters accumulated over one stage (see PerfCounterGroup).
+struct RunJsonStageCounters {
+  std::string stage;
+  std::uint64_t cycles = 0;
+  std::uint64_t instructions = 0;
+  std::uint64_t branch_misses = 0;
+  std::uint64_t llc_misses = 0;
+};
+
+// Per-column summary from the policy_parse/metrics stages.
+struct RunJsonColumn {
+  std::string name;
+  std::string type;   // number|bool|date|string|null
+  std::uint64_t count = 0;
+  std::uint64_t nulls = 0;
+  std::uint64_t errors = 0;
+  double min = 0.0, max = 0.0, mean = 0.0; // numbers only
+};
+
+// How the input format/dialect was chosen (see sniff_dialect).
+struct RunJsonSniff {
+  std::string format;             // csv|jsonl
+  std::string source;             // flag|content|extension|first_line
+  double confidence = 0.0;        // of the content sniff, 0 if none ran
+  std::string delimiter = ",";    // CSV settings the scan used
+  std::string quote = "\"";
+  bool header = true;
+  bool bom = false;
+  std::string line_ending;         // lf|crlf|cr|mixed, empty if not sniffed
+};
+
 struct RunJsonPayload {
   // Top-level KPIs
   std::uint64_t rows = 0;
@@ -30,6 +64,11 @@ struct RunJsonPayload {
   // Stages and errors
   std::vector<std::pair<std::string, std::uint64_t>> stage_times;
   std::unordered_map<std::string, std::uint64_t> errors_by_field;
+  std::vector<RunJsonStageCounters> stage_counters; // empty when perf is off/unavailable
+  std::vector<RunJsonColumn> columns;               // empty without the metrics stage
+
+  // Latency distributions (p50..max + buckets) keyed by histogram name
+  std::vector<LatencySummary> latency;
 
   // Series timeline
   std::vector<RunJsonSeriesPoint> series;
@@ -39,12 +78,59 @@ struct RunJsonPayload {
   std::string content_type;
   std::string etag;
   std::uint64_t file_size = 0;
+  // Byte offset an append-only rescan resumed from (0 = full scan); rows,
+  // bytes and columns then cover the whole file, the rates only this run.
+  std::uint64_t resumed_from = 0;
+  // gzip|zstd input: bytes read from disk; `bytes` counts decoded bytes
+  // and the decode time is the "decompress" stage.
+  std::string compression = "none";
+  std::uint64_t compressed_bytes = 0;
+  RunJsonSniff sniff;
+};
+
+// The series timeline, appended while a scan runs. Points are serialized as
+// they arrive and spooled to an unlinked temp file in 64 KiB writes, so a
+// long scan does not hold its whole timeline in memory. A bounded, evenly
+// thinned copy (every 2^k-th point) is kept for report.html, and is what
+// copy_to() writes if the temp file fails after points were spilled to it.
+// Single writer; read after the sampler has stopped.
+class RunJsonSeriesSpool {
+public:
+  explicit RunJsonSeriesSpool(std::size_t max_sampled = 2000);
+  ~RunJsonSeriesSpool();
+  RunJsonSeriesSpool(const RunJsonSeriesSpool&) = delete;
+  RunJsonSeriesSpool& operator=(const RunJsonSeriesSpool&) = delete;
+
+  void append(const RunJsonSeriesPoint& pt);
+  std::size_t size() const noexcept { return count_; }
+  const std::vector<RunJsonSeriesPoint>& sampled() const noexcept { return sampled_; }
+
+  // Splice every point, comma-separated, into w's open array (the sampled
+  // copy if spilled points were lost).
+  bool copy_to(JsonWriter& w);
+
+private:
+  void spill();
+  void lose();
+
+  std::FILE* file_ = nullptr; // null: tmpfile() failed, text stays in buf_
+  std::string buf_;
+  std::uint64_t spilled_ = 0; // bytes handed to file_
+  bool lost_ = false;         // file_ failed after a spill
+  std::size_t count_ = 0;
+  std::size_t max_sampled_;
+  std::size_t stride_ = 1;
+  std::vector<RunJsonSeriesPoint> sampled_;
 };
 
 class RunJsonWriter {
 public:
-  // Serialize payload to pretty JSON string.
+  // Serialize payload to a JSON string.
   static std::string to_json(const RunJsonPayload& p);
+  // Stream payload into w; with a spool, "series" comes from it instead of
+  // p.series.
+  static void write(JsonWriter& w, const RunJsonPayload& p,
+                    RunJsonSeriesSpool* series = nullptr);
 };
 
 }
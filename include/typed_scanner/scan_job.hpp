@@ -0,0 +1,92 @@
+#pragma once
+#include "typed_scanner/artifact_writer.hpp"
+#include "typed_scanner/fingerprint.hpp"
+#include "typed_scanner/path_utils.hpp"
+#include "typed_scanner/pipeline.hpp"
+#include "typed_scanner/tokenize.hpp"
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace ts {
+
+class EtagState;
+
+// [sync]: whether an input is (re)built, decided by comparing its
+// fingerprint with the etag recorded after its last successful scan.
+struct SyncOptions {
+  EtagState* etags = nullptr;   // null = always scan, no fingerprint
+  FingerprintMode fingerprint = FingerprintMode::Xxh3;
+  bool skip_unchanged = true;   // idempotency_use_etag
+  bool build_new = true;        // on_create = build|skip
+  bool rebuild_changed = true;  // on_update = rebuild|skip
+  // resume_appends: keep <slug>/checkpoint.txt and, when the input only grew
+  // since, tokenize just the new lines and merge them into the last totals.
+  // A resumed scan stops at the last newline.
+  bool resume_appends = false;
+};
+
+struct ScanOptions {
+  std::string artifact_root = "artifacts/typed-scanner";
+  std::string slug_mode = "hashprefix"; // hashprefix|basename|keypath
+  int slug_len = 8;
+  // With tracing on, write this file's events (tagged with its scan id,
+  // see trace::ScanTag) to <slug>/trace.json when it is done.
+  bool write_trace = true;
+  // --format: overrides the extension and the sniff. Unset, streams ("-",
+  // pipes) are sniffed from their first line, and files that neither sniff
+  // confidently nor have a known extension are skipped.
+  FileFormat format = FileFormat::Unknown;
+  // [csv] sniff: regular files are sniffed (sniff_file) and a confident
+  // result overrides the extension and, for CSV, the configured dialect.
+  bool sniff = true;
+  // [render] series_interval_ms: a helper thread samples throughput and RSS
+  // into run.json's "series" at this period while the file is tokenized.
+  int series_interval_ms = 250;
+  TokenizeOptions tokenize;
+  PipelineOptions pipeline;
+  SyncOptions sync;
+  ReportDirOptions report;
+  // Jobs submitted over HTTP (ScanJobs): an uploaded body is scanned from
+  // a spool file under its own slug and name, and can be cancelled.
+  std::string slug;          // non-empty: used instead of make_scan_slug(path)
+  std::string display_name;  // non-empty: run.json "filename"
+  const std::atomic<bool>* cancel = nullptr; // set: stop at the next block, write nothing
+};
+
+struct ScanResult {
+  enum class Status { Ok, Skipped, TokenizeError, WriteError, Cancelled };
+
+  std::string path;
+  std::string slug;
+  Status status = Status::Ok;
+  std::string error;
+  std::uint64_t rows = 0;
+  std::uint64_t bytes = 0;
+  double wall_ms = 0.0;
+
+  bool ok() const noexcept { return status == Status::Ok || status == Status::Skipped; }
+  // 0 ok/skipped/cancelled, 2 artifact write failed, 3 tokenizer error.
+  int exit_code() const noexcept {
+    return status == Status::WriteError ? 2 : status == Status::TokenizeError ? 3 : 0;
+  }
+};
+
+// Artifact directory name for `path` (hashprefix hashes the absolute path).
+std::string make_scan_slug(const std::string& path, const std::string& mode, int len);
+
+// Tokenize one CSV/JSONL file and write <artifact_root>/<slug>/{run.json,report.html}.
+// With sync.etags, unchanged inputs are Skipped before any tokenizing; with
+// sync.resume_appends, grown inputs are resumed from their checkpoint. A
+// new etag is only set(); the caller flush()es sync.etags after its batch.
+// Streams ("-" = stdin) are read once and never skipped or resumed.
+// Thread-safe: concurrent calls share nothing but the filesystem.
+ScanResult scan_file(const std::string& path, const ScanOptions& opts);
+
+// [sync] on_delete=delete_artifacts: remove <artifact_root>/<slug> of an
+// input that is gone and forget its etag (flushed by the caller, as after
+// scan_file). A missing directory is not an error.
+bool remove_scan_artifacts(const std::string& path, const ScanOptions& opts,
+                           std::string* err_out = nullptr);
+
+}
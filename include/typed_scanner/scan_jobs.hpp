@@ -0,0 +1,101 @@
+#pragma once
+#include "typed_scanner/scan_job.hpp"
+#include "typed_scanner/scan_scheduler.hpp"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace ts {
+
+class TaskPool;
+
+enum class ScanJobState { Queued, Running, Done, Failed, Cancelled };
+const char* scan_job_state_name(ScanJobState s) noexcept;
+
+// Snapshot of one submitted scan.
+struct ScanJobInfo {
+  std::uint64_t id = 0;
+  ScanJobState state = ScanJobState::Queued;
+  std::string name;  // the path, or the upload's name
+  std::string slug;  // report directory under the artifact root
+  std::uint64_t bytes = 0;
+  std::uint64_t rows = 0;
+  double wall_ms = 0.0;
+  std::string error;
+};
+
+// Scans submitted to a long-running process (POST /api/scans, --watch):
+// a ScanScheduler plus job ids, per-job cancel flags and a bounded history
+// of finished jobs for status polling. Every job scans with a copy of the
+// base ScanOptions, so templates, caches and the task pool stay warm
+// across jobs. The base sync.etags is flushed whenever the last queued job
+// finishes, and on shutdown().
+class ScanJobs {
+public:
+  struct Config {
+    ScanScheduler::Config scheduler;
+    // Uploaded bodies are spooled here and removed after their scan.
+    std::string upload_dir;
+    std::size_t history = 256; // finished jobs kept for get()/list()
+    // A stream job that no pool worker has picked up by then is Busy.
+    unsigned stream_start_ms = 1000;
+  };
+
+  struct Request {
+    std::string path;
+    std::string name;              // uploads: display name and slug source
+    std::uint64_t bytes = 0;       // 0 = stat the path
+    bool spooled = false;          // path is a spool file owned by the job
+    bool check_budget = true;      // false: never Busy (watcher submissions)
+    // Read end of a pipe the caller is filling; `path` names it
+    // (/dev/fd/N). The job starts at once or is Busy, never queued (a
+    // writer blocked on a full pipe cannot wait behind other files):
+    // submit() returns Ok only once a pool worker is running it. The
+    // job closes the fd when its scan returns.
+    int stream_fd = -1;
+    FileFormat format = FileFormat::Unknown; // Unknown = base options
+  };
+
+  enum class Submit { Ok, Busy, Invalid };
+
+  using ResultCallback = std::function<void(const ScanResult&)>;
+
+  // pool: executor for the scans (null = TaskPool::global()).
+  ScanJobs(Config cfg, ScanOptions base, ResultCallback on_result = {}, TaskPool* pool = nullptr);
+  ~ScanJobs(); // shutdown()
+  ScanJobs(const ScanJobs&) = delete;
+  ScanJobs& operator=(const ScanJobs&) = delete;
+
+  // Busy when the queued plus in-flight bytes would exceed
+  // max_inflight_bytes (an idle queue always admits, so one oversize file
+  // still runs alone). A spooled path is removed and a stream_fd closed
+  // when it is not accepted.
+  Submit submit(Request req, ScanJobInfo* out = nullptr, std::string* err_out = nullptr);
+  // Would a job of `bytes` be admitted right now.
+  bool admits(std::uint64_t bytes) const;
+
+  // A new 0600 spool file for an upload called `name` (its extension is
+  // kept so format and compression detection still work).
+  bool create_spool(const std::string& name, int& fd, std::string& path,
+                    std::string* err_out = nullptr) const;
+
+  bool get(std::uint64_t id, ScanJobInfo& out) const;
+  // Blocks until the job is done, failed or cancelled; false if unknown.
+  bool wait(std::uint64_t id, ScanJobInfo& out) const;
+  std::vector<ScanJobInfo> list() const; // newest first
+  // Queued jobs are dropped; running ones stop at their next block and
+  // write no report. False for unknown or finished jobs.
+  bool cancel(std::uint64_t id);
+
+  void wait_idle();
+  void shutdown(); // finishes queued work; submit() afterwards is Invalid
+
+  const ScanOptions& base_options() const noexcept;
+
+private:
+  struct Impl;
+  Impl* p_;
+};
+
+}
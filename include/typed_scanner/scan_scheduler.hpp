@@ -0,0 +1,81 @@
+#pragma once
+#include "typed_scanner/scan_job.hpp"
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace ts {
+
+class TaskPool;
+
+// Bounded multi-file scan queue ([limits] max_parallel / max_inflight_bytes).
+//
+// Pending files are ordered largest first (LPT scheduling keeps the makespan
+// short when a few big files hide among many small ones). Whenever a slot
+// frees up, the largest pending file whose size still fits the in-flight byte
+// budget is started as a TaskPool task; a file bigger than the whole budget
+// is admitted alone once nothing else is running. Results are delivered
+// through the callback as each file finishes, on the pool thread that
+// scanned it.
+class ScanScheduler {
+public:
+  struct Config {
+    unsigned max_parallel = 2;
+    std::uint64_t max_inflight_bytes = 1ull << 30; // 1 GiB
+  };
+
+  struct Stats {
+    std::uint64_t submitted = 0;
+    std::uint64_t completed = 0;
+    std::uint64_t failed = 0;
+    std::uint64_t cancelled = 0; // dropped from the queue by cancel()
+    std::uint64_t peak_inflight_bytes = 0;
+    unsigned peak_running = 0;
+  };
+
+  // Identifies one submission; never 0.
+  using Ticket = std::uint64_t;
+  using ScanFn = std::function<ScanResult(const std::string& path)>;
+  using TicketScanFn = std::function<ScanResult(const std::string& path, Ticket ticket)>;
+  using ResultCallback = std::function<void(const ScanResult&)>;
+
+  // pool: executor for the scans (null = TaskPool::global()).
+  ScanScheduler(Config cfg, ScanFn scan, ResultCallback on_result = {},
+                TaskPool* pool = nullptr);
+  ScanScheduler(Config cfg, TicketScanFn scan, ResultCallback on_result = {},
+                TaskPool* pool = nullptr);
+  ~ScanScheduler(); // shutdown(): finishes queued work
+  ScanScheduler(const ScanScheduler&) = delete;
+  ScanScheduler& operator=(const ScanScheduler&) = delete;
+
+  // Size is taken from the filesystem (0 if it cannot be stat'ed).
+  // Returns 0 once shut down.
+  Ticket submit(std::string path);
+  Ticket submit(std::string path, std::uint64_t size_bytes);
+
+  // Start at once if a slot is free and the budget admits the size (a lone
+  // file always fits); 0 otherwise, and nothing is queued. For inputs that
+  // cannot wait, such as an upload being streamed in.
+  Ticket try_start(std::string path, std::uint64_t size_bytes);
+
+  // Drop a file no pool worker has picked up yet (still pending, or started
+  // and waiting for a worker; its slot is freed at once); false once it is
+  // being scanned or done.
+  bool cancel(Ticket ticket);
+
+  // Bytes queued plus bytes being scanned.
+  std::uint64_t queued_bytes() const;
+
+  // Block until every submitted file has been scanned.
+  void wait_idle();
+  // Finish queued work; submit() afterwards is ignored.
+  void shutdown();
+
+  Stats stats() const;
+
+private:
+  struct Impl;
+  Impl* p_;
+};
+
+}
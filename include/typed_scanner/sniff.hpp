@@ -0,0 +1,41 @@
+#pragma once
+#include "typed_scanner/path_utils.hpp"
+#include "typed_scanner/token_csv_fsm.hpp"
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace ts {
+
+// What the first bytes of an input look like.
+struct Dialect {
+  FileFormat format = FileFormat::Unknown;
+  double confidence = 0.0;  // 0..1: share of sampled lines that agree
+  // CSV only
+  char delimiter = ',';     // , \t | ;
+  char quote = '"';         // " or '
+  bool header = true;
+  // Both formats
+  bool bom = false;         // UTF-8 byte order mark (dropped by ChunkReader)
+  std::string line_ending = "lf"; // lf|crlf|cr|mixed
+};
+
+constexpr std::size_t kSniffBytes = 64 * 1024;
+// Below this, content does not override the extension or the config.
+constexpr double kSniffMinConfidence = 0.6;
+
+// Sniff a decoded sample (a file's first bytes; a trailing partial line is
+// ignored unless `complete`). `fallback_header` is used when the sample
+// has a single row to judge from.
+Dialect sniff_dialect(std::string_view sample, bool complete = false, bool fallback_header = true);
+
+// Sniff the first kSniffBytes of a regular file, decoding gzip/zstd. False
+// with err_out if it cannot be read.
+bool sniff_file(const std::string& path, Dialect& out, bool fallback_header = true,
+                std::string* err_out = nullptr);
+
+// Apply a CSV dialect to `cfg` (delimiter, quote, header; the escape
+// follows a changed quote).
+void apply_dialect(const Dialect& d, CsvConfig& cfg);
+
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace ts {
+
+// Bounded single-producer/single-consumer ring (lock-free; capacity rounded
+// up to a power of two). Each side caches the other's index so the shared
+// cache lines are only touched when the ring looks full/empty.
+//
+// push()/pop() block with a yield-then-sleep backoff. close() may be called
+// by either side: the producer to signal end of stream (pop() drains what is
+// left, then returns false), the consumer to abandon it (push() returns false).
+template <class T>
+class SpscQueue {
+public:
+  explicit SpscQueue(std::size_t capacity) {
+    std::size_t cap = 2;
+    while (cap < capacity) cap <<= 1;
+    slots_.resize(cap);
+    mask_ = cap - 1;
+  }
+  SpscQueue(const SpscQueue&) = delete;
+  SpscQueue& operator=(const SpscQueue&) = delete;
+
+  // Producer. Moves from `v` only on success.
+  bool try_push(T& v) {
+    const std::size_t t = tail_.load(std::memory_order_relaxed);
+    if (t - head_cache_ > mask_) {
+      head_cache_ = head_.load(std::memory_order_acquire);
+      if (t - head_cache_ > mask_) return false;
+    }
+    slots_[t & mask_] = std::move(v);
+    tail_.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer.
+  bool try_pop(T& out) {
+    const std::size_t h = head_.load(std::memory_order_relaxed);
+    if (h == tail_cache_) {
+      tail_cache_ = tail_.load(std::memory_order_acquire);
+      if (h == tail_cache_) return false;
+    }
+    out = std::move(slots_[h & mask_]);
+    head_.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Producer: false if the queue was closed.
+  bool push(T v) {
+    for (unsigned idle = 0; !try_push(v); ) {
+      if (closed()) return false;
+      backoff(idle);
+    }
+    return true;
+  }
+
+  // Consumer: false once closed and drained.
+  bool pop(T& out) {
+    for (unsigned idle = 0; !try_pop(out); ) {
+      if (closed()) return try_pop(out); // items pushed before close()
+      backoff(idle);
+    }
+    return true;
+  }
+
+  void close() noexcept { closed_.store(true, std::memory_order_release); }
+  bool closed() const noexcept { return closed_.load(std::memory_order_acquire); }
+
+  static void backoff(unsigned& idle) {
+    if (++idle < 64) std::this_thread::yield();
+    else std::this_thread::sleep_for(std::chrono::microseconds(50));
+  }
+
+private:
+  std::vector<T> slots_;
+  std::size_t mask_ = 0;
+  alignas(64) std::atomic<std::size_t> head_{0}; // consumer-owned
+  std::size_t tail_cache_ = 0;                   // consumer's view of tail_
+  alignas(64) std::atomic<std::size_t> tail_{0}; // producer-owned
+  std::size_t head_cache_ = 0;                   // producer's view of head_
+  alignas(64) std::atomic<bool> closed_{false};
+};
+
+}
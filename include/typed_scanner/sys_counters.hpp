@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+namespace ts {
+
+// Hardware counters for one thread (perf_event_open on Linux).
+// `valid` stays false when the kernel refused the group (perf_event_paranoid,
+// seccomp'd containers, non-Linux builds), so callers can skip reporting.
+struct PerfSample {
+  std::uint64_t cycles = 0;
+  std::uint64_t instructions = 0;
+  std::uint64_t branch_misses = 0;
+  std::uint64_t llc_misses = 0;
+  bool valid = false;
+
+  double ipc() const noexcept {
+    return cycles ? static_cast<double>(instructions) / static_cast<double>(cycles) : 0.0;
+  }
+
+  PerfSample& operator+=(const PerfSample& o) noexcept;
+};
+
+PerfSample operator-(const PerfSample& end, const PerfSample& begin) noexcept;
+
+// Counter group (cycles leader + instructions, branch-misses, LLC misses)
+// bound to the thread that opened it. User-space only, so it also works at
+// perf_event_paranoid=2; members the PMU lacks (e.g. LLC in VMs) read as 0.
+class PerfCounterGroup {
+public:
+  PerfCounterGroup();
+  ~PerfCounterGroup();
+  PerfCounterGroup(const PerfCounterGroup&) = delete;
+  PerfCounterGroup& operator=(const PerfCounterGroup&) = delete;
+
+  bool available() const noexcept { return fds_[0] >= 0; }
+  const std::string& error() const noexcept { return err_; }
+
+  // Cumulative counts since open, scaled for multiplexing.
+  PerfSample read() const;
+
+  // Lazily opened group for the calling thread.
+  static PerfCounterGroup& this_thread();
+
+private:
+  static constexpr int kEvents = 4;
+  int fds_[kEvents];
+  std::uint64_t ids_[kEvents];
+  std::string err_;
+};
+
+// Process-wide opt-in; MetricsRegistry only samples counters when enabled.
+void set_perf_counters_enabled(bool on) noexcept;
+bool perf_counters_enabled() noexcept;
+
+// Resident set size of this process in MiB (/proc/self/statm); 0 where
+// unavailable.
+double resident_set_mb() noexcept;
+
+}
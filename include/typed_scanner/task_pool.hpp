@@ -0,0 +1,121 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ts {
+
+// Work-stealing thread pool shared by scanning, tokenization and rendering.
+//
+// Each worker owns a Chase-Lev deque: it pushes and pops at the bottom (LIFO,
+// cache-warm), idle workers steal from the top of a victim's deque (FIFO,
+// oldest/largest work first). Tasks submitted from outside the pool go
+// through a small locked injection queue. Idle workers sleep on a condition
+// variable, so an idle pool costs nothing.
+class TaskPool {
+public:
+  using Task = std::function<void()>;
+
+  struct Config {
+    unsigned threads = 0;      // 0 = std::thread::hardware_concurrency()
+    bool pin_threads = false;  // pin worker i to cpus[i % cpus.size()]
+    std::vector<int> cpus;     // empty = 0..hardware_concurrency-1
+  };
+
+  TaskPool();                  // default Config
+  explicit TaskPool(Config cfg);
+  ~TaskPool();                 // runs queued tasks, then joins
+  TaskPool(const TaskPool&) = delete;
+  TaskPool& operator=(const TaskPool&) = delete;
+
+  // Queue a task. From a worker it lands on that worker's deque.
+  void submit(Task t);
+
+  // Run one queued task on the calling thread, if any. Used by waiters to
+  // help instead of blocking (keeps nested waits deadlock-free).
+  bool try_run_one();
+
+  unsigned size() const noexcept;
+
+  // Index of the calling worker in this pool, or -1.
+  int worker_index() const noexcept;
+
+  // Process-wide pool. configure_global() only has an effect before the
+  // first global() call (e.g. from --threads / [scanner] reader_threads).
+  static TaskPool& global();
+  static void configure_global(Config cfg);
+
+private:
+  struct Impl;
+  Impl* p_;
+};
+
+// Fork/join scope over a pool: run() tasks, then wait() for all of them.
+// wait() runs the group's own tasks that no worker has started yet, oldest
+// first, and otherwise blocks, so it is safe on a worker and never picks up
+// unrelated pool work (another scan) onto the waiter's stack. Workers also
+// steal oldest first, so a started task never waits on an earlier one that
+// nobody has started. run() may be called from any thread, including the
+// group's own tasks.
+class TaskGroup {
+public:
+  explicit TaskGroup(TaskPool& pool) : pool_(pool) {}
+  ~TaskGroup() { wait(); }
+  TaskGroup(const TaskGroup&) = delete;
+  TaskGroup& operator=(const TaskGroup&) = delete;
+
+  void run(TaskPool::Task t);
+  void wait();
+
+private:
+  struct Item;
+  void execute(Item& it);
+
+  TaskPool& pool_;
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::deque<std::shared_ptr<Item>> unstarted_; // may still hold items a worker took
+  std::size_t prune_at_ = 64;
+  std::size_t pending_ = 0;
+};
+
+// Resumable work on a TaskGroup that never runs on two threads at once:
+// body() does what it can without blocking and returns true once it is
+// finished for good. schedule() makes sure body runs again after the call
+// (as a group task, or as a rerun of the current pass). A thread that waits
+// on its progress calls help() instead of sleeping, so the work never
+// needs a free worker to move. The group must be waited on before the
+// SerialTask is destroyed.
+class SerialTask {
+public:
+  SerialTask(TaskGroup& group, std::function<bool()> body)
+    : group_(group), body_(std::move(body)) {}
+  SerialTask(const SerialTask&) = delete;
+  SerialTask& operator=(const SerialTask&) = delete;
+
+  void schedule();
+  // Run one pass on this thread if no other thread is running it (a rerun
+  // it asks for is handed back to the pool). False while it runs elsewhere.
+  bool help();
+  bool finished() const noexcept { return state_.load(std::memory_order_acquire) == kDone; }
+
+private:
+  enum : int { kIdle, kQueued, kRunning, kAgain, kDone };
+  void submit();
+  void run(bool hand_off);
+
+  TaskGroup& group_;
+  std::function<bool()> body_;
+  std::atomic<int> state_{kIdle};
+};
+
+// Run fn(i) for i in [0, n) on the pool and wait.
+void parallel_for(TaskPool& pool, std::size_t n, const std::function<void(std::size_t)>& fn);
+
+}
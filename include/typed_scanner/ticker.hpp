@@ -0,0 +1,33 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+namespace ts {
+
+// Periodic callbacks run by one process-wide thread (started on first
+// use), so N concurrent scans sample their progress without N sleeping
+// threads. Callbacks share that thread: they must be short and must not
+// block or call cancel().
+class Ticker {
+public:
+  using Id = std::uint64_t;
+
+  static Ticker& global();
+
+  // Call fn every `period` (first call one period from now) until cancel().
+  Id every(std::chrono::milliseconds period, std::function<void()> fn);
+  // Once this returns, fn is not running and never runs again.
+  void cancel(Id id);
+
+  ~Ticker();
+  Ticker(const Ticker&) = delete;
+  Ticker& operator=(const Ticker&) = delete;
+
+private:
+  Ticker();
+  struct Impl;
+  Impl* p_;
+};
+
+}
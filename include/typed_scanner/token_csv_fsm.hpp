@@ -13,6 +13,7 @@ struct RecordView;
 struct CsvConfig {
   char delimiter = ',';
   char quote     = '"';
+  char escape    = '"';  // == quote: RFC 4180 doubling; else escapes the next char
   bool header    = true;
 };
 
@@ -21,9 +21,13 @@ public:
   using RecordCallback = std::function<void(const RecordView&)>;
 
   JsonlTokenizer(const JsonlConfig& cfg, Arena& header_arena, Arena& row_arena);
+  ~JsonlTokenizer();
   bool feed_line(std::string_view line, const RecordCallback& on_record);
 
   const std::vector<std::string_view>& header() const;
+  // Seed the column order (copied into the header arena), e.g. from the
+  // first line of the file when tokenizing a byte range in parallel.
+  void set_header(const std::vector<std::string_view>& keys);
   const std::string& error() const { return err_; }
 
 private:
@@ -0,0 +1,69 @@
+#pragma once
+#include "typed_scanner/chunk_reader.hpp"
+#include "typed_scanner/path_utils.hpp"
+#include "typed_scanner/token_csv_fsm.hpp"
+#include "typed_scanner/token_jsonl_simdjson.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace ts {
+
+class MetricsRegistry;
+class TaskPool;
+class RecordView;
+
+struct TokenizeOptions {
+  // reader.begin_offset/end_offset (both line-aligned) limit the scan to the
+  // lines starting in that window; ranges split the window instead.
+  ChunkReader::Config reader;
+  CsvConfig csv;
+  JsonlConfig jsonl;
+  std::size_t arena_bytes = 16u << 20; // row arena per range
+  // Split files into newline-aligned byte ranges tokenized on `pool`
+  // (null = calling thread only). Ranges are at least min_range_bytes.
+  TaskPool* pool = nullptr;
+  std::uint64_t min_range_bytes = 8ull << 20; // 8 MiB
+  unsigned max_ranges = 0;                    // 0 = pool->size()
+};
+
+struct TokenizeStats {
+  bool ok = true;
+  std::string error;
+  std::uint64_t rows = 0;
+  std::uint64_t fields = 0;
+  std::uint64_t bytes = 0;      // decoded input bytes
+  std::uint64_t raw_bytes = 0;  // bytes read from disk (== bytes unless compressed)
+  Compression compression = Compression::None;
+  FileFormat format = FileFormat::Unknown; // as tokenized (sniffed for streams)
+  std::uint64_t decompress_ns = 0; // on the reader's decode thread
+  unsigned ranges = 0;
+};
+
+// Receives records as they are tokenized. Calls for one range come from a
+// single thread, in file order; the views die when record() returns.
+class TokenizeSink {
+public:
+  virtual ~TokenizeSink() = default;
+  virtual void begin(unsigned ranges) { (void)ranges; } // before any range starts
+  virtual void record(unsigned range, const RecordView& rv) = 0;
+  virtual void end_range(unsigned range) { (void)range; } // also after errors
+  // Set once the sink wants no more records: every range stops reading at
+  // its next block (ChunkReader::Config::stop).
+  virtual const std::atomic<bool>* stop_flag() const { return nullptr; }
+};
+
+// Tokenize a CSV/JSONL file (optionally gzip/zstd), handing records to
+// `sink` (null = discard). Compressed files are read as one range unless
+// index_frames() finds BGZF blocks / zstd frames, which ranges then follow.
+// A stream (see is_stream_path) is one range read front to back, and with
+// fmt Unknown its format is sniffed from the first non-blank line.
+// Ranges that do not start at byte 0 get the header primed from line 1. With `metrics`,
+// rows are counted there and the chunk/record latency histograms are merged
+// in on the calling thread, and decode time lands in the "decompress" stage.
+TokenizeStats tokenize_file(const std::string& path, FileFormat fmt,
+                            const TokenizeOptions& opts, MetricsRegistry* metrics = nullptr,
+                            TokenizeSink* sink = nullptr);
+
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Lightweight timeline tracing, exported as Chrome trace-event JSON
+// (chrome://tracing, ui.perfetto.dev).
+//
+//   TS_TRACE_SCOPE("tokenize");        // coarse: per chunk / file / render
+//   TS_TRACE_SCOPE_FINE("csv.feed");   // fine: per record, opt-in separately
+//
+// Each thread appends complete events to its own ring buffer (oldest events
+// are overwritten). When tracing is off a scope costs one relaxed load; with
+// -DTS_ENABLE_TRACE=OFF the macros compile to nothing. Scope names must be
+// string literals (only the pointer is stored).
+//
+// Events carry the scan id of the thread that emitted them (ScanTag; pool
+// tasks inherit the submitter's), so scans running side by side can each
+// write just their own events.
+
+namespace ts {
+namespace trace {
+
+enum class Level : int { Off = 0, Coarse = 1, Fine = 2 };
+
+namespace detail {
+inline std::atomic<int> g_level{0};
+
+inline std::uint64_t now_ns() noexcept {
+  return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Scan the calling thread is working for (0 = none).
+inline thread_local std::uint32_t t_scan = 0;
+
+void emit(const char* name, const char* cat, std::uint64_t t0_ns, std::uint64_t t1_ns) noexcept;
+}
+
+void set_level(Level lv) noexcept;
+inline bool enabled(Level lv = Level::Coarse) noexcept {
+  return detail::g_level.load(std::memory_order_relaxed) >= static_cast<int>(lv);
+}
+
+// Label the calling thread in the exported timeline (e.g. "worker-3").
+void set_thread_name(std::string name);
+
+class Scope {
+public:
+  Scope(const char* name, const char* cat, Level lv = Level::Coarse) noexcept
+    : name_(name), cat_(cat), t0_(enabled(lv) ? detail::now_ns() : 0) {}
+  ~Scope() { if (t0_) detail::emit(name_, cat_, t0_, detail::now_ns()); }
+  Scope(const Scope&) = delete;
+  Scope& operator=(const Scope&) = delete;
+
+private:
+  const char* name_;
+  const char* cat_;
+  std::uint64_t t0_;
+};
+
+// A fresh id for ScanTag (never 0).
+std::uint32_t new_scan_id() noexcept;
+inline std::uint32_t current_scan() noexcept { return detail::t_scan; }
+
+// Events emitted on this thread while it lives belong to `scan`.
+class ScanTag {
+public:
+  explicit ScanTag(std::uint32_t scan) noexcept : prev_(detail::t_scan) { detail::t_scan = scan; }
+  ~ScanTag() { detail::t_scan = prev_; }
+  ScanTag(const ScanTag&) = delete;
+  ScanTag& operator=(const ScanTag&) = delete;
+
+private:
+  std::uint32_t prev_;
+};
+
+// Write buffered events to `path` and drop them from the buffers: those of
+// `scan` only, or every event when scan is 0. Buffers of threads that have
+// exited are freed once drained.
+bool write_chrome_json(const std::string& path, std::string* err_out = nullptr, std::uint32_t scan = 0);
+void clear();
+
+}
+}
+
+#if defined(TS_ENABLE_TRACE) && TS_ENABLE_TRACE
+  #define TS_TRACE_CAT2_(a, b) a##b
+  #define TS_TRACE_CAT_(a, b) TS_TRACE_CAT2_(a, b)
+  #define TS_TRACE_SCOPE_CAT(name, cat) \
+    ::ts::trace::Scope TS_TRACE_CAT_(ts_trace_scope_, __LINE__)(name, cat)
+  #define TS_TRACE_SCOPE(name) TS_TRACE_SCOPE_CAT(name, "scan")
+  #define TS_TRACE_SCOPE_FINE(name) \
+    ::ts::trace::Scope TS_TRACE_CAT_(ts_trace_scope_, __LINE__)(name, "record", ::ts::trace::Level::Fine)
+#else
+  #define TS_TRACE_SCOPE_CAT(name, cat) ((void)0)
+  #define TS_TRACE_SCOPE(name) ((void)0)
+  #define TS_TRACE_SCOPE_FINE(name) ((void)0)
+#endif
@@ -1,163 +1,269 @@
+#include "typed_scanner/config.hpp"
+#include "typed_scanner/dir_watcher.hpp"
+#include "typed_scanner/etag_state.hpp"
 #include "typed_scanner/http_server.hpp"
 #include "typed_scanner/path_utils.hpp"
-#include "typed_scanner/chunk_reader.hpp"
-#include "typed_scanner/token_csv_fsm.hpp"
-#include "typed_scanner/token_jsonl_simdjson.hpp"
-#include "typed_scanner/arena.hpp"
-#include "typed_scanner/run_json.hpp"
-#include "typed_scanner/artifact_writer.hpp"
-#include "typed_scanner/record_view.hpp"
-
-#include <chrono>
+#include "typed_scanner/scan_job.hpp"
+#include "typed_scanner/scan_jobs.hpp"
+#include "typed_scanner/scan_scheduler.hpp"
+#include "typed_scanner/sys_counters.hpp"
+#include "typed_scanner/task_pool.hpp"
+#include "typed_scanner/trace.hpp"
+
+#include <algorithm>
+#include <cstdint>
 #include <filesystem>
 #include <iostream>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <vector>
 
 namespace {
 
+// Flags left unset keep the value from the config files.
 struct Cli {
-  int port = 8080;
-  std::string artifact_root = "artifacts/typed-scanner";
-  std::string slug_mode = "hashprefix"; // hashprefix|basename|keypath
-  int slug_len = 8;
+  std::string config_path;   // default: configs/config.toml if present
+  std::string pipeline_path; // default: pipeline.toml next to the config
+  std::vector<std::string> overrides; // --set section.key=value
+  std::optional<int> port;
+  std::optional<std::string> artifact_root;
+  std::optional<std::string> slug_mode; // hashprefix|basename|keypath
+  std::optional<int> slug_len;
   bool scan_samples = false;
   bool serve_only = false;
-  std::vector<std::string> scans; // explicit file paths
+  bool perf = false; // sample hardware counters per stage
+  bool force = false; // full rebuild: ignore unchanged etags and checkpoints
+  ts::trace::Level trace = ts::trace::Level::Off; // write <slug>/trace.json
+  std::optional<int> max_parallel;                 // [limits]
+  std::optional<int> threads; // task pool size ([scanner] reader_threads); 0 = all cores
+  bool pin_threads = false;
+  std::optional<std::uint64_t> max_inflight_bytes;
+  std::vector<std::string> scans; // explicit file paths; "-" = stdin
+  std::optional<std::string> format; // --format=csv|jsonl (else extension / sniffed)
+  std::optional<std::string> watch_dir; // --watch=DIR: scan on change while serving
 };
 
 Cli parse_cli(int argc, char** argv) {
   Cli c;
   for (int i = 1; i < argc; ++i) {
     std::string a(argv[i]);
-    auto eat = [&](const char* pfx, std::string* out){
+    auto eat = [&](const char* pfx, auto* out){
       if (a.rfind(pfx, 0) == 0) { *out = a.substr(std::string(pfx).size()); return true; }
       return false;
     };
-    auto eat_i = [&](const char* pfx, int* out){
+    auto eat_i = [&](const char* pfx, std::optional<int>* out){
       if (a.rfind(pfx, 0) == 0) { *out = std::stoi(a.substr(std::string(pfx).size())); return true; }
       return false;
     };
+    if (eat("--config=", &c.config_path)) continue;
+    if (eat("--pipeline=", &c.pipeline_path)) continue;
+    if (a == "--set" && i+1 < argc) { c.overrides.push_back(argv[++i]); continue; }
+    if (a.rfind("--set=",0)==0) { c.overrides.push_back(a.substr(6)); continue; }
     if (eat_i("--port=", &c.port)) continue;
     if (eat("--artifact-root=", &c.artifact_root)) continue;
     if (eat("--slug-mode=", &c.slug_mode)) continue;
     if (eat_i("--slug-len=", &c.slug_len)) continue;
+    if (eat_i("--max-parallel=", &c.max_parallel)) continue;
+    if (eat_i("--threads=", &c.threads)) continue;
+    if (a == "--pin-threads")  { c.pin_threads  = true; continue; }
+    if (a.rfind("--max-inflight-bytes=", 0) == 0) {
+      c.max_inflight_bytes = std::stoull(a.substr(21));
+      continue;
+    }
     if (a == "--scan-samples") { c.scan_samples = true; continue; }
     if (a == "--serve-only")   { c.serve_only   = true; continue; }
+    if (a == "--perf")         { c.perf         = true; continue; }
+    if (a == "--force")        { c.force        = true; continue; }
+    if (a == "--trace")        { c.trace = ts::trace::Level::Coarse; continue; }
+    if (a == "--trace=fine")   { c.trace = ts::trace::Level::Fine;   continue; }
     if (a == "--scan" && i+1 < argc) { c.scans.push_back(argv[++i]); continue; }
     if (a.rfind("--scan=",0)==0) { c.scans.push_back(a.substr(7)); continue; }
+    if (eat("--watch=", &c.watch_dir)) continue;
+    if (eat("--format=", &c.format)) continue;
     if (a == "-h" || a == "--help") {
       std::cout <<
-        "Usage: typed-scanner [--port=N] [--artifact-root=DIR]\n"
+        "Usage: typed-scanner [--config=FILE] [--pipeline=FILE] [--set section.key=value]...\n"
+        "                     [--port=N] [--artifact-root=DIR]\n"
         "                     [--slug-mode=hashprefix|basename|keypath] [--slug-len=N]\n"
-        "                     [--scan <file>|--scan=<file>] [--scan-samples] [--serve-only]\n";
+        "                     [--scan <file>|--scan=<file>|--scan=-] [--format=csv|jsonl]\n"
+        "                     [--scan-samples] [--serve-only]\n"
+        "                     [--watch=DIR]\n"
+        "                     [--max-parallel=N] [--max-inflight-bytes=N]\n"
+        "                     [--threads=N] [--pin-threads]\n"
+        "                     [--perf] [--trace|--trace=fine] [--force]\n";
       std::exit(0);
     }
   }
   return c;
 }
 
-std::string make_slug_for(const std::string& path, const std::string& mode, int len) {
-  // For hashprefix mode, hash the full absolute path to be stable in examples.
-  std::string key = (mode == "hashprefix")
-      ? std::filesystem::weakly_canonical(std::filesystem::path(path)).string()
-      : path;
-  return ts::make_slug(key, mode, len);
+// config.toml -> pipeline.toml -> --set -> explicit flags, then validate.
+bool load_app_config(const Cli& cli, ts::AppConfig& app) {
+  namespace fs = std::filesystem;
+  std::string err;
+  std::string config_path = cli.config_path;
+  if (config_path.empty()) {
+    const fs::path def = fs::path(TS_DEFAULT_CONFIG_DIR) / "config.toml";
+    if (fs::exists(def)) config_path = def.string();
+  }
+  std::string pipeline_path = cli.pipeline_path;
+  if (pipeline_path.empty() && !config_path.empty()) {
+    const fs::path def = fs::path(config_path).parent_path() / "pipeline.toml";
+    if (fs::exists(def)) pipeline_path = def.string();
+  }
+  for (const auto& path : {config_path, pipeline_path}) {
+    if (path.empty()) continue;
+    if (!ts::load_config_file(path, app, &err)) {
+      std::cerr << "[config] " << err << "\n";
+      return false;
+    }
+  }
+  for (const auto& o : cli.overrides) {
+    if (!ts::apply_config_override(o, app, &err)) {
+      std::cerr << "[config] " << err << "\n";
+      return false;
+    }
+  }
+
+  if (cli.port)          app.server.port = *cli.port;
+  if (cli.artifact_root) app.artifact_root = app.server.artifact_root = *cli.artifact_root;
+  if (cli.slug_mode)     app.slug_rule = *cli.slug_mode;
+  if (cli.slug_len)      app.slug_len = *cli.slug_len;
+  if (cli.threads)       app.reader_threads = static_cast<unsigned>(std::max(0, *cli.threads));
+  if (cli.max_parallel)  app.max_parallel = static_cast<unsigned>(std::max(0, *cli.max_parallel));
+  if (cli.max_inflight_bytes) app.max_inflight_bytes = *cli.max_inflight_bytes;
+
+  const auto problems = ts::validate_config(app);
+  for (const auto& p : problems) std::cerr << "[config] " << p << "\n";
+  return problems.empty();
 }
 
-int scan_one_file(const std::string& filepath,
-                  const std::string& artifact_root,
-                  const std::string& slug_mode,
-                  int slug_len) {
-  namespace ch = std::chrono;
-  const auto t0 = ch::steady_clock::now();
-
-  // --- choose format
-  ts::FileFormat fmt = ts::detect_format(filepath);
-  if (fmt == ts::FileFormat::Unknown) {
-    std::cerr << "[scan] skip unsupported: " << filepath << "\n";
-    return 0;
+void report_result(const ts::ScanResult& r) {
+  static std::mutex mu; // results arrive on scheduler workers
+  std::lock_guard<std::mutex> lk(mu);
+  switch (r.status) {
+    case ts::ScanResult::Status::Skipped:
+      std::cerr << "[scan] skip " << r.error << ": " << r.path << "\n";
+      break;
+    case ts::ScanResult::Status::WriteError:
+      std::cerr << "[scan] " << r.error << "\n";
+      break;
+    case ts::ScanResult::Status::Cancelled:
+      std::cerr << "[scan] cancelled: " << r.path << "\n";
+      break;
+    case ts::ScanResult::Status::TokenizeError:
+      std::cerr << "[scan] " << r.error << "\n";
+      [[fallthrough]];
+    case ts::ScanResult::Status::Ok:
+      std::cout << "[scan] ok: " << r.path
+                << " → artifacts/typed-scanner/" << r.slug << "/report.html\n";
+      break;
+  }
+}
+
+// Scan settings from the config. [sync] state is loaded into `etags` when
+// any of its rules needs it.
+ts::ScanOptions make_scan_options(const Cli& cli, ts::AppConfig& app, ts::EtagState& etags) {
+  ts::ScanOptions opts;
+  opts.artifact_root = app.artifact_root;
+  opts.slug_mode = app.slug_rule;
+  opts.slug_len = app.slug_len;
+  if (cli.format) opts.format = ts::parse_format(*cli.format);
+  opts.sniff = app.csv_sniff;
+  opts.report.precompress.clear();
+  for (const auto& e : app.precompress) {
+    if (auto enc = ts::parse_encoding(e)) opts.report.precompress.push_back(*enc);
   }
+  opts.series_interval_ms = app.series_interval_ms;
+  opts.tokenize.reader = app.reader;
+  opts.tokenize.csv = app.csv;
+  opts.tokenize.jsonl = app.jsonl;
+  opts.tokenize.arena_bytes = app.arena_bytes;
+  opts.tokenize.pool = &ts::TaskPool::global(); // big files split into ranges
+  opts.pipeline.stages = app.stages;
+  opts.pipeline.policy = app.parse_policy();
+
+  // [sync]: etags of the last successful builds live next to the reports.
+  if (app.idempotency_use_etag || app.on_create == "skip" || app.on_update == "skip") {
+    std::string err;
+    if (!etags.load((std::filesystem::path(app.artifact_root) / ".etags").string(), &err)) {
+      std::cerr << "[sync] " << err << " (starting empty)\n";
+    }
+    opts.sync.etags = &etags;
+    (void)ts::parse_fingerprint_mode(app.fingerprint, opts.sync.fingerprint);
+    opts.sync.skip_unchanged = app.idempotency_use_etag && !cli.force;
+    opts.sync.build_new = app.on_create == "build";
+    opts.sync.rebuild_changed = app.on_update == "rebuild";
+  }
+  opts.sync.resume_appends = app.resume_appends && !cli.force;
+  return opts;
+}
 
-  // --- arenas
-  ts::Arena header_arena(64 * 1024);
-  ts::Arena row_arena(16 * 1024 * 1024);
-
-  // --- reader
-  ts::ChunkReader::Config rcfg;
-  ts::ChunkReader reader(filepath, rcfg);
-
-  // --- counters/series
-  std::uint64_t rows = 0;
-  std::uint64_t fields_total = 0;
-
-  // record callback (counts rows/fields and resets row arena periodically)
-  auto on_record = [&](const ts::RecordView& rv){
-    ++rows;
-    if (rv.fields()) fields_total += rv.fields()->size();
-    if ((rows % 10000) == 0) row_arena.reset();
-  };
-
-  // --- tokenize
-  bool ok = true;
-  if (fmt == ts::FileFormat::CSV) {
-    ts::CsvConfig ccfg; // header=true default
-    ts::CsvFsm csv(ccfg, header_arena, row_arena);
-    ok = reader.for_each_line([&](std::string_view line){ ok &= csv.feed(line, on_record); });
-    ok &= csv.finish(on_record);
-    if (!ok) std::cerr << "[scan] CSV error: " << csv.error() << "\n";
-  } else if (fmt == ts::FileFormat::JSONL) {
-    ts::JsonlConfig jcfg; // strict=true; keys interned
-    ts::JsonlTokenizer jtok(jcfg, header_arena, row_arena);
-    ok = reader.for_each_line([&](std::string_view line){ ok &= jtok.feed_line(line, on_record); });
-    if (!ok) std::cerr << "[scan] JSONL error: " << jtok.error() << "\n";
-  }
-
-  const auto t1 = ch::steady_clock::now();
-  const double wall_ms = ch::duration<double, std::milli>(t1 - t0).count();
-
-  const std::uint64_t bytes = reader.bytes_read();
-  const double mb = bytes / (1024.0 * 1024.0);
-  const double sec = wall_ms / 1000.0;
-  const double throughput_mb_s = sec > 0.0 ? (mb / sec) : 0.0;
-  const double rows_per_s = sec > 0.0 ? (rows / sec) : 0.0;
-
-  // --- run.json payload (fill what we have; rest can be zero/empty)
-  ts::RunJsonPayload p{};
-  p.rows = rows;
-  p.bytes = bytes;
-  p.wall_time_ms = wall_ms;
-  p.throughput_mb_s = throughput_mb_s;
-  p.tokens_per_sec = rows_per_s;           // treat "tokens" ~ rows for MVP
-  p.allocs_per_sec = 0.0;                  // not measured here
-  p.p50_ms = 0.0; p.p95_ms = 0.0;          // not measured here
-
-  p.filename = filepath;
-  p.content_type = (fmt == ts::FileFormat::CSV) ? "text/csv" : "application/x-ndjson";
-  p.etag = ""; // optional; can add later
-  std::error_code fec;
-  p.file_size = std::filesystem::file_size(filepath, fec);
-
-  // can also add stage_times, errors_by_field, series if you have them
-
-  std::string run_json = ts::RunJsonWriter::to_json(p);
-
-  // --- write artifacts
-  const std::string slug = make_slug_for(filepath, slug_mode, slug_len);
+ts::ScanScheduler::Config scheduler_config(const ts::AppConfig& app) {
+  ts::ScanScheduler::Config scfg;
+  scfg.max_parallel = app.max_parallel;
+  scfg.max_inflight_bytes = app.max_inflight_bytes;
+  return scfg;
+}
+
+ts::ScanJobs::Config jobs_config(const ts::AppConfig& app) {
+  ts::ScanJobs::Config jcfg;
+  jcfg.scheduler = scheduler_config(app);
+  return jcfg;
+}
+
+// --watch=DIR: files under DIR are scanned as they settle and the server
+// keeps running in this process, taking POST /api/scans through the same
+// queue. Returns the server's exit code.
+int run_watch(const Cli& cli, ts::AppConfig& app) {
+  ts::EtagState etags;
+  const ts::ScanOptions opts = make_scan_options(cli, app, etags);
+  ts::HttpServer server(app.server);
+  ts::ScanJobs jobs(jobs_config(app), opts, [&](const ts::ScanResult& r){
+    report_result(r);
+    if (!r.slug.empty()) server.report_updated(r.slug);
+  });
+  server.attach_jobs(&jobs);
+
+  ts::DirWatcher::Config wcfg;
+  wcfg.root = *cli.watch_dir;
+  wcfg.include = app.include;
+  wcfg.exclude = app.exclude;
+  wcfg.debounce_ms = app.watch_debounce_ms;
+  ts::DirWatcher watcher(wcfg, [&](const std::string& path, ts::DirWatcher::Event ev){
+    if (ev == ts::DirWatcher::Event::Changed) {
+      ts::ScanJobs::Request r;
+      r.path = path;
+      r.check_budget = false; // the watcher cannot retry; it just queues
+      (void)jobs.submit(std::move(r));
+      return;
+    }
+    if (app.on_delete != "delete_artifacts") return;
+    std::string err;
+    if (ts::remove_scan_artifacts(path, opts, &err)) std::cout << "[watch] deleted: " << path << "\n";
+    else std::cerr << "[watch] " << err << "\n";
+    server.report_updated(ts::make_scan_slug(path, opts.slug_mode, opts.slug_len));
+  }, [&]{
+    // Deletions forget their etags here; scans flush when the queue drains.
+    std::string err;
+    if (!etags.flush(&err)) std::cerr << "[sync] " << err << "\n";
+  });
   std::string err;
-  if (!ts::write_report_dir(artifact_root, slug, run_json, &err)) {
-    std::cerr << "[scan] write_report_dir failed: " << err << "\n";
+  if (!watcher.start(&err)) {
+    std::cerr << "[watch] " << err << "\n";
     return 2;
   }
+  std::cout << "[watch] watching " << wcfg.root << "\n";
 
-  std::cout << "[scan] ok: " << filepath
-            << " → artifacts/typed-scanner/" << slug << "/report.html\n";
-  return ok ? 0 : 3;
+  const int rc = server.run();
+  watcher.stop();
+  jobs.shutdown();
+  if (rc != 0) std::cerr << "Server failed to start on port " << app.server.port << "\n";
+  return rc;
 }
 
-void scan_samples_if_requested(const std::string& artifact_root,
-                               const std::string& slug_mode,
-                               int slug_len) {
+void scan_samples_if_requested(ts::ScanScheduler& sched) {
   const std::filesystem::path samples = "data/samples";
   if (!std::filesystem::exists(samples)) return;
   for (auto& e : std::filesystem::directory_iterator(samples)) {
@@ -165,7 +271,7 @@ void scan_samples_if_requested(const std::string& artifact_root,
     const std::string path = e.path().string();
     auto fmt = ts::detect_format(path);
     if (fmt == ts::FileFormat::Unknown) continue;
-    (void)scan_one_file(path, artifact_root, slug_mode, slug_len);
+    sched.submit(path);
   }
 }
 
@@ -173,19 +279,65 @@ void scan_samples_if_requested(const std::string& artifact_root,
 
 int main(int argc, char** argv) {
   auto cli = parse_cli(argc, argv);
+  ts::AppConfig app;
+  if (!load_app_config(cli, app)) return 2;
+  if (cli.format && ts::parse_format(*cli.format) == ts::FileFormat::Unknown) {
+    std::cerr << "[config] --format must be csv or jsonl, got '" << *cli.format << "'\n";
+    return 2;
+  }
+
+  if (cli.perf) {
+    ts::set_perf_counters_enabled(true);
+    const auto& grp = ts::PerfCounterGroup::this_thread();
+    if (!grp.available()) {
+      std::cerr << "[perf] hardware counters unavailable: " << grp.error() << "\n";
+    }
+  }
+
+  if (cli.trace != ts::trace::Level::Off) {
+    ts::trace::set_level(cli.trace);
+    ts::trace::set_thread_name("main");
+  }
+
+  {
+    ts::TaskPool::Config pcfg;
+    pcfg.threads = app.reader_threads;
+    pcfg.pin_threads = cli.pin_threads;
+    ts::TaskPool::configure_global(pcfg);
+  }
+
+  if (cli.watch_dir) return run_watch(cli, app);
 
   bool did_any_scan = false;
 
-  if (!cli.serve_only) {
+  if (!cli.serve_only && (!cli.scans.empty() || cli.scan_samples)) {
+    ts::EtagState etags;
+    const ts::ScanOptions opts = make_scan_options(cli, app, etags);
+    ts::ScanScheduler sched(scheduler_config(app),
+        [&](const std::string& path){ return ts::scan_file(path, opts); },
+        report_result);
+
     // explicit scans
     for (const auto& f : cli.scans) {
       did_any_scan = true;
-      (void)scan_one_file(f, cli.artifact_root, cli.slug_mode, cli.slug_len);
+      sched.submit(f);
     }
     // sample bundle
     if (cli.scan_samples) {
       did_any_scan = true;
-      scan_samples_if_requested(cli.artifact_root, cli.slug_mode, cli.slug_len);
+      scan_samples_if_requested(sched);
+    }
+    sched.wait_idle();
+    std::string serr;
+    if (!etags.flush(&serr)) std::cerr << "[sync] " << serr << "\n";
+
+    // Whatever no scan claimed (main thread, idle workers).
+    if (cli.trace != ts::trace::Level::Off) {
+      const auto trace_path = std::filesystem::path(app.artifact_root) / "trace.json";
+      std::string err;
+      if (!ts::trace::write_chrome_json(trace_path.string(), &err)) {
+        std::cerr << "[trace] " << err << "\n";
+      }
     }
   }
 
@@ -194,13 +346,15 @@ int main(int argc, char** argv) {
     return 0;
   }
 
-  ts::HttpServer::Config cfg;
-  cfg.port = cli.port;
-  cfg.artifact_root = cli.artifact_root;
-  cfg.index_title = "Typed Scanner Reports";
-  cfg.scan_per_request = true;
-
+  // Serve mode: a warm scanner for POST /api/scans.
+  const ts::HttpServer::Config& cfg = app.server;
+  ts::EtagState etags;
   ts::HttpServer server(cfg);
+  ts::ScanJobs jobs(jobs_config(app), make_scan_options(cli, app, etags), [&](const ts::ScanResult& r){
+    report_result(r);
+    if (!r.slug.empty()) server.report_updated(r.slug);
+  });
+  server.attach_jobs(&jobs);
   int rc = server.run();
   if (rc != 0) {
     std::cerr << "Server failed to start on port " << cfg.port << "\n";
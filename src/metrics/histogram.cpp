@@ -0,0 +1,83 @@
+#include "typed_scanner/histogram.hpp"
+#include <cmath>
+
+namespace ts {
+
+LatencyHistogram& LatencyHistogram::operator=(const LatencyHistogram& o) {
+  if (this != &o) { reset(); merge(o); }
+  return *this;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& o) noexcept {
+  for (std::size_t i = 0; i < kBuckets; ++i) {
+    const auto n = o.counts_[i].load(std::memory_order_relaxed);
+    if (n) bump(counts_[i], n);
+  }
+  bump(count_, o.count_.load(std::memory_order_relaxed));
+  bump(sum_ns_, o.sum_ns_.load(std::memory_order_relaxed));
+  const auto m = o.max_ns_.load(std::memory_order_relaxed);
+  if (m > max_ns_.load(std::memory_order_relaxed)) max_ns_.store(m, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::reset() noexcept {
+  for (auto& c : counts_) c.store(0, std::memory_order_relaxed);
+  count_.store(0, std::memory_order_relaxed);
+  sum_ns_.store(0, std::memory_order_relaxed);
+  max_ns_.store(0, std::memory_order_relaxed);
+}
+
+std::uint64_t LatencyHistogram::bucket_lower(std::size_t idx) noexcept {
+  if (idx < kSubCount) return idx;
+  const std::size_t group = idx / kSubCount;  // >= 1
+  const std::uint64_t sub = idx % kSubCount;
+  return (kSubCount + sub) << (group - 1);
+}
+
+std::uint64_t LatencyHistogram::bucket_upper(std::size_t idx) noexcept {
+  if (idx < kSubCount) return idx;
+  const std::size_t group = idx / kSubCount;
+  return bucket_lower(idx) + ((std::uint64_t{1} << (group - 1)) - 1);
+}
+
+std::uint64_t LatencyHistogram::value_at(double q) const noexcept {
+  const std::uint64_t total = count();
+  if (total == 0) return 0;
+  if (q < 0.0) q = 0.0;
+  if (q > 1.0) q = 1.0;
+  std::uint64_t rank = static_cast<std::uint64_t>(std::ceil(q * static_cast<double>(total)));
+  if (rank == 0) rank = 1;
+
+  std::uint64_t seen = 0;
+  for (std::size_t i = 0; i < kBuckets; ++i) {
+    seen += counts_[i].load(std::memory_order_relaxed);
+    if (seen >= rank) {
+      const std::uint64_t hi = bucket_upper(i);
+      const std::uint64_t mx = max_ns();
+      return (mx && hi > mx) ? mx : hi;
+    }
+  }
+  return max_ns();
+}
+
+LatencySummary LatencyHistogram::summarize(std::string name) const {
+  constexpr double kNsPerMs = 1e6;
+  LatencySummary s;
+  s.name = std::move(name);
+  s.count = count();
+  if (s.count == 0) return s;
+
+  s.p50_ms  = value_at(0.50)  / kNsPerMs;
+  s.p90_ms  = value_at(0.90)  / kNsPerMs;
+  s.p99_ms  = value_at(0.99)  / kNsPerMs;
+  s.p999_ms = value_at(0.999) / kNsPerMs;
+  s.max_ms  = max_ns() / kNsPerMs;
+  s.mean_ms = (sum_ns_.load(std::memory_order_relaxed) / static_cast<double>(s.count)) / kNsPerMs;
+
+  for (std::size_t i = 0; i < kBuckets; ++i) {
+    const auto n = counts_[i].load(std::memory_order_relaxed);
+    if (n) s.buckets.push_back({bucket_upper(i) / kNsPerMs, n});
+  }
+  return s;
+}
+
+}
@@ -1,51 +1,301 @@
 #include "typed_scanner/metrics.hpp"
 #include <algorithm>
 #include <chrono>
+#include <thread>
 
 namespace ts {
 
-void MetricsRegistry::reset() {
-  rows_ = bytes_ = 0;
-  cpu_pct_ = peak_rss_mb_ = 0.0;
-  field_errs_.clear();
-  stage_accum_ms_.clear();
-  stage_starts_.clear();
+namespace {
+
+std::atomic<std::uint64_t> g_next_registry_id{1};
+
+std::int64_t steady_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// One-entry cache of the calling thread's shard; misses go through the
+// registry mutex. Registry ids are never reused, so a stale entry is harmless.
+thread_local std::uint64_t t_cached_registry = 0;
+thread_local void* t_cached_shard = nullptr;
+
+// Identity used on the slow path to find this thread's existing shard.
+thread_local std::thread::id t_self = std::this_thread::get_id();
+
+template <class Id>
+Id intern(std::string_view name, std::vector<std::string>& names,
+          std::unordered_map<std::string, Id>& ids, std::size_t cap) {
+  std::string key(name);
+  auto it = ids.find(key);
+  if (it != ids.end()) return it->second;
+  if (names.size() >= cap) return static_cast<Id>(cap); // invalid: ignored by hot path
+  const Id id = static_cast<Id>(names.size());
+  names.push_back(key);
+  ids.emplace(std::move(key), id);
+  return id;
+}
+
+}
+
+MetricsRegistry::Shard::~Shard() {
+  for (auto& h : hist) delete h.load(std::memory_order_relaxed);
+}
+
+// stage_names_ never reallocates, so live() can read the published prefix
+// without the mutex.
+MetricsRegistry::MetricsRegistry()
+  : id_(g_next_registry_id.fetch_add(1, std::memory_order_relaxed)) {
+  stage_names_.reserve(kMaxStages);
+}
+
+MetricsRegistry::~MetricsRegistry() = default;
+
+// ---- registration ------------------------------------------------------------
+
+StageId MetricsRegistry::register_stage(std::string_view name) {
+  std::lock_guard<std::mutex> lk(mu_);
+  const StageId id = intern<StageId>(name, stage_names_, stage_ids_, kMaxStages);
+  nstages_.store(stage_names_.size(), std::memory_order_release);
+  return id;
+}
+
+CounterId MetricsRegistry::register_field_error(std::string_view field) {
+  std::lock_guard<std::mutex> lk(mu_);
+  // Keep the last slot for "(other)" so wide schemas never drop errors.
+  CounterId id = intern<CounterId>(field, counter_names_, counter_ids_, kMaxCounters - 1);
+  if (id >= kMaxCounters - 1) {
+    id = static_cast<CounterId>(kMaxCounters - 1);
+    if (counter_names_.size() < kMaxCounters) counter_names_.resize(kMaxCounters);
+    counter_names_[id] = "(other)";
+  }
+  return id;
+}
+
+HistogramId MetricsRegistry::register_histogram(std::string_view name) {
+  std::lock_guard<std::mutex> lk(mu_);
+  return intern<HistogramId>(name, hist_names_, hist_ids_, kMaxHistograms);
+}
+
+// ---- shards ------------------------------------------------------------------
+
+MetricsRegistry::Shard& MetricsRegistry::local() {
+  if (t_cached_registry == id_) return *static_cast<Shard*>(t_cached_shard);
+  Shard* s = make_shard();
+  t_cached_registry = id_;
+  t_cached_shard = s;
+  return *s;
+}
+
+MetricsRegistry::Shard* MetricsRegistry::make_shard() {
+  std::lock_guard<std::mutex> lk(mu_);
+  for (std::size_t i = 0; i < shard_owners_.size(); ++i) {
+    if (shard_owners_[i] == t_self) return shards_[i].get();
+  }
+  shards_.push_back(std::make_unique<Shard>());
+  shard_owners_.push_back(t_self);
+  Shard* s = shards_.back().get();
+  s->next = shard_head_.load(std::memory_order_relaxed);
+  shard_head_.store(s, std::memory_order_release);
+  return s;
 }
 
-void MetricsRegistry::start_stage(std::string_view name) {
-  stage_starts_[std::string(name)] = std::chrono::steady_clock::now();
+// ---- hot path ----------------------------------------------------------------
+
+void MetricsRegistry::add_field_error(CounterId id, std::uint64_t n) noexcept {
+  if (id >= kMaxCounters) return;
+  local().field_errs[id].add(n);
+}
+
+void MetricsRegistry::record_latency(HistogramId id, std::uint64_t ns) {
+  if (id >= kMaxHistograms) return;
+  Shard& s = local();
+  LatencyHistogram* h = s.hist[id].load(std::memory_order_acquire);
+  if (!h) {
+    h = new LatencyHistogram();
+    s.hist[id].store(h, std::memory_order_release);
+  }
+  h->record(ns);
+}
+
+void MetricsRegistry::start_stage(StageId id) {
+  if (id >= kMaxStages) return;
+  Shard& s = local();
+  s.stage_perf0[id] = perf_counters_enabled() ? PerfCounterGroup::this_thread().read() : PerfSample{};
+  s.stage_t0[id].store(steady_ns(), std::memory_order_relaxed);
+}
+
+void MetricsRegistry::end_stage(StageId id) {
+  if (id >= kMaxStages) return;
+  Shard& s = local();
+  const std::int64_t t0 = s.stage_t0[id].load(std::memory_order_relaxed);
+  if (t0 == 0) return; // never started
+  const std::int64_t ns = steady_ns() - t0;
+  // Closed before it is added: live() may briefly miss the span, but never
+  // counts it twice.
+  s.stage_t0[id].store(0, std::memory_order_relaxed);
+  s.stage_ns[id].add(static_cast<std::uint64_t>(ns));
+  s.stage_hits[id].add(1);
+
+  if (s.stage_perf0[id].valid) {
+    const PerfSample d = PerfCounterGroup::this_thread().read() - s.stage_perf0[id];
+    auto& p = s.stage_perf[id];
+    p.cycles.add(d.cycles);
+    p.instructions.add(d.instructions);
+    p.branch_misses.add(d.branch_misses);
+    p.llc_misses.add(d.llc_misses);
+    p.samples.add(1);
+  }
+}
+
+void MetricsRegistry::add_stage_ns(StageId id, std::uint64_t ns) {
+  if (id >= kMaxStages) return;
+  Shard& s = local();
+  s.stage_ns[id].add(ns);
+  s.stage_hits[id].add(1);
+}
+
+void MetricsRegistry::merge_latency(std::string_view name, const LatencyHistogram& h) {
+  const HistogramId id = register_histogram(name);
+  if (id >= kMaxHistograms) return;
+  Shard& s = local();
+  LatencyHistogram* dst = s.hist[id].load(std::memory_order_acquire);
+  if (!dst) {
+    dst = new LatencyHistogram();
+    s.hist[id].store(dst, std::memory_order_release);
+  }
+  dst->merge(h);
+}
+
+// ---- aggregation -------------------------------------------------------------
+
+LatencyHistogram MetricsRegistry::latency(std::string_view name) const {
+  LatencyHistogram out;
+  std::lock_guard<std::mutex> lk(mu_);
+  auto it = hist_ids_.find(std::string(name));
+  if (it == hist_ids_.end()) return out;
+  for (auto& sh : shards_) {
+    if (auto* h = sh->hist[it->second].load(std::memory_order_acquire)) out.merge(*h);
+  }
+  return out;
+}
+
+std::uint64_t MetricsRegistry::rows() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  std::uint64_t n = 0;
+  for (auto& sh : shards_) n += sh->rows.get();
+  return n;
 }
 
-void MetricsRegistry::end_stage(std::string_view name) {
-  auto key = std::string(name);
-  auto it = stage_starts_.find(key);
-  if (it == stage_starts_.end()) return;
-  auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-              std::chrono::steady_clock::now() - it->second).count();
-  stage_accum_ms_[key] += static_cast<std::uint64_t>(ms);
-  stage_starts_.erase(it);
+std::uint64_t MetricsRegistry::bytes() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  std::uint64_t n = 0;
+  for (auto& sh : shards_) n += sh->bytes.get();
+  return n;
 }
 
-void MetricsRegistry::add_field_error(std::string_view field) {
-  ++field_errs_[std::string(field)];
+MetricsRegistry::LiveTotals MetricsRegistry::live() const {
+  LiveTotals t;
+  const std::size_t nst = nstages_.load(std::memory_order_acquire);
+  std::array<std::uint64_t, kMaxStages> ns{};
+  std::array<bool, kMaxStages> seen{};
+  const std::int64_t now = steady_ns();
+  for (const Shard* sh = shard_head_.load(std::memory_order_acquire); sh; sh = sh->next) {
+    t.rows += sh->rows.get();
+    t.bytes += sh->bytes.get();
+    for (std::size_t i = 0; i < nst; ++i) {
+      ns[i] += sh->stage_ns[i].get();
+      seen[i] = seen[i] || sh->stage_hits[i].get() > 0;
+      const std::int64_t t0 = sh->stage_t0[i].load(std::memory_order_relaxed);
+      if (t0 != 0 && now > t0) {
+        ns[i] += static_cast<std::uint64_t>(now - t0);
+        seen[i] = true;
+      }
+    }
+  }
+  for (std::size_t i = 0; i < nst; ++i) {
+    if (seen[i]) t.stages.push_back(StageTiming{stage_names_[i], (ns[i] + 500000) / 1000000, {}});
+  }
+  return t;
+}
+
+void MetricsRegistry::reset() {
+  std::lock_guard<std::mutex> lk(mu_);
+  for (auto& sh : shards_) {
+    sh->rows.clear();
+    sh->bytes.clear();
+    for (std::size_t i = 0; i < kMaxStages; ++i) {
+      sh->stage_ns[i].clear();
+      sh->stage_hits[i].clear();
+      auto& p = sh->stage_perf[i];
+      p.cycles.clear(); p.instructions.clear(); p.branch_misses.clear();
+      p.llc_misses.clear(); p.samples.clear();
+      sh->stage_t0[i].store(0, std::memory_order_relaxed);
+    }
+    for (auto& c : sh->field_errs) c.clear();
+    for (auto& h : sh->hist) if (auto* p = h.load(std::memory_order_acquire)) p->reset();
+  }
+  cpu_pct_.store(0.0, std::memory_order_relaxed);
+  peak_rss_mb_.store(0.0, std::memory_order_relaxed);
+}
+
+RunStats MetricsRegistry::snapshot(double wall_ms, double tokens_per_sec,
+                                   double allocs_per_sec) const {
+  const LatencyHistogram h = latency(kLatencyChunk);
+  return snapshot(wall_ms, tokens_per_sec, allocs_per_sec,
+                  h.value_at(0.50) / 1e6, h.value_at(0.95) / 1e6);
 }
 
 RunStats MetricsRegistry::snapshot(double wall_ms, double tokens_per_sec,
                                    double allocs_per_sec, double p50_ms, double p95_ms) const {
   RunStats r;
-  r.rows = rows_;
-  r.bytes = bytes_;
   r.tokens_per_sec = tokens_per_sec;
   r.allocs_per_sec = allocs_per_sec;
   r.p50_ms = p50_ms;
   r.p95_ms = p95_ms;
-  r.cpu_pct = cpu_pct_;
-  r.peak_rss_mb = peak_rss_mb_;
-  r.throughput_mb_s = (wall_ms > 0.0) ? (bytes_ / (1024.0*1024.0)) / (wall_ms / 1000.0) : 0.0;
+  r.cpu_pct = cpu_pct_.load(std::memory_order_relaxed);
+  r.peak_rss_mb = peak_rss_mb_.load(std::memory_order_relaxed);
+
+  std::lock_guard<std::mutex> lk(mu_);
+  for (auto& sh : shards_) {
+    r.rows += sh->rows.get();
+    r.bytes += sh->bytes.get();
+  }
+  r.throughput_mb_s = (wall_ms > 0.0) ? (r.bytes / (1024.0*1024.0)) / (wall_ms / 1000.0) : 0.0;
+
+  // Stages in registration order.
+  for (StageId id = 0; id < stage_names_.size(); ++id) {
+    std::uint64_t ns = 0, hits = 0, perf_samples = 0;
+    PerfSample perf;
+    for (auto& sh : shards_) {
+      ns += sh->stage_ns[id].get();
+      hits += sh->stage_hits[id].get();
+      const auto& p = sh->stage_perf[id];
+      perf.cycles += p.cycles.get();
+      perf.instructions += p.instructions.get();
+      perf.branch_misses += p.branch_misses.get();
+      perf.llc_misses += p.llc_misses.get();
+      perf_samples += p.samples.get();
+    }
+    if (hits == 0) continue;
+    perf.valid = perf_samples > 0;
+    r.stages.push_back(StageTiming{stage_names_[id], (ns + 500000) / 1000000, perf});
+  }
+
+  for (CounterId id = 0; id < counter_names_.size(); ++id) {
+    std::uint64_t n = 0;
+    for (auto& sh : shards_) n += sh->field_errs[id].get();
+    if (n) r.errors_by_field[counter_names_[id]] += n;
+  }
 
-  r.errors_by_field = field_errs_;
-  r.stages.reserve(stage_accum_ms_.size());
-  for (auto& kv : stage_accum_ms_) r.stages.push_back(StageTiming{kv.first, kv.second});
+  for (HistogramId id = 0; id < hist_names_.size(); ++id) {
+    LatencyHistogram merged;
+    for (auto& sh : shards_) {
+      if (auto* h = sh->hist[id].load(std::memory_order_acquire)) merged.merge(*h);
+    }
+    if (merged.count()) r.latencies.push_back(merged.summarize(hist_names_[id]));
+  }
+  std::sort(r.latencies.begin(), r.latencies.end(),
+            [](const LatencySummary& a, const LatencySummary& b){ return a.name < b.name; });
   return r;
 }
 
@@ -1 +1,166 @@
-namespace { int _ts_sys_counters_placeholder = 0; }
\ No newline at end of file
+#include "typed_scanner/sys_counters.hpp"
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#if defined(__linux__)
+  #include <linux/perf_event.h>
+  #include <sys/ioctl.h>
+  #include <sys/syscall.h>
+  #include <unistd.h>
+#endif
+
+namespace ts {
+
+static std::atomic<bool> g_perf_enabled{false};
+
+void set_perf_counters_enabled(bool on) noexcept { g_perf_enabled.store(on, std::memory_order_relaxed); }
+bool perf_counters_enabled() noexcept { return g_perf_enabled.load(std::memory_order_relaxed); }
+
+PerfSample& PerfSample::operator+=(const PerfSample& o) noexcept {
+  cycles += o.cycles;
+  instructions += o.instructions;
+  branch_misses += o.branch_misses;
+  llc_misses += o.llc_misses;
+  valid = valid || o.valid;
+  return *this;
+}
+
+PerfSample operator-(const PerfSample& end, const PerfSample& begin) noexcept {
+  auto sub = [](std::uint64_t a, std::uint64_t b) { return a > b ? a - b : 0; };
+  PerfSample d;
+  d.cycles        = sub(end.cycles, begin.cycles);
+  d.instructions  = sub(end.instructions, begin.instructions);
+  d.branch_misses = sub(end.branch_misses, begin.branch_misses);
+  d.llc_misses    = sub(end.llc_misses, begin.llc_misses);
+  d.valid         = end.valid && begin.valid;
+  return d;
+}
+
+#if defined(__linux__)
+
+static int open_event(std::uint32_t type, std::uint64_t config, int group_fd) {
+  perf_event_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  attr.disabled = (group_fd < 0) ? 1 : 0; // leader starts disabled, members follow it
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID |
+                     PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  // pid=0, cpu=-1: this thread, on whatever CPU it runs.
+  return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+}
+
+static std::string paranoid_level() {
+  std::ifstream in("/proc/sys/kernel/perf_event_paranoid");
+  std::string v;
+  if (in) in >> v;
+  return v.empty() ? "?" : v;
+}
+
+PerfCounterGroup::PerfCounterGroup() {
+  for (int i = 0; i < kEvents; ++i) { fds_[i] = -1; ids_[i] = 0; }
+
+  fds_[0] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, -1);
+  if (fds_[0] < 0) {
+    err_ = std::string("perf_event_open: ") + std::strerror(errno) +
+           " (perf_event_paranoid=" + paranoid_level() + ")";
+    return;
+  }
+  fds_[1] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, fds_[0]);
+  fds_[2] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, fds_[0]);
+  fds_[3] = open_event(PERF_TYPE_HW_CACHE,
+                       PERF_COUNT_HW_CACHE_LL |
+                       (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                       (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+                       fds_[0]);
+
+  for (int i = 0; i < kEvents; ++i) {
+    if (fds_[i] < 0 || ::ioctl(fds_[i], PERF_EVENT_IOC_ID, &ids_[i]) == 0) continue;
+    if (i > 0) { ::close(fds_[i]); fds_[i] = -1; continue; }
+    // Without the leader's id no group entry can be matched: give up on
+    // the whole group (members go first, they hang off the leader).
+    err_ = std::string("PERF_EVENT_IOC_ID: ") + std::strerror(errno);
+    for (int k = kEvents - 1; k >= 0; --k) {
+      if (fds_[k] >= 0) ::close(fds_[k]);
+      fds_[k] = -1;
+      ids_[k] = 0;
+    }
+    return;
+  }
+  ::ioctl(fds_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ::ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+PerfCounterGroup::~PerfCounterGroup() {
+  for (int i = kEvents - 1; i >= 0; --i) if (fds_[i] >= 0) ::close(fds_[i]);
+}
+
+PerfSample PerfCounterGroup::read() const {
+  PerfSample s;
+  if (!available()) return s;
+
+  // { nr, time_enabled, time_running, { value, id }[nr] }
+  std::uint64_t buf[3 + 2 * kEvents];
+  const ssize_t n = ::read(fds_[0], buf, sizeof(buf));
+  if (n < static_cast<ssize_t>(3 * sizeof(std::uint64_t))) return s;
+
+  const std::uint64_t nr = buf[0];
+  const std::uint64_t enabled = buf[1];
+  const std::uint64_t running = buf[2];
+  const double scale = (running > 0 && running < enabled)
+      ? static_cast<double>(enabled) / static_cast<double>(running) : 1.0;
+
+  std::uint64_t* out[kEvents] = {&s.cycles, &s.instructions, &s.branch_misses, &s.llc_misses};
+  for (std::uint64_t k = 0; k < nr && k < static_cast<std::uint64_t>(kEvents); ++k) {
+    const std::uint64_t value = buf[3 + 2 * k];
+    const std::uint64_t id    = buf[4 + 2 * k];
+    for (int i = 0; i < kEvents; ++i) {
+      if (fds_[i] >= 0 && ids_[i] == id) {
+        *out[i] = static_cast<std::uint64_t>(static_cast<double>(value) * scale);
+        break;
+      }
+    }
+  }
+  s.valid = true;
+  return s;
+}
+
+#else
+
+PerfCounterGroup::PerfCounterGroup() {
+  for (int i = 0; i < kEvents; ++i) { fds_[i] = -1; ids_[i] = 0; }
+  err_ = "hardware counters require Linux perf_event_open";
+}
+
+PerfCounterGroup::~PerfCounterGroup() = default;
+
+PerfSample PerfCounterGroup::read() const { return {}; }
+
+#endif
+
+double resident_set_mb() noexcept {
+#if defined(__linux__)
+  std::FILE* f = std::fopen("/proc/self/statm", "r");
+  if (!f) return 0.0;
+  unsigned long size = 0, resident = 0;
+  const int n = std::fscanf(f, "%lu %lu", &size, &resident);
+  std::fclose(f);
+  if (n != 2) return 0.0;
+  return double(resident) * double(::sysconf(_SC_PAGESIZE)) / (1024.0 * 1024.0);
+#else
+  return 0.0;
+#endif
+}
+
+PerfCounterGroup& PerfCounterGroup::this_thread() {
+  thread_local PerfCounterGroup group;
+  return group;
+}
+
+}
@@ -0,0 +1,198 @@
+#include "typed_scanner/trace.hpp"
+#include "typed_scanner/path_utils.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ts {
+namespace trace {
+
+namespace {
+
+constexpr std::size_t kRingEvents = 1u << 15; // per thread, ~1 MiB
+
+struct Event {
+  const char* name;
+  const char* cat;
+  std::uint64_t t0_ns;
+  std::uint64_t t1_ns;
+  std::uint32_t scan;
+};
+
+// Per-thread ring. The owner is the only writer; the tiny spinlock is
+// uncontended except while a flush copies the ring out.
+struct ThreadBuffer {
+  std::uint32_t tid = 0;
+  std::string name;
+  std::vector<Event> ring;
+  std::uint64_t head = 0; // total events written
+  bool alive = true;      // owner thread still running
+  std::atomic_flag busy = ATOMIC_FLAG_INIT;
+
+  void lock() noexcept { while (busy.test_and_set(std::memory_order_acquire)) std::this_thread::yield(); }
+  void unlock() noexcept { busy.clear(std::memory_order_release); }
+};
+
+std::mutex g_mu; // guards g_buffers (registration + flush only)
+std::vector<std::shared_ptr<ThreadBuffer>> g_buffers;
+std::uint32_t g_next_tid = 1;
+std::atomic<std::uint32_t> g_next_scan{1};
+const std::uint64_t g_origin_ns = detail::now_ns();
+
+// Owns the thread's registration; marks the buffer dead on thread exit so
+// the next flush can free it.
+struct BufferHandle {
+  std::shared_ptr<ThreadBuffer> b;
+  BufferHandle() : b(std::make_shared<ThreadBuffer>()) {
+    b->ring.resize(kRingEvents);
+    std::lock_guard<std::mutex> lk(g_mu);
+    b->tid = g_next_tid++;
+    g_buffers.push_back(b);
+  }
+  ~BufferHandle() {
+    b->lock();
+    b->alive = false;
+    b->unlock();
+  }
+};
+
+ThreadBuffer& this_buffer() {
+  thread_local BufferHandle h;
+  return *h.b;
+}
+
+// Caller holds g_mu.
+void drop_dead_buffers() {
+  std::erase_if(g_buffers, [](const std::shared_ptr<ThreadBuffer>& b) {
+    b->lock();
+    const bool dead = !b->alive && b->head == 0;
+    b->unlock();
+    return dead;
+  });
+}
+
+void json_str(std::string& o, const std::string& s) {
+  o += '"';
+  for (char c : s) {
+    switch (c) {
+      case '\\': o += "\\\\"; break;
+      case '"':  o += "\\\""; break;
+      case '\n': o += "\\n";  break;
+      default:
+        if (static_cast<unsigned char>(c) >= 0x20) o += c;
+        break;
+    }
+  }
+  o += '"';
+}
+
+}
+
+namespace detail {
+
+void emit(const char* name, const char* cat, std::uint64_t t0_ns, std::uint64_t t1_ns) noexcept {
+  ThreadBuffer& b = this_buffer();
+  b.lock();
+  b.ring[b.head % kRingEvents] = Event{name, cat, t0_ns, t1_ns, t_scan};
+  ++b.head;
+  b.unlock();
+}
+
+}
+
+void set_level(Level lv) noexcept {
+  detail::g_level.store(static_cast<int>(lv), std::memory_order_relaxed);
+}
+
+void set_thread_name(std::string name) {
+  ThreadBuffer& b = this_buffer();
+  b.lock();
+  b.name = std::move(name);
+  b.unlock();
+}
+
+std::uint32_t new_scan_id() noexcept {
+  std::uint32_t id = g_next_scan.fetch_add(1, std::memory_order_relaxed);
+  if (id == 0) id = g_next_scan.fetch_add(1, std::memory_order_relaxed); // wrapped
+  return id;
+}
+
+void clear() {
+  std::lock_guard<std::mutex> lk(g_mu);
+  for (auto& b : g_buffers) { b->lock(); b->head = 0; b->unlock(); }
+  drop_dead_buffers();
+}
+
+bool write_chrome_json(const std::string& path, std::string* err_out, std::uint32_t scan) {
+  std::string o;
+  o.reserve(1 << 16);
+  o += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+  char num[96];
+
+  {
+    std::lock_guard<std::mutex> lk(g_mu);
+    std::vector<Event> events, kept;
+    for (auto& b : g_buffers) {
+      std::string name;
+      b->lock();
+      const std::uint64_t n = b->head < kRingEvents ? b->head : kRingEvents;
+      events.clear();
+      kept.clear();
+      events.reserve(n);
+      for (std::uint64_t i = b->head - n; i < b->head; ++i) {
+        const Event& e = b->ring[i % kRingEvents];
+        (scan == 0 || e.scan == scan ? events : kept).push_back(e);
+      }
+      // Other scans' events stay, compacted to the front in order.
+      std::copy(kept.begin(), kept.end(), b->ring.begin());
+      b->head = kept.size();
+      name = b->name;
+      b->unlock();
+      if (events.empty()) continue;
+
+      if (!name.empty()) {
+        if (!first) o += ',';
+        first = false;
+        std::snprintf(num, sizeof(num), "%u", b->tid);
+        o += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":";
+        o += num;
+        o += ",\"args\":{\"name\":";
+        json_str(o, name);
+        o += "}}";
+      }
+
+      for (const auto& e : events) {
+        if (!first) o += ',';
+        first = false;
+        const double ts  = (e.t0_ns >= g_origin_ns ? e.t0_ns - g_origin_ns : 0) / 1000.0;
+        const double dur = (e.t1_ns - e.t0_ns) / 1000.0;
+        o += "{\"name\":";
+        json_str(o, e.name);
+        o += ",\"cat\":";
+        json_str(o, e.cat);
+        std::snprintf(num, sizeof(num), ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+                      ts, dur, b->tid);
+        o += num;
+      }
+    }
+    drop_dead_buffers();
+  }
+  o += "]}";
+
+  const std::filesystem::path p(path);
+  if (!ensure_parent_dirs(p)) { if (err_out) *err_out = "mkdir -p failed: " + path; return false; }
+  std::ofstream out(p, std::ios::binary);
+  if (!out) { if (err_out) *err_out = "write failed: " + path; return false; }
+  out.write(o.data(), static_cast<std::streamsize>(o.size()));
+  return static_cast<bool>(out);
+}
+
+}
+}
@@ -44,6 +44,10 @@ std::optional<bool> ParsePolicy::parse_bool(std::string_view s) const {
 
 // Minimal null heuristic: empty string or explicit tokens in bool policy's sets
 bool ParsePolicy::is_null_token(std::string_view s) const {
+  if (null_tokens) {
+    for (const auto& n : *null_tokens) if (s == n) return true;
+    return false;
+  }
   if (s.empty()) return true;
   static constexpr std::string_view nulls[] = {"null","NULL","NaN","","NA"};
   for (auto n : nulls) if (s == n) return true;
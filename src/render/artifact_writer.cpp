@@ -1,52 +1,139 @@
 #include "typed_scanner/artifact_writer.hpp"
+#include "typed_scanner/asset_store.hpp"
 #include "typed_scanner/mustache_renderer.hpp"
 #include "typed_scanner/path_utils.hpp"
+#include "typed_scanner/trace.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
 #include <filesystem>
 #include <fstream>
+#include <iostream>
+#include <unistd.h>
 
 namespace ts {
 
+// Renderer for report.mustache with the CSS/JS published to the shared
+// store; `shared` is false when the store could not be written.
+static MustacheRenderer::Config report_renderer_config(const std::string& artifact_root,
+                                                       const std::vector<Encoding>& precompress,
+                                                       bool& shared) {
+  MustacheRenderer::Config rcfg;
+#ifdef TS_DEFAULT_TEMPLATE_DIR
+  rcfg.template_dir = TS_DEFAULT_TEMPLATE_DIR;
+#else
+  rcfg.template_dir = "templates";
+#endif
+  rcfg.partials_dir = rcfg.template_dir + "/partials";
+  rcfg.static_js    = {"web/js/vega.min.js",
+                       "web/js/vega-lite.min.js",
+                       "web/js/vega-embed.min.js",
+                       "web/js/report.js"};
+  rcfg.static_css   = {"web/css/report.css"};
+
+  std::vector<std::string> sources = rcfg.static_js;
+  sources.insert(sources.end(), rcfg.static_css.begin(), rcfg.static_css.end());
+  std::vector<StaticAsset> assets;
+  std::string aerr;
+  shared = publish_assets(artifact_root, sources, precompress, assets, &aerr);
+  if (!aerr.empty()) std::cerr << "[render] " << aerr << "\n";
+  for (const auto& a : assets) rcfg.asset_urls[a.name] = a.url;
+  return rcfg;
+}
+
+bool render_report_html(const std::string& artifact_root,
+                        const std::string& ctx_json,
+                        std::string& html_out,
+                        std::string* err_out) {
+  bool shared = true;
+  MustacheRenderer renderer(report_renderer_config(artifact_root, ReportDirOptions{}.precompress, shared));
+  if (!shared) {
+    if (err_out) *err_out = "static asset store unavailable";
+    return false;
+  }
+  if (!renderer.render_to_string("report.mustache", ctx_json, html_out)) {
+    if (err_out) *err_out = renderer.last_error();
+    return false;
+  }
+  return true;
+}
+
 bool write_report_dir(const std::string& artifact_root,
                       const std::string& slug,
                       const std::string& run_json_str,
                       std::string* err_out) {
+  return write_report_dir(artifact_root, slug, run_json_str, ReportDirOptions{}, err_out);
+}
+
+bool write_report_dir(const std::string& artifact_root,
+                      const std::string& slug,
+                      const std::string& run_json_str,
+                      const ReportDirOptions& opts,
+                      std::string* err_out) {
   const std::filesystem::path out_dir =
       std::filesystem::path(artifact_root) / slug;
 
   // (A) Save run.json alongside report.html (handy for debugging)
   {
+    TS_TRACE_SCOPE_CAT("artifact.write_run_json", "io");
     std::filesystem::create_directories(out_dir);
-    std::ofstream rj(out_dir / "run.json", std::ios::binary);
-    if (!rj) {
-      if (err_out) *err_out = "failed to write run.json";
-      return false;
+    if (opts.write_run_json) {
+      const std::string path = (out_dir / "run.json").string();
+      const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+      if (fd < 0) {
+        if (err_out) *err_out = "failed to write run.json: " + std::string(std::strerror(errno));
+        return false;
+      }
+      std::string werr;
+      const bool wrote = opts.write_run_json(fd, &werr);
+      if (::close(fd) != 0 || !wrote) {
+        if (err_out) *err_out = "failed to write run.json" + (werr.empty() ? "" : ": " + werr);
+        return false;
+      }
+    } else {
+      std::ofstream rj(out_dir / "run.json", std::ios::binary);
+      if (!rj) {
+        if (err_out) *err_out = "failed to write run.json";
+        return false;
+      }
+      rj.write(run_json_str.data(),
+               static_cast<std::streamsize>(run_json_str.size()));
     }
-    rj.write(run_json_str.data(),
-             static_cast<std::streamsize>(run_json_str.size()));
   }
 
-  // (B) Render report.html + copy CSS/JS assets to the same folder
-  ts::MustacheRenderer::Config rcfg;
-#ifdef TS_DEFAULT_TEMPLATE_DIR
-  rcfg.template_dir = TS_DEFAULT_TEMPLATE_DIR;
-#else
-  rcfg.template_dir = "templates";
-#endif
-  rcfg.partials_dir = rcfg.template_dir + "/partials";
-  rcfg.static_js    = {"web/js/vega.min.js",
-                       "web/js/vega-lite.min.js",
-                       "web/js/vega-embed.min.js",
-                       "web/js/report.js"};
-  rcfg.static_css   = {"web/css/report.css"};
-
+  // (B) Render report.html. CSS/JS live once in the shared static store and
+  // are linked by content hash; only if the store cannot be written are
+  // they copied next to the report as before.
+  bool shared = true;
+  const MustacheRenderer::Config rcfg = report_renderer_config(artifact_root, opts.precompress, shared);
   ts::MustacheRenderer renderer(rcfg);
   const bool ok = renderer.render_to_dir("report.mustache",
                                          run_json_str,
                                          out_dir.string(),
                                          "report.html",
-                                         /*copy_assets=*/true);
-  if (!ok && err_out) *err_out = renderer.last_error();
-  return ok;
+                                         /*copy_assets=*/!shared);
+  if (!ok) {
+    if (err_out) *err_out = renderer.last_error();
+    return false;
+  }
+
+  // (C) Precompressed variants; the plain files stay authoritative, so a
+  // failure here is reported but does not fail the report.
+  TS_TRACE_SCOPE_CAT("artifact.precompress", "io");
+  std::vector<std::filesystem::path> files = {out_dir / "report.html", out_dir / "run.json"};
+  if (!shared) {
+    for (const auto& a : rcfg.static_js) files.push_back(out_dir / std::filesystem::path(a).filename());
+    for (const auto& a : rcfg.static_css) files.push_back(out_dir / std::filesystem::path(a).filename());
+  }
+  std::error_code ec;
+  for (const auto& f : files) {
+    if (!std::filesystem::is_regular_file(f, ec)) continue; // asset not shipped
+    std::string perr;
+    if (!precompress_file(f.string(), opts.precompress, &perr)) {
+      std::cerr << "[render] precompress " << f.filename().string() << ": " << perr << "\n";
+    }
+  }
+  return true;
 }
 
 }
@@ -0,0 +1,135 @@
+#include "typed_scanner/asset_store.hpp"
+#include "typed_scanner/trace.hpp"
+
+#define XXH_INLINE_ALL
+#include <xxhash.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <vector>
+#include <sys/stat.h>
+
+namespace ts {
+
+namespace {
+
+struct Known {
+  std::int64_t mtime_ns = 0;
+  std::uint64_t size = 0;
+  std::string hash;
+  std::string published_root; // store the hash was last written to
+};
+
+// Held for a whole publish: concurrent scans would otherwise race on the
+// same temp file. After the first call it only guards a few stats.
+std::mutex& memo_mu() { static std::mutex m; return m; }
+std::map<std::string, Known>& memo() { static std::map<std::string, Known> m; return m; }
+
+// Same lookup copy_one_asset used to do: as given, then the install dir.
+std::filesystem::path resolve(const std::string& hint) {
+  std::vector<std::filesystem::path> candidates = {hint};
+#ifdef TS_DEFAULT_STATIC_DIR
+  const std::filesystem::path base(TS_DEFAULT_STATIC_DIR);
+  candidates.push_back(base / std::filesystem::path(hint).filename()); // flatten
+  candidates.push_back(base / hint);                                   // preserve subdirs
+#endif
+  std::error_code ec;
+  for (const auto& c : candidates) {
+    if (std::filesystem::is_regular_file(c, ec)) return c;
+  }
+  return {};
+}
+
+bool stat_of(const std::filesystem::path& p, std::int64_t& mtime_ns, std::uint64_t& size) {
+  struct stat st{};
+  if (::stat(p.c_str(), &st) != 0) return false;
+  mtime_ns = std::int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+  size = static_cast<std::uint64_t>(st.st_size);
+  return true;
+}
+
+bool read_all(const std::filesystem::path& p, std::string& out) {
+  std::ifstream in(p, std::ios::binary);
+  if (!in) return false;
+  std::ostringstream ss; ss << in.rdbuf();
+  out = ss.str();
+  return static_cast<bool>(in) || in.eof();
+}
+
+}
+
+bool publish_assets(const std::string& artifact_root,
+                    const std::vector<std::string>& sources,
+                    const std::vector<Encoding>& encs,
+                    std::vector<StaticAsset>& out,
+                    std::string* err_out) {
+  TS_TRACE_SCOPE_CAT("assets.publish", "io");
+  const std::filesystem::path store = std::filesystem::path(artifact_root) / kStaticDirName;
+  std::string missing;
+  out.clear();
+  std::lock_guard<std::mutex> lk(memo_mu());
+  for (const auto& hint : sources) {
+    const std::filesystem::path src = resolve(hint);
+    std::int64_t mtime_ns = 0;
+    std::uint64_t size = 0;
+    if (src.empty() || !stat_of(src, mtime_ns, size)) {
+      missing += (missing.empty() ? "asset not found: " : ", ") + hint;
+      continue;
+    }
+    StaticAsset a;
+    a.name = src.filename().string();
+    if (auto it = memo().find(src.string());
+        it != memo().end() && it->second.mtime_ns == mtime_ns && it->second.size == size &&
+        it->second.published_root == artifact_root) {
+      a.hash = it->second.hash;
+    }
+    std::error_code sec;
+    if (!a.hash.empty() && !std::filesystem::is_regular_file(store / a.hash / a.name, sec)) {
+      a.hash.clear(); // store was cleaned up underneath us
+    }
+    if (a.hash.empty()) {
+      std::string body;
+      if (!read_all(src, body)) {
+        missing += (missing.empty() ? "asset not found: " : ", ") + hint;
+        continue;
+      }
+      char hex[17];
+      std::snprintf(hex, sizeof hex, "%016llx",
+                    static_cast<unsigned long long>(XXH3_64bits(body.data(), body.size())));
+      a.hash = hex;
+
+      // Content-addressed: a file already at its path is already right.
+      const std::filesystem::path dst = store / a.hash / a.name;
+      std::error_code ec;
+      if (!std::filesystem::is_regular_file(dst, ec) || std::filesystem::file_size(dst, ec) != body.size()) {
+        std::filesystem::create_directories(dst.parent_path(), ec);
+        const std::filesystem::path tmp = dst.string() + ".tmp";
+        {
+          std::ofstream o(tmp, std::ios::binary | std::ios::trunc);
+          o.write(body.data(), static_cast<std::streamsize>(body.size()));
+          if (!o) ec = std::make_error_code(std::errc::io_error);
+        }
+        if (!ec) std::filesystem::rename(tmp, dst, ec);
+        if (ec) {
+          std::filesystem::remove(tmp, ec);
+          if (err_out) *err_out = "write failed: " + dst.string();
+          return false;
+        }
+        std::string perr;
+        if (!precompress_file(dst.string(), encs, &perr) && err_out) *err_out = perr;
+      }
+      memo()[src.string()] = Known{mtime_ns, size, a.hash, artifact_root};
+    }
+    a.url = "/static/" + a.hash + "/" + a.name;
+    out.push_back(std::move(a));
+  }
+  if (!missing.empty() && err_out) *err_out = missing;
+  return true;
+}
+
+}
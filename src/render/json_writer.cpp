@@ -0,0 +1,194 @@
+#include "typed_scanner/json_writer.hpp"
+
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <unistd.h>
+
+namespace ts {
+
+namespace {
+
+constexpr std::uint64_t kOnes = 0x0101010101010101ull;
+constexpr std::uint64_t kHighs = 0x8080808080808080ull;
+
+// Nonzero iff some byte of x is zero / below n (n <= 128); exact tests.
+inline std::uint64_t has_zero(std::uint64_t x) { return (x - kOnes) & ~x & kHighs; }
+inline std::uint64_t has_less(std::uint64_t x, std::uint64_t n) { return (x - kOnes * n) & ~x & kHighs; }
+
+// Any byte in the word that JSON strings cannot carry as-is.
+inline bool needs_escape8(const char* p) {
+  std::uint64_t x;
+  std::memcpy(&x, p, 8);
+  return has_zero(x ^ (kOnes * '"')) | has_zero(x ^ (kOnes * '\\')) | has_less(x, 0x20);
+}
+
+inline bool needs_escape(unsigned char c) { return c < 0x20 || c == '"' || c == '\\'; }
+
+void append_escape(std::string& out, unsigned char c) {
+  switch (c) {
+    case '"':  out += "\\\""; break;
+    case '\\': out += "\\\\"; break;
+    case '\n': out += "\\n"; break;
+    case '\r': out += "\\r"; break;
+    case '\t': out += "\\t"; break;
+    case '\b': out += "\\b"; break;
+    case '\f': out += "\\f"; break;
+    default: {
+      static const char kHex[] = "0123456789abcdef";
+      const char u[6] = {'\\', 'u', '0', '0', kHex[c >> 4], kHex[c & 15]};
+      out.append(u, 6);
+    }
+  }
+}
+
+}
+
+void append_json_string(std::string& out, std::string_view s) {
+  out += '"';
+  const char* p = s.data();
+  const char* const end = p + s.size();
+  const char* run = p; // start of the pending unescaped run
+  while (p < end) {
+    if (end - p >= 8 && !needs_escape8(p)) { p += 8; continue; }
+    const unsigned char c = static_cast<unsigned char>(*p);
+    if (needs_escape(c)) {
+      out.append(run, static_cast<std::size_t>(p - run));
+      append_escape(out, c);
+      run = p + 1;
+    }
+    ++p;
+  }
+  out.append(run, static_cast<std::size_t>(end - run));
+  out += '"';
+}
+
+JsonWriter::JsonWriter(std::string& out) : out_(&out) {}
+
+JsonWriter::JsonWriter(int fd, std::size_t buffer_bytes)
+  : out_(&buf_), fd_(fd), cap_(buffer_bytes ? buffer_bytes : 1) {
+  buf_.reserve(cap_ + 256);
+}
+
+JsonWriter::~JsonWriter() { flush(); }
+
+bool JsonWriter::flush() {
+  if (fd_ < 0) return true;
+  const char* p = buf_.data();
+  std::size_t left = buf_.size();
+  while (left > 0 && err_.empty()) {
+    const ssize_t n = ::write(fd_, p, left);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) { err_ = std::string("write: ") + std::strerror(errno); break; }
+    p += n;
+    left -= static_cast<std::size_t>(n);
+  }
+  buf_.clear();
+  return err_.empty();
+}
+
+void JsonWriter::before_value() {
+  if (after_key_) { after_key_ = false; return; }
+  if (!first_[depth_]) *out_ += ',';
+  first_[depth_] = false;
+}
+
+JsonWriter& JsonWriter::begin_object() {
+  before_value();
+  *out_ += '{';
+  if (depth_ < kMaxDepth) first_[++depth_] = true;
+  return *this;
+}
+
+JsonWriter& JsonWriter::end_object() {
+  *out_ += '}';
+  if (depth_ > 0) --depth_;
+  maybe_flush();
+  return *this;
+}
+
+JsonWriter& JsonWriter::begin_array() {
+  before_value();
+  *out_ += '[';
+  if (depth_ < kMaxDepth) first_[++depth_] = true;
+  return *this;
+}
+
+JsonWriter& JsonWriter::end_array() {
+  *out_ += ']';
+  if (depth_ > 0) --depth_;
+  maybe_flush();
+  return *this;
+}
+
+JsonWriter& JsonWriter::key(std::string_view k) {
+  before_value();
+  append_json_string(*out_, k);
+  *out_ += ':';
+  after_key_ = true;
+  return *this;
+}
+
+JsonWriter& JsonWriter::value(std::string_view s) {
+  before_value();
+  append_json_string(*out_, s);
+  maybe_flush();
+  return *this;
+}
+
+JsonWriter& JsonWriter::value(double v) {
+  before_value();
+  if (!std::isfinite(v)) v = 0.0;
+  char buf[32];
+  const auto r = std::to_chars(buf, buf + sizeof buf, v);
+  out_->append(buf, static_cast<std::size_t>(r.ptr - buf));
+  maybe_flush();
+  return *this;
+}
+
+JsonWriter& JsonWriter::value(bool b) {
+  before_value();
+  *out_ += b ? "true" : "false";
+  return *this;
+}
+
+JsonWriter& JsonWriter::write_int(std::int64_t v) {
+  before_value();
+  char buf[24];
+  const auto r = std::to_chars(buf, buf + sizeof buf, v);
+  out_->append(buf, static_cast<std::size_t>(r.ptr - buf));
+  maybe_flush();
+  return *this;
+}
+
+JsonWriter& JsonWriter::write_uint(std::uint64_t v) {
+  before_value();
+  char buf[24];
+  const auto r = std::to_chars(buf, buf + sizeof buf, v);
+  out_->append(buf, static_cast<std::size_t>(r.ptr - buf));
+  maybe_flush();
+  return *this;
+}
+
+JsonWriter& JsonWriter::null() {
+  before_value();
+  *out_ += "null";
+  return *this;
+}
+
+JsonWriter& JsonWriter::raw(std::string_view json) {
+  if (fd_ >= 0 && out_->size() + json.size() > cap_) {
+    flush();
+    if (json.size() >= cap_) {
+      // Big splice: write it through rather than growing the buffer.
+      buf_.assign(json);
+      flush();
+      return *this;
+    }
+  }
+  out_->append(json);
+  return *this;
+}
+
+}
@@ -1,5 +1,6 @@
 #include "typed_scanner/mustache_renderer.hpp"
 #include "typed_scanner/path_utils.hpp"
+#include "typed_scanner/trace.hpp"
 
 #if __has_include(<kainjow/mustache.hpp>)
   #include <kainjow/mustache.hpp>
@@ -9,15 +10,22 @@
   #error "kainjow/Mustache header not found"
 #endif
 
+#include <atomic>
+#include <cstdint>
 #include <filesystem>
 #include <fstream>
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <map>
 #include <string>
 #include <string_view>
 #include <system_error>
+#include <unordered_map>
 #include <vector>
 #include <cctype>
 #include <ctime>
+#include <sys/stat.h>
 
 namespace ts {
 
@@ -30,11 +38,33 @@ static std::string read_file(const std::string& path, std::string& err) {
   return ss.str();
 }
 
-// naive "{{> name}}" inliner that looks for partial files in cfg_.partials_dir
-static std::string inline_partials(std::string tpl,
+// Modification stamp of a file a template was built from; absent = -1.
+struct Dep {
+  std::string path;
+  std::int64_t mtime_ns = -1;
+  std::int64_t size = -1;
+};
+
+static Dep stamp(std::string path) {
+  Dep d{std::move(path)};
+  struct stat st{};
+  if (::stat(d.path.c_str(), &st) == 0) {
+    d.mtime_ns = std::int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    d.size = static_cast<std::int64_t>(st.st_size);
+  }
+  return d;
+}
+
+// naive "{{> name}}" inliner that looks for partial files in cfg_.partials_dir.
+// One pass into a fresh string; every file looked at (found or not) lands in
+// `deps` so the cache can tell when the result goes stale.
+static std::string inline_partials(const std::string& tpl,
                                    const std::filesystem::path& partials_dir,
+                                   std::vector<Dep>& deps,
                                    std::string& err) {
-  size_t pos = 0;
+  std::string out;
+  out.reserve(tpl.size());
+  size_t pos = 0, copied = 0;
   while ((pos = tpl.find("{{>", pos)) != std::string::npos) {
     size_t name_start = pos + 3;
     while (name_start < tpl.size() && std::isspace(static_cast<unsigned char>(tpl[name_start])))
@@ -56,8 +86,12 @@ static std::string inline_partials(std::string tpl,
     std::filesystem::path p1 = partials_dir / partial_name;
     std::filesystem::path p2 = partials_dir / (partial_name + ".mustache");
 
+    deps.push_back(stamp(p1.string()));
     std::string content = read_file(p1.string(), perr);
-    if (content.empty()) content = read_file(p2.string(), perr);
+    if (content.empty()) {
+      deps.push_back(stamp(p2.string()));
+      content = read_file(p2.string(), perr);
+    }
     if (content.empty()) {
       err += "partial not found: " + p1.string() + " | " + p2.string() + "\n";
       pos = close + 2;
@@ -65,10 +99,97 @@ static std::string inline_partials(std::string tpl,
     }
 
     // replace the whole tag with the partial contents
-    tpl.replace(pos, (close + 2) - pos, content);
-    pos += content.size();
+    out.append(tpl, copied, pos - copied);
+    out += content;
+    pos = copied = close + 2;
   }
-  return tpl;
+  out.append(tpl, copied, std::string::npos);
+  return out;
+}
+
+namespace {
+
+// A template with its partials inlined, as read at `version`.
+struct Source {
+  std::string text;
+  std::vector<Dep> deps; // template first, then partials
+  std::string warnings;  // partials not found; reported on each render
+  std::uint64_t version = 0;
+};
+
+// Process-wide: sources by (template, partials dir), revalidated by stat on
+// every lookup, so editing a template or partial takes effect on the next
+// render. Compiled kainjow views are per thread (render() mutates the view),
+// keyed by source version, so renders never share one and never re-parse an
+// unchanged template.
+class TemplateCache {
+public:
+  static TemplateCache& instance() {
+    static TemplateCache c;
+    return c;
+  }
+
+  std::shared_ptr<const Source> get(const std::string& tpl_path, const std::string& partials_dir,
+                                    std::string& err) {
+    const std::string key = tpl_path + '\n' + partials_dir;
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      auto it = sources_.find(key);
+      if (it != sources_.end() && fresh(*it->second)) return it->second;
+    }
+    auto src = load(tpl_path, partials_dir, err);
+    if (!src) return nullptr;
+    src->version = next_version_.fetch_add(1, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lk(mu_);
+    sources_[key] = src;
+    return src;
+  }
+
+  static std::shared_ptr<Source> load(const std::string& tpl_path, const std::string& partials_dir,
+                                      std::string& err) {
+    TS_TRACE_SCOPE_CAT("mustache.load", "render");
+    auto src = std::make_shared<Source>();
+    src->deps.push_back(stamp(tpl_path));
+    std::string ferr;
+    std::string tpl = read_file(tpl_path, ferr);
+    if (tpl.empty() && !ferr.empty()) { err += ferr; return nullptr; }
+    // expand partials before handing to the engine
+    src->text = inline_partials(tpl, std::filesystem::path(partials_dir), src->deps, src->warnings);
+    return src;
+  }
+
+private:
+  static bool fresh(const Source& s) {
+    for (const auto& d : s.deps) {
+      const Dep now = stamp(d.path);
+      if (now.mtime_ns != d.mtime_ns || now.size != d.size) return false;
+    }
+    return true;
+  }
+
+  std::mutex mu_;
+  std::unordered_map<std::string, std::shared_ptr<const Source>> sources_;
+  std::atomic<std::uint64_t> next_version_{1};
+};
+
+struct CompiledView {
+  std::uint64_t version = 0;
+  std::unique_ptr<kainjow::mustache::mustache> view;
+};
+
+kainjow::mustache::mustache* compiled_view(const std::string& key, const Source& src) {
+  thread_local std::unordered_map<std::string, CompiledView> views;
+  CompiledView& c = views[key];
+  if (!c.view || c.version != src.version) {
+    TS_TRACE_SCOPE_CAT("mustache.compile", "render");
+    c.view = std::make_unique<kainjow::mustache::mustache>(src.text);
+    // Do not escape; template controls with {{}} vs {{{}}}
+    c.view->set_custom_escape([](const std::string& s){ return s; });
+    c.version = src.version;
+  }
+  return c.view.get();
+}
+
 }
 
 // --- copy one asset if it exists (tries a couple locations) ---------------
@@ -119,41 +240,86 @@ static bool copy_one_asset(const std::filesystem::path& src_hint,
 
 MustacheRenderer::MustacheRenderer(Config cfg) : cfg_(std::move(cfg)) {}
 
-bool MustacheRenderer::render_to_file(std::string_view template_name,
-                                      std::string_view context_json,
-                                      std::string_view out_path) {
+static std::vector<std::string> static_js_of(const MustacheRenderer::Config& cfg) {
+  return cfg.static_js.empty()
+      ? std::vector<std::string>{"web/js/vega.min.js","web/js/vega-lite.min.js","web/js/vega-embed.min.js",
+                                 "web/js/report.js"}
+      : cfg.static_js;
+}
+
+static std::vector<std::string> static_css_of(const MustacheRenderer::Config& cfg) {
+  return cfg.static_css.empty() ? std::vector<std::string>{"web/css/report.css"} : cfg.static_css;
+}
+
+// "vega-lite.min.js" -> "asset_vega_lite_min_js"
+static std::string asset_key(const std::string& name) {
+  std::string k = "asset_";
+  for (const char c : name) k += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+  return k;
+}
+
+bool MustacheRenderer::render_to_string(std::string_view template_name,
+                                        std::string_view context_json,
+                                        std::string& out) {
+  TS_TRACE_SCOPE_CAT("mustache.render", "render");
   err_.clear();
 
   const auto tpl_path =
       (std::filesystem::path(cfg_.template_dir) / std::string(template_name)).string();
 
-  std::string tpl = read_file(tpl_path, err_);
-  if (tpl.empty() && !err_.empty()) return false;
-
-  // expand partials before handing to the engine
-  tpl = inline_partials(std::move(tpl), std::filesystem::path(cfg_.partials_dir), err_);
-
-  kainjow::mustache::mustache view(tpl);
-  if (!view.is_valid()) { err_ = view.error_message(); return false; }
+  std::shared_ptr<const Source> src = cfg_.cache_templates
+      ? TemplateCache::instance().get(tpl_path, cfg_.partials_dir, err_)
+      : TemplateCache::load(tpl_path, cfg_.partials_dir, err_);
+  if (!src) return false;
+  err_ += src->warnings;
+
+  std::unique_ptr<kainjow::mustache::mustache> uncached;
+  kainjow::mustache::mustache* view = nullptr;
+  if (cfg_.cache_templates) {
+    view = compiled_view(tpl_path + '\n' + cfg_.partials_dir, *src);
+  } else {
+    uncached = std::make_unique<kainjow::mustache::mustache>(src->text);
+    uncached->set_custom_escape([](const std::string& s){ return s; });
+    view = uncached.get();
+  }
+  if (!view->is_valid()) { err_ = view->error_message(); return false; }
 
   kainjow::mustache::data data;
   // raw JSON string for {{{ctx}}} in template
   data.set("ctx", std::string(context_json));
 
+  // asset links: shared /static/<hash>/ URLs, or the copies next to the report
+  {
+    std::vector<std::string> assets = static_js_of(cfg_);
+    for (auto& c : static_css_of(cfg_)) assets.push_back(std::move(c));
+    for (const auto& a : assets) {
+      const std::string name = std::filesystem::path(a).filename().string();
+      auto it = cfg_.asset_urls.find(name);
+      data.set(asset_key(name), it != cfg_.asset_urls.end() ? it->second : "./" + name);
+    }
+  }
+
   // footer date
   {
     auto t = std::time(nullptr);
+    std::tm tm{};
     char buf[64];
-    if (std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", std::localtime(&t))) {
+    if (localtime_r(&t, &tm) && std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm)) {
       data.set("date", std::string(buf));
     }
   }
 
-  // Do not escape; template controls with {{}} vs {{{}}}
-  view.set_custom_escape([](const std::string& s){ return s; });
+  out = view->render(data);
+  if (out.empty() && !view->is_valid()) { err_ = view->error_message(); return false; }
+  return true;
+}
 
-  const std::string rendered = view.render(data);
-  if (rendered.empty() && !view.is_valid()) { err_ = view.error_message(); return false; }
+bool MustacheRenderer::render_to_file(std::string_view template_name,
+                                      std::string_view context_json,
+                                      std::string_view out_path) {
+  TS_TRACE_SCOPE_CAT("mustache.render_to_file", "render");
+  std::string rendered;
+  if (!render_to_string(template_name, context_json, rendered)) return false;
 
   if (!ensure_parent_dirs(std::filesystem::path(out_path))) { err_ = "mkdir -p failed"; return false; }
 
@@ -177,14 +343,10 @@ bool MustacheRenderer::render_to_dir(std::string_view template_name,
   }
   if (!copy_assets) return true;
 
-  std::vector<std::string> js = cfg_.static_js.empty()
-      ? std::vector<std::string>{"web/js/vega.min.js","web/js/vega-lite.min.js","web/js/vega-embed.min.js"}
-      : cfg_.static_js;
-
-  std::vector<std::string> css = cfg_.static_css.empty()
-      ? std::vector<std::string>{"web/css/report.css"}
-      : cfg_.static_css;
+  const std::vector<std::string> js = static_js_of(cfg_);
+  const std::vector<std::string> css = static_css_of(cfg_);
 
+  TS_TRACE_SCOPE_CAT("mustache.copy_assets", "io");
   for (auto& s : js)  copy_one_asset(std::filesystem::path(s), outdir, err_);
   for (auto& s : css) copy_one_asset(std::filesystem::path(s), outdir, err_);
 
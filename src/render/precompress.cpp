@@ -0,0 +1,260 @@
+#include "typed_scanner/precompress.hpp"
+#include "typed_scanner/trace.hpp"
+
+#define XXH_INLINE_ALL
+#include <xxhash.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+#ifndef TS_HAVE_ZLIB
+  #define TS_HAVE_ZLIB 0
+#endif
+#ifndef TS_HAVE_ZSTD
+  #define TS_HAVE_ZSTD 0
+#endif
+#ifndef TS_HAVE_BROTLI
+  #define TS_HAVE_BROTLI 0
+#endif
+#if TS_HAVE_ZLIB
+  #include <zlib.h>
+#endif
+#if TS_HAVE_ZSTD
+  #include <zstd.h>
+#endif
+#if TS_HAVE_BROTLI
+  #include <brotli/encode.h>
+#endif
+
+namespace ts {
+
+namespace {
+
+constexpr std::size_t kMinBytes = 1024;  // headers would eat the gain
+constexpr std::size_t kMemoBytes = 32u << 20;
+constexpr int kGzipLevel = 9;
+constexpr int kBrotliQuality = 9;        // 10/11 cost ~10x for a few %
+constexpr int kZstdLevel = 12;           // 19 is ~10x slower for ~6%
+
+// Compressed outputs by (content hash, size, encoding); cleared when full.
+struct Memo {
+  std::mutex mu;
+  std::map<std::tuple<std::uint64_t, std::size_t, int>, std::string> out;
+  std::size_t bytes = 0;
+};
+
+Memo& memo() {
+  static Memo m;
+  return m;
+}
+
+bool read_all(const std::string& path, std::string& out, std::string* err_out) {
+  FILE* f = std::fopen(path.c_str(), "rb");
+  if (!f) {
+    if (err_out) *err_out = path + ": " + std::strerror(errno);
+    return false;
+  }
+  out.clear();
+  char buf[64 * 1024];
+  for (std::size_t n; (n = std::fread(buf, 1, sizeof buf, f)) > 0;) out.append(buf, n);
+  const bool failed = std::ferror(f);
+  std::fclose(f);
+  if (failed && err_out) *err_out = path + ": read error";
+  return !failed;
+}
+
+// Write via a temp file and rename, so the server never sees half a variant.
+bool write_atomic(const std::filesystem::path& path, const std::string& data, std::string* err_out) {
+  const std::filesystem::path tmp = path.string() + ".tmp";
+  FILE* f = std::fopen(tmp.c_str(), "wb");
+  bool ok = f && std::fwrite(data.data(), 1, data.size(), f) == data.size();
+  if (f) ok = (std::fclose(f) == 0) && ok;
+  std::error_code ec;
+  if (ok) std::filesystem::rename(tmp, path, ec);
+  if (!ok || ec) {
+    std::filesystem::remove(tmp, ec);
+    if (err_out) *err_out = "write failed: " + path.string();
+    return false;
+  }
+  return true;
+}
+
+}
+
+const char* encoding_name(Encoding e) {
+  switch (e) {
+    case Encoding::Brotli: return "br";
+    case Encoding::Zstd:   return "zstd";
+    case Encoding::Gzip:   return "gzip";
+  }
+  return "identity";
+}
+
+const char* encoding_suffix(Encoding e) {
+  switch (e) {
+    case Encoding::Brotli: return ".br";
+    case Encoding::Zstd:   return ".zst";
+    case Encoding::Gzip:   return ".gz";
+  }
+  return "";
+}
+
+std::optional<Encoding> parse_encoding(std::string_view name) {
+  for (const Encoding e : kAllEncodings) {
+    if (name == encoding_name(e)) return e;
+  }
+  return std::nullopt;
+}
+
+bool encoding_available(Encoding e) {
+  switch (e) {
+    case Encoding::Brotli: return TS_HAVE_BROTLI != 0;
+    case Encoding::Zstd:   return TS_HAVE_ZSTD != 0;
+    case Encoding::Gzip:   return TS_HAVE_ZLIB != 0;
+  }
+  return false;
+}
+
+std::vector<Encoding> accepted_encodings(std::string_view header) {
+  std::vector<std::pair<Encoding, double>> out;
+  auto q_of = [&](std::string_view want) -> double {
+    double q = -1.0, star = 0.0;
+    std::string_view h = header;
+    while (!h.empty()) {
+      const std::size_t comma = h.find(',');
+      std::string_view item = h.substr(0, comma);
+      h = comma == std::string_view::npos ? std::string_view{} : h.substr(comma + 1);
+      const std::size_t semi = item.find(';');
+      std::string_view name = item.substr(0, semi);
+      while (!name.empty() && name.front() == ' ') name.remove_prefix(1);
+      while (!name.empty() && name.back() == ' ') name.remove_suffix(1);
+      double iq = 1.0;
+      if (semi != std::string_view::npos) {
+        const std::size_t eq = item.find("q=", semi);
+        if (eq != std::string_view::npos) iq = std::atof(std::string(item.substr(eq + 2)).c_str());
+      }
+      const bool match = name.size() == want.size() &&
+          std::equal(name.begin(), name.end(), want.begin(),
+                     [](unsigned char a, unsigned char b){ return std::tolower(a) == std::tolower(b); });
+      if (match) q = iq;
+      else if (name == "*") star = iq;
+    }
+    return q >= 0.0 ? q : star;
+  };
+  for (const Encoding e : kAllEncodings) {
+    const double q = q_of(encoding_name(e));
+    if (q > 0.0) out.emplace_back(e, q);
+  }
+  std::stable_sort(out.begin(), out.end(), [](const auto& a, const auto& b){ return a.second > b.second; });
+  std::vector<Encoding> encs;
+  for (const auto& [e, q] : out) encs.push_back(e);
+  return encs;
+}
+
+bool compress_buffer(Encoding e, std::string_view in, std::string& out, std::string* err_out) {
+  TS_TRACE_SCOPE_CAT("precompress.compress", "render");
+  switch (e) {
+    case Encoding::Gzip: {
+#if TS_HAVE_ZLIB
+      z_stream zs{};
+      if (deflateInit2(&zs, kGzipLevel, Z_DEFLATED, 15 + 16, 9, Z_DEFAULT_STRATEGY) != Z_OK) break;
+      out.resize(deflateBound(&zs, static_cast<uLong>(in.size())) + 32);
+      zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+      zs.avail_in = static_cast<uInt>(in.size());
+      zs.next_out = reinterpret_cast<Bytef*>(out.data());
+      zs.avail_out = static_cast<uInt>(out.size());
+      const int rc = deflate(&zs, Z_FINISH);
+      out.resize(zs.total_out);
+      deflateEnd(&zs);
+      if (rc == Z_STREAM_END) return true;
+#endif
+      break;
+    }
+    case Encoding::Zstd: {
+#if TS_HAVE_ZSTD
+      out.resize(ZSTD_compressBound(in.size()));
+      const std::size_t n = ZSTD_compress(out.data(), out.size(), in.data(), in.size(), kZstdLevel);
+      if (!ZSTD_isError(n)) { out.resize(n); return true; }
+#endif
+      break;
+    }
+    case Encoding::Brotli: {
+#if TS_HAVE_BROTLI
+      std::size_t n = BrotliEncoderMaxCompressedSize(in.size());
+      out.resize(n ? n : in.size() + 1024);
+      n = out.size();
+      if (BrotliEncoderCompress(kBrotliQuality, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT,
+                                in.size(), reinterpret_cast<const std::uint8_t*>(in.data()),
+                                &n, reinterpret_cast<std::uint8_t*>(out.data()))) {
+        out.resize(n);
+        return true;
+      }
+#endif
+      break;
+    }
+  }
+  out.clear();
+  if (err_out) {
+    *err_out = std::string(encoding_name(e)) +
+               (encoding_available(e) ? ": compression failed" : " support is not compiled in");
+  }
+  return false;
+}
+
+bool precompress_file(const std::string& path, const std::vector<Encoding>& encs,
+                      std::string* err_out) {
+  TS_TRACE_SCOPE_CAT("precompress.file", "render");
+  std::string in;
+  if (!read_all(path, in, err_out)) return false;
+  const std::uint64_t h = XXH3_64bits(in.data(), in.size());
+
+  bool ok = true;
+  std::error_code ec;
+  for (const Encoding e : kAllEncodings) {
+    const std::filesystem::path variant = path + encoding_suffix(e);
+    const bool wanted = in.size() >= kMinBytes && encoding_available(e) &&
+                        std::find(encs.begin(), encs.end(), e) != encs.end();
+    std::string out;
+    if (wanted) {
+      Memo& m = memo();
+      const auto key = std::make_tuple(h, in.size(), static_cast<int>(e));
+      {
+        std::lock_guard<std::mutex> lk(m.mu);
+        if (auto it = m.out.find(key); it != m.out.end()) out = it->second;
+      }
+      if (out.empty()) {
+        std::string cerr_msg;
+        if (!compress_buffer(e, in, out, &cerr_msg)) {
+          if (err_out) *err_out = cerr_msg;
+          ok = false;
+        } else {
+          std::lock_guard<std::mutex> lk(m.mu);
+          if (m.bytes + out.size() > kMemoBytes) { m.out.clear(); m.bytes = 0; }
+          if (out.size() <= kMemoBytes) {
+            m.bytes += out.size();
+            m.out.emplace(key, out);
+          }
+        }
+      }
+    }
+    // A variant that does not pay for itself (or is no longer wanted) must
+    // not outlive the file it was made from.
+    if (out.empty() || out.size() >= in.size()) {
+      std::filesystem::remove(variant, ec);
+      continue;
+    }
+    if (!write_atomic(variant, out, err_out)) ok = false;
+  }
+  return ok;
+}
+
+}
@@ -1,77 +1,194 @@
 #include "typed_scanner/run_json.hpp"
-#include <sstream>
-#include <cmath> // std::isfinite
+#include "typed_scanner/trace.hpp"
+#include <unistd.h>
 
 namespace ts {
 
-static void esc(std::ostringstream& o, const std::string& s){
-  o << '"';
-  for (char c : s){
-    switch(c){
-      case '\\': o << "\\\\"; break;
-      case '"':  o << "\\\""; break;
-      case '\n': o << "\\n";  break;
-      case '\r': o << "\\r";  break;
-      case '\t': o << "\\t";  break;
-      default:   o << c;      break;
+static void write_point(JsonWriter& w, const RunJsonSeriesPoint& s) {
+  w.begin_object()
+   .key("time_ms").value(s.time_ms)
+   .key("mb_s").value(s.mb_s)
+   .key("rss_mb").value(s.rss_mb)
+   .key("allocs_per_sec").value(s.allocs_per_sec)
+   .end_object();
+}
+
+RunJsonSeriesSpool::RunJsonSeriesSpool(std::size_t max_sampled)
+  : file_(std::tmpfile()), max_sampled_(max_sampled ? max_sampled : 1) {}
+
+RunJsonSeriesSpool::~RunJsonSeriesSpool() {
+  if (file_) std::fclose(file_);
+}
+
+void RunJsonSeriesSpool::append(const RunJsonSeriesPoint& pt) {
+  if (!lost_) {
+    if (count_) buf_ += ',';
+    JsonWriter w(buf_);
+    write_point(w, pt);
+  }
+  if (count_ % stride_ == 0) {
+    sampled_.push_back(pt);
+    if (sampled_.size() > max_sampled_) {
+      // Keep every other point and halve the rate from here on.
+      std::size_t j = 0;
+      for (std::size_t i = 0; i < sampled_.size(); i += 2) sampled_[j++] = sampled_[i];
+      sampled_.resize(j);
+      stride_ *= 2;
     }
   }
-  o << '"';
+  ++count_;
+  if (buf_.size() >= (64u << 10)) spill();
+}
+
+void RunJsonSeriesSpool::spill() {
+  if (!file_ || buf_.empty()) return;
+  if (std::fwrite(buf_.data(), 1, buf_.size(), file_) != buf_.size()) {
+    // Disk full or similar: keep what is buffered in memory instead. Points
+    // already spilled are gone with the file, so then only the sampled copy
+    // is left to write.
+    std::fclose(file_);
+    file_ = nullptr;
+    if (spilled_) lose();
+    return;
+  }
+  spilled_ += buf_.size();
+  buf_.clear();
 }
 
-static inline double safe_num(double v){ return std::isfinite(v) ? v : 0.0; }
+void RunJsonSeriesSpool::lose() {
+  lost_ = true;
+  std::string().swap(buf_);
+}
 
-std::string RunJsonWriter::to_json(const RunJsonPayload& p) {
-  std::ostringstream o;
-  o << "{";
-  o << "\"rows\":" << p.rows << ",";
-  o << "\"bytes\":" << p.bytes << ",";
-  o << "\"wall_time_ms\":" << safe_num(p.wall_time_ms) << ",";
-  o << "\"throughput_mb_s\":" << safe_num(p.throughput_mb_s) << ",";
-  o << "\"tokens_per_sec\":" << safe_num(p.tokens_per_sec) << ",";
-  o << "\"allocs_per_sec\":" << safe_num(p.allocs_per_sec) << ",";
-  o << "\"p50_ms\":" << safe_num(p.p50_ms) << ",";
-  o << "\"p95_ms\":" << safe_num(p.p95_ms) << ",";
-  o << "\"peak_rss_mb\":" << safe_num(p.peak_rss_mb) << ",";
-  o << "\"cpu_pct\":" << safe_num(p.cpu_pct) << ",";
-
-  o << "\"stage_times\":[";
-  for (size_t i=0;i<p.stage_times.size();++i){
-    if (i) o << ",";
-    o << "{\"stage\":"; esc(o, p.stage_times[i].first);
-    o << ",\"duration_ms\":" << p.stage_times[i].second << "}";
+bool RunJsonSeriesSpool::copy_to(JsonWriter& w) {
+  if (file_ && spilled_ && std::fflush(file_) != 0) lose();
+  if (lost_) {
+    for (const auto& s : sampled_) write_point(w, s);
+    return w.ok();
+  }
+  if (file_ && spilled_) {
+    const int fd = fileno(file_);
+    char chunk[64u << 10];
+    off_t off = 0;
+    for (;;) {
+      const ssize_t n = ::pread(fd, chunk, sizeof chunk, off);
+      if (n <= 0) break;
+      w.raw(std::string_view(chunk, static_cast<std::size_t>(n)));
+      off += n;
+    }
+  }
+  w.raw(buf_);
+  return w.ok();
+}
+
+void RunJsonWriter::write(JsonWriter& w, const RunJsonPayload& p, RunJsonSeriesSpool* series) {
+  TS_TRACE_SCOPE_CAT("run_json.write", "render");
+  w.begin_object();
+  w.key("rows").value(p.rows);
+  w.key("bytes").value(p.bytes);
+  w.key("wall_time_ms").value(p.wall_time_ms);
+  w.key("throughput_mb_s").value(p.throughput_mb_s);
+  w.key("tokens_per_sec").value(p.tokens_per_sec);
+  w.key("allocs_per_sec").value(p.allocs_per_sec);
+  w.key("p50_ms").value(p.p50_ms);
+  w.key("p95_ms").value(p.p95_ms);
+  w.key("peak_rss_mb").value(p.peak_rss_mb);
+  w.key("cpu_pct").value(p.cpu_pct);
+
+  w.key("stage_times").begin_array();
+  for (const auto& [stage, ms] : p.stage_times) {
+    w.begin_object().key("stage").value(stage).key("duration_ms").value(ms).end_object();
+  }
+  w.end_array();
+
+  w.key("stage_counters").begin_array();
+  for (const auto& c : p.stage_counters) {
+    const double ipc = c.cycles ? double(c.instructions) / double(c.cycles) : 0.0;
+    w.begin_object()
+     .key("stage").value(c.stage)
+     .key("cycles").value(c.cycles)
+     .key("instructions").value(c.instructions)
+     .key("ipc").value(ipc)
+     .key("branch_misses").value(c.branch_misses)
+     .key("llc_misses").value(c.llc_misses)
+     .end_object();
+  }
+  w.end_array();
+
+  w.key("columns").begin_array();
+  for (const auto& c : p.columns) {
+    w.begin_object()
+     .key("name").value(c.name)
+     .key("type").value(c.type)
+     .key("count").value(c.count)
+     .key("nulls").value(c.nulls)
+     .key("errors").value(c.errors)
+     .key("min").value(c.min)
+     .key("max").value(c.max)
+     .key("mean").value(c.mean)
+     .end_object();
   }
-  o << "],";
-
-  o << "\"errors_by_field\":{";
-  bool first=true;
-  for (auto& kv : p.errors_by_field) {
-    if (!first) o << ",";
-    first=false;
-    esc(o, kv.first); o << ":" << kv.second;
+  w.end_array();
+
+  w.key("latency").begin_object();
+  for (const auto& h : p.latency) {
+    w.key(h.name).begin_object()
+     .key("count").value(h.count)
+     .key("p50_ms").value(h.p50_ms)
+     .key("p90_ms").value(h.p90_ms)
+     .key("p99_ms").value(h.p99_ms)
+     .key("p999_ms").value(h.p999_ms)
+     .key("max_ms").value(h.max_ms)
+     .key("mean_ms").value(h.mean_ms);
+    w.key("buckets").begin_array();
+    for (const auto& b : h.buckets) {
+      w.begin_object().key("le_ms").value(b.le_ms).key("count").value(b.count).end_object();
+    }
+    w.end_array().end_object();
   }
-  o << "},";
-
-  o << "\"series\":[";
-  for (size_t i=0;i<p.series.size();++i){
-    if (i) o << ",";
-    const auto& s = p.series[i];
-    o << "{"
-      << "\"time_ms\":"       << safe_num(s.time_ms)       << ","
-      << "\"mb_s\":"          << safe_num(s.mb_s)          << ","
-      << "\"rss_mb\":"        << safe_num(s.rss_mb)        << ","
-      << "\"allocs_per_sec\":"<< safe_num(s.allocs_per_sec)
-      << "}";
+  w.end_object();
+
+  w.key("errors_by_field").begin_object();
+  for (const auto& [field, n] : p.errors_by_field) w.key(field).value(n);
+  w.end_object();
+
+  w.key("series").begin_array();
+  if (series) {
+    series->copy_to(w);
+  } else {
+    for (const auto& s : p.series) write_point(w, s);
   }
-  o << "],";
+  w.end_array();
 
-  o << "\"filename\":";     esc(o, p.filename);     o << ",";
-  o << "\"content_type\":"; esc(o, p.content_type); o << ",";
-  o << "\"etag\":";         esc(o, p.etag);         o << ",";
-  o << "\"file_size\":" << p.file_size;
+  w.key("filename").value(p.filename);
+  w.key("content_type").value(p.content_type);
+  w.key("etag").value(p.etag);
+  w.key("file_size").value(p.file_size);
+  w.key("resumed_from").value(p.resumed_from);
+  w.key("compression").value(p.compression);
+  w.key("compressed_bytes").value(p.compressed_bytes);
+  const auto& sn = p.sniff;
+  w.key("sniff").begin_object()
+   .key("format").value(sn.format)
+   .key("source").value(sn.source)
+   .key("confidence").value(sn.confidence)
+   .key("delimiter").value(sn.delimiter)
+   .key("quote").value(sn.quote)
+   .key("header").value(sn.header)
+   .key("bom").value(sn.bom)
+   .key("line_ending").value(sn.line_ending)
+   .end_object();
+  w.end_object();
+}
 
-  o << "}";
-  return o.str();
+std::string RunJsonWriter::to_json(const RunJsonPayload& p) {
+  std::string out;
+  out.reserve(4096 + p.series.size() * 96);
+  {
+    JsonWriter w(out);
+    write(w, p);
+  }
+  return out;
 }
 
 }
@@ -0,0 +1,483 @@
+#include "typed_scanner/byte_source.hpp"
+#include "typed_scanner/spsc_queue.hpp"
+#include "typed_scanner/task_pool.hpp"
+#include "typed_scanner/trace.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+#ifndef TS_HAVE_ZLIB
+  #define TS_HAVE_ZLIB 0
+#endif
+#ifndef TS_HAVE_ZSTD
+  #define TS_HAVE_ZSTD 0
+#endif
+#if TS_HAVE_ZLIB
+  #include <zlib.h>
+#endif
+#if TS_HAVE_ZSTD
+  #include <zstd.h>
+#endif
+
+namespace ts {
+
+namespace {
+
+constexpr std::size_t kInputBytes = 256 * 1024; // compressed read size
+
+// Single writer, read from the consumer thread.
+struct Counter {
+  std::atomic<std::uint64_t> v{0};
+  void add(std::uint64_t n) noexcept { v.store(v.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+  std::uint64_t get() const noexcept { return v.load(std::memory_order_relaxed); }
+};
+
+// The owned FILE*, behind any bytes that were read ahead of the source.
+class RawInput {
+public:
+  RawInput(FILE* f, std::string head) : f_(f), head_(std::move(head)) {}
+  ~RawInput() { std::fclose(f_); }
+
+  // fread semantics; errno text in err on failure.
+  std::size_t read(char* dst, std::size_t n, std::string& err) {
+    std::size_t got = 0;
+    if (pos_ < head_.size()) {
+      got = std::min(n, head_.size() - pos_);
+      std::memcpy(dst, head_.data() + pos_, got);
+      pos_ += got;
+      if (got == n) return got;
+    }
+    const std::size_t more = std::fread(dst + got, 1, n - got, f_);
+    if (more == 0 && got == 0 && std::ferror(f_)) err = std::strerror(errno);
+    return got + more;
+  }
+
+private:
+  FILE* f_;
+  std::string head_;
+  std::size_t pos_ = 0;
+};
+
+class FileSource : public ByteSource {
+public:
+  FileSource(FILE* f, std::string head) : in_(f, std::move(head)) {}
+
+  std::size_t read(char* dst, std::size_t n) override {
+    TS_TRACE_SCOPE_CAT("chunk_reader.read", "io");
+    const std::size_t got = in_.read(dst, n, err_);
+    raw_.add(got);
+    return got;
+  }
+  std::uint64_t raw_bytes() const override { return raw_.get(); }
+
+private:
+  RawInput in_;
+  Counter raw_;
+};
+
+// Shared input buffering and timing for the codecs below.
+class DecoderSource : public ByteSource {
+public:
+  DecoderSource(FILE* f, std::string head) : file_(f, std::move(head)), in_(kInputBytes) {}
+  std::uint64_t raw_bytes() const override { return raw_.get(); }
+  std::uint64_t decode_ns() const override { return ns_.get(); }
+
+protected:
+  // Refill in_ once avail_ is used up; false at EOF or on error.
+  bool refill() {
+    TS_TRACE_SCOPE_CAT("decompress.read", "io");
+    avail_ = file_.read(in_.data(), in_.size(), err_);
+    raw_.add(avail_);
+    return avail_ > 0;
+  }
+
+  RawInput file_;
+  std::vector<char> in_;
+  std::size_t avail_ = 0;
+  Counter raw_, ns_;
+};
+
+class ScopedNs {
+public:
+  explicit ScopedNs(Counter& c) : c_(c), t0_(std::chrono::steady_clock::now()) {}
+  ~ScopedNs() {
+    c_.add(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - t0_).count()));
+  }
+
+private:
+  Counter& c_;
+  std::chrono::steady_clock::time_point t0_;
+};
+
+#if TS_HAVE_ZLIB
+// gzip (also concatenated members, as written by pigz/bgzip) and zlib.
+class GzipSource : public DecoderSource {
+public:
+  GzipSource(FILE* f, std::string head) : DecoderSource(f, std::move(head)) {
+    if (inflateInit2(&zs_, 15 + 32) != Z_OK) err_ = "inflateInit2 failed";
+  }
+  ~GzipSource() override { inflateEnd(&zs_); }
+
+  std::size_t read(char* dst, std::size_t n) override {
+    TS_TRACE_SCOPE_CAT("decompress.gzip", "io");
+    ScopedNs timed(ns_);
+    if (!err_.empty() || done_) return 0;
+    zs_.next_out = reinterpret_cast<Bytef*>(dst);
+    zs_.avail_out = static_cast<uInt>(n);
+    while (zs_.avail_out > 0) {
+      if (zs_.avail_in == 0) {
+        if (!refill()) {
+          if (err_.empty() && in_member_) err_ = "gzip: truncated input";
+          done_ = true;
+          break;
+        }
+        zs_.next_in = reinterpret_cast<Bytef*>(in_.data());
+        zs_.avail_in = static_cast<uInt>(avail_);
+      }
+      in_member_ = true;
+      const int rc = inflate(&zs_, Z_NO_FLUSH);
+      if (rc == Z_STREAM_END) {
+        in_member_ = false;
+        inflateReset(&zs_); // another member may follow
+      } else if (rc != Z_OK && rc != Z_BUF_ERROR) {
+        err_ = std::string("gzip: ") + (zs_.msg ? zs_.msg : "inflate failed");
+        done_ = true;
+        break;
+      }
+    }
+    return n - zs_.avail_out;
+  }
+
+private:
+  z_stream zs_{};
+  bool in_member_ = false;
+  bool done_ = false;
+};
+#endif
+
+#if TS_HAVE_ZSTD
+// zstd, including multi-frame files (frames are decoded back to back).
+class ZstdSource : public DecoderSource {
+public:
+  ZstdSource(FILE* f, std::string head) : DecoderSource(f, std::move(head)), ds_(ZSTD_createDStream()) {
+    if (!ds_) err_ = "ZSTD_createDStream failed";
+  }
+  ~ZstdSource() override { ZSTD_freeDStream(ds_); }
+
+  std::size_t read(char* dst, std::size_t n) override {
+    TS_TRACE_SCOPE_CAT("decompress.zstd", "io");
+    ScopedNs timed(ns_);
+    if (!err_.empty() || done_) return 0;
+    ZSTD_outBuffer out{dst, n, 0};
+    while (out.pos < out.size) {
+      if (zin_.pos == zin_.size) {
+        if (!refill()) {
+          if (err_.empty() && pending_ != 0) err_ = "zstd: truncated input";
+          done_ = true;
+          break;
+        }
+        zin_ = ZSTD_inBuffer{in_.data(), avail_, 0};
+      }
+      pending_ = ZSTD_decompressStream(ds_, &out, &zin_);
+      if (ZSTD_isError(pending_)) {
+        err_ = std::string("zstd: ") + ZSTD_getErrorName(pending_);
+        done_ = true;
+        break;
+      }
+    }
+    return out.pos;
+  }
+
+private:
+  ZSTD_DStream* ds_;
+  ZSTD_inBuffer zin_{nullptr, 0, 0};
+  std::size_t pending_ = 0; // 0 = at a frame boundary
+  bool done_ = false;
+};
+#endif
+
+// Decodes as pool tasks; blocks travel through a pair of SPSC rings
+// (filled ones to the reader, drained ones back for reuse). A reader that
+// finds the ring empty decodes the next block itself unless a task already
+// is, so no worker ever sleeps waiting on the other side.
+class PrefetchSource : public ByteSource {
+public:
+  PrefetchSource(std::unique_ptr<ByteSource> inner, std::size_t block_bytes, std::size_t depth,
+                 TaskPool& pool)
+    : inner_(std::move(inner)), full_(depth), free_(depth + 1), group_(pool),
+      decoder_(group_, [this]{ return produce(); }) {
+    for (std::size_t i = 0; i < depth; ++i) {
+      auto b = std::make_unique<Block>();
+      b->data.resize(block_bytes);
+      free_.try_push(b);
+    }
+    decoder_.schedule();
+  }
+
+  ~PrefetchSource() override {
+    stop_.store(true, std::memory_order_relaxed);
+    group_.wait(); // a queued decode task still points here
+  }
+
+  std::size_t read(char* dst, std::size_t n) override {
+    std::size_t copied = 0;
+    while (copied < n) {
+      if (!cur_ || pos_ == cur_->n) {
+        if (cur_) {
+          (void)free_.try_push(cur_); // never full: it holds every block
+          cur_.reset();
+          decoder_.schedule();
+        }
+        if (!next_block()) { finish(); break; }
+        pos_ = 0;
+      }
+      const std::size_t take = std::min(n - copied, cur_->n - pos_);
+      std::memcpy(dst + copied, cur_->data.data() + pos_, take);
+      pos_ += take;
+      copied += take;
+    }
+    return copied;
+  }
+
+  std::uint64_t raw_bytes() const override { return inner_->raw_bytes(); }
+  std::uint64_t decode_ns() const override { return inner_->decode_ns(); }
+
+private:
+  struct Block {
+    std::vector<char> data;
+    std::size_t n = 0;
+  };
+  using BlockPtr = std::unique_ptr<Block>;
+
+  bool next_block() {
+    for (unsigned idle = 0; ; ) {
+      const bool done = decoder_.finished(); // before the pop: its last block is visible
+      if (full_.try_pop(cur_)) return true;
+      if (done) return false;
+      if (!decoder_.help()) SpscQueue<BlockPtr>::backoff(idle);
+    }
+  }
+
+  // One pass: fill every free block, then return; the reader schedules the
+  // next pass as it hands blocks back. True at the end of the input.
+  bool produce() {
+    TS_TRACE_SCOPE("decompress.pass");
+    BlockPtr b;
+    while (free_.try_pop(b)) {
+      if (stop_.load(std::memory_order_relaxed)) return true;
+      b->n = 0;
+      while (b->n < b->data.size()) {
+        const std::size_t got = inner_->read(b->data.data() + b->n, b->data.size() - b->n);
+        if (got == 0) break;
+        b->n += got;
+      }
+      const bool last = b->n < b->data.size();
+      if (b->n > 0) (void)full_.try_push(b); // room for every block
+      if (last) return true;
+    }
+    return stop_.load(std::memory_order_relaxed);
+  }
+
+  // End of stream: the decoder is done, so its error is safe to read.
+  void finish() {
+    if (err_.empty()) err_ = inner_->error();
+  }
+
+  std::unique_ptr<ByteSource> inner_;
+  SpscQueue<BlockPtr> full_, free_;
+  std::atomic<bool> stop_{false};
+  TaskGroup group_;
+  SerialTask decoder_;
+  BlockPtr cur_;
+  std::size_t pos_ = 0;
+};
+
+bool ends_with(std::string_view s, std::string_view suf) {
+  return s.size() >= suf.size() && s.substr(s.size() - suf.size()) == suf;
+}
+
+std::size_t read_at(FILE* f, std::uint64_t off, unsigned char* dst, std::size_t n) {
+#if defined(_WIN32)
+  if (_fseeki64(f, static_cast<__int64>(off), SEEK_SET) != 0) return 0;
+#else
+  if (fseeko(f, static_cast<off_t>(off), SEEK_SET) != 0) return 0;
+#endif
+  return std::fread(dst, 1, n, f);
+}
+
+std::uint32_t le16(const unsigned char* p) { return p[0] | (p[1] << 8); }
+std::uint32_t le32(const unsigned char* p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<std::uint32_t>(p[3]) << 24);
+}
+
+// BGZF: every member is a gzip block whose extra field holds BC/BSIZE
+// (block size - 1); ISIZE in the trailer is its decoded size.
+bool index_bgzf(FILE* f, std::uint64_t size, std::vector<CompressedFrame>& out) {
+  std::uint64_t off = 0, out_off = 0;
+  unsigned char h[12 + 64];
+  while (off < size) {
+    const std::size_t n = read_at(f, off, h, sizeof(h));
+    if (n < 18 || h[0] != 0x1f || h[1] != 0x8b || h[2] != 8 || !(h[3] & 4)) return false;
+    const std::uint32_t xlen = le16(h + 10);
+    std::uint64_t bsize = 0;
+    for (std::uint32_t x = 12; x + 4 <= 12 + xlen && x + 4 <= n;) {
+      const std::uint32_t slen = le16(h + x + 2);
+      if (h[x] == 'B' && h[x + 1] == 'C' && slen == 2 && x + 6 <= n) { bsize = le16(h + x + 4) + 1ull; break; }
+      x += 4 + slen;
+    }
+    if (bsize < 26 || off + bsize > size) return false;
+    unsigned char isize[4];
+    if (read_at(f, off + bsize - 4, isize, 4) != 4) return false;
+    out.push_back({off, bsize, out_off, le32(isize)});
+    off += bsize;
+    out_off += le32(isize);
+  }
+  return true;
+}
+
+// zstd: sizes come from the frame header and a walk over the block
+// headers (3 bytes each); skippable frames (e.g. a seek table) decode to
+// nothing. Frames without a content size cannot be placed.
+bool index_zstd(FILE* f, std::uint64_t size, std::vector<CompressedFrame>& out) {
+  std::uint64_t off = 0, out_off = 0;
+  unsigned char h[18]; // longest frame header
+  while (off < size) {
+    const std::size_t n = read_at(f, off, h, sizeof(h));
+    if (n < 8) return false;
+    const std::uint32_t magic = le32(h);
+    if ((magic & 0xFFFFFFF0u) == 0x184D2A50u) { // skippable frame
+      const std::uint64_t len = 8ull + le32(h + 4);
+      out.push_back({off, len, out_off, 0});
+      off += len;
+      continue;
+    }
+    if (magic != 0xFD2FB528u) return false;
+    const unsigned fhd = h[4];
+    const bool single_segment = fhd & 0x20;
+    static constexpr unsigned kDictIdBytes[4] = {0, 1, 2, 4};
+    static constexpr unsigned kSizeBytes[4] = {0, 2, 4, 8};
+    const unsigned fcs_bytes = (fhd >> 6) == 0 ? (single_segment ? 1 : 0) : kSizeBytes[fhd >> 6];
+    if (fcs_bytes == 0) return false;
+    const std::size_t fcs_at = 5 + (single_segment ? 0 : 1) + kDictIdBytes[fhd & 3];
+    if (fcs_at + fcs_bytes > n) return false;
+    std::uint64_t content = 0;
+    for (unsigned i = 0; i < fcs_bytes; ++i) content |= static_cast<std::uint64_t>(h[fcs_at + i]) << (8 * i);
+    if (fcs_bytes == 2) content += 256;
+
+    std::uint64_t pos = off + fcs_at + fcs_bytes;
+    for (bool last = false; !last;) {
+      unsigned char b[3];
+      if (read_at(f, pos, b, 3) != 3) return false;
+      const std::uint32_t bh = b[0] | (b[1] << 8) | (b[2] << 16);
+      last = bh & 1;
+      const std::uint32_t type = (bh >> 1) & 3;
+      if (type == 3) return false; // reserved
+      pos += 3 + (type == 1 ? 1 : (bh >> 3)); // RLE blocks store one byte
+    }
+    if (fhd & 0x04) pos += 4; // content checksum
+    if (pos > size) return false;
+    out.push_back({off, pos - off, out_off, content});
+    off = pos;
+    out_off += content;
+  }
+  return true;
+}
+
+}
+
+const char* compression_name(Compression c) {
+  switch (c) {
+    case Compression::Gzip: return "gzip";
+    case Compression::Zstd: return "zstd";
+    default:                return "none";
+  }
+}
+
+Compression compression_from_magic(std::string_view head) {
+  if (head.size() >= 2 && static_cast<unsigned char>(head[0]) == 0x1f &&
+      static_cast<unsigned char>(head[1]) == 0x8b) {
+    return Compression::Gzip;
+  }
+  if (head.size() >= 4 && head.substr(0, 4) == std::string_view("\x28\xb5\x2f\xfd", 4)) {
+    return Compression::Zstd;
+  }
+  return Compression::None;
+}
+
+Compression detect_compression(const std::string& path) {
+  std::error_code ec;
+  // Reading the magic would consume a pipe; those go by name only.
+  FILE* f = std::filesystem::is_regular_file(path, ec) ? std::fopen(path.c_str(), "rb") : nullptr;
+  if (f) {
+    char head[4];
+    const std::size_t n = std::fread(head, 1, sizeof(head), f);
+    std::fclose(f);
+    const Compression c = compression_from_magic(std::string_view(head, n));
+    if (c != Compression::None || n > 0) return c; // content wins over the name
+  }
+  if (ends_with(path, ".gz") || ends_with(path, ".gzip")) return Compression::Gzip;
+  if (ends_with(path, ".zst") || ends_with(path, ".zstd")) return Compression::Zstd;
+  return Compression::None;
+}
+
+bool compression_supported(Compression c) {
+  switch (c) {
+    case Compression::None: return true;
+    case Compression::Gzip: return TS_HAVE_ZLIB != 0;
+    case Compression::Zstd: return TS_HAVE_ZSTD != 0;
+  }
+  return false;
+}
+
+std::unique_ptr<ByteSource> open_byte_source(FILE* f, Compression c, std::string* err_out,
+                                             std::string head) {
+  switch (c) {
+    case Compression::None:
+      return std::make_unique<FileSource>(f, std::move(head));
+#if TS_HAVE_ZLIB
+    case Compression::Gzip:
+      return std::make_unique<GzipSource>(f, std::move(head));
+#endif
+#if TS_HAVE_ZSTD
+    case Compression::Zstd:
+      return std::make_unique<ZstdSource>(f, std::move(head));
+#endif
+    default:
+      break;
+  }
+  std::fclose(f);
+  if (err_out) *err_out = std::string(compression_name(c)) + " support is not compiled in";
+  return nullptr;
+}
+
+bool index_frames(const std::string& path, Compression c, std::vector<CompressedFrame>& out,
+                  std::string* err_out) {
+  TS_TRACE_SCOPE_CAT("decompress.index", "io");
+  out.clear();
+  std::error_code ec;
+  const std::uint64_t size = std::filesystem::file_size(path, ec);
+  if (ec) { if (err_out) *err_out = ec.message(); return false; }
+  FILE* f = std::fopen(path.c_str(), "rb");
+  if (!f) { if (err_out) *err_out = std::strerror(errno); return false; }
+  bool ok = false;
+  if (c == Compression::Gzip) ok = index_bgzf(f, size, out);
+  else if (c == Compression::Zstd) ok = index_zstd(f, size, out);
+  std::fclose(f);
+  if (!ok) out.clear();
+  return ok;
+}
+
+std::unique_ptr<ByteSource> make_prefetch_source(std::unique_ptr<ByteSource> inner,
+                                                 std::size_t block_bytes, std::size_t depth,
+                                                 TaskPool* pool) {
+  return std::make_unique<PrefetchSource>(std::move(inner), block_bytes, depth,
+                                          pool ? *pool : TaskPool::global());
+}
+
+}
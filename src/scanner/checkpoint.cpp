@@ -0,0 +1,214 @@
+#include "typed_scanner/checkpoint.hpp"
+#include "typed_scanner/fingerprint.hpp"
+#include "typed_scanner/path_utils.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace ts {
+
+namespace {
+
+constexpr std::string_view kMagic = "typed-scanner checkpoint 1";
+
+// Names go last on their line; keep them on it.
+std::string escape(std::string_view s) {
+  std::string out;
+  for (char c : s) {
+    if (c == '\\') out += "\\\\";
+    else if (c == '\t') out += "\\t";
+    else if (c == '\n') out += "\\n";
+    else if (c == '\r') out += "\\r";
+    else out += c;
+  }
+  return out;
+}
+
+std::string unescape(std::string_view s) {
+  std::string out;
+  for (std::size_t i = 0; i < s.size(); ++i) {
+    if (s[i] != '\\' || i + 1 == s.size()) { out += s[i]; continue; }
+    const char c = s[++i];
+    out += c == 't' ? '\t' : c == 'n' ? '\n' : c == 'r' ? '\r' : c;
+  }
+  return out;
+}
+
+std::vector<std::string_view> split_tabs(std::string_view line, std::size_t max_parts) {
+  std::vector<std::string_view> parts;
+  while (parts.size() + 1 < max_parts) {
+    const auto tab = line.find('\t');
+    if (tab == std::string_view::npos) break;
+    parts.push_back(line.substr(0, tab));
+    line.remove_prefix(tab + 1);
+  }
+  parts.push_back(line);
+  return parts;
+}
+
+std::uint64_t to_u64(std::string_view s, int base = 10) {
+  return std::strtoull(std::string(s).c_str(), nullptr, base);
+}
+
+double to_double(std::string_view s) { return std::strtod(std::string(s).c_str(), nullptr); }
+
+std::string hex64(std::uint64_t v) {
+  char buf[17];
+  std::snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(v));
+  return buf;
+}
+
+std::string num(double v) {
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), "%.17g", v);
+  return buf;
+}
+
+}
+
+bool load_checkpoint(const std::string& path, ScanCheckpoint& out, std::string* err_out) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    if (err_out) *err_out = "cannot read " + path;
+    return false;
+  }
+  std::string line;
+  if (!std::getline(in, line) || line != kMagic) {
+    if (err_out) *err_out = path + ": not a checkpoint";
+    return false;
+  }
+  out = ScanCheckpoint{};
+  while (std::getline(in, line)) {
+    const auto kv = split_tabs(line, 2);
+    if (kv.size() < 2) continue;
+    const std::string_view key = kv[0], val = kv[1];
+    if (key == "format")        out.format = std::string(val);
+    else if (key == "settings") out.settings = std::string(val);
+    else if (key == "offset")   out.offset = to_u64(val);
+    else if (key == "rows")     out.rows = to_u64(val);
+    else if (key == "head")     out.head_hash = to_u64(val, 16);
+    else if (key == "tail")     out.tail_hash = to_u64(val, 16);
+    else if (key == "kind")     out.kinds.push_back(static_cast<FieldKind>(to_u64(val)));
+    else if (key == "error") {
+      const auto f = split_tabs(val, 2);
+      if (f.size() == 2) out.errors_by_field[unescape(f[1])] = to_u64(f[0]);
+    } else if (key == "column") {
+      // count nulls errors numbers bools dates strings min max sum name
+      const auto f = split_tabs(val, 11);
+      if (f.size() != 11) {
+        if (err_out) *err_out = path + ": bad column line";
+        return false;
+      }
+      ColumnStats c;
+      c.count = to_u64(f[0]);
+      c.nulls = to_u64(f[1]);
+      c.errors = to_u64(f[2]);
+      c.numbers = to_u64(f[3]);
+      c.bools = to_u64(f[4]);
+      c.dates = to_u64(f[5]);
+      c.strings = to_u64(f[6]);
+      c.min = to_double(f[7]);
+      c.max = to_double(f[8]);
+      c.sum = to_double(f[9]);
+      c.name = unescape(f[10]);
+      merge_column_stats(c, ColumnStats{}); // recompute type
+      out.columns.push_back(std::move(c));
+    }
+  }
+  return true;
+}
+
+bool save_checkpoint(const std::string& path, const ScanCheckpoint& cp, std::string* err_out) {
+  const std::string tmp = path + ".tmp";
+  ensure_parent_dirs(path);
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    out << kMagic << '\n'
+        << "format\t" << cp.format << '\n'
+        << "settings\t" << cp.settings << '\n'
+        << "offset\t" << cp.offset << '\n'
+        << "rows\t" << cp.rows << '\n'
+        << "head\t" << hex64(cp.head_hash) << '\n'
+        << "tail\t" << hex64(cp.tail_hash) << '\n';
+    for (FieldKind k : cp.kinds) out << "kind\t" << static_cast<unsigned>(k) << '\n';
+    for (const auto& c : cp.columns) {
+      out << "column\t" << c.count << '\t' << c.nulls << '\t' << c.errors << '\t'
+          << c.numbers << '\t' << c.bools << '\t' << c.dates << '\t' << c.strings << '\t'
+          << num(c.min) << '\t' << num(c.max) << '\t' << num(c.sum) << '\t'
+          << escape(c.name) << '\n';
+    }
+    for (const auto& [field, n] : cp.errors_by_field) out << "error\t" << n << '\t' << escape(field) << '\n';
+    if (!out.flush()) {
+      if (err_out) *err_out = "cannot write " + tmp;
+      return false;
+    }
+  }
+  std::error_code ec;
+  std::filesystem::rename(tmp, path, ec);
+  if (ec) {
+    if (err_out) *err_out = "rename " + tmp + ": " + ec.message();
+    return false;
+  }
+  return true;
+}
+
+bool checkpoint_hashes(const std::string& path, std::uint64_t offset,
+                       std::uint64_t& head, std::uint64_t& tail, std::string* err_out) {
+  const std::uint64_t block = std::min<std::uint64_t>(offset, kCheckpointBlock);
+  return hash_file_range(path, 0, block, head, err_out) &&
+         hash_file_range(path, offset - block, offset, tail, err_out);
+}
+
+bool checkpoint_matches(const ScanCheckpoint& cp, const std::string& path) {
+  std::error_code ec;
+  const std::uint64_t size = std::filesystem::file_size(path, ec);
+  if (ec || size < cp.offset) return false; // truncated or rotated
+  std::uint64_t head = 0, tail = 0;
+  return checkpoint_hashes(path, cp.offset, head, tail) &&
+         head == cp.head_hash && tail == cp.tail_hash;
+}
+
+std::string checkpoint_etag(const std::string& path, std::uint64_t size, std::string* err_out) {
+  std::uint64_t head = 0, tail = 0;
+  if (!checkpoint_hashes(path, size, head, tail, err_out)) return {};
+  char sz[24];
+  std::snprintf(sz, sizeof(sz), "%llx", static_cast<unsigned long long>(size));
+  return "append-" + std::string(sz) + "-" + hex64(head) + hex64(tail);
+}
+
+std::uint64_t last_line_end(const std::string& path, std::uint64_t size, std::string* err_out) {
+  std::unique_ptr<FILE, int(*)(FILE*)> f(std::fopen(path.c_str(), "rb"), &std::fclose);
+  if (!f) {
+    if (err_out) *err_out = path + ": " + std::strerror(errno);
+    return 0;
+  }
+  std::vector<char> buf(kCheckpointBlock);
+  for (std::uint64_t end = size; end > 0;) {
+    const std::uint64_t begin = end > buf.size() ? end - buf.size() : 0;
+    const std::size_t n = static_cast<std::size_t>(end - begin);
+#if defined(_WIN32)
+    const bool seeked = _fseeki64(f.get(), static_cast<long long>(begin), SEEK_SET) == 0;
+#else
+    const bool seeked = fseeko(f.get(), static_cast<off_t>(begin), SEEK_SET) == 0;
+#endif
+    if (!seeked || std::fread(buf.data(), 1, n, f.get()) != n) {
+      if (err_out) *err_out = path + ": " + std::strerror(errno);
+      return 0;
+    }
+    for (std::size_t i = n; i > 0; --i) {
+      if (buf[i - 1] == '\n') return begin + i;
+    }
+    end = begin;
+  }
+  return 0;
+}
+
+}
@@ -1,35 +1,158 @@
 #include "typed_scanner/chunk_reader.hpp"
+#include "typed_scanner/byte_source.hpp"
+#include "typed_scanner/path_utils.hpp"
+#include "typed_scanner/trace.hpp"
+#include <cerrno>
+#include <chrono>
 #include <cstdio>
 #include <cstring>
 #include <string_view>
 #include <vector>
 
+#if defined(__linux__)
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
+
 namespace ts {
 
+namespace {
+
+bool seek_to(FILE* f, std::uint64_t off) {
+#if defined(_WIN32)
+  return _fseeki64(f, static_cast<__int64>(off), SEEK_SET) == 0;
+#else
+  return fseeko(f, static_cast<off_t>(off), SEEK_SET) == 0;
+#endif
+}
+
+// "-" is stdin (dup'ed, so closing the reader leaves fd 0 alone).
+FILE* open_input(const std::string& path, bool stream) {
+  FILE* f = nullptr;
+#if defined(__linux__)
+  if (path == "-") {
+    const int fd = ::dup(STDIN_FILENO);
+    f = fd < 0 ? nullptr : ::fdopen(fd, "rb");
+    if (!f && fd >= 0) ::close(fd);
+  } else {
+    f = std::fopen(path.c_str(), "rb");
+  }
+  // Fewer, larger reads from a pipe: grow its buffer (best effort).
+  if (f && stream) (void)::fcntl(::fileno(f), F_SETPIPE_SZ, 1 << 20);
+#else
+  (void)stream;
+  f = path == "-" ? stdin : std::fopen(path.c_str(), "rb");
+#endif
+  return f;
+}
+
+}
+
 struct ChunkReader::Impl {
   std::string path;
   Config cfg;
   int last_errno{0};
   std::uint64_t bytes{0};
+  ChunkCallback on_chunk;
+  Compression compression{Compression::None};
+  std::uint64_t raw_bytes{0};
+  std::uint64_t decode_ns{0};
+  std::string error;
 
   bool for_each_line(const LineCallback& cb) {
-    FILE* f = std::fopen(path.c_str(), "rb");
+    TS_TRACE_SCOPE_CAT("chunk_reader.file", "io");
+    const bool stream = is_stream_path(path);
+    FILE* f = open_input(path, stream);
     if (!f) { last_errno = errno; return false; }
 
+    // Compressed input (by magic bytes) is decoded as it is read; ranges
+    // start decoding at a frame boundary. A stream cannot seek back, so
+    // its sniffed bytes are replayed instead.
+    std::string head;
+    if (cfg.decompress) {
+      head.resize(4);
+      head.resize(std::fread(head.data(), 1, head.size(), f));
+      compression = compression_from_magic(head);
+      if (!stream) {
+        head.clear();
+        if (!seek_to(f, 0)) { last_errno = errno; std::fclose(f); return false; }
+      }
+    }
+    const bool compressed = compression != Compression::None;
+    const bool ranged = cfg.begin_offset > 0 || (stream && cfg.end_offset > 0);
+    if (ranged && (stream || (compressed && cfg.frame_offset == 0))) {
+      error = std::string(stream ? "a stream" : compression_name(compression)) +
+              " input cannot be read by byte range";
+      last_errno = EINVAL;
+      std::fclose(f);
+      return false;
+    }
+
     std::vector<char> buf(cfg.chunk_bytes + 1, 0);
     std::string carry;
     carry.reserve(256);
     bool skipping_oversize = false; // if true, drop until next newline
 
-    while (true) {
-      std::size_t n = std::fread(buf.data(), 1, cfg.chunk_bytes, f);
-      if (n == 0 && std::ferror(f)) { last_errno = errno; std::fclose(f); return false; }
-      if (n == 0 && std::feof(f))   break;
+    // Byte range: a line belongs to the range its first byte falls in. Start
+    // one byte early and drop through the first newline, so a range that
+    // begins exactly on a line start keeps that line.
+    std::uint64_t block_off = 0;
+    std::uint64_t stop_at = cfg.end_offset;
+    if (compressed) {
+      // Decoded ranges own the lines after their newlines: drop through the
+      // first one and stop at the first line start past end_offset.
+      block_off = cfg.begin_offset;
+      if (stop_at) ++stop_at;
+      if (cfg.begin_offset > 0) {
+        if (!seek_to(f, cfg.frame_offset)) { last_errno = errno; std::fclose(f); return false; }
+        skipping_oversize = true;
+      }
+    } else if (cfg.begin_offset > 0) {
+      block_off = cfg.begin_offset - 1;
+      if (!seek_to(f, block_off)) { last_errno = errno; std::fclose(f); return false; }
+      skipping_oversize = true;
+    }
+    std::unique_ptr<ByteSource> src = open_byte_source(f, compression, &error, std::move(head)); // owns f
+    if (!src) { last_errno = ENOTSUP; return false; }
+    if (compressed && cfg.decompress_thread) {
+      src = make_prefetch_source(std::move(src), cfg.chunk_bytes, 4, cfg.pool);
+    }
+    auto finish_source = [&]{
+      raw_bytes = src->raw_bytes();
+      decode_ns = src->decode_ns();
+      if (!src->error().empty()) {
+        error = src->error();
+        last_errno = EIO;
+        return false;
+      }
+      return true;
+    };
+    bool done = false;
+    bool at_input_start = cfg.strip_bom && block_off == 0 && !skipping_oversize;
+
+    while (!done) {
+      const bool cancelled = cfg.cancel && cfg.cancel->load(std::memory_order_relaxed);
+      if (cancelled || (cfg.stop && cfg.stop->load(std::memory_order_relaxed))) {
+        (void)finish_source();
+        error = cancelled ? "cancelled" : "stopped";
+        last_errno = ECANCELED;
+        return false;
+      }
+      const std::size_t n = src->read(buf.data(), cfg.chunk_bytes);
+      if (n == 0) break;
       bytes += n;
+      const auto t_block = std::chrono::steady_clock::now();
+      TS_TRACE_SCOPE("chunk_reader.dispatch");
 
       std::string_view block(buf.data(), n);
       std::size_t start = 0;
+      if (at_input_start) {
+        at_input_start = false;
+        if (block.substr(0, 3) == "\xEF\xBB\xBF") start = 3;
+      }
       while (true) {
+        if (stop_at && !skipping_oversize && carry.empty() &&
+            block_off + start >= stop_at) { done = true; break; }
         std::size_t pos = block.find('\n', start);
         const bool hit_nl = (pos != std::string_view::npos);
         std::string_view slice = hit_nl ? block.substr(start, pos - start)
@@ -80,6 +203,13 @@ struct ChunkReader::Impl {
 
         start = pos + 1;
       }
+
+      if (on_chunk) {
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - t_block).count();
+        on_chunk(n, static_cast<std::uint64_t>(ns));
+      }
+      block_off += n;
     }
 
     if (!carry.empty() && !skipping_oversize) {
@@ -89,8 +219,7 @@ struct ChunkReader::Impl {
       carry.clear();
     }
 
-    std::fclose(f);
-    return true;
+    return finish_source();
   }
 };
 
@@ -103,8 +232,13 @@ ChunkReader::ChunkReader(std::string path, Config cfg)
 ChunkReader::~ChunkReader() { delete p_; }
 
 bool ChunkReader::for_each_line(const LineCallback& cb) { return p_->for_each_line(cb); }
+void ChunkReader::on_chunk(ChunkCallback cb) { p_->on_chunk = std::move(cb); }
 int  ChunkReader::last_error() const noexcept { return p_->last_errno; }
 std::uint64_t ChunkReader::bytes_read() const noexcept { return p_->bytes; }
+std::uint64_t ChunkReader::raw_bytes_read() const noexcept { return p_->raw_bytes; }
+Compression ChunkReader::compression() const noexcept { return p_->compression; }
+std::uint64_t ChunkReader::decompress_ns() const noexcept { return p_->decode_ns; }
+const std::string& ChunkReader::error() const noexcept { return p_->error; }
 
 bool ChunkReader::read_next(std::string_view& out) {
   bool got = false;
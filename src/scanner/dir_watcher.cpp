@@ -0,0 +1,233 @@
+#include "typed_scanner/dir_watcher.hpp"
+#include "typed_scanner/trace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+#if defined(__linux__)
+  #include <poll.h>
+  #include <sys/inotify.h>
+  #include <unistd.h>
+#endif
+
+namespace ts {
+
+bool glob_match(std::string_view p, std::string_view s) {
+  if (p.empty()) return s.empty();
+  if (p.substr(0, 3) == "**/") {
+    if (glob_match(p.substr(3), s)) return true;              // zero directories
+    const auto slash = s.find('/');
+    return slash != std::string_view::npos && glob_match(p, s.substr(slash + 1));
+  }
+  if (p == "**") return true;
+  if (p[0] == '*') {
+    for (std::size_t i = 0;; ++i) {
+      if (glob_match(p.substr(1), s.substr(i))) return true;
+      if (i == s.size() || s[i] == '/') return false;
+    }
+  }
+  if (s.empty()) return false;
+  if (p[0] == '?') return s[0] != '/' && glob_match(p.substr(1), s.substr(1));
+  return p[0] == s[0] && glob_match(p.substr(1), s.substr(1));
+}
+
+struct DirWatcher::Impl {
+  using Clock = std::chrono::steady_clock;
+
+  Config cfg;
+  Callback cb;
+  BatchCallback on_batch;
+  std::thread th;
+  int ifd = -1;
+  int wake[2] = {-1, -1};
+  std::unordered_map<int, std::string> dirs; // watch descriptor -> directory
+  std::unordered_map<std::string, std::pair<Event, Clock::time_point>> pending;
+
+  bool wanted(const std::string& path) const {
+    std::string_view rel(path);
+    if (rel.substr(0, cfg.root.size()) == cfg.root) rel.remove_prefix(cfg.root.size());
+    while (!rel.empty() && rel.front() == '/') rel.remove_prefix(1);
+    auto any = [&](const std::vector<std::string>& globs){
+      return std::any_of(globs.begin(), globs.end(),
+                         [&](const std::string& g){ return glob_match(g, rel); });
+    };
+    return any(cfg.include) && !any(cfg.exclude);
+  }
+
+  void queue(const std::string& path, Event ev) {
+    if (!wanted(path)) return;
+    pending[path] = {ev, Clock::now() + std::chrono::milliseconds(cfg.debounce_ms)};
+  }
+
+#if defined(__linux__)
+  static constexpr std::uint32_t kMask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM |
+                                         IN_DELETE | IN_CREATE | IN_ONLYDIR;
+
+  // Watch `dir` and everything below it; report_files queues what is there
+  // (initial scan, or a directory that was created/moved in).
+  void add_tree(const std::string& dir, bool report_files) {
+    const int wd = inotify_add_watch(ifd, dir.c_str(), kMask);
+    if (wd < 0) {
+      std::cerr << "[watch] " << dir << ": " << std::strerror(errno) << "\n";
+      return;
+    }
+    dirs[wd] = dir;
+    std::error_code ec;
+    for (std::filesystem::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+      const std::string p = it->path().string();
+      std::error_code tec;
+      if (!cfg.recursive) {
+        if (report_files && it->is_directory(tec)) queue(p, Event::Changed);
+        continue;
+      }
+      if (it->is_directory(tec)) add_tree(p, report_files);
+      else if (report_files && it->is_regular_file(tec)) queue(p, Event::Changed);
+    }
+  }
+
+  // A directory moved out of the tree keeps its watches under a stale path.
+  void drop_tree(const std::string& dir) {
+    for (auto it = dirs.begin(); it != dirs.end();) {
+      const std::string& d = it->second;
+      if (d == dir || (d.size() > dir.size() && d.compare(0, dir.size(), dir) == 0 && d[dir.size()] == '/')) {
+        inotify_rm_watch(ifd, it->first);
+        it = dirs.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  void handle(const inotify_event& e) {
+    if (e.mask & IN_Q_OVERFLOW) {
+      // Events were lost: rescan everything (unchanged files are skipped by etag).
+      std::cerr << "[watch] event queue overflow; rescanning " << cfg.root << "\n";
+      for (const auto& [wd, d] : dirs) inotify_rm_watch(ifd, wd);
+      dirs.clear();
+      add_tree(cfg.root, true);
+      return;
+    }
+    if (e.mask & IN_IGNORED) { dirs.erase(e.wd); return; }
+    const auto it = dirs.find(e.wd);
+    if (it == dirs.end() || e.len == 0) return;
+    const std::string path = it->second + "/" + e.name;
+
+    if (!cfg.recursive) {
+      if (!(e.mask & IN_ISDIR)) return;
+      if (e.mask & (IN_CREATE | IN_MOVED_TO)) queue(path, Event::Changed);
+      else if (e.mask & (IN_DELETE | IN_MOVED_FROM)) queue(path, Event::Deleted);
+      return;
+    }
+    if (e.mask & IN_ISDIR) {
+      if (e.mask & (IN_CREATE | IN_MOVED_TO)) add_tree(path, true);
+      else if (e.mask & IN_MOVED_FROM) drop_tree(path);
+      return;
+    }
+    if (e.mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) queue(path, Event::Changed);
+    else if (e.mask & (IN_DELETE | IN_MOVED_FROM)) queue(path, Event::Deleted);
+  }
+
+  void flush_due() {
+    const auto now = Clock::now();
+    std::vector<std::pair<std::string, Event>> due;
+    for (auto it = pending.begin(); it != pending.end();) {
+      if (it->second.second <= now) {
+        due.emplace_back(it->first, it->second.first);
+        it = pending.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    std::sort(due.begin(), due.end());
+    for (const auto& [path, ev] : due) cb(path, ev);
+    if (!due.empty() && on_batch) on_batch();
+  }
+
+  void loop() {
+    if (trace::enabled()) trace::set_thread_name("dir-watcher");
+    alignas(inotify_event) char buf[64 * 1024];
+    for (;;) {
+      int timeout = -1;
+      if (!pending.empty()) {
+        auto next = Clock::time_point::max();
+        for (const auto& kv : pending) next = std::min(next, kv.second.second);
+        const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(next - Clock::now()).count();
+        timeout = static_cast<int>(std::max<long long>(0, ms + 1));
+      }
+      pollfd fds[2] = {{ifd, POLLIN, 0}, {wake[0], POLLIN, 0}};
+      const int n = ::poll(fds, 2, timeout);
+      if (n < 0 && errno != EINTR) break;
+      if (fds[1].revents) break; // stop()
+      if (n > 0 && (fds[0].revents & POLLIN)) {
+        const ssize_t len = ::read(ifd, buf, sizeof(buf));
+        for (ssize_t off = 0; off < len;) {
+          const auto* e = reinterpret_cast<const inotify_event*>(buf + off);
+          handle(*e);
+          off += static_cast<ssize_t>(sizeof(inotify_event) + e->len);
+        }
+      }
+      flush_due();
+    }
+  }
+#endif
+};
+
+DirWatcher::DirWatcher(Config cfg, Callback cb, BatchCallback on_batch) : p_(new Impl) {
+  while (cfg.root.size() > 1 && cfg.root.back() == '/') cfg.root.pop_back();
+  p_->cfg = std::move(cfg);
+  p_->cb = std::move(cb);
+  p_->on_batch = std::move(on_batch);
+}
+
+DirWatcher::~DirWatcher() {
+  stop();
+  delete p_;
+}
+
+bool DirWatcher::start(std::string* err_out) {
+#if defined(__linux__)
+  if (p_->th.joinable()) return true;
+  std::error_code ec;
+  if (!std::filesystem::is_directory(p_->cfg.root, ec)) {
+    if (err_out) *err_out = "not a directory: " + p_->cfg.root;
+    return false;
+  }
+  p_->ifd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (p_->ifd < 0 || ::pipe(p_->wake) != 0) {
+    if (err_out) *err_out = std::string("inotify: ") + std::strerror(errno);
+    stop();
+    return false;
+  }
+  p_->add_tree(p_->cfg.root, p_->cfg.initial_scan);
+  p_->th = std::thread([this]{ p_->loop(); });
+  return true;
+#else
+  if (err_out) *err_out = "--watch needs inotify (Linux only)";
+  return false;
+#endif
+}
+
+void DirWatcher::stop() {
+#if defined(__linux__)
+  if (p_->th.joinable()) {
+    const char c = 1;
+    (void)!::write(p_->wake[1], &c, 1);
+    p_->th.join();
+  }
+  for (int* fd : {&p_->ifd, &p_->wake[0], &p_->wake[1]}) {
+    if (*fd >= 0) ::close(*fd);
+    *fd = -1;
+  }
+  p_->dirs.clear();
+  p_->pending.clear();
+#endif
+}
+
+}
@@ -0,0 +1,82 @@
+#include "typed_scanner/live_scan.hpp"
+
+namespace ts {
+
+LiveScan::LiveScan(std::string slug, std::string filename)
+  : slug_(std::move(slug)), filename_(std::move(filename)) {}
+
+void LiveScan::publish(LiveScanSample s) {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    last_ = std::move(s);
+    ++seq_;
+  }
+  cv_.notify_all();
+}
+
+void LiveScan::finish(bool ok, std::string error) {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    done_ = true;
+    ok_ = ok;
+    error_ = std::move(error);
+  }
+  cv_.notify_all();
+}
+
+std::uint64_t LiveScan::wait(std::uint64_t seen, std::chrono::milliseconds timeout,
+                             LiveScanSample& out) const {
+  std::unique_lock<std::mutex> lk(mu_);
+  cv_.wait_for(lk, timeout, [&]{ return seq_ != seen || done_; });
+  if (seq_ != seen) out = last_;
+  return seq_;
+}
+
+bool LiveScan::done() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return done_;
+}
+
+bool LiveScan::ok() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return ok_;
+}
+
+std::string LiveScan::error() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return error_;
+}
+
+LiveScans& LiveScans::global() {
+  static LiveScans table;
+  return table;
+}
+
+std::shared_ptr<LiveScan> LiveScans::begin(const std::string& slug, const std::string& filename) {
+  auto s = std::make_shared<LiveScan>(slug, filename);
+  std::lock_guard<std::mutex> lk(mu_);
+  scans_[slug] = s;
+  return s;
+}
+
+void LiveScans::end(const std::shared_ptr<LiveScan>& scan) {
+  std::lock_guard<std::mutex> lk(mu_);
+  auto it = scans_.find(scan->slug());
+  if (it != scans_.end() && it->second == scan) scans_.erase(it);
+}
+
+std::shared_ptr<LiveScan> LiveScans::find(const std::string& slug) const {
+  std::lock_guard<std::mutex> lk(mu_);
+  auto it = scans_.find(slug);
+  return it == scans_.end() ? nullptr : it->second;
+}
+
+std::vector<std::shared_ptr<LiveScan>> LiveScans::list() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  std::vector<std::shared_ptr<LiveScan>> out;
+  out.reserve(scans_.size());
+  for (const auto& [slug, s] : scans_) out.push_back(s);
+  return out;
+}
+
+}
@@ -0,0 +1,480 @@
+#include "typed_scanner/pipeline.hpp"
+#include "typed_scanner/metrics.hpp"
+#include "typed_scanner/record_view.hpp"
+#include "typed_scanner/spsc_queue.hpp"
+#include "typed_scanner/task_pool.hpp"
+#include "typed_scanner/trace.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ts {
+
+void RecordBatch::add(const RecordView& rv) {
+  for (std::size_t i = 0; i < rv.size(); ++i) {
+    data.append(rv.at(i));
+    ends.push_back(static_cast<std::uint32_t>(data.size()));
+  }
+  rows.push_back(static_cast<std::uint32_t>(ends.size()));
+}
+
+namespace {
+
+using BatchPtr = std::unique_ptr<RecordBatch>;
+using BatchQueue = SpscQueue<BatchPtr>;
+
+std::string column_name(const RecordBatch& b, std::size_t col) {
+  if (b.header && col < b.header->size() && !(*b.header)[col].empty()) return (*b.header)[col];
+  return "$" + std::to_string(col);
+}
+
+const char* dominant_type(const ColumnStats& c) {
+  const std::uint64_t best = std::max({c.numbers, c.bools, c.dates, c.strings});
+  return best == 0 ? "null"
+       : best == c.numbers ? "number"
+       : best == c.bools ? "bool"
+       : best == c.dates ? "date" : "string";
+}
+
+// ---- policy_parse: type each field against its column ------------------------
+// A column takes the kind of its first non-null value in file order
+// (number, bool, date, else string); later values that do not parse as
+// that kind are errors, counted per field. on_error=strict stops the scan
+// at the first one, the other modes once a field passes
+// max_errors_per_field. A batch of a later byte range with values in a column
+// whose kind an earlier, unfinished range may still decide is held back
+// (ready()), so split scans type columns the way a single range would.
+class PolicyParseStage : public PipelineStage {
+public:
+  PolicyParseStage(const PipelineOptions& o, MetricsRegistry& m) : policy_(o.policy), metrics_(m) {
+    cols_.resize(o.seed_kinds.size());
+    for (std::size_t i = 0; i < cols_.size(); ++i) cols_[i].kind = o.seed_kinds[i];
+  }
+  const char* name() const override { return "policy_parse"; }
+
+  void finish(PipelineResult& out) override {
+    out.kinds.clear();
+    for (const auto& c : cols_) out.kinds.push_back(c.kind);
+  }
+
+  bool ready(const RecordBatch& b) const override {
+    if (b.range <= prefix_) return true; // every earlier range is done
+    std::size_t width = 0;
+    for (std::size_t r = 0; r < b.size(); ++r) width = std::max<std::size_t>(width, b.rows[r] - b.row_begin(r));
+    bool settled = true;
+    for (std::size_t col = 0; col < width && settled; ++col) settled = final_kind(col);
+    if (settled) return true;
+    // Only values matter: a column that is null throughout waits for nothing.
+    for (std::size_t r = 0; r < b.size(); ++r) {
+      const std::size_t first = b.row_begin(r);
+      for (std::size_t i = first; i < b.rows[r]; ++i) {
+        if (!final_kind(i - first) && !policy_.is_null_token(b.field(i))) return false;
+      }
+    }
+    return true;
+  }
+
+  void end_range(unsigned r) override {
+    if (r >= range_done_.size()) range_done_.resize(r + 1, false);
+    range_done_[r] = true;
+    while (prefix_ < range_done_.size() && range_done_[prefix_]) ++prefix_;
+  }
+
+  bool process(RecordBatch& b) override {
+    b.kinds.assign(b.ends.size(), FieldKind::Null);
+    b.values.assign(b.ends.size(), 0.0);
+    for (std::size_t r = 0; r < b.size(); ++r) {
+      const std::size_t first = b.row_begin(r);
+      for (std::size_t i = first; i < b.rows[r]; ++i) {
+        const std::size_t col = i - first;
+        if (col >= cols_.size()) cols_.resize(col + 1);
+        Column& c = cols_[col];
+        const std::string_view s = b.field(i);
+        if (policy_.is_null_token(s)) continue;
+
+        double v = 0.0;
+        const FieldKind k = (c.kind == FieldKind::Null) ? classify(s, v) : parse_as(c.kind, s, v);
+        if (c.kind == FieldKind::Null) {
+          c.kind = k;
+          c.first_range = b.range;
+        }
+        if (k == FieldKind::Error) {
+          if (!c.registered) {
+            c.err_id = metrics_.register_field_error(column_name(b, col));
+            c.registered = true;
+          }
+          metrics_.add_field_error(c.err_id);
+          ++c.errors;
+          if (policy_.on_error == ParsePolicy::OnError::Strict) {
+            err_ = "policy_parse: field '" + column_name(b, col) + "': cannot parse '" +
+                   std::string(s.substr(0, 64)) + "' as " + kind_name(c.kind);
+            return false;
+          }
+          if (policy_.max_errors_per_field && c.errors > policy_.max_errors_per_field) {
+            err_ = "policy_parse: field '" + column_name(b, col) + "': more than " +
+                   std::to_string(policy_.max_errors_per_field) + " values do not parse as " +
+                   kind_name(c.kind) + " (max_errors_per_field)";
+            return false;
+          }
+        }
+        b.kinds[i] = k;
+        b.values[i] = v;
+      }
+    }
+    return true;
+  }
+
+private:
+  struct Column {
+    FieldKind kind = FieldKind::Null; // until the first non-null value
+    unsigned first_range = 0;         // range that value came from
+    bool registered = false;
+    CounterId err_id = 0;
+    std::uint64_t errors = 0;         // for max_errors_per_field
+  };
+
+  // No earlier range can still change the column's kind.
+  bool final_kind(std::size_t col) const {
+    return col < cols_.size() && cols_[col].kind != FieldKind::Null && cols_[col].first_range <= prefix_;
+  }
+
+  static const char* kind_name(FieldKind k) {
+    switch (k) {
+      case FieldKind::Number: return "number";
+      case FieldKind::Bool:   return "bool";
+      case FieldKind::Date:   return "date";
+      default:                return "string";
+    }
+  }
+
+  FieldKind classify(std::string_view s, double& v) const {
+    if (auto n = policy_.parse_number(s)) { v = *n; return FieldKind::Number; }
+    if (auto t = policy_.parse_bool(s))   { v = *t ? 1.0 : 0.0; return FieldKind::Bool; }
+    if (auto d = policy_.parse_date(s))   { v = static_cast<double>(*d); return FieldKind::Date; }
+    return FieldKind::String;
+  }
+
+  FieldKind parse_as(FieldKind k, std::string_view s, double& v) const {
+    switch (k) {
+      case FieldKind::Number:
+        if (auto n = policy_.parse_number(s)) { v = *n; return k; }
+        return FieldKind::Error;
+      case FieldKind::Bool:
+        if (auto t = policy_.parse_bool(s)) { v = *t ? 1.0 : 0.0; return k; }
+        return FieldKind::Error;
+      case FieldKind::Date:
+        if (auto d = policy_.parse_date(s)) { v = static_cast<double>(*d); return k; }
+        return FieldKind::Error;
+      default:
+        return FieldKind::String;
+    }
+  }
+
+  ParsePolicy policy_;
+  MetricsRegistry& metrics_;
+  std::vector<Column> cols_;
+  std::vector<bool> range_done_;
+  unsigned prefix_ = 0; // ranges [0, prefix_) are done
+};
+
+// ---- metrics: per-column null/type/error counts and numeric ranges -----------
+class MetricsStage : public PipelineStage {
+public:
+  const char* name() const override { return "metrics"; }
+
+  bool process(RecordBatch& b) override {
+    const bool typed = !b.kinds.empty();
+    for (std::size_t r = 0; r < b.size(); ++r) {
+      const std::size_t first = b.row_begin(r);
+      for (std::size_t i = first; i < b.rows[r]; ++i) {
+        const std::size_t col = i - first;
+        if (col >= cols_.size()) cols_.resize(col + 1);
+        ColumnStats& c = cols_[col];
+        if (c.name.empty() || (c.name[0] == '$' && b.header)) c.name = column_name(b, col);
+        ++c.count;
+        const FieldKind k = typed ? b.kinds[i] : (b.field(i).empty() ? FieldKind::Null : FieldKind::String);
+        switch (k) {
+          case FieldKind::Null:   ++c.nulls;   break;
+          case FieldKind::Error:  ++c.errors;  break;
+          case FieldKind::Bool:   ++c.bools;   break;
+          case FieldKind::Date:   ++c.dates;   break;
+          case FieldKind::String: ++c.strings; break;
+          case FieldKind::Number: {
+            const double v = b.values[i];
+            if (c.numbers == 0 || v < c.min) c.min = v;
+            if (c.numbers == 0 || v > c.max) c.max = v;
+            c.sum += v;
+            ++c.numbers;
+            break;
+          }
+        }
+      }
+    }
+    return true;
+  }
+
+  void finish(PipelineResult& out) override {
+    for (auto& c : cols_) c.type = dominant_type(c);
+    out.columns = std::move(cols_);
+  }
+
+private:
+  std::vector<ColumnStats> cols_;
+};
+
+// Producer side of an edge. A full queue means its consumer is behind (or
+// holding this range back): run it here unless another thread already is,
+// then make sure it sees the new batch.
+void push_to(BatchQueue& q, SerialTask& consumer, BatchPtr& b) {
+  for (unsigned idle = 0; !q.try_push(b); ) {
+    if (q.closed()) return; // aborted
+    (void)consumer.help();
+    BatchQueue::backoff(idle);
+  }
+  consumer.schedule();
+}
+
+// ---- source: tokenizer records -> one batch queue per byte range -------------
+class BatchSink : public TokenizeSink {
+public:
+  // first: the stage that drains the range queues. Once `stop` is set the
+  // tokenizer stops reading.
+  BatchSink(const PipelineOptions& opts, SerialTask& first, const std::atomic<bool>& stop)
+    : opts_(opts), first_(first), stop_(stop) {}
+
+  std::vector<std::unique_ptr<BatchQueue>> queues;
+
+  void begin(unsigned ranges) override {
+    queues.clear();
+    for (unsigned r = 0; r < ranges; ++r) {
+      queues.push_back(std::make_unique<BatchQueue>(opts_.queue_batches));
+    }
+    open_.clear();
+    open_.resize(ranges);
+    headers_.assign(ranges, nullptr);
+  }
+
+  void record(unsigned r, const RecordView& rv) override {
+    if (queues[r]->closed()) return; // downstream gave up
+    const auto* h = rv.header();
+    if (h && (!headers_[r] || headers_[r]->size() != h->size())) {
+      headers_[r] = std::make_shared<const std::vector<std::string>>(h->begin(), h->end());
+    }
+    BatchPtr& b = open_[r];
+    if (b && b->header != headers_[r]) flush(r);
+    if (!b) {
+      b = std::make_unique<RecordBatch>();
+      b->header = headers_[r];
+      b->range = r;
+      b->rows.reserve(opts_.batch_rows);
+    }
+    b->add(rv);
+    if (b->size() >= opts_.batch_rows || b->data.size() >= opts_.batch_bytes) flush(r);
+  }
+
+  void end_range(unsigned r) override {
+    flush(r);
+    queues[r]->close();
+    first_.schedule(); // it finishes once every range is closed and drained
+  }
+
+  const std::atomic<bool>* stop_flag() const override { return &stop_; }
+
+private:
+  void flush(unsigned r) {
+    if (open_[r] && open_[r]->size()) push_to(*queues[r], first_, open_[r]);
+    open_[r].reset();
+  }
+
+  const PipelineOptions& opts_;
+  SerialTask& first_;
+  const std::atomic<bool>& stop_;
+  std::vector<BatchPtr> open_;
+  std::vector<std::shared_ptr<const std::vector<std::string>>> headers_;
+};
+
+// Without waiting; `drained` as for try_pop_any.
+bool try_pop_one(BatchQueue& q, BatchPtr& out, bool& drained) {
+  drained = q.closed(); // before the pop, so a push that raced close() is seen
+  if (q.try_pop(out)) { drained = false; return true; }
+  return false;
+}
+
+// Fan-in over the range queues (each still single-producer) for the first
+// stage, without waiting. A batch the stage is not ready() for stays at the
+// head of its range; the stage hears end_range() once a range is closed and
+// emptied. `drained` is set when every range has ended.
+class FanIn {
+public:
+  bool pop(std::vector<std::unique_ptr<BatchQueue>>& qs, PipelineStage& stage, bool hold,
+           BatchPtr& out, bool& drained) {
+    const std::size_t n = qs.size();
+    if (head_.size() != n) {
+      head_.resize(n);
+      ended_.assign(n, false);
+    }
+    for (bool again = true; again; ) {
+      again = false; // an end_range() may make a head we passed ready
+      drained = true;
+      for (std::size_t k = 0; k < n; ++k) {
+        const std::size_t q = (rr_ + k) % n;
+        if (ended_[q]) continue;
+        bool closed = false;
+        if (!head_[q] && !try_pop_one(*qs[q], head_[q], closed)) {
+          if (!closed) { drained = false; continue; }
+          ended_[q] = true;
+          stage.end_range(static_cast<unsigned>(q));
+          again = true;
+          continue;
+        }
+        drained = false;
+        if (hold && !stage.ready(*head_[q])) continue;
+        out = std::move(head_[q]);
+        rr_ = (q + 1) % n;
+        return true;
+      }
+    }
+    return false;
+  }
+
+private:
+  std::vector<BatchPtr> head_;
+  std::vector<bool> ended_;
+  std::size_t rr_ = 0;
+};
+
+}
+
+void merge_column_stats(ColumnStats& into, const ColumnStats& more) {
+  if (more.numbers) {
+    if (into.numbers == 0 || more.min < into.min) into.min = more.min;
+    if (into.numbers == 0 || more.max > into.max) into.max = more.max;
+  }
+  if (into.name.empty() || (into.name[0] == '$' && !more.name.empty() && more.name[0] != '$')) {
+    into.name = more.name;
+  }
+  into.count += more.count;
+  into.nulls += more.nulls;
+  into.errors += more.errors;
+  into.numbers += more.numbers;
+  into.bools += more.bools;
+  into.dates += more.dates;
+  into.strings += more.strings;
+  into.sum += more.sum;
+  into.type = dominant_type(into);
+}
+
+std::unique_ptr<PipelineStage> make_pipeline_stage(std::string_view name, const PipelineOptions& opts,
+                                                   MetricsRegistry& metrics) {
+  if (name == "policy_parse") return std::make_unique<PolicyParseStage>(opts, metrics);
+  if (name == "metrics") return std::make_unique<MetricsStage>();
+  return nullptr;
+}
+
+PipelineResult run_pipeline(const std::string& path, FileFormat fmt, const TokenizeOptions& tok,
+                            const PipelineOptions& opts, MetricsRegistry& metrics) {
+  PipelineResult res;
+  std::vector<std::unique_ptr<PipelineStage>> stages;
+  for (const auto& name : opts.stages) {
+    if (auto s = make_pipeline_stage(name, opts, metrics)) stages.push_back(std::move(s));
+  }
+  // Registered up front so stage_times lists them in DAG order.
+  if (tok.reader.decompress && detect_compression(path) != Compression::None) {
+    (void)metrics.register_stage("decompress");
+  }
+  const StageId st_tokenize = metrics.register_stage("tokenize");
+  std::vector<StageId> stage_ids;
+  for (auto& s : stages) stage_ids.push_back(metrics.register_stage(s->name()));
+
+  if (stages.empty()) {
+    metrics.start_stage(st_tokenize);
+    res.tok = tokenize_file(path, fmt, tok, &metrics);
+    metrics.end_stage(st_tokenize);
+    return res;
+  }
+
+  // edges[i] connects stage i to stage i+1.
+  std::vector<std::unique_ptr<BatchQueue>> edges;
+  for (std::size_t i = 0; i + 1 < stages.size(); ++i) {
+    edges.push_back(std::make_unique<BatchQueue>(opts.queue_batches));
+  }
+
+  std::mutex fail_mu;
+  std::string fail_msg;
+  std::atomic<bool> failed{false};
+  BatchSink* sink_ptr = nullptr;
+
+  // Each stage is a SerialTask on the pool: a pass drains what its input
+  // holds and returns; pushes and closes upstream schedule the next one.
+  TaskGroup group(tok.pool ? *tok.pool : TaskPool::global());
+  std::vector<std::unique_ptr<SerialTask>> runs;
+
+  auto abort_all = [&](const std::string& msg){
+    {
+      std::lock_guard<std::mutex> lk(fail_mu);
+      if (fail_msg.empty()) fail_msg = msg;
+    }
+    failed.store(true);
+    for (auto& q : sink_ptr->queues) q->close();
+    for (auto& q : edges) q->close();
+    for (auto& r : runs) r->schedule(); // to drop what is queued and finish
+  };
+
+  FanIn fan_in;
+  const std::size_t pass_batches = std::max<std::size_t>(1, opts.queue_batches);
+  auto stage_pass = [&](std::size_t i){
+    PipelineStage& stage = *stages[i];
+    const StageId sid = stage_ids[i];
+    BatchQueue* in = i ? edges[i - 1].get() : nullptr;
+    BatchQueue* out = (i < edges.size()) ? edges[i].get() : nullptr;
+    BatchPtr b;
+    for (std::size_t n = 0; n < pass_batches; ++n) {
+      bool drained = false;
+      const bool got = in ? try_pop_one(*in, b, drained)
+                          : fan_in.pop(sink_ptr->queues, stage, !failed.load(std::memory_order_relaxed), b, drained);
+      if (!got) {
+        if (!drained) return false; // the next push or close schedules us
+        if (out) { out->close(); runs[i + 1]->schedule(); }
+        return true;
+      }
+      if (failed.load(std::memory_order_relaxed)) { b.reset(); continue; } // aborted: drop it
+      bool ok;
+      {
+        TS_TRACE_SCOPE_CAT(stage.name(), "pipeline");
+        metrics.start_stage(sid);
+        ok = stage.process(*b);
+        metrics.end_stage(sid);
+      }
+      if (!ok) { abort_all(stage.error()); b.reset(); continue; }
+      if (out) push_to(*out, *runs[i + 1], b);
+      b.reset();
+    }
+    runs[i]->schedule(); // used up its pass: the rest goes round again
+    return false;
+  };
+  for (std::size_t i = 0; i < stages.size(); ++i) {
+    runs.push_back(std::make_unique<SerialTask>(group, [&stage_pass, i]{ return stage_pass(i); }));
+  }
+
+  BatchSink sink(opts, *runs[0], failed);
+  sink_ptr = &sink;
+
+  metrics.start_stage(st_tokenize);
+  res.tok = tokenize_file(path, fmt, tok, &metrics, &sink);
+  metrics.end_stage(st_tokenize);
+  group.wait();
+
+  for (auto& s : stages) s->finish(res);
+  if (!fail_msg.empty()) {
+    // The cause; ranges it stopped only report "stopped".
+    res.tok.ok = false;
+    res.tok.error = fail_msg;
+  }
+  return res;
+}
+
+}
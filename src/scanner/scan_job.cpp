@@ -0,0 +1,417 @@
+#include "typed_scanner/scan_job.hpp"
+#include "typed_scanner/arena.hpp"
+#include "typed_scanner/artifact_writer.hpp"
+#include "typed_scanner/checkpoint.hpp"
+#include "typed_scanner/chunk_reader.hpp"
+#include "typed_scanner/etag_state.hpp"
+#include "typed_scanner/histogram.hpp"
+#include "typed_scanner/live_scan.hpp"
+#include "typed_scanner/json_writer.hpp"
+#include "typed_scanner/metrics.hpp"
+#include "typed_scanner/path_utils.hpp"
+#include "typed_scanner/record_view.hpp"
+#include "typed_scanner/run_json.hpp"
+#include "typed_scanner/sniff.hpp"
+#include "typed_scanner/sys_counters.hpp"
+#include "typed_scanner/task_pool.hpp"
+#include "typed_scanner/ticker.hpp"
+#include "typed_scanner/token_csv_fsm.hpp"
+#include "typed_scanner/token_jsonl_simdjson.hpp"
+#include "typed_scanner/trace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ts {
+
+namespace {
+
+// Series points embedded in report.html; run.json keeps all of them.
+constexpr std::size_t kReportSeriesPoints = 2000;
+
+// An in-flight scan's LiveScans entry. Each return path calls finish()
+// with the scan's outcome before `return res;`, so the outcome never
+// depends on whether res was moved into the return value yet; the
+// destructor only ends an entry some path forgot to finish.
+struct LiveScanEntry {
+  std::shared_ptr<LiveScan> scan;
+  bool finished = false;
+  void finish(const ScanResult& res) {
+    scan->finish(res.status == ScanResult::Status::Ok, res.error);
+    LiveScans::global().end(scan);
+    finished = true;
+  }
+  ~LiveScanEntry() {
+    if (finished) return;
+    scan->finish(false, "scan ended without a result");
+    LiveScans::global().end(scan);
+  }
+};
+
+// Why [sync] says not to scan, or null to scan.
+const char* sync_skip_reason(const SyncOptions& sync, const std::string& artifact_root,
+                             const std::string& slug, const std::string& etag) {
+  const auto prev = sync.etags->get(slug);
+  if (!prev) return sync.build_new ? nullptr : "new file (on_create=skip)";
+  if (*prev != etag) return sync.rebuild_changed ? nullptr : "changed (on_update=skip)";
+  if (!sync.skip_unchanged) return nullptr;
+  // Artifacts removed by hand are rebuilt even if the input is unchanged.
+  std::error_code ec;
+  return std::filesystem::exists(std::filesystem::path(artifact_root) / slug / "run.json", ec)
+      ? "unchanged" : nullptr;
+}
+
+// Options that change what a scan produces; a checkpoint taken under other
+// settings cannot be resumed.
+std::string resume_settings(FileFormat fmt, const CsvConfig& csv, const PipelineOptions& pipeline) {
+  std::string key = fmt == FileFormat::CSV ? "csv" : "jsonl";
+  key += '|';
+  key += {csv.delimiter, csv.quote, csv.escape, csv.header ? '1' : '0'};
+  for (const auto& st : pipeline.stages) key += '|' + st;
+  const ParsePolicy& pol = pipeline.policy;
+  key += '|' + std::to_string(static_cast<int>(pol.on_error));
+  if (pol.max_errors_per_field) key += "|e" + std::to_string(pol.max_errors_per_field);
+  if (pol.null_tokens) {
+    for (const auto& t : *pol.null_tokens) key += '|' + t;
+  }
+  if (pol.date_policy) key += '|' + pol.date_policy->mode;
+  if (pol.bool_policy) {
+    for (const auto& t : pol.bool_policy->true_tokens) key += "|t" + t;
+    for (const auto& t : pol.bool_policy->false_tokens) key += "|f" + t;
+    key += pol.bool_policy->case_sensitive ? "|cs" : "|ci";
+  }
+  return hex_hash_prefix(key, 16);
+}
+
+}
+
+std::string make_scan_slug(const std::string& path, const std::string& mode, int len) {
+  if (path == "-") return make_slug("stdin", mode, len);
+  // For hashprefix mode, hash the full absolute path to be stable in examples.
+  // /dev/fd/N of a pipe resolves to "pipe:[inode]", which does not exist:
+  // such paths are hashed as given.
+  std::string key = path;
+  if (mode == "hashprefix") {
+    std::error_code ec;
+    const auto canon = std::filesystem::weakly_canonical(std::filesystem::path(path), ec);
+    if (!ec) key = canon.string();
+  }
+  return make_slug(key, mode, len);
+}
+
+ScanResult scan_file(const std::string& filepath, const ScanOptions& opts) {
+  namespace ch = std::chrono;
+  const auto t0 = ch::steady_clock::now();
+  ScanResult res;
+  res.path = filepath;
+  const std::uint64_t trace_t0 = trace::enabled() ? trace::detail::now_ns() : 0;
+  // Events of this scan, on any thread, go to its own trace.json.
+  const trace::ScanTag trace_tag(trace_t0 ? trace::new_scan_id() : trace::current_scan());
+
+  // --- choose format: --format, else a confident content sniff, else the
+  // extension (a stream left Unknown is sniffed by the tokenizer)
+  const bool stream = is_stream_path(filepath);
+  TokenizeOptions tok_opts = opts.tokenize;
+  tok_opts.reader.cancel = opts.cancel;
+  Dialect dialect;
+  bool sniffed = false;
+  if (opts.sniff && !stream) {
+    std::string serr;
+    sniffed = sniff_file(filepath, dialect, tok_opts.csv.header, &serr);
+    if (!sniffed) std::cerr << "[sniff] " << serr << "\n"; // the tokenizer reports it too
+  }
+  const bool confident = sniffed && dialect.format != FileFormat::Unknown &&
+                         dialect.confidence >= kSniffMinConfidence;
+  FileFormat fmt = opts.format;
+  const char* fmt_source = "flag";
+  if (fmt == FileFormat::Unknown) {
+    if (stream) {
+      fmt_source = "first_line";
+    } else if (confident) {
+      fmt = dialect.format;
+      fmt_source = "content";
+    } else {
+      fmt = detect_format(filepath);
+      fmt_source = "extension";
+    }
+  }
+  if (fmt == FileFormat::Unknown && !stream) {
+    res.status = ScanResult::Status::Skipped;
+    res.error = "unsupported format";
+    return res;
+  }
+  // The sampled dialect replaces the configured one.
+  if (fmt == FileFormat::CSV && confident && dialect.format == FileFormat::CSV) {
+    apply_dialect(dialect, tok_opts.csv);
+  }
+
+  res.slug = opts.slug.empty() ? make_scan_slug(filepath, opts.slug_mode, opts.slug_len) : opts.slug;
+
+  // --- counters/series
+  MetricsRegistry metrics;
+
+  // --- resume: scan only the complete lines appended since the checkpoint
+  PipelineOptions pipe_opts = opts.pipeline;
+  const auto slug_dir = std::filesystem::path(opts.artifact_root) / res.slug;
+  const std::string cp_path = (slug_dir / "checkpoint.txt").string();
+  ScanCheckpoint prev;
+  bool resumed = false;
+  std::uint64_t line_end = 0;
+  std::uint64_t size = 0;
+  // Offsets only mean something in plain files.
+  if (opts.sync.resume_appends && !stream && detect_compression(filepath) == Compression::None) {
+    std::error_code rec;
+    size = std::filesystem::file_size(filepath, rec);
+    std::string cerr_msg;
+    if (!rec) line_end = last_line_end(filepath, size, &cerr_msg);
+    if (!cerr_msg.empty()) std::cerr << "[resume] " << cerr_msg << "\n";
+    if (line_end > 0) {
+      resumed = load_checkpoint(cp_path, prev) &&
+                prev.format == (fmt == FileFormat::CSV ? "csv" : "jsonl") &&
+                prev.settings == resume_settings(fmt, tok_opts.csv, opts.pipeline) &&
+                prev.offset <= line_end &&
+                std::filesystem::exists(slug_dir / "run.json", rec) &&
+                checkpoint_matches(prev, filepath);
+      if (resumed) {
+        // A resumed scan stops at the last newline; a full scan reads the
+        // unterminated tail too and then leaves no checkpoint behind.
+        tok_opts.reader.begin_offset = prev.offset;
+        tok_opts.reader.end_offset = line_end;
+        pipe_opts.seed_kinds = prev.kinds;
+        if (size > line_end) {
+          std::cerr << "[resume] " << filepath << ": " << (size - line_end)
+                    << " bytes after the last newline left for the next run\n";
+        }
+      }
+    }
+  }
+
+  // --- fingerprint: skip the whole pipeline when [sync] says so. A file
+  // that only grew since its checkpoint is not hashed end to end.
+  std::string etag;
+  if (opts.sync.etags && !stream) {
+    const StageId st_fp = metrics.register_stage("fingerprint");
+    metrics.start_stage(st_fp);
+    std::string ferr;
+    etag = resumed ? checkpoint_etag(filepath, size, &ferr)
+                   : file_fingerprint(filepath, opts.sync.fingerprint, &ferr);
+    metrics.end_stage(st_fp);
+    if (etag.empty()) {
+      std::cerr << "[sync] " << ferr << "\n"; // scan anyway, just not idempotently
+    } else if (const char* why = sync_skip_reason(opts.sync, opts.artifact_root, res.slug, etag)) {
+      res.status = ScanResult::Status::Skipped;
+      res.error = why;
+      res.wall_ms = ch::duration<double, std::milli>(ch::steady_clock::now() - t0).count();
+      return res;
+    }
+  }
+
+  // --- series: sample live throughput and RSS while the pipeline runs, and
+  // publish each sample for the server's /api/scans/<slug>/events
+  LiveScanEntry live{LiveScans::global().begin(res.slug, !opts.display_name.empty() ? opts.display_name
+                                                        : filepath == "-" ? "stdin" : filepath)};
+  RunJsonSeriesSpool series(kReportSeriesPoints);
+  double peak_rss_mb = resident_set_mb();
+  auto last_t = ch::steady_clock::now();
+  std::uint64_t last_bytes = 0;
+  // Runs on the process-wide Ticker thread, then once more here at the end;
+  // Ticker::cancel() orders the two.
+  auto sample = [&](bool last){
+    const auto now = ch::steady_clock::now();
+    const double dt = ch::duration<double>(now - last_t).count();
+    if (last && dt < 0.001) return; // nothing new since the last point
+    // Lock-free read: the tokenizer threads never wait on the sampler.
+    const MetricsRegistry::LiveTotals lt = metrics.live();
+    RunJsonSeriesPoint pt;
+    pt.time_ms = ch::duration<double, std::milli>(now - t0).count();
+    pt.mb_s = dt > 0.0 ? double(lt.bytes - last_bytes) / (1024.0 * 1024.0) / dt : 0.0;
+    pt.rss_mb = resident_set_mb();
+    peak_rss_mb = std::max(peak_rss_mb, pt.rss_mb);
+    series.append(pt);
+    LiveScanSample ls{pt.time_ms, lt.rows, lt.bytes, pt.mb_s, pt.rss_mb, {}};
+    for (const auto& st : lt.stages) ls.stage_ms.emplace_back(st.name, st.duration_ms);
+    live.scan->publish(std::move(ls));
+    last_t = now;
+    last_bytes = lt.bytes;
+  };
+  const Ticker::Id sampler = opts.series_interval_ms > 0
+      ? Ticker::global().every(ch::milliseconds(opts.series_interval_ms), [&]{ sample(false); })
+      : 0;
+
+  // --- tokenize -> policy_parse -> metrics ([dag] stages)
+  PipelineResult pr = run_pipeline(filepath, fmt, tok_opts, pipe_opts, metrics);
+  if (sampler) {
+    Ticker::global().cancel(sampler);
+    sample(true);
+  }
+  if (opts.cancel && opts.cancel->load(std::memory_order_relaxed)) {
+    // Partial totals would overwrite the last good report.
+    res.status = ScanResult::Status::Cancelled;
+    res.error = "cancelled";
+    res.wall_ms = ch::duration<double, std::milli>(ch::steady_clock::now() - t0).count();
+    live.finish(res);
+    return res;
+  }
+  const TokenizeStats& tok = pr.tok;
+  const bool ok = tok.ok;
+  if (!ok) res.error = tok.error;
+  const std::uint64_t new_rows = tok.rows;
+  const std::uint64_t rows = (resumed ? prev.rows : 0) + new_rows;
+
+  const auto t1 = ch::steady_clock::now();
+  const double wall_ms = ch::duration<double, std::milli>(t1 - t0).count();
+
+  LatencyHistogram file_lat;
+  file_lat.record(static_cast<std::uint64_t>(ch::duration_cast<ch::nanoseconds>(t1 - t0).count()));
+  metrics.merge_latency(kLatencyFile, file_lat);
+
+  const std::uint64_t new_bytes = tok.bytes;
+  const std::uint64_t bytes = (resumed ? prev.offset : 0) + new_bytes;
+  const double mb = new_bytes / (1024.0 * 1024.0);
+  const double sec = wall_ms / 1000.0;
+  const double throughput_mb_s = sec > 0.0 ? (mb / sec) : 0.0;
+  const double rows_per_s = sec > 0.0 ? (new_rows / sec) : 0.0;
+
+  // Fold the checkpoint's totals into this run's.
+  std::unordered_map<std::string, std::uint64_t> errors_by_field;
+  if (resumed) {
+    errors_by_field = prev.errors_by_field;
+    for (std::size_t i = 0; i < pr.columns.size(); ++i) {
+      if (i < prev.columns.size()) merge_column_stats(prev.columns[i], pr.columns[i]);
+      else prev.columns.push_back(pr.columns[i]);
+    }
+    pr.columns = std::move(prev.columns);
+  }
+
+  // --- run.json payload (fill what we have; rest can be zero/empty)
+  RunJsonPayload p{};
+  p.rows = rows;
+  p.bytes = bytes;
+  p.resumed_from = resumed ? prev.offset : 0;
+  p.compression = compression_name(tok.compression);
+  p.compressed_bytes = tok.compression == Compression::None ? 0 : tok.raw_bytes;
+  p.wall_time_ms = wall_ms;
+  p.throughput_mb_s = throughput_mb_s;
+  p.tokens_per_sec = rows_per_s;           // treat "tokens" ~ rows for MVP
+  p.allocs_per_sec = 0.0;                  // not measured here
+  p.peak_rss_mb = std::max(peak_rss_mb, resident_set_mb());
+  metrics.set_peak_rss_mb(p.peak_rss_mb);
+
+  p.filename = !opts.display_name.empty() ? opts.display_name : filepath == "-" ? "stdin" : filepath;
+  p.content_type = (tok.format == FileFormat::JSONL) ? "application/x-ndjson" : "text/csv";
+  p.etag = etag;
+  p.sniff.format = tok.format == FileFormat::JSONL ? "jsonl" : "csv";
+  p.sniff.source = fmt_source;
+  p.sniff.confidence = sniffed ? dialect.confidence : 0.0;
+  p.sniff.delimiter = std::string(1, tok_opts.csv.delimiter);
+  p.sniff.quote = std::string(1, tok_opts.csv.quote);
+  p.sniff.header = tok_opts.csv.header;
+  p.sniff.bom = dialect.bom;
+  if (sniffed) p.sniff.line_ending = dialect.line_ending;
+  std::error_code fec;
+  // A stream's size is whatever was read from it.
+  p.file_size = stream ? tok.raw_bytes : std::filesystem::file_size(filepath, fec);
+
+  const RunStats stats = metrics.snapshot(wall_ms, rows_per_s, 0.0);
+  p.p50_ms = stats.p50_ms;                 // per-chunk tokenize latency
+  p.p95_ms = stats.p95_ms;
+  p.latency = stats.latencies;
+  for (const auto& [field, n] : stats.errors_by_field) errors_by_field[field] += n;
+  p.errors_by_field = errors_by_field;
+  for (const auto& c : pr.columns) {
+    const double mean = c.numbers ? c.sum / double(c.numbers) : 0.0;
+    p.columns.push_back({c.name, c.type, c.count, c.nulls, c.errors, c.min, c.max, mean});
+  }
+  // "render" cannot time itself into the run.json it writes; its span is in
+  // the trace.
+  for (const auto& st : stats.stages) {
+    p.stage_times.emplace_back(st.name, st.duration_ms);
+    if (st.perf.valid) {
+      p.stage_counters.push_back({st.name, st.perf.cycles, st.perf.instructions,
+                                  st.perf.branch_misses, st.perf.llc_misses});
+    }
+  }
+
+  // report.html embeds the thinned series; a longer one is streamed from
+  // the spool into run.json whole.
+  p.series = series.sampled();
+  const std::string run_json = RunJsonWriter::to_json(p);
+  ReportDirOptions report = opts.report;
+  if (series.size() > p.series.size()) {
+    report.write_run_json = [&](int fd, std::string* err_out) {
+      JsonWriter w(fd);
+      RunJsonWriter::write(w, p, &series);
+      if (!w.flush() && err_out) *err_out = w.error();
+      return w.ok();
+    };
+  }
+
+  // --- write artifacts
+  res.rows = rows;
+  res.bytes = bytes;
+  res.wall_ms = wall_ms;
+  std::string err;
+  if (!write_report_dir(opts.artifact_root, res.slug, run_json, report, &err)) {
+    res.status = ScanResult::Status::WriteError;
+    res.error = "write_report_dir failed: " + err;
+    live.finish(res);
+    return res;
+  }
+
+  if (trace_t0) {
+    trace::detail::emit("scan_file", "scan", trace_t0, trace::detail::now_ns());
+    if (opts.write_trace) {
+      const auto trace_path = std::filesystem::path(opts.artifact_root) / res.slug / "trace.json";
+      if (!trace::write_chrome_json(trace_path.string(), &err, trace::current_scan())) {
+        std::cerr << "[trace] " << err << "\n";
+      }
+    }
+  }
+
+  if (!ok) {
+    res.status = ScanResult::Status::TokenizeError;
+    live.finish(res);
+    return res;
+  }
+  if (opts.sync.etags && !etag.empty()) {
+    // Only a complete, successful build makes the input "seen". The
+    // caller flushes the state once its batch of scans is done.
+    opts.sync.etags->set(res.slug, etag);
+  }
+  if (opts.sync.resume_appends && line_end > 0 && (resumed || line_end == size)) {
+    ScanCheckpoint cp;
+    cp.format = fmt == FileFormat::CSV ? "csv" : "jsonl";
+    cp.settings = resume_settings(fmt, tok_opts.csv, opts.pipeline);
+    cp.offset = line_end;
+    cp.rows = rows;
+    cp.kinds = std::move(pr.kinds);
+    cp.columns = std::move(pr.columns);
+    cp.errors_by_field = std::move(errors_by_field);
+    if (!checkpoint_hashes(filepath, cp.offset, cp.head_hash, cp.tail_hash, &err) ||
+        !save_checkpoint(cp_path, cp, &err)) {
+      std::cerr << "[resume] " << err << "\n";
+    }
+  }
+  live.finish(res);
+  return res;
+}
+
+bool remove_scan_artifacts(const std::string& filepath, const ScanOptions& opts,
+                           std::string* err_out) {
+  const std::string slug = make_scan_slug(filepath, opts.slug_mode, opts.slug_len);
+  std::error_code ec;
+  std::filesystem::remove_all(std::filesystem::path(opts.artifact_root) / slug, ec);
+  if (ec) {
+    if (err_out) *err_out = "remove " + slug + ": " + ec.message();
+    return false;
+  }
+  if (opts.sync.etags) opts.sync.etags->erase(slug);
+  return true;
+}
+
+}
@@ -0,0 +1,298 @@
+#include "typed_scanner/scan_jobs.hpp"
+#include "typed_scanner/etag_state.hpp"
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cerrno>
+#include <cstdlib>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fcntl.h>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace ts {
+
+const char* scan_job_state_name(ScanJobState s) noexcept {
+  switch (s) {
+    case ScanJobState::Queued: return "queued";
+    case ScanJobState::Running: return "running";
+    case ScanJobState::Done: return "done";
+    case ScanJobState::Failed: return "failed";
+    case ScanJobState::Cancelled: return "cancelled";
+  }
+  return "unknown";
+}
+
+namespace {
+
+bool finished(ScanJobState s) {
+  return s == ScanJobState::Done || s == ScanJobState::Failed || s == ScanJobState::Cancelled;
+}
+
+// ".csv", ".jsonl.gz", ... of `name`; empty when it looks like anything else.
+std::string spool_suffix(const std::string& name) {
+  const std::string base = fs::path(name).filename().string();
+  const auto dot = base.find('.', 1);
+  if (dot == std::string::npos || base.size() - dot > 16) return {};
+  for (std::size_t i = dot; i < base.size(); ++i) {
+    const unsigned char c = static_cast<unsigned char>(base[i]);
+    if (c != '.' && !std::isalnum(c)) return {};
+  }
+  return base.substr(dot);
+}
+
+}
+
+struct ScanJobs::Impl {
+  struct Job {
+    ScanJobInfo info;
+    Request req;
+    std::atomic<bool> cancel{false};
+  };
+
+  Config cfg;
+  ScanOptions base;
+  ResultCallback on_result;
+
+  mutable std::mutex mu;
+  mutable std::condition_variable cv_done;
+  std::map<std::uint64_t, std::unique_ptr<Job>> jobs; // id (= scheduler ticket) -> job
+  std::deque<std::uint64_t> done;                     // finished ids, oldest first
+  std::size_t active = 0;                             // queued + running jobs
+  bool stopping = false;
+  std::unique_ptr<ScanScheduler> sched;
+
+  bool admits(std::uint64_t bytes) const {
+    const std::uint64_t queued = sched->queued_bytes();
+    return queued == 0 || queued + bytes <= cfg.scheduler.max_inflight_bytes;
+  }
+
+  // One .etags rewrite per pass: when the last queued job finishes.
+  void flush_etags() {
+    std::string err;
+    if (base.sync.etags && !base.sync.etags->flush(&err)) std::cerr << "[sync] " << err << "\n";
+  }
+
+  // Caller holds `mu`.
+  void finish(Job& j, ScanJobState state, std::string error) {
+    --active;
+    j.info.state = state;
+    j.info.error = std::move(error);
+    if (j.req.spooled) ::unlink(j.req.path.c_str());
+    if (j.req.stream_fd >= 0) {
+      // The writer sees EPIPE from here on if the scan stopped early.
+      ::close(j.req.stream_fd);
+      j.req.stream_fd = -1;
+    }
+    done.push_back(j.info.id);
+    while (done.size() > cfg.history) {
+      jobs.erase(done.front());
+      done.pop_front();
+    }
+    cv_done.notify_all();
+  }
+
+  ScanResult run(const std::string& path, ScanScheduler::Ticket id) {
+    ScanResult r;
+    r.path = path;
+    Job* j = nullptr;
+    {
+      std::lock_guard<std::mutex> lk(mu);
+      auto it = jobs.find(id);
+      if (it == jobs.end()) return r; // submit() registers before releasing `mu`
+      j = it->second.get();
+      j->info.state = ScanJobState::Running;
+      cv_done.notify_all(); // a stream submit() waits for this
+    }
+    if (j->cancel.load()) {
+      r.status = ScanResult::Status::Cancelled;
+      r.error = "cancelled";
+    } else {
+      ScanOptions o = base;
+      o.cancel = &j->cancel;
+      if (j->req.format != FileFormat::Unknown) o.format = j->req.format;
+      if (j->req.spooled || j->req.stream_fd >= 0) {
+        // An upload is new every time: nothing to skip or resume.
+        o.sync = SyncOptions{};
+        o.slug = j->info.slug;
+        o.display_name = j->info.name;
+      }
+      r = scan_file(path, o);
+    }
+    bool idle = false;
+    {
+      std::lock_guard<std::mutex> lk(mu);
+      j->info.rows = r.rows;
+      j->info.wall_ms = r.wall_ms;
+      if (r.bytes) j->info.bytes = r.bytes;
+      const ScanJobState st = r.status == ScanResult::Status::Cancelled ? ScanJobState::Cancelled
+                            : r.ok() ? ScanJobState::Done : ScanJobState::Failed;
+      finish(*j, st, r.error); // j may be gone past this point
+      idle = active == 0;
+    }
+    if (idle) flush_etags();
+    if (on_result) on_result(r);
+    return r;
+  }
+};
+
+ScanJobs::ScanJobs(Config cfg, ScanOptions base, ResultCallback on_result, TaskPool* pool)
+  : p_(new Impl{}) {
+  if (cfg.upload_dir.empty()) cfg.upload_dir = (fs::path(base.artifact_root) / ".uploads").string();
+  p_->cfg = std::move(cfg);
+  p_->base = std::move(base);
+  p_->on_result = std::move(on_result);
+  p_->sched = std::make_unique<ScanScheduler>(
+      p_->cfg.scheduler,
+      ScanScheduler::TicketScanFn([impl = p_](const std::string& path, ScanScheduler::Ticket t){
+        return impl->run(path, t);
+      }),
+      ScanScheduler::ResultCallback{}, pool);
+}
+
+ScanJobs::~ScanJobs() {
+  shutdown();
+  delete p_;
+}
+
+ScanJobs::Submit ScanJobs::submit(Request req, ScanJobInfo* out, std::string* err_out) {
+  auto refuse = [&](Submit s, const std::string& msg) {
+    if (req.spooled && !req.path.empty()) ::unlink(req.path.c_str());
+    if (req.stream_fd >= 0) ::close(req.stream_fd);
+    if (err_out) *err_out = msg;
+    return s;
+  };
+  if (req.path.empty()) return refuse(Submit::Invalid, "path is empty");
+  const bool stream = req.stream_fd >= 0;
+  if (req.bytes == 0 && !req.spooled && !stream) {
+    std::error_code ec;
+    if (!fs::is_regular_file(req.path, ec)) return refuse(Submit::Invalid, "not a regular file: " + req.path);
+    req.bytes = static_cast<std::uint64_t>(fs::file_size(req.path, ec));
+  }
+  if (req.name.empty()) req.name = req.path;
+
+  std::unique_lock<std::mutex> lk(p_->mu);
+  if (p_->stopping) return refuse(Submit::Invalid, "shutting down");
+  if (req.check_budget && !p_->admits(req.bytes)) {
+    return refuse(Submit::Busy, "scan queue is full (max_inflight_bytes)");
+  }
+
+  auto j = std::make_unique<Impl::Job>();
+  j->info.name = req.name;
+  j->info.slug = make_scan_slug(req.spooled || stream ? req.name : req.path, p_->base.slug_mode, p_->base.slug_len);
+  j->info.bytes = req.bytes;
+  // The scan task blocks on `mu` until the job is registered below.
+  const ScanScheduler::Ticket id = stream ? p_->sched->try_start(req.path, req.bytes)
+                                          : p_->sched->submit(req.path, req.bytes);
+  if (id == 0 && stream) return refuse(Submit::Busy, "no free scan slot (max_parallel)");
+  if (id == 0) return refuse(Submit::Invalid, "shutting down");
+  j->info.id = id;
+  j->req = std::move(req);
+  if (out) *out = j->info;
+  p_->jobs.emplace(id, std::move(j));
+  ++p_->active;
+  if (!stream) return Submit::Ok;
+
+  // A slot is no worker: with every pool thread busy the scan would not
+  // read the pipe and its writer would block indefinitely.
+  const auto started = [&]{
+    auto it = p_->jobs.find(id);
+    return it == p_->jobs.end() || it->second->info.state != ScanJobState::Queued;
+  };
+  if (p_->cv_done.wait_for(lk, std::chrono::milliseconds(p_->cfg.stream_start_ms), started)) return Submit::Ok;
+  // Not picked up: drop it from the scheduler, which frees its slot and
+  // bytes, and finish it here (that closes the fd). Otherwise a worker
+  // claimed it just now and is waiting on `mu` to mark it running.
+  if (!p_->sched->cancel(id)) return Submit::Ok;
+  p_->finish(*p_->jobs.at(id), ScanJobState::Cancelled, "no free worker");
+  if (err_out) *err_out = "no free worker for a stream (task pool busy)";
+  return Submit::Busy;
+}
+
+bool ScanJobs::admits(std::uint64_t bytes) const {
+  return p_->admits(bytes);
+}
+
+bool ScanJobs::create_spool(const std::string& name, int& fd, std::string& path,
+                            std::string* err_out) const {
+  std::error_code ec;
+  fs::create_directories(p_->cfg.upload_dir, ec);
+  const std::string suffix = spool_suffix(name);
+  std::string tmpl = (fs::path(p_->cfg.upload_dir) / "upload-XXXXXX").string() + suffix;
+  fd = ::mkostemps(tmpl.data(), static_cast<int>(suffix.size()), O_CLOEXEC);
+  if (fd < 0) {
+    if (err_out) *err_out = "spool " + p_->cfg.upload_dir + ": " + std::strerror(errno);
+    return false;
+  }
+  path = std::move(tmpl);
+  return true;
+}
+
+bool ScanJobs::get(std::uint64_t id, ScanJobInfo& out) const {
+  std::lock_guard<std::mutex> lk(p_->mu);
+  auto it = p_->jobs.find(id);
+  if (it == p_->jobs.end()) return false;
+  out = it->second->info;
+  return true;
+}
+
+bool ScanJobs::wait(std::uint64_t id, ScanJobInfo& out) const {
+  std::unique_lock<std::mutex> lk(p_->mu);
+  for (;;) {
+    auto it = p_->jobs.find(id);
+    if (it == p_->jobs.end()) return false;
+    if (finished(it->second->info.state)) {
+      out = it->second->info;
+      return true;
+    }
+    p_->cv_done.wait(lk);
+  }
+}
+
+std::vector<ScanJobInfo> ScanJobs::list() const {
+  std::lock_guard<std::mutex> lk(p_->mu);
+  std::vector<ScanJobInfo> out;
+  out.reserve(p_->jobs.size());
+  for (auto it = p_->jobs.rbegin(); it != p_->jobs.rend(); ++it) out.push_back(it->second->info);
+  return out;
+}
+
+bool ScanJobs::cancel(std::uint64_t id) {
+  std::lock_guard<std::mutex> lk(p_->mu);
+  auto it = p_->jobs.find(id);
+  if (it == p_->jobs.end() || finished(it->second->info.state)) return false;
+  Impl::Job& j = *it->second;
+  j.cancel.store(true);
+  // Still queued: never starts. Otherwise the scan sees the flag.
+  if (j.info.state == ScanJobState::Queued && p_->sched->cancel(id)) {
+    p_->finish(j, ScanJobState::Cancelled, "cancelled");
+  }
+  return true;
+}
+
+void ScanJobs::wait_idle() {
+  p_->sched->wait_idle();
+}
+
+void ScanJobs::shutdown() {
+  {
+    std::lock_guard<std::mutex> lk(p_->mu);
+    p_->stopping = true;
+  }
+  p_->sched->shutdown();
+  p_->flush_etags();
+}
+
+const ScanOptions& ScanJobs::base_options() const noexcept {
+  return p_->base;
+}
+
+}
@@ -0,0 +1,190 @@
+#include "typed_scanner/scan_scheduler.hpp"
+#include "typed_scanner/task_pool.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <filesystem>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
+namespace ts {
+
+struct ScanScheduler::Impl {
+  Config cfg;
+  TicketScanFn scan;
+  ResultCallback on_result;
+
+  TaskPool* pool = nullptr;
+
+  mutable std::mutex mu;
+  std::condition_variable cv_idle;
+  struct Pending { std::string path; Ticket ticket; };
+  std::multimap<std::uint64_t, Pending> pending; // size -> file (ascending)
+  std::uint64_t pending_bytes = 0;
+  std::uint64_t inflight_bytes = 0;
+  // Started but not yet picked up by a pool worker: ticket -> size.
+  std::unordered_map<Ticket, std::uint64_t> launched;
+  Ticket next_ticket = 1;
+  unsigned running = 0;
+  std::size_t tasks = 0; // pool tasks not yet returned, cancelled ones too
+  bool stopping = false;
+  Stats st;
+
+  // Largest pending file that fits the remaining budget; a lone oversize
+  // file when nothing is running. Caller holds `mu`.
+  bool take(Pending& job, std::uint64_t& size) {
+    if (pending.empty()) return false;
+    auto it = pending.end();
+    const std::uint64_t room = cfg.max_inflight_bytes > inflight_bytes
+                             ? cfg.max_inflight_bytes - inflight_bytes : 0;
+    auto fit = pending.upper_bound(room);
+    if (fit != pending.begin()) it = std::prev(fit);
+    else if (running == 0) it = std::prev(pending.end());
+    if (it == pending.end()) return false;
+    size = it->first;
+    job = std::move(it->second);
+    pending.erase(it);
+    pending_bytes -= size;
+    return true;
+  }
+
+  // Caller holds `mu`.
+  void start(Pending job, std::uint64_t size) {
+    inflight_bytes += size;
+    ++running;
+    st.peak_inflight_bytes = std::max(st.peak_inflight_bytes, inflight_bytes);
+    st.peak_running = std::max(st.peak_running, running);
+    launched.emplace(job.ticket, size);
+    ++tasks;
+    pool->submit([this, job = std::move(job), size]{ run_one(job, size); });
+  }
+
+  // Caller holds `mu`.
+  void slot_freed(std::uint64_t size) {
+    inflight_bytes -= size;
+    --running;
+    pump();
+    if (pending.empty() && running == 0) cv_idle.notify_all();
+  }
+
+  // Start as many admitted files as slots allow. Caller holds `mu`.
+  void pump() {
+    while (running < cfg.max_parallel) {
+      Pending job;
+      std::uint64_t size = 0;
+      if (!take(job, size)) return;
+      start(std::move(job), size);
+    }
+  }
+
+  void run_one(const Pending& job, std::uint64_t size) {
+    std::unique_lock<std::mutex> lk(mu);
+    if (launched.erase(job.ticket)) { // else cancelled while waiting for a worker
+      lk.unlock();
+      ScanResult r = scan(job.path, job.ticket);
+      if (on_result) on_result(r);
+      lk.lock();
+      ++st.completed;
+      if (!r.ok()) ++st.failed;
+      slot_freed(size);
+    }
+    if (--tasks == 0) cv_idle.notify_all();
+  }
+};
+
+ScanScheduler::ScanScheduler(Config cfg, ScanFn scan, ResultCallback on_result, TaskPool* pool)
+  : ScanScheduler(cfg,
+                  TicketScanFn([scan = std::move(scan)](const std::string& path, Ticket){ return scan(path); }),
+                  std::move(on_result), pool) {}
+
+ScanScheduler::ScanScheduler(Config cfg, TicketScanFn scan, ResultCallback on_result, TaskPool* pool)
+  : p_(new Impl{}) {
+  if (cfg.max_parallel == 0) cfg.max_parallel = 1;
+  p_->cfg = cfg;
+  p_->scan = std::move(scan);
+  p_->on_result = std::move(on_result);
+  p_->pool = pool ? pool : &TaskPool::global();
+}
+
+ScanScheduler::~ScanScheduler() {
+  shutdown();
+  {
+    // Cancelled files still have a (no-op) task queued on the pool.
+    std::unique_lock<std::mutex> lk(p_->mu);
+    p_->cv_idle.wait(lk, [&]{ return p_->tasks == 0; });
+  }
+  delete p_;
+}
+
+ScanScheduler::Ticket ScanScheduler::submit(std::string path) {
+  std::error_code ec;
+  const auto sz = std::filesystem::file_size(path, ec);
+  return submit(std::move(path), ec ? 0 : static_cast<std::uint64_t>(sz));
+}
+
+ScanScheduler::Ticket ScanScheduler::submit(std::string path, std::uint64_t size_bytes) {
+  std::lock_guard<std::mutex> lk(p_->mu);
+  if (p_->stopping) return 0;
+  const Ticket t = p_->next_ticket++;
+  p_->pending.emplace(size_bytes, Impl::Pending{std::move(path), t});
+  p_->pending_bytes += size_bytes;
+  ++p_->st.submitted;
+  p_->pump();
+  return t;
+}
+
+ScanScheduler::Ticket ScanScheduler::try_start(std::string path, std::uint64_t size_bytes) {
+  std::lock_guard<std::mutex> lk(p_->mu);
+  if (p_->stopping || p_->running >= p_->cfg.max_parallel) return 0;
+  if (p_->running > 0 && p_->inflight_bytes + size_bytes > p_->cfg.max_inflight_bytes) return 0;
+  const Ticket t = p_->next_ticket++;
+  ++p_->st.submitted;
+  p_->start(Impl::Pending{std::move(path), t}, size_bytes);
+  return t;
+}
+
+bool ScanScheduler::cancel(Ticket ticket) {
+  std::lock_guard<std::mutex> lk(p_->mu);
+  for (auto it = p_->pending.begin(); it != p_->pending.end(); ++it) {
+    if (it->second.ticket != ticket) continue;
+    p_->pending_bytes -= it->first;
+    p_->pending.erase(it);
+    ++p_->st.cancelled;
+    if (p_->pending.empty() && p_->running == 0) p_->cv_idle.notify_all();
+    return true;
+  }
+  // Started, but its pool task has not begun: the slot comes back now.
+  auto it = p_->launched.find(ticket);
+  if (it == p_->launched.end()) return false;
+  const std::uint64_t size = it->second;
+  p_->launched.erase(it);
+  ++p_->st.cancelled;
+  p_->slot_freed(size);
+  return true;
+}
+
+std::uint64_t ScanScheduler::queued_bytes() const {
+  std::lock_guard<std::mutex> lk(p_->mu);
+  return p_->pending_bytes + p_->inflight_bytes;
+}
+
+void ScanScheduler::wait_idle() {
+  std::unique_lock<std::mutex> lk(p_->mu);
+  p_->cv_idle.wait(lk, [&]{ return p_->pending.empty() && p_->running == 0; });
+}
+
+void ScanScheduler::shutdown() {
+  {
+    std::lock_guard<std::mutex> lk(p_->mu);
+    p_->stopping = true;
+  }
+  wait_idle();
+}
+
+ScanScheduler::Stats ScanScheduler::stats() const {
+  std::lock_guard<std::mutex> lk(p_->mu);
+  return p_->st;
+}
+
+}
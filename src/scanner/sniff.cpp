@@ -0,0 +1,230 @@
+#include "typed_scanner/sniff.hpp"
+#include "typed_scanner/byte_source.hpp"
+#include "typed_scanner/trace.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace ts {
+
+namespace {
+
+constexpr char kDelimiters[] = {',', '\t', '|', ';'}; // ties go to the earlier one
+constexpr std::size_t kMaxLines = 100;
+constexpr std::size_t kHeaderRows = 50;
+
+std::string_view trim(std::string_view s) {
+  while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+  while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r')) s.remove_suffix(1);
+  return s;
+}
+
+// Non-blank lines, without a trailing partial one unless the sample is the
+// whole input (or that is all there is).
+std::vector<std::string_view> sample_lines(std::string_view s, char eol, bool complete) {
+  std::vector<std::string_view> lines;
+  std::size_t b = 0;
+  while (b < s.size() && lines.size() < kMaxLines) {
+    std::size_t e = s.find(eol, b);
+    if (e == std::string_view::npos) {
+      if (!complete && !lines.empty()) break;
+      e = s.size();
+    }
+    std::string_view line = s.substr(b, e - b);
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+    if (!trim(line).empty()) lines.push_back(line);
+    b = e + 1;
+  }
+  return lines;
+}
+
+std::size_t count_outside_quotes(std::string_view line, char delim, char quote) {
+  std::size_t n = 0;
+  bool quoted = false;
+  for (const char c : line) {
+    if (c == quote) quoted = !quoted; // a doubled quote toggles twice
+    else if (c == delim && !quoted) ++n;
+  }
+  return n;
+}
+
+std::vector<std::string_view> split_fields(std::string_view line, char delim, char quote) {
+  std::vector<std::string_view> out;
+  std::size_t b = 0;
+  bool quoted = false;
+  for (std::size_t i = 0; i <= line.size(); ++i) {
+    if (i < line.size() && line[i] == quote) { quoted = !quoted; continue; }
+    if (i == line.size() || (line[i] == delim && !quoted)) {
+      std::string_view f = trim(line.substr(b, i - b));
+      if (f.size() >= 2 && f.front() == quote && f.back() == quote) f = f.substr(1, f.size() - 2);
+      out.push_back(f);
+      b = i + 1;
+    }
+  }
+  return out;
+}
+
+bool is_number(std::string_view s) {
+  if (s.empty() || s.size() > 64) return false;
+  char buf[65];
+  std::memcpy(buf, s.data(), s.size());
+  buf[s.size()] = '\0';
+  char* end = nullptr;
+  errno = 0;
+  (void)std::strtod(buf, &end);
+  return end == buf + s.size();
+}
+
+// Quote used at field starts: ' only when it clearly beats ".
+char sniff_quote(const std::vector<std::string_view>& lines) {
+  std::size_t dq = 0, sq = 0;
+  for (const auto line : lines) {
+    for (std::size_t i = 0; i < line.size(); ++i) {
+      const bool field_start = i == 0 || std::strchr(",\t|;", line[i - 1]) != nullptr;
+      if (!field_start) continue;
+      dq += line[i] == '"';
+      sq += line[i] == '\'';
+    }
+  }
+  return sq > dq ? '\'' : '"';
+}
+
+// A header row is text above columns that are otherwise numbers, or (all
+// text) a row of distinct names that never repeat below.
+bool sniff_header(const std::vector<std::string_view>& lines, char delim, char quote, bool fallback) {
+  if (lines.size() < 2) return fallback;
+  std::vector<std::vector<std::string_view>> rows;
+  for (std::size_t i = 0; i < lines.size() && i < kHeaderRows; ++i) {
+    rows.push_back(split_fields(lines[i], delim, quote));
+  }
+  const auto& first = rows[0];
+  int votes = 0;
+  for (std::size_t c = 0; c < first.size(); ++c) {
+    std::size_t numeric = 0, seen = 0;
+    for (std::size_t r = 1; r < rows.size(); ++r) {
+      if (c >= rows[r].size() || rows[r][c].empty()) continue;
+      ++seen;
+      numeric += is_number(rows[r][c]);
+    }
+    if (seen == 0) continue;
+    const bool col_numeric = numeric * 5 >= seen * 4; // 80%
+    if (col_numeric) votes += is_number(first[c]) ? -1 : 1;
+  }
+  if (votes != 0) return votes > 0;
+
+  std::set<std::string_view> names;
+  for (std::size_t c = 0; c < first.size(); ++c) {
+    if (first[c].empty() || is_number(first[c]) || !names.insert(first[c]).second) return false;
+    for (std::size_t r = 1; r < rows.size(); ++r) {
+      if (c < rows[r].size() && rows[r][c] == first[c]) return false;
+    }
+  }
+  return true;
+}
+
+}
+
+Dialect sniff_dialect(std::string_view s, bool complete, bool fallback_header) {
+  Dialect d;
+  d.header = fallback_header;
+  if (s.substr(0, 3) == "\xEF\xBB\xBF") {
+    d.bom = true;
+    s.remove_prefix(3);
+  }
+  if (s.find('\0') != std::string_view::npos) return d; // binary
+
+  std::size_t crlf = 0, lf = 0, cr = 0;
+  for (std::size_t i = 0; i < s.size(); ++i) {
+    if (s[i] == '\r') {
+      if (i + 1 < s.size() && s[i + 1] == '\n') { ++crlf; ++i; }
+      else ++cr;
+    } else if (s[i] == '\n') {
+      ++lf;
+    }
+  }
+  if (cr && !lf && !crlf) d.line_ending = "cr";
+  else if (crlf && !lf) d.line_ending = "crlf";
+  else if (crlf && lf) d.line_ending = "mixed";
+
+  const auto lines = sample_lines(s, d.line_ending == "cr" ? '\r' : '\n', complete);
+  if (lines.empty()) return d;
+
+  // JSONL: objects, one per line.
+  if (trim(lines[0]).front() == '{') {
+    std::size_t objects = 0;
+    for (const auto line : lines) {
+      const auto t = trim(line);
+      objects += t.front() == '{' && t.back() == '}';
+    }
+    d.format = FileFormat::JSONL;
+    d.confidence = double(objects) / double(lines.size());
+    return d;
+  }
+
+  // CSV: the delimiter that splits the most lines into the same number of
+  // fields; the share of lines that agree is the confidence.
+  d.format = FileFormat::CSV;
+  d.quote = sniff_quote(lines);
+  double best = 0.0;
+  std::size_t best_fields = 0;
+  for (const char delim : kDelimiters) {
+    std::map<std::size_t, std::size_t> freq;
+    for (const auto line : lines) ++freq[count_outside_quotes(line, delim, d.quote)];
+    const auto mode = std::max_element(freq.begin(), freq.end(),
+        [](const auto& a, const auto& b){ return a.second < b.second || (a.second == b.second && a.first < b.first); });
+    if (mode->first == 0) continue;
+    const double share = double(mode->second) / double(lines.size());
+    if (share > best || (share == best && mode->first > best_fields)) {
+      best = share;
+      best_fields = mode->first;
+      d.delimiter = delim;
+    }
+  }
+  // One column or one line proves little.
+  d.confidence = best_fields == 0 ? 0.5 : lines.size() < 2 ? std::min(best, 0.5) : best;
+  d.header = sniff_header(lines, d.delimiter, d.quote, fallback_header);
+  return d;
+}
+
+bool sniff_file(const std::string& path, Dialect& out, bool fallback_header, std::string* err_out) {
+  TS_TRACE_SCOPE_CAT("sniff", "io");
+  std::error_code ec;
+  if (!std::filesystem::is_regular_file(path, ec)) {
+    if (err_out) *err_out = "not a regular file: " + path;
+    return false;
+  }
+  FILE* f = std::fopen(path.c_str(), "rb");
+  if (!f) {
+    if (err_out) *err_out = path + ": " + std::strerror(errno);
+    return false;
+  }
+  std::unique_ptr<ByteSource> src = open_byte_source(f, detect_compression(path), err_out);
+  if (!src) return false;
+  std::string sample(kSniffBytes, '\0');
+  std::size_t got = 0;
+  while (got < sample.size()) {
+    const std::size_t n = src->read(sample.data() + got, sample.size() - got);
+    if (n == 0) break;
+    got += n;
+  }
+  // A damaged stream may still yield a usable head.
+  sample.resize(got);
+  out = sniff_dialect(sample, got < kSniffBytes, fallback_header);
+  return true;
+}
+
+void apply_dialect(const Dialect& d, CsvConfig& cfg) {
+  if (d.quote != cfg.quote && cfg.escape == cfg.quote) cfg.escape = d.quote;
+  cfg.quote = d.quote;
+  cfg.delimiter = d.delimiter;
+  if (cfg.escape == cfg.delimiter) cfg.escape = cfg.quote;
+  cfg.header = d.header;
+}
+
+}
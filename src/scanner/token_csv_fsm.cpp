@@ -1,6 +1,8 @@
 #include "typed_scanner/token_csv_fsm.hpp"
 #include "typed_scanner/arena.hpp"
 #include "typed_scanner/record_view.hpp"
+#include "typed_scanner/trace.hpp"
+#include <cstring>
 #include <string_view>
 #include <vector>
 
@@ -25,7 +27,19 @@ struct CsvFsm::Impl {
     const char* s = buf.data();
     const char* e = s + buf.size();
 
-    enum class Mode { Unquoted, Quoted, QuoteEscape } mode = Mode::Unquoted;
+    // Fast path: no quote on the line, so fields end at each delimiter.
+    if (!buf.empty() && !std::memchr(s, cfg.quote, buf.size())) {
+      const char* f = s;
+      while (const char* d = static_cast<const char*>(std::memchr(f, cfg.delimiter, e - f))) {
+        st.fields.emplace_back(f, d - f);
+        f = d + 1;
+      }
+      st.fields.emplace_back(f, e - f);
+      return true;
+    }
+
+    enum class Mode { Unquoted, Quoted, QuoteEscape, Escaped } mode = Mode::Unquoted;
+    const bool backslash_style = cfg.escape != cfg.quote;
     const char* field_start = s;
     for (const char* p = s; p <= e; ++p) {
       char c = (p < e) ? *p : cfg.delimiter; // sentinel delimiter at end
@@ -40,7 +54,11 @@ struct CsvFsm::Impl {
           }
           break;
         case Mode::Quoted:
-          if (c == cfg.quote) mode = Mode::QuoteEscape;
+          if (backslash_style && c == cfg.escape && p < e) mode = Mode::Escaped;
+          else if (c == cfg.quote) mode = Mode::QuoteEscape;
+          break;
+        case Mode::Escaped:
+          mode = Mode::Quoted;              // escaped char kept verbatim
           break;
         case Mode::QuoteEscape:
           if (c == cfg.quote) {
@@ -65,6 +83,7 @@ CsvFsm::CsvFsm(const CsvConfig& cfg, Arena& header_arena, Arena& row_arena)
 const std::vector<std::string_view>& CsvFsm::header() const { return p_->st.header; }
 
 bool CsvFsm::feed(std::string_view line, const RecordCallback& on_record) {
+  TS_TRACE_SCOPE_FINE("csv.feed");
   if (!p_->parse_line(line)) { err_ = "CSV parse error (quoted field mismatch)"; return false; }
 
   if (p_->cfg.header && !p_->st.has_header_emitted) {
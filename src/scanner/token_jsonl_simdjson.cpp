@@ -1,6 +1,7 @@
 #include "typed_scanner/token_jsonl_simdjson.hpp"
 #include "typed_scanner/arena.hpp"
 #include "typed_scanner/record_view.hpp"
+#include "typed_scanner/trace.hpp"
 
 #include <simdjson.h>
 #include <string>
@@ -41,9 +42,18 @@ struct JsonlTokenizer::Impl {
 JsonlTokenizer::JsonlTokenizer(const JsonlConfig& cfg, Arena& header_arena, Arena& row_arena)
   : p_(new Impl(cfg, header_arena, row_arena)) {}
 
+JsonlTokenizer::~JsonlTokenizer() { delete p_; }
+
 const std::vector<std::string_view>& JsonlTokenizer::header() const { return p_->header; }
 
+void JsonlTokenizer::set_header(const std::vector<std::string_view>& keys) {
+  p_->header.clear();
+  p_->header.reserve(keys.size());
+  for (auto k : keys) p_->header.emplace_back(p_->header_arena.copy(k));
+}
+
 bool JsonlTokenizer::feed_line(std::string_view line, const RecordCallback& on_record) {
+  TS_TRACE_SCOPE_FINE("jsonl.feed_line");
   p_->fields.clear();
 
   // thread-local scratch and parser
@@ -64,17 +74,21 @@ bool JsonlTokenizer::feed_line(std::string_view line, const RecordCallback& on_r
       std::vector<std::pair<std::string_view, std::string_view>> kvs;
       kvs.reserve(16);
 
+      // First object seen → capture header order (all of its keys).
+      const bool capture = p_->cfg.intern_keys && p_->header.empty();
+
       simdjson::ondemand::object obj = root.get_object();
       for (auto field : obj) {
         auto k = field.unescaped_key().value_unsafe();
-        std::string_view ksv = p_->cfg.intern_keys
-          ? p_->header_arena.copy(std::string_view(k.data(), k.size()))
-          : p_->row_arena.copy(std::string_view(k.data(), k.size()));
-
-        if (p_->cfg.intern_keys && p_->header.empty()) {
-          // First object seen → capture header order
-          p_->header.emplace_back(ksv);
-        }
+        // Once the header is known, keys are only matched against it and the
+        // parser's buffer outlives this call, so they are not copied (copying
+        // every key grew the header arena and moved the header under us).
+        std::string_view ksv = !p_->cfg.intern_keys
+          ? p_->row_arena.copy(std::string_view(k.data(), k.size()))
+          : capture ? p_->header_arena.copy(std::string_view(k.data(), k.size()))
+                    : std::string_view(k.data(), k.size());
+
+        if (capture) p_->header.emplace_back(ksv);
 
         simdjson::ondemand::value v = field.value();
         std::string_view val_sv{};
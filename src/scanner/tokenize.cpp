@@ -0,0 +1,238 @@
+#include "typed_scanner/tokenize.hpp"
+#include "typed_scanner/arena.hpp"
+#include "typed_scanner/chunk_reader.hpp"
+#include "typed_scanner/histogram.hpp"
+#include "typed_scanner/metrics.hpp"
+#include "typed_scanner/record_view.hpp"
+#include "typed_scanner/task_pool.hpp"
+#include "typed_scanner/token_csv_fsm.hpp"
+#include "typed_scanner/token_jsonl_simdjson.hpp"
+#include "typed_scanner/trace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace ts {
+
+TokenizeStats tokenize_file(const std::string& path, FileFormat fmt,
+                            const TokenizeOptions& opts, MetricsRegistry* metrics,
+                            TokenizeSink* sink) {
+  namespace ch = std::chrono;
+  TokenizeStats out;
+  // Unknown is sniffed from the first line, so only streams may pass it.
+  const bool stream = is_stream_path(path);
+  if (fmt == FileFormat::Unknown && !stream) {
+    out.ok = false;
+    out.error = "unsupported format";
+    return out;
+  }
+
+  // Compressed files are one stream (no window), split only along the
+  // frames of BGZF / multi-frame zstd files.
+  const Compression comp = opts.reader.decompress ? detect_compression(path) : Compression::None;
+  out.compression = comp;
+
+  std::error_code ec;
+  const std::uint64_t file_size = std::filesystem::file_size(path, ec);
+  std::uint64_t size = file_size;
+  // reader.begin_offset/end_offset narrow the scan to a window (resume).
+  const std::uint64_t first = opts.reader.begin_offset;
+  if (opts.reader.end_offset && opts.reader.end_offset < size) size = opts.reader.end_offset;
+  std::uint64_t span = (!ec && size > first) ? size - first : 0;
+  const bool may_split = opts.pool && !ec && !stream && opts.min_range_bytes > 0;
+  std::vector<CompressedFrame> frames;
+  if (comp != Compression::None) {
+    if (may_split && index_frames(path, comp, frames) && frames.size() > 1) {
+      span = frames.back().out_offset + frames.back().out_size;
+    } else {
+      frames.clear();
+    }
+  }
+  unsigned nranges = 1;
+  if (may_split && (comp == Compression::None || !frames.empty())) {
+    const unsigned cap = opts.max_ranges ? opts.max_ranges : opts.pool->size();
+    const std::uint64_t by_size = span / opts.min_range_bytes;
+    nranges = static_cast<unsigned>(std::max<std::uint64_t>(1, std::min<std::uint64_t>(cap, by_size)));
+  }
+
+  // Compressed ranges start on the first frame at or after an even split
+  // of the decoded size; big frames can merge ranges.
+  std::vector<std::size_t> cuts; // frame index each range starts at
+  if (!frames.empty() && nranges > 1) {
+    for (unsigned r = 0; r < nranges; ++r) {
+      const std::uint64_t target = span * r / nranges;
+      const auto it = std::lower_bound(frames.begin(), frames.end(), target,
+          [](const CompressedFrame& f, std::uint64_t v){ return f.out_offset < v; });
+      const std::size_t k = static_cast<std::size_t>(it - frames.begin());
+      if (k < frames.size() && (cuts.empty() || k > cuts.back())) cuts.push_back(k);
+    }
+    nranges = static_cast<unsigned>(cuts.size());
+  }
+
+  // Header of line 1, replayed into every range that does not start at 0.
+  std::string header_line;
+  Arena prime_arena(4 * 1024);
+  std::vector<std::string_view> jsonl_keys;
+  if (nranges > 1 || first > 0) {
+    ChunkReader::Config hcfg = opts.reader;
+    hcfg.begin_offset = 0;
+    hcfg.end_offset = 1; // just the first line
+    hcfg.decompress_thread = false;
+    ChunkReader hr(path, hcfg);
+    bool have_header = false;
+    (void)hr.for_each_line([&](std::string_view l){
+      if (!have_header) header_line.assign(l);
+      have_header = true;
+    });
+    if (fmt == FileFormat::JSONL) {
+      Arena scratch(4 * 1024);
+      JsonlTokenizer jt(opts.jsonl, prime_arena, scratch);
+      (void)jt.feed_line(header_line, [](const RecordView&){});
+      jsonl_keys = jt.header();
+    }
+  }
+
+  struct RangeOut {
+    bool ok = true;
+    std::string error;
+    std::uint64_t rows = 0;
+    std::uint64_t fields = 0;
+    std::uint64_t bytes = 0;
+    std::uint64_t raw_bytes = 0;
+    std::uint64_t decompress_ns = 0;
+    Compression compression = Compression::None;
+    FileFormat format = FileFormat::Unknown;
+    LatencyHistogram chunk_lat, record_lat; // per range, single writer
+  };
+  std::vector<RangeOut> outs(nranges);
+  if (sink) sink->begin(nranges);
+
+  auto run_range = [&](std::size_t r){
+    TS_TRACE_SCOPE("tokenize.range");
+    RangeOut& ro = outs[r];
+    Arena header_arena(64 * 1024);
+    Arena row_arena(opts.arena_bytes);
+
+    ChunkReader::Config rcfg = opts.reader;
+    if (!rcfg.pool) rcfg.pool = opts.pool;
+    if (sink && sink->stop_flag()) rcfg.stop = sink->stop_flag();
+    if (!cuts.empty()) {
+      // Frames decode in parallel across ranges instead of on a helper thread.
+      const CompressedFrame& fr = frames[cuts[r]];
+      rcfg.begin_offset = fr.out_offset;
+      rcfg.frame_offset = fr.raw_offset;
+      rcfg.end_offset = (r + 1 == nranges) ? 0 : frames[cuts[r + 1]].out_offset;
+      rcfg.decompress_thread = false;
+    } else if (nranges > 1) {
+      rcfg.begin_offset = first + span * r / nranges;
+      rcfg.end_offset = (r + 1 == nranges) ? opts.reader.end_offset : first + span * (r + 1) / nranges;
+    }
+    const bool primed = rcfg.begin_offset > 0;
+    ChunkReader reader(path, rcfg);
+
+    // record callback (counts rows/fields and resets row arena periodically)
+    const unsigned range = static_cast<unsigned>(r);
+    auto on_record = [&](const RecordView& rv){
+      if (sink) sink->record(range, rv);
+      ++ro.rows;
+      if (metrics) metrics->add_row();
+      if (rv.fields()) ro.fields += rv.fields()->size();
+      if ((ro.rows % 10000) == 0) row_arena.reset();
+    };
+
+    // Live progress for the series sampler; overlapping range edges make it
+    // a slight overcount, TokenizeStats::bytes is the exact total.
+    reader.on_chunk([&](std::uint64_t n, std::uint64_t ns){
+      ro.chunk_lat.record(ns);
+      if (metrics) metrics->add_bytes(n);
+    });
+    // One line in kRecordSampleEvery is timed: two clock reads per line
+    // cost more than tokenizing a short one, and the percentiles do not
+    // need every sample.
+    std::uint32_t until_sample = 0;
+    auto timed = [&](auto&& feed){
+      if (until_sample-- != 0) return feed();
+      until_sample = kRecordSampleEvery - 1;
+      const auto r0 = ch::steady_clock::now();
+      const bool step = feed();
+      ro.record_lat.record(static_cast<std::uint64_t>(
+          ch::duration_cast<ch::nanoseconds>(ch::steady_clock::now() - r0).count()));
+      return step;
+    };
+
+    bool read_ok = true;
+    ro.format = fmt;
+    if (ro.format == FileFormat::Unknown) {
+      // Stream without --format: blank lines are skipped until one tells.
+      CsvFsm csv(opts.csv, header_arena, row_arena);
+      JsonlTokenizer jtok(opts.jsonl, header_arena, row_arena);
+      read_ok = reader.for_each_line([&](std::string_view line){
+        if (ro.format == FileFormat::Unknown) {
+          ro.format = sniff_format(line);
+          if (ro.format == FileFormat::Unknown) return;
+        }
+        ro.ok &= timed([&]{
+          return ro.format == FileFormat::CSV ? csv.feed(line, on_record) : jtok.feed_line(line, on_record);
+        });
+      });
+      if (ro.format == FileFormat::CSV) ro.ok &= csv.finish(on_record);
+      if (!ro.ok) ro.error = ro.format == FileFormat::CSV ? "CSV error: " + csv.error() : "JSONL error: " + jtok.error();
+    } else if (fmt == FileFormat::CSV) {
+      CsvFsm csv(opts.csv, header_arena, row_arena);
+      if (primed && opts.csv.header) (void)csv.feed(header_line, on_record);
+      read_ok = reader.for_each_line([&](std::string_view line){
+        ro.ok &= timed([&]{ return csv.feed(line, on_record); });
+      });
+      ro.ok &= csv.finish(on_record);
+      if (!ro.ok) ro.error = "CSV error: " + csv.error();
+    } else {
+      JsonlTokenizer jtok(opts.jsonl, header_arena, row_arena);
+      if (primed) jtok.set_header(jsonl_keys);
+      read_ok = reader.for_each_line([&](std::string_view line){
+        ro.ok &= timed([&]{ return jtok.feed_line(line, on_record); });
+      });
+      if (!ro.ok) ro.error = "JSONL error: " + jtok.error();
+    }
+    if (!read_ok) {
+      ro.ok = false;
+      ro.error = "read failed: " + path;
+      if (!reader.error().empty()) ro.error += ": " + reader.error();
+    }
+    ro.bytes = reader.bytes_read();
+    ro.raw_bytes = reader.raw_bytes_read();
+    ro.decompress_ns = reader.decompress_ns();
+    ro.compression = reader.compression();
+    if (sink) sink->end_range(range);
+  };
+
+  if (nranges == 1) run_range(0);
+  else parallel_for(*opts.pool, nranges, run_range);
+
+  out.ranges = nranges;
+  out.format = outs[0].format;
+  if (stream) out.compression = outs[0].compression; // known once read
+  const Compression comp_read = out.compression;
+  for (auto& ro : outs) {
+    out.rows += ro.rows;
+    out.fields += ro.fields;
+    out.decompress_ns += ro.decompress_ns;
+    if (!ro.ok && out.ok) { out.ok = false; out.error = ro.error; }
+    if (metrics) {
+      metrics->merge_latency(kLatencyChunk, ro.chunk_lat);
+      metrics->merge_latency(kLatencyRecord, ro.record_lat);
+    }
+  }
+  // Ranges overlap by the partial lines they skip/finish; count the file once.
+  out.bytes = (nranges == 1 && first == 0 && !opts.reader.end_offset) ? outs[0].bytes : span;
+  if (comp_read == Compression::None) out.raw_bytes = out.bytes;
+  else out.raw_bytes = nranges > 1 ? file_size : outs[0].raw_bytes; // ranges read ahead of their frames
+  if (metrics && comp_read != Compression::None) {
+    metrics->add_stage_ns(metrics->register_stage("decompress"), out.decompress_ns);
+  }
+  return out;
+}
+
+}
@@ -0,0 +1,220 @@
+#include "typed_scanner/file_cache.hpp"
+#include "typed_scanner/trace.hpp"
+
+#define XXH_INLINE_ALL
+#include <xxhash.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <sys/stat.h>
+
+namespace ts {
+
+namespace {
+
+struct FileId {
+  std::int64_t mtime_ns = 0;
+  std::uint64_t size = 0;
+  std::uint64_t inode = 0;
+};
+
+bool stat_file(const std::string& path, FileId& id, std::string* err_out) {
+  struct stat st{};
+  if (::stat(path.c_str(), &st) != 0) {
+    if (err_out) *err_out = path + ": " + std::strerror(errno);
+    return false;
+  }
+  if (!S_ISREG(st.st_mode)) {
+    if (err_out) *err_out = path + ": not a regular file";
+    return false;
+  }
+  id.mtime_ns = std::int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+  id.size = static_cast<std::uint64_t>(st.st_size);
+  id.inode = static_cast<std::uint64_t>(st.st_ino);
+  return true;
+}
+
+bool same(const CachedFile& f, const FileId& id) {
+  return f.mtime_ns == id.mtime_ns && f.size == id.size && f.inode == id.inode;
+}
+
+std::shared_ptr<CachedFile> load(const std::string& path, const FileId& id, std::string* err_out) {
+  TS_TRACE_SCOPE_CAT("file_cache.load", "io");
+  FILE* f = std::fopen(path.c_str(), "rb");
+  if (!f) {
+    if (err_out) *err_out = path + ": " + std::strerror(errno);
+    return nullptr;
+  }
+  auto out = std::make_shared<CachedFile>();
+  out->body.resize(id.size);
+  std::size_t got = std::fread(out->body.data(), 1, out->body.size(), f);
+  // A file that grew since the stat is read to its end.
+  char tail[64 * 1024];
+  for (std::size_t n; (n = std::fread(tail, 1, sizeof tail, f)) > 0;) {
+    out->body.append(tail, n);
+    got += n;
+  }
+  const bool failed = std::ferror(f);
+  std::fclose(f);
+  if (failed) {
+    if (err_out) *err_out = path + ": read error";
+    return nullptr;
+  }
+  out->body.resize(got);
+  out->path = path;
+  char hex[19];
+  std::snprintf(hex, sizeof hex, "%016llx",
+                static_cast<unsigned long long>(XXH3_64bits(out->body.data(), out->body.size())));
+  out->etag = std::string("\"") + hex + "\"";
+  out->last_modified = http_date(id.mtime_ns / 1000000000);
+  out->mtime_ns = id.mtime_ns;
+  out->size = id.size;
+  out->inode = id.inode;
+  return out;
+}
+
+// Validators only; hashing a large artifact on every change would cost as
+// much as reading it.
+std::shared_ptr<CachedFile> describe(const std::string& path, const FileId& id) {
+  auto out = std::make_shared<CachedFile>();
+  char tag[48];
+  std::snprintf(tag, sizeof tag, "\"%llx-%llx\"", static_cast<unsigned long long>(id.size),
+                static_cast<unsigned long long>(id.mtime_ns));
+  out->path = path;
+  out->streamed = true;
+  out->etag = tag;
+  out->last_modified = http_date(id.mtime_ns / 1000000000);
+  out->mtime_ns = id.mtime_ns;
+  out->size = id.size;
+  out->inode = id.inode;
+  return out;
+}
+
+std::string_view trim(std::string_view s) {
+  while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+  while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+  return s;
+}
+
+std::string_view opaque_tag(std::string_view tag) {
+  if (tag.substr(0, 2) == "W/") tag.remove_prefix(2);
+  return tag;
+}
+
+}
+
+struct FileCache::Impl {
+  using Lru = std::list<std::pair<std::string, std::shared_ptr<const CachedFile>>>;
+
+  Config cfg;
+  mutable std::mutex mu;
+  Lru lru; // front = most recently used
+  std::unordered_map<std::string, Lru::iterator> index;
+  Stats st;
+
+  void erase_locked(std::unordered_map<std::string, Lru::iterator>::iterator it) {
+    st.bytes -= it->second->second->body.size();
+    lru.erase(it->second);
+    index.erase(it);
+  }
+
+  void insert_locked(const std::string& path, std::shared_ptr<const CachedFile> f) {
+    if (auto it = index.find(path); it != index.end()) erase_locked(it);
+    st.bytes += f->body.size();
+    lru.emplace_front(path, std::move(f));
+    index.emplace(path, lru.begin());
+    while (st.bytes > cfg.max_bytes && !lru.empty()) {
+      erase_locked(index.find(lru.back().first));
+      ++st.evictions;
+    }
+  }
+};
+
+FileCache::FileCache(Config cfg) : p_(new Impl{}) { p_->cfg = cfg; }
+FileCache::~FileCache() { delete p_; }
+
+std::shared_ptr<const CachedFile> FileCache::get(const std::string& path, std::string* err_out) {
+  FileId id;
+  if (!stat_file(path, id, err_out)) {
+    std::lock_guard<std::mutex> lk(p_->mu);
+    if (auto it = p_->index.find(path); it != p_->index.end()) p_->erase_locked(it);
+    return nullptr;
+  }
+  {
+    std::lock_guard<std::mutex> lk(p_->mu);
+    if (auto it = p_->index.find(path); it != p_->index.end()) {
+      if (same(*it->second->second, id)) {
+        p_->lru.splice(p_->lru.begin(), p_->lru, it->second);
+        ++p_->st.hits;
+        return it->second->second;
+      }
+      p_->erase_locked(it);
+    }
+    ++p_->st.misses;
+  }
+  if (id.size > p_->cfg.max_entry_bytes) return describe(path, id);
+  std::shared_ptr<const CachedFile> f = load(path, id, err_out);
+  if (!f) return nullptr;
+  if (f->body.size() <= p_->cfg.max_entry_bytes && f->body.size() <= p_->cfg.max_bytes) {
+    std::lock_guard<std::mutex> lk(p_->mu);
+    p_->insert_locked(path, f);
+  }
+  return f;
+}
+
+FileCache::Stats FileCache::stats() const {
+  std::lock_guard<std::mutex> lk(p_->mu);
+  Stats s = p_->st;
+  s.entries = p_->index.size();
+  return s;
+}
+
+bool not_modified(const CachedFile& f, std::string_view if_none_match,
+                  std::string_view if_modified_since) {
+  if_none_match = trim(if_none_match);
+  if (!if_none_match.empty()) {
+    if (if_none_match == "*") return true;
+    while (!if_none_match.empty()) {
+      const std::size_t comma = if_none_match.find(',');
+      const std::string_view tag = trim(if_none_match.substr(0, comma));
+      if (opaque_tag(tag) == opaque_tag(f.etag)) return true;
+      if (comma == std::string_view::npos) break;
+      if_none_match.remove_prefix(comma + 1);
+    }
+    return false;
+  }
+  if_modified_since = trim(if_modified_since);
+  if (if_modified_since.empty()) return false;
+  std::tm tm{};
+  const std::string ims(if_modified_since);
+  const char* end = ::strptime(ims.c_str(), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+  if (!end || *end) return false;
+  return f.mtime_ns / 1000000000 <= std::int64_t(::timegm(&tm));
+}
+
+bool range_applies(const CachedFile& f, std::string_view if_range) {
+  if_range = trim(if_range);
+  return if_range.empty() || if_range == f.etag;
+}
+
+std::string http_date(std::int64_t unix_seconds) {
+  static const char* const kDays[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+  static const char* const kMonths[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                        "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+  const std::time_t t = static_cast<std::time_t>(unix_seconds);
+  std::tm tm{};
+  ::gmtime_r(&t, &tm);
+  char buf[40];
+  // Spelled out rather than %a/%b, which follow the locale.
+  std::snprintf(buf, sizeof buf, "%s, %02d %s %04d %02d:%02d:%02d GMT",
+                kDays[tm.tm_wday], tm.tm_mday, kMonths[tm.tm_mon], tm.tm_year + 1900,
+                tm.tm_hour, tm.tm_min, tm.tm_sec);
+  return buf;
+}
+
+}
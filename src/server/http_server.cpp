@@ -1,11 +1,39 @@
 #include "typed_scanner/http_server.hpp"
+#include "typed_scanner/artifact_writer.hpp"
+#include "typed_scanner/asset_store.hpp"
+#include "typed_scanner/dir_watcher.hpp"
+#include "typed_scanner/file_cache.hpp"
+#include "typed_scanner/json_writer.hpp"
+#include "typed_scanner/live_scan.hpp"
 #include "typed_scanner/path_utils.hpp"
+#include "typed_scanner/precompress.hpp"
+#include "typed_scanner/report_index.hpp"
+#include "typed_scanner/scan_jobs.hpp"
+#include "typed_scanner/ticker.hpp"
 #include <httplib.h>
+
+#define XXH_INLINE_ALL
+#include <xxhash.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <filesystem>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <string>
-#include <fstream>     // <-- add
-#include <sstream>     // <-- add
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace ts {
 
@@ -23,39 +51,326 @@ static std::string guess_mime(const std::string& name) {
   return "application/octet-stream";
 }
 
+// Open fd shared by a streamed response's provider calls.
+struct StreamedFile {
+  int fd = -1;
+  std::vector<char> buf;
+  ~StreamedFile() { if (fd >= 0) ::close(fd); }
+};
+
+// Send `f` unless the request's validators show the client has it (304).
+// A Range request gets an explicit status: 206 lets httplib cut the sized
+// provider into the range(s), with Content-Range or multipart/byteranges,
+// and answer 416 for ranges outside the file; 200 sends it whole.
+// Reports are rebuilt in place, so clients revalidate; /static/<hash>/ URLs
+// never change content.
+static constexpr const char* kRevalidate = "no-cache";
+static constexpr const char* kImmutable = "public, max-age=31536000, immutable";
+
+static void send_file(std::shared_ptr<const CachedFile> f, const std::string& mime,
+                      const httplib::Request& req, httplib::Response& res,
+                      const char* cache_control = kRevalidate) {
+  res.set_header("ETag", f->etag);
+  // Generated pages have no file time; they revalidate by ETag only.
+  if (!f->last_modified.empty()) res.set_header("Last-Modified", f->last_modified);
+  res.set_header("Cache-Control", cache_control);
+  res.set_header("Accept-Ranges", "bytes");
+  if (not_modified(*f, req.get_header_value("If-None-Match"),
+                   f->last_modified.empty() ? std::string() : req.get_header_value("If-Modified-Since"))) {
+    res.status = 304;
+    return;
+  }
+  if (!req.ranges.empty()) res.status = range_applies(*f, req.get_header_value("If-Range")) ? 206 : 200;
+  if (f->size == 0) { res.set_content(std::string(), mime); return; }
+  if (!f->streamed) {
+    // Write straight from the cached body; the provider keeps it alive.
+    res.set_content_provider(f->body.size(), mime, [f](std::size_t off, std::size_t len, httplib::DataSink& sink){
+      return sink.write(f->body.data() + off, len);
+    });
+    return;
+  }
+
+  // Large artifact: pread slices through one fixed buffer, so memory per
+  // response is flat whatever the file size. httplib's DataSink hides the
+  // socket (and may be TLS), so sendfile(2) is not available here.
+  auto sf = std::make_shared<StreamedFile>();
+  sf->fd = ::open(f->path.c_str(), O_RDONLY | O_CLOEXEC);
+  struct stat st{};
+  if (sf->fd < 0 || ::fstat(sf->fd, &st) != 0 ||
+      static_cast<std::uint64_t>(st.st_size) != f->size ||
+      static_cast<std::uint64_t>(st.st_ino) != f->inode) {
+    res.status = 503; // replaced between stat and open; the client retries
+    res.set_header("Retry-After", "1");
+    return;
+  }
+#ifdef POSIX_FADV_SEQUENTIAL
+  (void)::posix_fadvise(sf->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+  sf->buf.resize(256u << 10);
+  res.set_content_provider(f->size, mime, [sf](std::size_t off, std::size_t len, httplib::DataSink& sink){
+    while (len > 0) {
+      const ssize_t n = ::pread(sf->fd, sf->buf.data(), std::min(len, sf->buf.size()), static_cast<off_t>(off));
+      if (n < 0 && errno == EINTR) continue;
+      if (n <= 0) return false; // truncated underneath us: drop the connection
+      if (!sink.write(sf->buf.data(), static_cast<std::size_t>(n))) return false;
+      off += static_cast<std::size_t>(n);
+      len -= static_cast<std::size_t>(n);
+    }
+    return true;
+  });
+}
+
+static void append_html_escaped(std::string& out, const std::string& s) {
+  for (const char c : s) {
+    switch (c) {
+      case '&':  out += "&amp;"; break;
+      case '<':  out += "&lt;"; break;
+      case '>':  out += "&gt;"; break;
+      case '"':  out += "&quot;"; break;
+      case '\'': out += "&#39;"; break;
+      default:   out += c;
+    }
+  }
+}
+
+static std::size_t param_size(const httplib::Request& req, const char* key, std::size_t dflt) {
+  if (!req.has_param(key)) return dflt;
+  const std::string v = req.get_param_value(key);
+  char* end = nullptr;
+  const unsigned long long n = std::strtoull(v.c_str(), &end, 10);
+  return (end && *end == '\0' && !v.empty() && v[0] != '-') ? static_cast<std::size_t>(n) : dflt;
+}
+
+// One SSE message: `id:` is the sample's sequence number.
+static std::string progress_event(std::uint64_t seq, const LiveScanSample& s) {
+  std::string out = "id: " + std::to_string(seq) + "\ndata: ";
+  JsonWriter w(out);
+  w.begin_object()
+   .key("time_ms").value(s.time_ms)
+   .key("rows").value(s.rows)
+   .key("bytes").value(s.bytes)
+   .key("mb_s").value(s.mb_s)
+   .key("rss_mb").value(s.rss_mb);
+  w.key("stages").begin_array();
+  for (const auto& [stage, ms] : s.stage_ms) {
+    w.begin_object().key("stage").value(stage).key("duration_ms").value(ms).end_object();
+  }
+  w.end_array().end_object();
+  out += "\n\n";
+  return out;
+}
+
+static std::string done_event(bool ok, const std::string& error, const std::string& slug) {
+  std::string out = "event: done\ndata: ";
+  JsonWriter w(out);
+  w.begin_object()
+   .key("ok").value(ok)
+   .key("error").value(error)
+   .key("report").value("/reports/" + slug + "/report.html")
+   .end_object();
+  out += "\n\n";
+  return out;
+}
+
+static std::string job_json(const ScanJobInfo& j) {
+  std::string out;
+  JsonWriter w(out);
+  w.begin_object()
+   .key("id").value(j.id)
+   .key("state").value(scan_job_state_name(j.state))
+   .key("name").value(j.name)
+   .key("slug").value(j.slug)
+   .key("bytes").value(j.bytes)
+   .key("rows").value(j.rows)
+   .key("wall_ms").value(j.wall_ms)
+   .key("error").value(j.error)
+   .key("status").value("/api/scans/" + std::to_string(j.id))
+   .key("live").value("/scans/" + j.slug)
+   .key("events").value("/api/scans/" + j.slug + "/events")
+   .key("report").value("/reports/" + j.slug + "/report.html")
+   .end_object();
+  return out;
+}
+
+static void send_error(httplib::Response& res, int status, const std::string& msg) {
+  std::string out;
+  JsonWriter(out).begin_object().key("error").value(msg).end_object();
+  res.status = status;
+  res.set_content(std::move(out), "application/json; charset=utf-8");
+}
+
+// An index page rendered once per index generation, with its encodings.
+struct RenderedPage {
+  std::uint64_t generation = 0;
+  std::shared_ptr<const CachedFile> identity;
+  std::map<Encoding, std::shared_ptr<const CachedFile>> variants;
+};
+
+static std::shared_ptr<const CachedFile> page_file(std::string body, const std::string& tag) {
+  auto f = std::make_shared<CachedFile>();
+  f->body = std::move(body);
+  f->size = f->body.size();
+  f->etag = "\"" + tag + "\"";
+  return f;
+}
+
 struct HttpServer::Impl {
   Config cfg;
   httplib::Server svr;
+  FileCache cache;
 
-  explicit Impl(Config c) : cfg(std::move(c)) {}
+  explicit Impl(Config c)
+    : cfg(std::move(c)), cache(FileCache::Config{cfg.cache_bytes, std::min<std::size_t>(cfg.cache_bytes, 8u << 20)}),
+      index(cfg.artifact_root) {}
+  ~Impl() { if (pending_tick) Ticker::global().cancel(pending_tick); }
 
-  std::vector<std::string> slugs() const {
-    std::vector<std::string> out;
-    std::filesystem::path root(cfg.artifact_root);
-    if (!std::filesystem::exists(root)) return out;
-    for (auto& d : std::filesystem::directory_iterator(root)) {
-      if (d.is_directory()) out.push_back(d.path().filename().string());
-    }
-    std::sort(out.begin(), out.end());
-    return out;
+  ReportIndex index;
+  std::unique_ptr<DirWatcher> watcher;
+  Ticker::Id pending_tick = 0;
+  ScanJobs* jobs = nullptr;
+  std::atomic<std::size_t> event_streams{0};
+  std::atomic<bool> stopping{false};
+  std::mutex pages_mu;
+  std::map<std::string, RenderedPage> pages; // "html?..." / "json?..." -> page
+
+  static const char* sort_name(ReportIndex::Sort s) { return s == ReportIndex::Sort::Time ? "time" : "name"; }
+
+  static ReportIndex::Query query_of(const httplib::Request& req, std::size_t limit) {
+    ReportIndex::Query q;
+    q.sort = req.get_param_value("sort") == "time" ? ReportIndex::Sort::Time : ReportIndex::Sort::Name;
+    q.desc = req.get_param_value("order") == "desc";
+    q.limit = limit;
+    return q;
   }
 
-  std::string index_html() const {
-    auto items = slugs();
+  std::string index_html(const ReportIndex::Query& q, std::size_t page_no) const {
+    const ReportIndex::Page pg = index.page(q);
     std::string html = "<!doctype html><html><head><meta charset='utf-8'><title>";
-    html += cfg.index_title + "</title></head><body><h1>" + cfg.index_title + "</h1><ul>";
-    for (auto& s : items) {
-      html += "<li><a href=\"/reports/" + s + "/report.html\">" + s + "</a></li>";
+    append_html_escaped(html, cfg.index_title);
+    html += "</title></head><body><h1>";
+    append_html_escaped(html, cfg.index_title);
+    html += "</h1><p>Sort: <a href=\"/?sort=name\">name</a> | <a href=\"/?sort=time&amp;order=desc\">newest</a></p><ul>";
+    for (const auto& e : pg.items) {
+      html += "<li><a href=\"/reports/";
+      append_html_escaped(html, e.slug);
+      html += "/report.html\">";
+      append_html_escaped(html, e.slug);
+      html += "</a></li>";
     }
-    html += "</ul></body></html>";
+    html += "</ul>";
+    const std::size_t pages_total = q.limit ? (pg.total + q.limit - 1) / q.limit : 1;
+    if (pages_total > 1) {
+      const std::string base = std::string("/?sort=") + sort_name(q.sort) + (q.desc ? "&amp;order=desc" : "") + "&amp;page=";
+      html += "<p>Page " + std::to_string(page_no) + " of " + std::to_string(pages_total) +
+              " (" + std::to_string(pg.total) + " reports)";
+      if (page_no > 1) html += " <a href=\"" + base + std::to_string(page_no - 1) + "\">prev</a>";
+      if (page_no < pages_total) html += " <a href=\"" + base + std::to_string(page_no + 1) + "\">next</a>";
+      html += "</p>";
+    }
+    html += "</body></html>";
     return html;
   }
 
+  std::string reports_json(const ReportIndex::Query& q) const {
+    const ReportIndex::Page pg = index.page(q);
+    std::string out = "{\"total\":" + std::to_string(pg.total) +
+                      ",\"offset\":" + std::to_string(q.offset) +
+                      ",\"limit\":" + std::to_string(q.limit) +
+                      ",\"sort\":\"" + sort_name(q.sort) + "\",\"order\":\"" + (q.desc ? "desc" : "asc") +
+                      "\",\"reports\":[";
+    for (std::size_t i = 0; i < pg.items.size(); ++i) {
+      const auto& e = pg.items[i];
+      if (i) out += ',';
+      out += "{\"slug\":";
+      append_json_string(out, e.slug);
+      out += ",\"url\":";
+      append_json_string(out, "/reports/" + e.slug + "/report.html");
+      out += ",\"mtime\":\"" + http_date(e.mtime_ns / 1000000000) + "\"";
+      out += ",\"mtime_ns\":" + std::to_string(e.mtime_ns) + "}";
+    }
+    out += "]}";
+    return out;
+  }
+
+  // Pages are rendered (and compressed) once per index generation; later
+  // hits for the same query are a map lookup.
+  void serve_page(const std::string& key, const std::string& mime,
+                  const std::function<std::string()>& render,
+                  const httplib::Request& req, httplib::Response& res) {
+    const std::uint64_t gen = index.generation();
+    RenderedPage page;
+    {
+      std::lock_guard<std::mutex> lk(pages_mu);
+      if (auto it = pages.find(key); it != pages.end() && it->second.generation == gen) page = it->second;
+    }
+    if (!page.identity) {
+      std::string body = render();
+      char hex[17];
+      std::snprintf(hex, sizeof hex, "%016llx",
+                    static_cast<unsigned long long>(XXH3_64bits(body.data(), body.size())));
+      page.generation = gen;
+      for (const Encoding e : kAllEncodings) {
+        std::string z;
+        if (body.size() >= 1024 && encoding_available(e) && compress_buffer(e, body, z) && z.size() < body.size()) {
+          page.variants[e] = page_file(std::move(z), std::string(hex) + "-" + encoding_name(e));
+        }
+      }
+      page.identity = page_file(std::move(body), hex);
+      std::lock_guard<std::mutex> lk(pages_mu);
+      // Entries of older generations are dead weight; so is an unbounded
+      // set of distinct query strings.
+      for (auto it = pages.begin(); it != pages.end();) {
+        it = it->second.generation != gen ? pages.erase(it) : std::next(it);
+      }
+      if (pages.size() >= 256) pages.clear();
+      pages[key] = page;
+    }
+    res.set_header("Vary", "Accept-Encoding");
+    for (const Encoding e : accepted_encodings(req.ranges.empty() ? req.get_header_value("Accept-Encoding") : std::string())) {
+      auto it = page.variants.find(e);
+      if (it == page.variants.end()) continue;
+      res.set_header("Content-Encoding", encoding_name(e));
+      send_file(it->second, mime, req, res);
+      return;
+    }
+    send_file(page.identity, mime, req, res);
+  }
+
+  void start_index() {
+    std::string err;
+    std::error_code ec;
+    std::filesystem::create_directories(cfg.artifact_root, ec);
+    if (!index.rescan(&err)) std::cerr << "[index] " << err << "\n";
+    if (!cfg.watch_index || watcher) return;
+    // One watch on the root, for report directories coming and going; a
+    // watch per report would run into fs.inotify.max_user_watches long
+    // before the index gets big. Rewrites inside a report arrive through
+    // report_updated(); a directory created before its report.html is
+    // re-checked until that file shows up.
+    DirWatcher::Config wcfg;
+    wcfg.root = cfg.artifact_root;
+    wcfg.include = {"*"};
+    wcfg.debounce_ms = 200;
+    wcfg.initial_scan = false; // rescan() above has the starting state
+    wcfg.recursive = false;
+    watcher = std::make_unique<DirWatcher>(wcfg, [this](const std::string& path, DirWatcher::Event){
+      index.update(std::filesystem::path(path).filename().string());
+    });
+    if (!watcher->start(&err)) {
+      std::cerr << "[index] " << err << (cfg.scan_per_request ? "; rescanning on GET / when the root changes\n" : "\n");
+      watcher.reset();
+      return;
+    }
+    pending_tick = Ticker::global().every(std::chrono::seconds(1), [this]{ index.recheck_pending(); });
+  }
+
   // Serve a file under artifact_root/<slug>/<rel>, preventing traversal.
   bool serve_under_slug(const std::string& slug,
                         const std::string& rel,
-                        httplib::Response& res) const {
-    if (rel.find("..") != std::string::npos) { res.status = 400; return true; }
+                        const httplib::Request& req,
+                        httplib::Response& res,
+                        const char* cache_control = kRevalidate) {
+    if (slug == ".." || rel.find("..") != std::string::npos) { res.status = 400; return true; }
 
     std::filesystem::path base = std::filesystem::path(cfg.artifact_root) / slug;
     std::error_code ec;
@@ -70,31 +385,372 @@ struct HttpServer::Impl {
     auto mismatch = std::mismatch(base_canon.begin(), base_canon.end(), target_canon.begin(), target_canon.end());
     if (mismatch.first != base_canon.end()) { res.status = 403; return true; }
 
-    std::ifstream in(target_canon, std::ios::binary);
-    if (!in) { res.status = 404; return true; }
+    const std::string target_path = target_canon.string();
+    auto f = cache.get(target_path);
+    if (!f) { res.status = 404; return true; }
+    const std::string mime = guess_mime(target_canon.filename().string());
 
-    std::ostringstream ss; ss << in.rdbuf();
-    res.set_content(ss.str(), guess_mime(target_canon.filename().string()).c_str());
+    // Precompressed variant written with the report, if the client takes it.
+    // Byte ranges always address the identity file: a slice of a .br is no
+    // use to a dashboard.
+    res.set_header("Vary", "Accept-Encoding");
+    const std::string accept = req.ranges.empty() ? req.get_header_value("Accept-Encoding") : std::string();
+    for (const Encoding e : accepted_encodings(accept)) {
+      auto v = cache.get(target_path + encoding_suffix(e));
+      if (!v || v->mtime_ns < f->mtime_ns) continue; // left over from an older build
+      res.set_header("Content-Encoding", encoding_name(e));
+      send_file(std::move(v), mime, req, res, cache_control);
+      return true;
+    }
+    send_file(std::move(f), mime, req, res, cache_control);
     return true;
   }
 
+  bool report_exists(const std::string& slug) const {
+    if (slug.empty() || slug == "." || slug == "..") return false;
+    std::error_code ec;
+    return std::filesystem::is_regular_file(std::filesystem::path(cfg.artifact_root) / slug / "report.html", ec);
+  }
+
+  // Forwards each sample the scan's sampler publishes (the scan side never
+  // waits on this), then `event: done`. A scan that already finished gets
+  // just the done event.
+  void serve_events(const std::string& slug, httplib::Response& res) {
+    std::shared_ptr<LiveScan> scan = LiveScans::global().find(slug);
+    if (!scan && !report_exists(slug)) { res.status = 404; return; }
+    if (event_streams.fetch_add(1) >= cfg.max_event_streams) {
+      event_streams.fetch_sub(1);
+      res.status = 503;
+      res.set_header("Retry-After", "2");
+      return;
+    }
+    struct Stream {
+      std::shared_ptr<LiveScan> scan;
+      std::uint64_t seen = 0;
+      std::chrono::steady_clock::time_point last_write = std::chrono::steady_clock::now();
+    };
+    auto st = std::make_shared<Stream>();
+    st->scan = std::move(scan);
+    res.set_header("Cache-Control", "no-store");
+    res.set_header("X-Accel-Buffering", "no"); // nginx: do not buffer the stream
+    res.set_chunked_content_provider("text/event-stream",
+      [this, st, slug](std::size_t, httplib::DataSink& sink) {
+        if (stopping.load(std::memory_order_relaxed)) return false;
+        if (!st->scan) {
+          const std::string ev = done_event(true, std::string(), slug);
+          sink.write(ev.data(), ev.size());
+          sink.done();
+          return true;
+        }
+        // Short waits so stop() and dropped clients are noticed.
+        LiveScanSample s;
+        const std::uint64_t seq = st->scan->wait(st->seen, std::chrono::milliseconds(1000), s);
+        const auto now = std::chrono::steady_clock::now();
+        if (seq != st->seen) {
+          st->seen = seq;
+          const std::string ev = progress_event(seq, s);
+          if (!sink.write(ev.data(), ev.size())) return false;
+          st->last_write = now;
+        }
+        if (st->scan->done()) {
+          const std::string ev = done_event(st->scan->ok(), st->scan->error(), slug);
+          sink.write(ev.data(), ev.size());
+          sink.done();
+          return true;
+        }
+        if (now - st->last_write >= std::chrono::seconds(15)) {
+          static const char kPing[] = ": ping\n\n"; // keeps proxies from timing out
+          if (!sink.write(kPing, sizeof kPing - 1)) return false;
+          st->last_write = now;
+        }
+        return sink.is_writable ? sink.is_writable() : true;
+      },
+      [this](bool) { event_streams.fetch_sub(1); });
+  }
+
+  // report.mustache with a ctx that tells report.js to follow the events.
+  void serve_live_page(const std::string& slug, httplib::Response& res) {
+    std::shared_ptr<LiveScan> scan = LiveScans::global().find(slug);
+    if (!scan) {
+      if (report_exists(slug)) res.set_redirect("/reports/" + slug + "/report.html");
+      else res.status = 404;
+      return;
+    }
+    std::string ctx;
+    {
+      JsonWriter w(ctx);
+      w.begin_object();
+      w.key("live").begin_object()
+       .key("slug").value(slug)
+       .key("events").value("/api/scans/" + slug + "/events")
+       .key("report").value("/reports/" + slug + "/report.html")
+       .end_object();
+      w.key("filename").value(scan->filename());
+      w.end_object();
+    }
+    // The ctx is inlined in a <script> block; '<' only occurs inside strings.
+    std::string safe;
+    for (const char c : ctx) {
+      if (c == '<') safe += "\\u003c";
+      else safe += c;
+    }
+    std::string html, err;
+    if (!render_report_html(cfg.artifact_root, safe, html, &err)) {
+      res.status = 500;
+      res.set_content(err, "text/plain; charset=utf-8");
+      return;
+    }
+    res.set_header("Cache-Control", "no-store");
+    res.set_content(std::move(html), "text/html; charset=utf-8");
+  }
+
+  // A local path for POST /api/scans: it must resolve under a scan root.
+  bool path_allowed(const std::string& path) const {
+    std::error_code ec;
+    const auto target = std::filesystem::weakly_canonical(path, ec);
+    if (ec) return false;
+    for (const auto& root : cfg.scan_roots) {
+      const auto base = std::filesystem::weakly_canonical(root, ec);
+      if (ec || base.empty()) continue;
+      auto m = std::mismatch(base.begin(), base.end(), target.begin(), target.end());
+      if (m.first == base.end()) return true;
+    }
+    return false;
+  }
+
+  void send_submit(ScanJobs::Submit s, const ScanJobInfo& job, const std::string& err,
+                   httplib::Response& res) {
+    if (s == ScanJobs::Submit::Busy) {
+      res.set_header("Retry-After", "5");
+      send_error(res, 429, err);
+      return;
+    }
+    if (s != ScanJobs::Submit::Ok) { send_error(res, 400, err); return; }
+    res.status = 202;
+    res.set_header("Location", "/api/scans/" + std::to_string(job.id));
+    res.set_content(job_json(job), "application/json; charset=utf-8");
+  }
+
+  // ?format=csv|jsonl; for a body, also ?name= (its name and extension)
+  // and a Content-Length within max_upload_bytes. False: `res` is the error.
+  bool scan_params(const httplib::Request& req, httplib::Response& res, bool body,
+                   ScanJobs::Request& r) const {
+    if (req.has_param("format")) {
+      r.format = parse_format(req.get_param_value("format"));
+      if (r.format == FileFormat::Unknown) { send_error(res, 400, "format must be csv or jsonl"); return false; }
+    }
+    if (!body) return true;
+    if (req.is_multipart_form_data()) { send_error(res, 415, "send the file as the raw request body"); return false; }
+    r.name = std::filesystem::path(req.get_param_value("name")).filename().string();
+    if (r.name.empty()) r.name = "upload";
+    r.bytes = req.has_header("Content-Length")
+            ? std::strtoull(req.get_header_value("Content-Length").c_str(), nullptr, 10) : 0;
+    if (r.bytes > cfg.max_upload_bytes) { send_error(res, 413, "upload exceeds max_upload_bytes"); return false; }
+    return true;
+  }
+
+  // ?path=<file>: scan a file under a scan root. Otherwise the request body
+  // is the file, spooled under the artifact root while it arrives.
+  // 429 + Retry-After while the queue holds max_inflight_bytes.
+  void submit_scan(const httplib::Request& req, httplib::Response& res,
+                   const httplib::ContentReader& content_reader) {
+    ScanJobs::Request r;
+    const bool body = !req.has_param("path");
+    if (!scan_params(req, res, body, r)) return;
+    ScanJobInfo job;
+    std::string err;
+    if (!body) {
+      r.path = req.get_param_value("path");
+      if (!path_allowed(r.path)) { send_error(res, 403, "path is outside [server] scan_roots"); return; }
+      send_submit(jobs->submit(std::move(r), &job, &err), job, err, res);
+      return;
+    }
+
+    // Refuse before reading a body that cannot be taken. A chunked body
+    // declares no length: the budget is checked again as it grows, and
+    // submit() checks the final size.
+    const bool sized = req.has_header("Content-Length");
+    const std::uint64_t declared = r.bytes;
+    r.bytes = 0;
+    if (!jobs->admits(declared)) {
+      send_submit(ScanJobs::Submit::Busy, job, "scan queue is full (max_inflight_bytes)", res);
+      return;
+    }
+    int fd = -1;
+    if (!jobs->create_spool(r.name, fd, r.path, &err)) { send_error(res, 500, err); return; }
+    bool write_ok = true;
+    bool too_big = false;
+    bool over_budget = false;
+    content_reader([&](const char* data, std::size_t n) {
+      if ((r.bytes += n) > cfg.max_upload_bytes) { too_big = true; return false; }
+      if (!sized && !jobs->admits(r.bytes)) { over_budget = true; return false; }
+      while (n > 0) {
+        const ssize_t w = ::write(fd, data, n);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) { write_ok = false; return false; }
+        data += w;
+        n -= static_cast<std::size_t>(w);
+      }
+      return true;
+    });
+    if (::close(fd) != 0) write_ok = false;
+    if (too_big || over_budget || !write_ok || r.bytes == 0) {
+      ::unlink(r.path.c_str());
+      if (too_big) send_error(res, 413, "upload exceeds max_upload_bytes");
+      else if (over_budget) send_submit(ScanJobs::Submit::Busy, job, "scan queue is full (max_inflight_bytes)", res);
+      else if (!write_ok) send_error(res, 500, std::string("spool: ") + std::strerror(errno));
+      else send_error(res, 400, "empty body (use ?path= for a local file)");
+      return;
+    }
+    r.spooled = true;
+    send_submit(jobs->submit(std::move(r), &job, &err), job, err, res);
+  }
+
+  // PUT: the body is tokenized while it arrives and never touches disk.
+  // It goes through a pipe that the scan reads as /dev/fd/N, like any
+  // stream input. The pipe's 1 MiB buffer is the only queue: when the
+  // tokenizer falls behind, write() blocks, this thread stops reading the
+  // socket and TCP window pressure slows the client. The job starts at
+  // once on a pool worker or the answer is 429 (a blocked writer cannot
+  // wait in the queue); the response is the finished job.
+  void stream_scan(const httplib::Request& req, httplib::Response& res,
+                   const httplib::ContentReader& content_reader) {
+    ScanJobs::Request r;
+    if (!scan_params(req, res, true, r)) return;
+    if (r.format == FileFormat::Unknown) r.format = detect_format(r.name); // else: first line
+    int fds[2];
+    if (::pipe2(fds, O_CLOEXEC) != 0) { send_error(res, 500, std::string("pipe: ") + std::strerror(errno)); return; }
+    (void)::fcntl(fds[1], F_SETPIPE_SZ, 1 << 20);
+    r.path = "/dev/fd/" + std::to_string(fds[0]);
+    r.stream_fd = fds[0]; // owned by the job from here on
+    ScanJobInfo job;
+    std::string err;
+    const ScanJobs::Submit s = jobs->submit(std::move(r), &job, &err);
+    if (s != ScanJobs::Submit::Ok) {
+      ::close(fds[1]);
+      send_submit(s, job, err, res);
+      return;
+    }
+
+    std::uint64_t total = 0;
+    bool too_big = false;
+    bool scan_gone = false; // EPIPE: the scan stopped reading (error or cancel)
+    const bool read_ok = content_reader([&](const char* data, std::size_t n) {
+      if ((total += n) > cfg.max_upload_bytes) { too_big = true; return false; }
+      while (n > 0) {
+        const ssize_t w = ::write(fds[1], data, n);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) { scan_gone = true; return false; }
+        data += w;
+        n -= static_cast<std::size_t>(w);
+      }
+      return true;
+    });
+    // A cut-off body must not be reported as the whole file.
+    if (!read_ok && !scan_gone) (void)jobs->cancel(job.id);
+    ::close(fds[1]); // EOF for the tokenizer
+    if (!jobs->wait(job.id, job)) { send_error(res, 500, "job record expired"); return; }
+    if (too_big) { send_error(res, 413, "upload exceeds max_upload_bytes"); return; }
+    res.status = job.state == ScanJobState::Done ? 200 : job.state == ScanJobState::Cancelled ? 409 : 422;
+    res.set_header("Location", "/api/scans/" + std::to_string(job.id));
+    res.set_content(job_json(job), "application/json; charset=utf-8");
+  }
+
   void routes() {
-    // Index
-    svr.Get("/", [this](const httplib::Request&, httplib::Response& res) {
-      res.set_content(index_html(), "text/html; charset=utf-8");
+    // Index: ?page=N (1-based), ?sort=name|time, ?order=asc|desc
+    svr.Get("/", [this](const httplib::Request& req, httplib::Response& res) {
+      if (cfg.scan_per_request) index.revalidate();
+      ReportIndex::Query q = query_of(req, std::max<std::size_t>(1, cfg.index_page_size));
+      const std::size_t page_no = std::max<std::size_t>(1, param_size(req, "page", 1));
+      q.offset = (page_no - 1) * q.limit;
+      const std::string key = std::string("html?") + sort_name(q.sort) + (q.desc ? "-" : "+") + std::to_string(page_no);
+      serve_page(key, "text/html; charset=utf-8", [&]{ return index_html(q, page_no); }, req, res);
+    });
+
+    // Same list as JSON: ?offset=N&limit=N (max 1000), ?sort=name|time, ?order=asc|desc
+    svr.Get("/api/reports", [this](const httplib::Request& req, httplib::Response& res) {
+      if (cfg.scan_per_request) index.revalidate();
+      ReportIndex::Query q = query_of(req, std::min<std::size_t>(1000, param_size(req, "limit", cfg.index_page_size)));
+      q.offset = param_size(req, "offset", 0);
+      const std::string key = std::string("json?") + sort_name(q.sort) + (q.desc ? "-" : "+") +
+                              std::to_string(q.offset) + "," + std::to_string(q.limit);
+      serve_page(key, "application/json; charset=utf-8", [&]{ return reports_json(q); }, req, res);
     });
 
     // report.html (kept, but could be covered by the generic handler below)
     svr.Get(R"(/reports/([^/]+)/report\.html)", [this](const httplib::Request& req, httplib::Response& res) {
       auto slug = req.matches[1].str();
-      (void)serve_under_slug(slug, "report.html", res);
+      (void)serve_under_slug(slug, "report.html", req, res);
+    });
+
+    // Shared CSS/JS by content hash (asset_store.hpp): cache forever.
+    svr.Get(R"(/static/([0-9a-f]{16})/([^/]+))", [this](const httplib::Request& req, httplib::Response& res) {
+      const std::string dir = std::string(kStaticDirName) + "/" + req.matches[1].str();
+      (void)serve_under_slug(dir, req.matches[2].str(), req, res, kImmutable);
+    });
+
+    // Live progress of an in-flight scan: a report page that charts the
+    // events below, then moves on to the finished report.
+    svr.Get(R"(/scans/([^/]+))", [this](const httplib::Request& req, httplib::Response& res) {
+      serve_live_page(req.matches[1].str(), res);
+    });
+
+    // Server-Sent Events: rows, bytes, MB/s, RSS and stage times per
+    // sampler tick ([render] series_interval_ms), then `event: done`.
+    svr.Get(R"(/api/scans/([^/]+)/events)", [this](const httplib::Request& req, httplib::Response& res) {
+      serve_events(req.matches[1].str(), res);
+    });
+
+    // Scan submission (attach_jobs): POST enqueues and answers 202 with the
+    // job; PUT scans the body as it uploads and answers with the finished
+    // job; GET polls one job or lists recent ones; DELETE cancels.
+    svr.Post("/api/scans", [this](const httplib::Request& req, httplib::Response& res,
+                                  const httplib::ContentReader& content_reader) {
+      if (!jobs) { res.status = 404; return; }
+      submit_scan(req, res, content_reader);
+    });
+    svr.Put("/api/scans", [this](const httplib::Request& req, httplib::Response& res,
+                                 const httplib::ContentReader& content_reader) {
+      if (!jobs) { res.status = 404; return; }
+      stream_scan(req, res, content_reader);
+    });
+    svr.Get("/api/scans", [this](const httplib::Request&, httplib::Response& res) {
+      if (!jobs) { res.status = 404; return; }
+      std::string out = "{\"jobs\":[";
+      bool first = true;
+      for (const auto& j : jobs->list()) {
+        if (!first) out += ',';
+        first = false;
+        out += job_json(j);
+      }
+      out += "]}";
+      res.set_header("Cache-Control", "no-store");
+      res.set_content(std::move(out), "application/json; charset=utf-8");
+    });
+    svr.Get(R"(/api/scans/(\d+))", [this](const httplib::Request& req, httplib::Response& res) {
+      ScanJobInfo j;
+      if (!jobs || !jobs->get(std::strtoull(req.matches[1].str().c_str(), nullptr, 10), j)) {
+        send_error(res, 404, "no such job");
+        return;
+      }
+      res.set_header("Cache-Control", "no-store");
+      res.set_content(job_json(j), "application/json; charset=utf-8");
+    });
+    svr.Delete(R"(/api/scans/(\d+))", [this](const httplib::Request& req, httplib::Response& res) {
+      const std::uint64_t id = std::strtoull(req.matches[1].str().c_str(), nullptr, 10);
+      ScanJobInfo j;
+      if (!jobs || !jobs->get(id, j)) { send_error(res, 404, "no such job"); return; }
+      if (!jobs->cancel(id)) { send_error(res, 409, std::string("job is ") + scan_job_state_name(j.state)); return; }
+      (void)jobs->get(id, j);
+      res.status = 202;
+      res.set_content(job_json(j), "application/json; charset=utf-8");
     });
 
     // Any other file under a slug (CSS/JS/JSON etc.)
     svr.Get(R"(/reports/([^/]+)/(.+))", [this](const httplib::Request& req, httplib::Response& res) {
       auto slug = req.matches[1].str();
       auto rel  = req.matches[2].str(); // e.g., "report.css", "vega.min.js", "run.json"
-      (void)serve_under_slug(slug, rel, res);
+      (void)serve_under_slug(slug, rel, req, res);
     });
   }
 };
@@ -103,6 +759,10 @@ HttpServer::HttpServer(Config cfg) : p_(new Impl(std::move(cfg))) { p_->routes()
 HttpServer::~HttpServer() { delete p_; }
 
 bool HttpServer::start() {
+  // PUT /api/scans writes into pipes; a scan that stopped reading must
+  // come back as EPIPE, not kill the process.
+  std::signal(SIGPIPE, SIG_IGN);
+  p_->start_index();
   return p_->svr.bind_to_port("0.0.0.0", p_->cfg.port);
 }
 
@@ -111,6 +771,14 @@ int HttpServer::run() {
   p_->svr.listen_after_bind();
   return 0;
 }
-void HttpServer::stop() { p_->svr.stop(); }
+void HttpServer::stop() {
+  p_->stopping.store(true, std::memory_order_relaxed);
+  p_->svr.stop();
+  if (p_->watcher) p_->watcher->stop();
+}
+
+void HttpServer::report_updated(const std::string& slug) { p_->index.update(slug); }
+
+void HttpServer::attach_jobs(ScanJobs* jobs) { p_->jobs = jobs; }
 
 }
@@ -0,0 +1,181 @@
+#include "typed_scanner/report_index.hpp"
+#include "typed_scanner/trace.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <sys/stat.h>
+
+namespace ts {
+
+namespace {
+
+std::int64_t mtime_ns_of(const struct stat& st) {
+  return std::int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+}
+
+// Hidden entries (.etags, temp dirs) and anything path-like are not slugs.
+bool plausible_slug(const std::string& s) {
+  return !s.empty() && s.front() != '.' && s.find('/') == std::string::npos;
+}
+
+// mtime of <dir>/report.html, or -1 when there is no report there.
+std::int64_t report_mtime(const std::filesystem::path& dir) {
+  struct stat st{};
+  const std::string p = (dir / "report.html").string();
+  if (::stat(p.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) return -1;
+  return mtime_ns_of(st);
+}
+
+// Both orders of one generation; rebuilt lazily after a change.
+struct Views {
+  std::vector<ReportIndex::Entry> by_name;
+  std::vector<ReportIndex::Entry> by_time; // oldest first, ties by name
+};
+
+}
+
+struct ReportIndex::Impl {
+  std::string root;
+  mutable std::mutex mu;
+  std::unordered_map<std::string, std::int64_t> entries; // slug -> report mtime
+  std::unordered_set<std::string> pending;                // directories, no report.html yet
+  std::int64_t root_mtime_ns = -1;
+  std::uint64_t gen = 1;
+  mutable std::shared_ptr<const Views> views;
+  mutable std::uint64_t views_gen = 0;
+
+  std::shared_ptr<const Views> views_locked() const {
+    if (views && views_gen == gen) return views;
+    TS_TRACE_SCOPE_CAT("report_index.sort", "server");
+    auto v = std::make_shared<Views>();
+    v->by_name.reserve(entries.size());
+    for (const auto& [slug, t] : entries) v->by_name.push_back({slug, t});
+    std::sort(v->by_name.begin(), v->by_name.end(),
+              [](const Entry& a, const Entry& b){ return a.slug < b.slug; });
+    v->by_time = v->by_name;
+    std::stable_sort(v->by_time.begin(), v->by_time.end(),
+                     [](const Entry& a, const Entry& b){ return a.mtime_ns < b.mtime_ns; });
+    views = std::move(v);
+    views_gen = gen;
+    return views;
+  }
+};
+
+ReportIndex::ReportIndex(std::string root) : p_(new Impl{}) { p_->root = std::move(root); }
+ReportIndex::~ReportIndex() { delete p_; }
+
+bool ReportIndex::rescan(std::string* err_out) {
+  TS_TRACE_SCOPE_CAT("report_index.rescan", "server");
+  struct stat rst{};
+  std::int64_t root_mtime = -1;
+  std::unordered_map<std::string, std::int64_t> found;
+  std::unordered_set<std::string> waiting;
+  if (::stat(p_->root.c_str(), &rst) == 0) {
+    root_mtime = mtime_ns_of(rst);
+    std::error_code ec;
+    for (std::filesystem::directory_iterator it(p_->root, ec), end; !ec && it != end; it.increment(ec)) {
+      std::error_code dec;
+      if (!it->is_directory(dec)) continue;
+      std::string slug = it->path().filename().string();
+      if (!plausible_slug(slug)) continue;
+      const std::int64_t t = report_mtime(it->path());
+      if (t >= 0) found.emplace(std::move(slug), t);
+      else waiting.insert(std::move(slug));
+    }
+    if (ec) {
+      if (err_out) *err_out = p_->root + ": " + ec.message();
+      return false;
+    }
+  } else if (errno != ENOENT) {
+    if (err_out) *err_out = p_->root + ": " + std::strerror(errno);
+    return false;
+  }
+  std::lock_guard<std::mutex> lk(p_->mu);
+  p_->root_mtime_ns = root_mtime;
+  p_->pending = std::move(waiting);
+  if (found != p_->entries) {
+    p_->entries = std::move(found);
+    ++p_->gen;
+  }
+  return true;
+}
+
+void ReportIndex::revalidate() {
+  struct stat st{};
+  const std::int64_t now = ::stat(p_->root.c_str(), &st) == 0 ? mtime_ns_of(st) : -1;
+  bool now_current = false;
+  {
+    std::lock_guard<std::mutex> lk(p_->mu);
+    if (now == p_->root_mtime_ns) now_current = true;
+  }
+  if (!now_current) (void)rescan();
+  recheck_pending();
+}
+
+void ReportIndex::update(const std::string& slug) {
+  if (!plausible_slug(slug) || slug == "..") return;
+  const std::filesystem::path dir = std::filesystem::path(p_->root) / slug;
+  const std::int64_t t = report_mtime(dir);
+  struct stat dst{};
+  const bool waiting = t < 0 && ::stat(dir.c_str(), &dst) == 0 && S_ISDIR(dst.st_mode);
+  std::lock_guard<std::mutex> lk(p_->mu);
+  if (waiting) p_->pending.insert(slug);
+  else p_->pending.erase(slug);
+  auto it = p_->entries.find(slug);
+  if (t < 0) {
+    if (it == p_->entries.end()) return;
+    p_->entries.erase(it);
+  } else if (it == p_->entries.end()) {
+    p_->entries.emplace(slug, t);
+  } else if (it->second != t) {
+    it->second = t;
+  } else {
+    return;
+  }
+  ++p_->gen;
+}
+
+void ReportIndex::recheck_pending() {
+  std::vector<std::string> slugs;
+  {
+    std::lock_guard<std::mutex> lk(p_->mu);
+    slugs.assign(p_->pending.begin(), p_->pending.end());
+  }
+  for (const auto& slug : slugs) update(slug);
+}
+
+ReportIndex::Page ReportIndex::page(const Query& q) const {
+  std::shared_ptr<const Views> v;
+  Page out;
+  {
+    std::lock_guard<std::mutex> lk(p_->mu);
+    v = p_->views_locked();
+    out.generation = p_->gen;
+  }
+  const auto& all = q.sort == Sort::Time ? v->by_time : v->by_name;
+  out.total = all.size();
+  const std::size_t first = std::min(q.offset, all.size());
+  const std::size_t n = std::min(q.limit, all.size() - first);
+  out.items.reserve(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    out.items.push_back(q.desc ? all[all.size() - 1 - first - i] : all[first + i]);
+  }
+  return out;
+}
+
+std::size_t ReportIndex::size() const {
+  std::lock_guard<std::mutex> lk(p_->mu);
+  return p_->entries.size();
+}
+
+std::uint64_t ReportIndex::generation() const {
+  std::lock_guard<std::mutex> lk(p_->mu);
+  return p_->gen;
+}
+
+}
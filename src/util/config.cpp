@@ -0,0 +1,364 @@
+#include "typed_scanner/config.hpp"
+#include "typed_scanner/fingerprint.hpp"
+#include "typed_scanner/precompress.hpp"
+
+#include <toml++/toml.h>
+
+#include <algorithm>
+#include <cctype>
+#include <initializer_list>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace ts {
+
+namespace {
+
+// Maps the keys of one parsed document onto AppConfig. Keys that are absent
+// leave the field alone; the first type error wins and stops further reads.
+class Mapper {
+public:
+  Mapper(const toml::table& root, std::string origin) : root_(root), origin_(std::move(origin)) {}
+
+  bool ok() const { return err_.empty(); }
+  const std::string& error() const { return err_; }
+  unsigned hits() const { return hits_; } // keys applied
+
+  void get(std::string_view sec, std::string_view key, std::string& out) {
+    if (const toml::node* n = find(sec, key)) {
+      if (const auto* v = n->as_string()) { out = v->get(); ++hits_; }
+      else fail(*n, sec, key, "expected a string");
+    }
+  }
+
+  void get(std::string_view sec, std::string_view key, bool& out) {
+    if (const toml::node* n = find(sec, key)) {
+      if (const auto* v = n->as_boolean()) { out = v->get(); ++hits_; }
+      else fail(*n, sec, key, "expected true/false");
+    }
+  }
+
+  // One-character strings (CSV delimiter/quote/escape).
+  void get(std::string_view sec, std::string_view key, char& out) {
+    if (const toml::node* n = find(sec, key)) {
+      const auto* v = n->as_string();
+      if (v && v->get().size() == 1) { out = v->get()[0]; ++hits_; }
+      else fail(*n, sec, key, "expected a one-character string");
+    }
+  }
+
+  void get(std::string_view sec, std::string_view key, std::vector<std::string>& out) {
+    const toml::node* n = find(sec, key);
+    if (!n) return;
+    const auto* arr = n->as_array();
+    if (!arr) { fail(*n, sec, key, "expected an array of strings"); return; }
+    std::vector<std::string> vals;
+    for (const toml::node& el : *arr) {
+      const auto* s = el.as_string();
+      if (!s) { fail(el, sec, key, "expected an array of strings"); return; }
+      vals.push_back(s->get());
+    }
+    out = std::move(vals);
+    ++hits_;
+  }
+
+  // Integers, range-checked against the destination type.
+  template <class T>
+  void get_int(std::string_view sec, std::string_view key, T& out) {
+    const toml::node* n = find(sec, key);
+    if (!n) return;
+    const auto* v = n->as_integer();
+    if (!v) { fail(*n, sec, key, "expected an integer"); return; }
+    const std::int64_t x = v->get();
+    if (x < 0 && !std::numeric_limits<T>::is_signed) { fail(*n, sec, key, "must not be negative"); return; }
+    if ((x < 0 && x < static_cast<std::int64_t>(std::numeric_limits<T>::min())) ||
+        static_cast<std::uint64_t>(std::max<std::int64_t>(x, 0)) >
+        static_cast<std::uint64_t>(std::numeric_limits<T>::max())) {
+      fail(*n, sec, key, "out of range");
+      return;
+    }
+    out = static_cast<T>(x);
+    ++hits_;
+  }
+
+  template <class E>
+  void get_enum(std::string_view sec, std::string_view key,
+                std::initializer_list<std::pair<std::string_view, E>> names, E& out) {
+    const toml::node* n = find(sec, key);
+    if (!n) return;
+    const auto* v = n->as_string();
+    std::string want = "expected one of";
+    for (const auto& [name, e] : names) {
+      if (v && v->get() == name) { out = e; ++hits_; return; }
+      want += " " + std::string(name);
+    }
+    fail(*n, sec, key, want.c_str());
+  }
+
+private:
+  const toml::table* section(std::string_view sec) const {
+    const toml::table* t = &root_;
+    while (t && !sec.empty()) {
+      const auto dot = sec.find('.');
+      const std::string_view part = sec.substr(0, dot);
+      const toml::node* n = t->get(part);
+      t = n ? n->as_table() : nullptr;
+      sec = (dot == std::string_view::npos) ? std::string_view{} : sec.substr(dot + 1);
+    }
+    return t;
+  }
+
+  const toml::node* find(std::string_view sec, std::string_view key) const {
+    if (!ok()) return nullptr;
+    const toml::table* t = section(sec);
+    return t ? t->get(key) : nullptr;
+  }
+
+  void fail(const toml::node& n, std::string_view sec, std::string_view key, const char* what) {
+    if (!ok()) return;
+    err_ = origin_;
+    if (n.source().begin.line > 0) err_ += ":" + std::to_string(n.source().begin.line);
+    err_ += ": " + std::string(sec) + "." + std::string(key) + ": " + what;
+  }
+
+  const toml::table& root_;
+  std::string origin_;
+  std::string err_;
+  unsigned hits_ = 0;
+};
+
+void apply_table(Mapper& m, AppConfig& c) {
+  // config.toml
+  m.get("project", "artifact_root", c.artifact_root);
+
+  m.get_int("server", "port", c.server.port);
+  m.get("server", "scan_per_request", c.server.scan_per_request);
+  m.get("server", "index_title", c.server.index_title);
+  m.get_int("server", "cache_bytes", c.server.cache_bytes);
+  m.get("server", "watch_index", c.server.watch_index);
+  m.get_int("server", "index_page_size", c.server.index_page_size);
+  m.get_int("server", "max_event_streams", c.server.max_event_streams);
+  m.get("server", "scan_roots", c.server.scan_roots);
+  m.get_int("server", "max_upload_bytes", c.server.max_upload_bytes);
+
+  m.get_int("scanner", "reader_threads", c.reader_threads);
+  m.get_int("scanner", "chunk_bytes", c.reader.chunk_bytes);
+  m.get_int("scanner", "max_record_bytes", c.reader.max_record_bytes);
+  m.get_int("scanner", "arena_bytes", c.arena_bytes);
+  m.get_int("scanner", "max_errors_per_field", c.max_errors_per_field);
+
+  m.get("csv", "delimiter", c.csv.delimiter);
+  m.get("csv", "quote", c.csv.quote);
+  m.get("csv", "escape", c.csv.escape);
+  m.get("csv", "header", c.csv.header);
+  m.get("csv", "sniff", c.csv_sniff);
+  m.get("csv", "null_values", c.null_values);
+
+  m.get("jsonl", "encoding", c.jsonl_encoding);
+  m.get("jsonl", "strict", c.jsonl.strict);
+
+  m.get("render", "precompress", c.precompress);
+  m.get_int("render", "series_interval_ms", c.series_interval_ms);
+
+  m.get("sync", "on_create", c.on_create);
+  m.get("sync", "on_update", c.on_update);
+  m.get("sync", "on_delete", c.on_delete);
+  m.get("sync", "idempotency_use_etag", c.idempotency_use_etag);
+  m.get("sync", "fingerprint", c.fingerprint);
+  m.get("sync", "resume_appends", c.resume_appends);
+
+  m.get_int("limits", "max_parallel", c.max_parallel);
+  m.get_int("limits", "max_inflight_bytes", c.max_inflight_bytes);
+
+  // pipeline.toml
+  m.get("sources", "include", c.include);
+  m.get("sources", "exclude", c.exclude);
+  m.get_int("sources", "debounce_ms", c.watch_debounce_ms);
+  m.get("dag", "stages", c.stages);
+
+  m.get_enum("stages.policy_parse", "on_error",
+             {{"strict", ParsePolicy::OnError::Strict},
+              {"lenient", ParsePolicy::OnError::Lenient},
+              {"null", ParsePolicy::OnError::Null}},
+             c.on_error);
+  m.get("stages.policy_parse", "date_policy", c.date_policy.mode);
+  // Listed as true,false pairs: ["true","false","1","0"].
+  std::vector<std::string> bools;
+  m.get("stages.policy_parse", "bool_policy", bools);
+  if (!bools.empty()) {
+    c.bool_policy.true_tokens.clear();
+    c.bool_policy.false_tokens.clear();
+    for (std::size_t i = 0; i < bools.size(); ++i) {
+      (i % 2 == 0 ? c.bool_policy.true_tokens : c.bool_policy.false_tokens).push_back(bools[i]);
+    }
+  }
+
+  m.get("mapping", "slug_rule", c.slug_rule);
+  m.get_int("mapping", "slug_len", c.slug_len);
+}
+
+bool parse_toml(std::string_view text, std::string_view origin, bool is_file,
+                toml::table& out, std::string* err_out) {
+#if TOML_EXCEPTIONS
+  try {
+    out = is_file ? toml::parse_file(origin) : toml::parse(text, origin);
+  } catch (const toml::parse_error& e) {
+    if (err_out) {
+      *err_out = std::string(origin) + ":" + std::to_string(e.source().begin.line) + ": " +
+                 std::string(e.description());
+    }
+    return false;
+  }
+#else
+  toml::parse_result r = is_file ? toml::parse_file(origin) : toml::parse(text, origin);
+  if (!r) {
+    if (err_out) {
+      *err_out = std::string(origin) + ":" + std::to_string(r.error().source().begin.line) + ": " +
+                 std::string(r.error().description());
+    }
+    return false;
+  }
+  out = std::move(r).table();
+#endif
+  return true;
+}
+
+std::string_view trim(std::string_view s) {
+  while (!s.empty() && std::isspace(static_cast<unsigned char>(s.front()))) s.remove_prefix(1);
+  while (!s.empty() && std::isspace(static_cast<unsigned char>(s.back()))) s.remove_suffix(1);
+  return s;
+}
+
+bool one_of(const std::string& v, std::initializer_list<std::string_view> allowed) {
+  return std::find(allowed.begin(), allowed.end(), v) != allowed.end();
+}
+
+}
+
+ParsePolicy AppConfig::parse_policy() {
+  ParsePolicy p;
+  p.on_error = on_error;
+  p.max_errors_per_field = max_errors_per_field;
+  p.date_policy = &date_policy;
+  p.bool_policy = &bool_policy;
+  p.null_tokens = &null_values;
+  return p;
+}
+
+bool load_config_file(const std::string& path, AppConfig& cfg, std::string* err_out) {
+  toml::table root;
+  if (!parse_toml({}, path, /*is_file=*/true, root, err_out)) return false;
+  Mapper m(root, path);
+  apply_table(m, cfg);
+  if (!m.ok()) {
+    if (err_out) *err_out = m.error();
+    return false;
+  }
+  // The server always serves what the scanner writes.
+  cfg.server.artifact_root = cfg.artifact_root;
+  return true;
+}
+
+bool apply_config_override(std::string_view assignment, AppConfig& cfg, std::string* err_out) {
+  const auto eq = assignment.find('=');
+  const std::string_view key = trim(assignment.substr(0, eq));
+  if (eq == std::string_view::npos || key.find('.') == std::string_view::npos) {
+    if (err_out) *err_out = "override must look like section.key=value: " + std::string(assignment);
+    return false;
+  }
+  const std::string_view value = trim(assignment.substr(eq + 1));
+
+  // Dotted keys build the nested tables: "scanner.chunk_bytes = 1048576".
+  toml::table root;
+  std::string text = std::string(key) + " = " + std::string(value);
+  if (!parse_toml(text, "--set", /*is_file=*/false, root, nullptr)) {
+    std::string quoted;
+    for (char c : value) {
+      if (c == '"' || c == '\\') quoted.push_back('\\');
+      quoted.push_back(c);
+    }
+    text = std::string(key) + " = \"" + quoted + "\"";
+    if (!parse_toml(text, "--set", /*is_file=*/false, root, err_out)) return false;
+  }
+
+  Mapper m(root, "--set");
+  apply_table(m, cfg);
+  if (!m.ok()) {
+    if (err_out) *err_out = m.error();
+    return false;
+  }
+  if (m.hits() == 0) {
+    if (err_out) *err_out = "unknown config key: " + std::string(key);
+    return false;
+  }
+  if (key.rfind("project.", 0) == 0) cfg.server.artifact_root = cfg.artifact_root;
+  return true;
+}
+
+std::vector<std::string> validate_config(const AppConfig& c) {
+  std::vector<std::string> errs;
+  auto check = [&](bool cond, std::string msg){ if (!cond) errs.push_back(std::move(msg)); };
+
+  check(!c.artifact_root.empty(), "project.artifact_root must not be empty");
+  check(c.server.port > 0 && c.server.port <= 65535, "server.port must be in 1..65535");
+  check(c.server.index_page_size >= 1 && c.server.index_page_size <= 1000,
+        "server.index_page_size must be in 1..1000");
+  check(c.server.max_event_streams >= 1, "server.max_event_streams must be >= 1");
+  check(c.server.max_upload_bytes > 0, "server.max_upload_bytes must be > 0");
+
+  check(c.reader_threads <= 1024, "scanner.reader_threads must be <= 1024 (0 = all cores)");
+  check(c.reader.chunk_bytes >= 4096 && c.reader.chunk_bytes <= (256u << 20),
+        "scanner.chunk_bytes must be in 4 KiB..256 MiB");
+  check(c.reader.max_record_bytes >= 1024, "scanner.max_record_bytes must be >= 1 KiB");
+  check(c.arena_bytes >= (64u << 10), "scanner.arena_bytes must be >= 64 KiB");
+
+  auto bad_sep = [](char ch){ return ch == '\n' || ch == '\r' || ch == '\0'; };
+  check(!bad_sep(c.csv.delimiter) && !bad_sep(c.csv.quote) && !bad_sep(c.csv.escape),
+        "csv.delimiter/quote/escape must not be a line break or NUL");
+  check(c.csv.delimiter != c.csv.quote, "csv.delimiter and csv.quote must differ");
+  check(c.csv.escape != c.csv.delimiter, "csv.escape and csv.delimiter must differ");
+
+  std::string enc = c.jsonl_encoding;
+  for (auto& ch : enc) ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+  check(enc == "utf-8" || enc == "utf8", "jsonl.encoding must be utf-8 (got '" + c.jsonl_encoding + "')");
+
+  for (const auto& e : c.precompress) {
+    check(parse_encoding(e).has_value(), "render.precompress: unknown encoding '" + e + "' (br|zstd|gzip)");
+  }
+  check(c.series_interval_ms >= 0, "render.series_interval_ms must be >= 0");
+
+  check(one_of(c.on_create, {"build", "skip"}), "sync.on_create must be build|skip");
+  check(one_of(c.on_update, {"rebuild", "skip"}), "sync.on_update must be rebuild|skip");
+  FingerprintMode fm;
+  check(parse_fingerprint_mode(c.fingerprint, fm), "sync.fingerprint must be xxh3|sampled");
+  check(one_of(c.on_delete, {"delete_artifacts", "keep"}), "sync.on_delete must be delete_artifacts|keep");
+
+  check(!c.include.empty(), "sources.include must list at least one glob");
+  check(c.watch_debounce_ms <= 60000, "sources.debounce_ms must be <= 60000");
+
+  check(c.max_parallel >= 1, "limits.max_parallel must be >= 1");
+  check(c.max_inflight_bytes > 0, "limits.max_inflight_bytes must be > 0");
+
+  check(!c.stages.empty() && c.stages.front() == "tokenize", "dag.stages must start with tokenize");
+  for (std::size_t i = 0; i < c.stages.size(); ++i) {
+    check(one_of(c.stages[i], {"tokenize", "policy_parse", "metrics", "render"}),
+          "dag.stages: unknown stage '" + c.stages[i] + "'");
+    check(std::find(c.stages.begin(), c.stages.begin() + static_cast<std::ptrdiff_t>(i), c.stages[i]) ==
+              c.stages.begin() + static_cast<std::ptrdiff_t>(i),
+          "dag.stages: duplicate stage '" + c.stages[i] + "'");
+  }
+  check(c.date_policy.mode == "iso8601", "stages.policy_parse.date_policy must be iso8601");
+  check(!c.bool_policy.true_tokens.empty() &&
+            c.bool_policy.true_tokens.size() == c.bool_policy.false_tokens.size(),
+        "stages.policy_parse.bool_policy must list true,false pairs");
+
+  check(one_of(c.slug_rule, {"hashprefix", "basename", "keypath"}),
+        "mapping.slug_rule must be hashprefix|basename|keypath");
+  check(c.slug_len >= 1 && c.slug_len <= 64, "mapping.slug_len must be in 1..64");
+  return errs;
+}
+
+}
@@ -1,10 +1,14 @@
 #include "typed_scanner/etag_state.hpp"
+#include "typed_scanner/path_utils.hpp"
+#include <filesystem>
+#include <fstream>
 
 namespace ts {
 
 void EtagState::set(std::string slug, std::string etag) {
   std::lock_guard<std::mutex> lk(mu_);
   map_[std::move(slug)] = std::move(etag);
+  dirty_ = true;
 }
 
 std::optional<std::string> EtagState::get(std::string_view slug) const {
@@ -19,4 +23,60 @@ bool EtagState::matches(std::string_view slug, std::string_view etag) const {
   return v.has_value() && v->compare(std::string(etag)) == 0;
 }
 
+void EtagState::erase(std::string_view slug) {
+  std::lock_guard<std::mutex> lk(mu_);
+  if (map_.erase(std::string(slug))) dirty_ = true;
+}
+
+bool EtagState::load(const std::string& path, std::string* err_out) {
+  std::lock_guard<std::mutex> lk(mu_);
+  path_ = path;
+  map_.clear();
+  dirty_ = false;
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    if (!std::filesystem::exists(path)) return true;
+    if (err_out) *err_out = "cannot read " + path;
+    return false;
+  }
+  for (std::string line; std::getline(in, line);) {
+    const auto tab = line.find('\t');
+    if (tab == std::string::npos || tab == 0) continue; // tolerate junk lines
+    map_[line.substr(0, tab)] = line.substr(tab + 1);
+  }
+  return true;
+}
+
+bool EtagState::save(std::string* err_out) {
+  std::lock_guard<std::mutex> lk(mu_);
+  return save_locked(err_out);
+}
+
+bool EtagState::flush(std::string* err_out) {
+  std::lock_guard<std::mutex> lk(mu_);
+  return !dirty_ || save_locked(err_out);
+}
+
+bool EtagState::save_locked(std::string* err_out) {
+  if (path_.empty()) return true;
+  const std::string tmp = path_ + ".tmp";
+  ensure_parent_dirs(path_);
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    for (const auto& [slug, etag] : map_) out << slug << '\t' << etag << '\n';
+    if (!out.flush()) {
+      if (err_out) *err_out = "cannot write " + tmp;
+      return false;
+    }
+  }
+  std::error_code ec;
+  std::filesystem::rename(tmp, path_, ec);
+  if (ec) {
+    if (err_out) *err_out = "rename " + tmp + ": " + ec.message();
+    return false;
+  }
+  dirty_ = false;
+  return true;
+}
+
 }
@@ -0,0 +1,115 @@
+#include "typed_scanner/fingerprint.hpp"
+#include "typed_scanner/trace.hpp"
+
+#define XXH_INLINE_ALL
+#include <xxhash.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+namespace ts {
+
+namespace {
+
+struct Xxh3 {
+  XXH3_state_t* st = XXH3_createState();
+  Xxh3() { XXH3_64bits_reset(st); }
+  ~Xxh3() { XXH3_freeState(st); }
+  void update(const void* p, std::size_t n) { XXH3_64bits_update(st, p, n); }
+  std::uint64_t digest() const { return XXH3_64bits_digest(st); }
+};
+
+std::string hex64(std::uint64_t v) {
+  char buf[17];
+  std::snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(v));
+  return buf;
+}
+
+bool fail(std::string* err_out, const std::string& path) {
+  if (err_out) *err_out = "fingerprint " + path + ": " + std::strerror(errno);
+  return false;
+}
+
+bool seek(FILE* f, std::uint64_t off) {
+#if defined(_WIN32)
+  return _fseeki64(f, static_cast<long long>(off), SEEK_SET) == 0;
+#else
+  return fseeko(f, static_cast<off_t>(off), SEEK_SET) == 0;
+#endif
+}
+
+}
+
+bool parse_fingerprint_mode(std::string_view s, FingerprintMode& out) {
+  if (s == "xxh3")    { out = FingerprintMode::Xxh3;    return true; }
+  if (s == "sampled") { out = FingerprintMode::Sampled; return true; }
+  return false;
+}
+
+std::string file_fingerprint(const std::string& path, FingerprintMode mode, std::string* err_out) {
+  TS_TRACE_SCOPE_CAT("fingerprint", "io");
+  std::unique_ptr<FILE, int(*)(FILE*)> f(std::fopen(path.c_str(), "rb"), &std::fclose);
+  if (!f) { fail(err_out, path); return {}; }
+
+  Xxh3 h;
+  std::vector<char> buf(mode == FingerprintMode::Xxh3 ? (1u << 20) : kSampleBlockSize);
+
+  if (mode == FingerprintMode::Xxh3) {
+    std::size_t n;
+    while ((n = std::fread(buf.data(), 1, buf.size(), f.get())) > 0) h.update(buf.data(), n);
+    if (std::ferror(f.get())) { fail(err_out, path); return {}; }
+    return "xxh3-" + hex64(h.digest());
+  }
+
+  // Sampled: size and mtime catch appends/rewrites; blocks at evenly spaced
+  // offsets (always including the first and last) catch most edits.
+  std::error_code ec;
+  const std::uint64_t size = std::filesystem::file_size(path, ec);
+  const auto mtime = std::filesystem::last_write_time(path, ec);
+  if (ec) {
+    if (err_out) *err_out = "fingerprint " + path + ": " + ec.message();
+    return {};
+  }
+  const std::int64_t mtime_ns = mtime.time_since_epoch().count();
+  h.update(&size, sizeof(size));
+  h.update(&mtime_ns, sizeof(mtime_ns));
+
+  const std::uint64_t span = size > kSampleBlockSize ? size - kSampleBlockSize : 0;
+  for (unsigned i = 0; i < kSampleBlocks; ++i) {
+    const std::uint64_t off = span * i / (kSampleBlocks - 1);
+    if (!seek(f.get(), off)) { fail(err_out, path); return {}; }
+    const std::size_t n = std::fread(buf.data(), 1, buf.size(), f.get());
+    if (n == 0 && std::ferror(f.get())) { fail(err_out, path); return {}; }
+    h.update(buf.data(), n);
+    if (span == 0) break; // whole file fits one block
+  }
+  return "sampled-" + hex64(h.digest());
+}
+
+bool hash_file_range(const std::string& path, std::uint64_t begin, std::uint64_t end,
+                     std::uint64_t& out, std::string* err_out) {
+  std::unique_ptr<FILE, int(*)(FILE*)> f(std::fopen(path.c_str(), "rb"), &std::fclose);
+  if (!f || !seek(f.get(), begin)) return fail(err_out, path);
+  Xxh3 h;
+  std::vector<char> buf(kSampleBlockSize);
+  for (std::uint64_t left = end > begin ? end - begin : 0; left > 0;) {
+    const std::size_t want = static_cast<std::size_t>(std::min<std::uint64_t>(left, buf.size()));
+    const std::size_t n = std::fread(buf.data(), 1, want, f.get());
+    if (n == 0) {
+      if (std::ferror(f.get())) return fail(err_out, path);
+      if (err_out) *err_out = "fingerprint " + path + ": shorter than " + std::to_string(end);
+      return false;
+    }
+    h.update(buf.data(), n);
+    left -= n;
+  }
+  out = h.digest();
+  return true;
+}
+
+}
@@ -22,12 +22,37 @@ bool ensure_parent_dirs(const std::filesystem::path& p) {
 }
 
 FileFormat detect_format(std::string_view path) {
-  auto ext = std::filesystem::path(std::string(path)).extension().string();
+  std::filesystem::path p{std::string(path)};
+  auto ext = p.extension().string();
+  if (ext == ".gz" || ext == ".gzip" || ext == ".zst" || ext == ".zstd") {
+    ext = p.stem().extension().string(); // data.csv.gz -> .csv
+  }
   if (ext == ".csv") return FileFormat::CSV;
   if (ext == ".jsonl" || ext == ".ndjson") return FileFormat::JSONL;
   return FileFormat::Unknown;
 }
 
+FileFormat sniff_format(std::string_view line) {
+  if (line.substr(0, 3) == "\xEF\xBB\xBF") line.remove_prefix(3); // UTF-8 BOM
+  const auto i = line.find_first_not_of(" \t\r");
+  if (i == std::string_view::npos) return FileFormat::Unknown;
+  return line[i] == '{' ? FileFormat::JSONL : FileFormat::CSV;
+}
+
+FileFormat parse_format(std::string_view name) {
+  if (name == "csv") return FileFormat::CSV;
+  if (name == "jsonl" || name == "ndjson") return FileFormat::JSONL;
+  return FileFormat::Unknown;
+}
+
+bool is_stream_path(const std::string& path) {
+  if (path == "-") return true;
+  std::error_code ec;
+  const auto st = std::filesystem::status(path, ec);
+  return !ec && std::filesystem::exists(st) && !std::filesystem::is_regular_file(st) &&
+         !std::filesystem::is_directory(st);
+}
+
 std::string hex_hash_prefix(std::string_view data, int len) {
 #ifdef TS_USE_OPENSSL
   unsigned char md[SHA256_DIGEST_LENGTH];
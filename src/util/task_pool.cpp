@@ -0,0 +1,356 @@
+#include "typed_scanner/task_pool.hpp"
+#include "typed_scanner/trace.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#if defined(__linux__)
+  #include <pthread.h>
+  #include <sched.h>
+#endif
+
+namespace ts {
+
+namespace {
+
+// Chase-Lev work-stealing deque ("Correct and Efficient Work-Stealing for
+// Weak Memory Models", Le et al. 2013), with seq_cst on the bottom/top
+// handshake instead of standalone fences. Grown arrays are retired, not
+// freed, until the deque dies, so a thief holding an old array stays valid.
+class WsDeque {
+public:
+  WsDeque() : array_(new Array(64)) { retired_.emplace_back(array_.load()); }
+
+  // Owner only.
+  void push(TaskPool::Task* t) {
+    const std::int64_t b = bottom_.load(std::memory_order_relaxed);
+    const std::int64_t top = top_.load(std::memory_order_acquire);
+    Array* a = array_.load(std::memory_order_relaxed);
+    if (b - top >= a->cap) a = grow(a, top, b);
+    a->put(b, t);
+    bottom_.store(b + 1, std::memory_order_release);
+  }
+
+  // Owner only.
+  TaskPool::Task* pop() {
+    const std::int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    Array* a = array_.load(std::memory_order_relaxed);
+    bottom_.store(b, std::memory_order_seq_cst);
+    std::int64_t t = top_.load(std::memory_order_seq_cst);
+    if (t > b) { bottom_.store(b + 1, std::memory_order_relaxed); return nullptr; }
+    TaskPool::Task* x = a->get(b);
+    if (t == b) {
+      // Last element: race the thieves for it.
+      if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                        std::memory_order_relaxed)) x = nullptr;
+      bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+    return x;
+  }
+
+  // Any thread.
+  TaskPool::Task* steal() {
+    std::int64_t t = top_.load(std::memory_order_seq_cst);
+    const std::int64_t b = bottom_.load(std::memory_order_seq_cst);
+    if (t >= b) return nullptr;
+    Array* a = array_.load(std::memory_order_acquire);
+    TaskPool::Task* x = a->get(t);
+    if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) return nullptr;
+    return x;
+  }
+
+private:
+  struct Array {
+    explicit Array(std::int64_t c) : cap(c), slots(new std::atomic<TaskPool::Task*>[static_cast<std::size_t>(c)]) {}
+    std::int64_t cap;
+    std::unique_ptr<std::atomic<TaskPool::Task*>[]> slots;
+    TaskPool::Task* get(std::int64_t i) const { return slots[static_cast<std::size_t>(i & (cap - 1))].load(std::memory_order_relaxed); }
+    void put(std::int64_t i, TaskPool::Task* t) { slots[static_cast<std::size_t>(i & (cap - 1))].store(t, std::memory_order_relaxed); }
+  };
+
+  Array* grow(Array* a, std::int64_t t, std::int64_t b) {
+    auto* n = new Array(a->cap * 2);
+    for (std::int64_t i = t; i < b; ++i) n->put(i, a->get(i));
+    retired_.emplace_back(n);
+    array_.store(n, std::memory_order_release);
+    return n;
+  }
+
+  alignas(64) std::atomic<std::int64_t> top_{0};
+  alignas(64) std::atomic<std::int64_t> bottom_{0};
+  std::atomic<Array*> array_;
+  std::vector<std::unique_ptr<Array>> retired_; // owner only
+};
+
+thread_local const void* t_pool = nullptr; // pool the calling thread works for
+thread_local int t_index = -1;
+
+std::mutex g_global_mu;
+TaskPool::Config g_global_cfg;
+
+void pin_to_cpu(std::thread& th, int cpu) {
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  (void)pthread_setaffinity_np(th.native_handle(), sizeof(set), &set);
+#else
+  (void)th; (void)cpu;
+#endif
+}
+
+}
+
+struct TaskPool::Impl {
+  Config cfg;
+  std::vector<std::unique_ptr<WsDeque>> deques;
+  std::vector<std::thread> threads;
+
+  std::mutex inject_mu;
+  std::deque<Task*> inject;
+
+  std::mutex mu; // sleep/wake only
+  std::condition_variable cv;
+  std::atomic<std::int64_t> queued{0}; // submitted, not yet taken
+  std::atomic<int> sleepers{0};
+  bool stopping = false;
+
+  Task* take_injected() {
+    std::lock_guard<std::mutex> lk(inject_mu);
+    if (inject.empty()) return nullptr;
+    Task* t = inject.front();
+    inject.pop_front();
+    return t;
+  }
+
+  Task* steal_any(std::size_t start) {
+    const std::size_t n = deques.size();
+    for (std::size_t k = 0; k < n; ++k) {
+      if (Task* t = deques[(start + k) % n]->steal()) return t;
+    }
+    return nullptr;
+  }
+
+  Task* find_work(int idx, std::uint64_t& rng) {
+    Task* t = nullptr;
+    if (idx >= 0) t = deques[static_cast<std::size_t>(idx)]->pop();
+    if (!t) t = take_injected();
+    if (!t) {
+      rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17; // xorshift victim pick
+      t = steal_any(static_cast<std::size_t>(rng % deques.size()));
+    }
+    if (t) queued.fetch_sub(1, std::memory_order_seq_cst);
+    return t;
+  }
+
+  static void run(Task* t) {
+    (*t)();
+    delete t;
+  }
+
+  void wake_one() {
+    if (sleepers.load(std::memory_order_seq_cst) > 0) {
+      std::lock_guard<std::mutex> lk(mu);
+      cv.notify_one();
+    }
+  }
+
+  void worker(int idx) {
+    t_pool = this;
+    t_index = idx;
+    if (trace::enabled()) trace::set_thread_name("pool-" + std::to_string(idx));
+    std::uint64_t rng = 0x9E3779B97F4A7C15ull * static_cast<std::uint64_t>(idx + 1);
+    while (true) {
+      if (Task* t = find_work(idx, rng)) { run(t); continue; }
+      std::unique_lock<std::mutex> lk(mu);
+      sleepers.fetch_add(1, std::memory_order_seq_cst);
+      cv.wait(lk, [&]{ return stopping || queued.load(std::memory_order_seq_cst) > 0; });
+      sleepers.fetch_sub(1, std::memory_order_seq_cst);
+      if (stopping && queued.load(std::memory_order_seq_cst) == 0) return;
+    }
+  }
+};
+
+TaskPool::TaskPool() : TaskPool(Config{}) {}
+
+TaskPool::TaskPool(Config cfg) : p_(new Impl{}) {
+  const unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+  if (cfg.threads == 0) cfg.threads = hw;
+  if (cfg.cpus.empty()) for (unsigned c = 0; c < hw; ++c) cfg.cpus.push_back(static_cast<int>(c));
+  p_->cfg = cfg;
+  for (unsigned i = 0; i < cfg.threads; ++i) p_->deques.push_back(std::make_unique<WsDeque>());
+  p_->threads.reserve(cfg.threads);
+  for (unsigned i = 0; i < cfg.threads; ++i) {
+    p_->threads.emplace_back([this, i]{ p_->worker(static_cast<int>(i)); });
+    if (cfg.pin_threads) pin_to_cpu(p_->threads.back(), cfg.cpus[i % cfg.cpus.size()]);
+  }
+}
+
+TaskPool::~TaskPool() {
+  {
+    std::lock_guard<std::mutex> lk(p_->mu);
+    p_->stopping = true;
+  }
+  p_->cv.notify_all();
+  for (auto& t : p_->threads) t.join();
+  delete p_;
+}
+
+void TaskPool::submit(Task t) {
+  // Trace events of the task belong to the submitter's scan.
+  if (const std::uint32_t scan = trace::current_scan()) {
+    t = [scan, t = std::move(t)]{
+      trace::ScanTag tag(scan);
+      t();
+    };
+  }
+  Task* task = new Task(std::move(t));
+  p_->queued.fetch_add(1, std::memory_order_seq_cst);
+  if (t_pool == p_ && t_index >= 0) {
+    p_->deques[static_cast<std::size_t>(t_index)]->push(task);
+  } else {
+    std::lock_guard<std::mutex> lk(p_->inject_mu);
+    p_->inject.push_back(task);
+  }
+  p_->wake_one();
+}
+
+bool TaskPool::try_run_one() {
+  thread_local std::uint64_t rng = 0x2545F4914F6CDD1Dull;
+  const int idx = (t_pool == p_) ? t_index : -1;
+  Task* t = p_->find_work(idx, rng);
+  if (!t) return false;
+  Impl::run(t);
+  return true;
+}
+
+unsigned TaskPool::size() const noexcept { return static_cast<unsigned>(p_->threads.size()); }
+
+int TaskPool::worker_index() const noexcept { return t_pool == p_ ? t_index : -1; }
+
+void TaskPool::configure_global(Config cfg) {
+  std::lock_guard<std::mutex> lk(g_global_mu);
+  g_global_cfg = std::move(cfg);
+}
+
+TaskPool& TaskPool::global() {
+  static TaskPool pool([]{
+    std::lock_guard<std::mutex> lk(g_global_mu);
+    return g_global_cfg;
+  }());
+  return pool;
+}
+
+// ---- TaskGroup -----------------------------------------------------------------
+
+// Claimed by whichever comes first: the pool task or a waiter.
+struct TaskGroup::Item {
+  TaskPool::Task fn;
+  std::atomic<bool> taken{false};
+};
+
+void TaskGroup::run(TaskPool::Task t) {
+  auto it = std::make_shared<Item>();
+  it->fn = std::move(t);
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    ++pending_;
+    if (unstarted_.size() >= prune_at_) {
+      std::erase_if(unstarted_, [](const std::shared_ptr<Item>& x){ return x->taken.load(); });
+      prune_at_ = std::max<std::size_t>(64, 2 * unstarted_.size());
+    }
+    unstarted_.push_back(it);
+  }
+  // Touches the group only once it has claimed the item, i.e. while
+  // pending_ still counts it.
+  pool_.submit([this, it]{
+    if (!it->taken.exchange(true)) execute(*it);
+  });
+}
+
+void TaskGroup::execute(Item& it) {
+  it.fn();
+  it.fn = nullptr;
+  std::lock_guard<std::mutex> lk(mu_);
+  if (--pending_ == 0) cv_.notify_all(); // under mu_: the waiter may free us next
+}
+
+void TaskGroup::wait() {
+  std::unique_lock<std::mutex> lk(mu_);
+  while (pending_ > 0) {
+    std::shared_ptr<Item> mine;
+    while (!mine && !unstarted_.empty()) {
+      mine = std::move(unstarted_.front());
+      unstarted_.pop_front();
+      if (mine->taken.exchange(true)) mine.reset();
+    }
+    if (!mine) { cv_.wait(lk); continue; } // the rest is running elsewhere
+    lk.unlock();
+    execute(*mine);
+    lk.lock();
+  }
+  unstarted_.clear();
+}
+
+// ---- SerialTask ----------------------------------------------------------------
+
+void SerialTask::schedule() {
+  // Orders the caller's preceding writes (a queue push) before the state
+  // load, so a pass that already looked finds them on its rerun.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  int s = state_.load();
+  for (;;) {
+    if (s == kIdle) {
+      if (state_.compare_exchange_weak(s, kQueued)) { submit(); return; }
+    } else if (s == kRunning) {
+      if (state_.compare_exchange_weak(s, kAgain)) return;
+    } else {
+      return; // already queued, rerun pending, or done
+    }
+  }
+}
+
+bool SerialTask::help() {
+  int s = state_.load();
+  for (;;) {
+    if (s == kDone) return true;
+    if (s == kRunning || s == kAgain) return false;
+    // Idle, or queued: a queued task that loses this race does nothing.
+    if (state_.compare_exchange_weak(s, kRunning)) { run(true); return true; }
+  }
+}
+
+void SerialTask::submit() {
+  group_.run([this]{
+    int s = kQueued;
+    if (state_.compare_exchange_strong(s, kRunning)) run(false);
+  });
+}
+
+void SerialTask::run(bool hand_off) {
+  for (;;) {
+    if (body_()) { state_.store(kDone, std::memory_order_release); return; }
+    int s = kRunning;
+    if (state_.compare_exchange_strong(s, kIdle)) return;
+    // kAgain: schedule() came in during the pass.
+    if (hand_off) {
+      state_.store(kQueued);
+      submit();
+      return;
+    }
+    state_.store(kRunning);
+  }
+}
+
+void parallel_for(TaskPool& pool, std::size_t n, const std::function<void(std::size_t)>& fn) {
+  TaskGroup g(pool);
+  for (std::size_t i = 0; i < n; ++i) g.run([&fn, i]{ fn(i); });
+  g.wait();
+}
+
+}
@@ -0,0 +1,89 @@
+#include "typed_scanner/ticker.hpp"
+#include "typed_scanner/trace.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace ts {
+
+struct Ticker::Impl {
+  struct Entry {
+    std::chrono::milliseconds period;
+    std::chrono::steady_clock::time_point next;
+    std::function<void()> fn;
+  };
+
+  std::mutex mu;
+  std::condition_variable cv;      // wakes the thread: new entry or stop
+  std::condition_variable cv_idle; // wakes cancel(): a callback returned
+  std::map<Id, Entry> entries;
+  Id next_id = 1;
+  Id running = 0;                  // entry whose fn is being called
+  bool stopping = false;
+  std::thread th;
+
+  void loop() {
+    if (trace::enabled()) trace::set_thread_name("ticker");
+    std::unique_lock<std::mutex> lk(mu);
+    while (!stopping) {
+      auto due = entries.end();
+      for (auto it = entries.begin(); it != entries.end(); ++it) {
+        if (due == entries.end() || it->second.next < due->second.next) due = it;
+      }
+      if (due == entries.end()) { cv.wait(lk); continue; }
+      if (std::chrono::steady_clock::now() < due->second.next) {
+        cv.wait_until(lk, due->second.next);
+        continue; // the table may have changed
+      }
+      const Id id = due->first;
+      Entry& e = due->second;
+      // Skip missed ticks rather than firing a burst after a stall.
+      e.next = std::max(e.next + e.period, std::chrono::steady_clock::now());
+      std::function<void()> fn = e.fn;
+      running = id;
+      lk.unlock();
+      fn();
+      lk.lock();
+      running = 0;
+      cv_idle.notify_all();
+    }
+  }
+};
+
+Ticker::Ticker() : p_(new Impl{}) {}
+
+Ticker::~Ticker() {
+  {
+    std::lock_guard<std::mutex> lk(p_->mu);
+    p_->stopping = true;
+  }
+  p_->cv.notify_all();
+  if (p_->th.joinable()) p_->th.join();
+  delete p_;
+}
+
+Ticker& Ticker::global() {
+  static Ticker t;
+  return t;
+}
+
+Ticker::Id Ticker::every(std::chrono::milliseconds period, std::function<void()> fn) {
+  std::lock_guard<std::mutex> lk(p_->mu);
+  if (!p_->th.joinable()) p_->th = std::thread([this]{ p_->loop(); });
+  const Id id = p_->next_id++;
+  period = std::max(period, std::chrono::milliseconds(1));
+  p_->entries.emplace(id, Impl::Entry{period, std::chrono::steady_clock::now() + period, std::move(fn)});
+  p_->cv.notify_all();
+  return id;
+}
+
+void Ticker::cancel(Id id) {
+  std::unique_lock<std::mutex> lk(p_->mu);
+  p_->entries.erase(id);
+  p_->cv_idle.wait(lk, [&]{ return p_->running != id; });
+  p_->cv.notify_all();
+}
+
+}
@@ -46,11 +46,30 @@ int main() {
     std::this_thread::sleep_for(200ms);
   }
 
+  // Range requests on the index page: two ranges come back as one 206
+  // multipart/byteranges body; a stale If-Range gets the whole page.
+  std::string range_fail;
+  if (up) {
+    // identity: ranges must index the same bytes as the full page
+    auto full = cli.Get("/", {{"Accept-Encoding", "identity"}});
+    auto multi = cli.Get("/", {{"Accept-Encoding", "identity"}, {"Range", "bytes=0-9,20-29"}});
+    auto stale = cli.Get("/", {{"Accept-Encoding", "identity"}, {"Range", "bytes=0-9"},
+                               {"If-Range", "\"not-the-etag\""}});
+    if (!full || full->body.size() < 30) range_fail = "index too small for ranges";
+    else if (!multi || multi->status != 206 ||
+             multi->get_header_value("Content-Type").rfind("multipart/byteranges", 0) != 0 ||
+             multi->body.find(full->body.substr(0, 10)) == std::string::npos ||
+             multi->body.find(full->body.substr(20, 10)) == std::string::npos) range_fail = "multi-range";
+    else if (!stale || stale->status != 200 || stale->body != full->body) range_fail = "stale If-Range";
+  }
+
   // Stop server
   int pid = read_pid(pidf);
   if (pid > 1) kill(pid, SIGTERM);
 
   if (!up) { std::cerr << "[FAIL] server did not respond with 200 on /\n"; return 1; }
   std::cout << "[PASS] http server GET / responded 200 with body\n";
+  if (!range_fail.empty()) { std::cerr << "[FAIL] " << range_fail << "\n"; return 1; }
+  std::cout << "[PASS] multi-range 206 and stale If-Range 200\n";
   return 0;
 }
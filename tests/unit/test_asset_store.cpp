@@ -0,0 +1,59 @@
+#include "typed_scanner/asset_store.hpp"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static int fails = 0;
+static void check(bool ok, const std::string& what) {
+  std::cout << (ok ? "[PASS] " : "[FAIL] ") << what << "\n";
+  if (!ok) ++fails;
+}
+
+int main(){
+  const fs::path dir = fs::temp_directory_path() / "ts_test_asset_store";
+  fs::remove_all(dir);
+  fs::create_directories(dir / "src");
+  const std::string css = (dir / "src" / "report.css").string();
+  const std::string js = (dir / "src" / "app.js").string();
+  std::ofstream(css) << "body { color: red; }\n";
+  std::ofstream(js) << std::string(4096, 'j');
+  const std::string root = (dir / "artifacts").string();
+
+  std::vector<ts::StaticAsset> out;
+  std::string err;
+  check(ts::publish_assets(root, {css, js}, {}, out, &err) && out.size() == 2 && err.empty(), "publish");
+  check(out[0].name == "report.css" && out[0].hash.size() == 16 &&
+        out[0].url == "/static/" + out[0].hash + "/report.css", "url by content hash");
+  const fs::path stored = fs::path(root) / ts::kStaticDirName / out[0].hash / "report.css";
+  check(fs::exists(stored) && fs::file_size(stored) == fs::file_size(css), "stored once under .static");
+
+  // Same content from another path shares the entry; the store is not rewritten.
+  const std::string css2 = (dir / "src" / "copy.css").string();
+  fs::copy_file(css, css2);
+  const auto t0 = fs::last_write_time(stored);
+  std::vector<ts::StaticAsset> again;
+  check(ts::publish_assets(root, {css}, {}, again) && again[0].url == out[0].url &&
+        fs::last_write_time(stored) == t0, "republish is a no-op");
+
+  // Changed content gets a new URL; the old one stays valid for old reports.
+  std::ofstream(css, std::ios::trunc) << "body { color: blue; }\n";
+  std::vector<ts::StaticAsset> changed;
+  check(ts::publish_assets(root, {css}, {}, changed) && changed[0].hash != out[0].hash &&
+        fs::exists(stored), "new content, new hash");
+
+  // Store removed underneath: republished rather than pointing at nothing.
+  fs::remove_all(fs::path(root) / ts::kStaticDirName);
+  check(ts::publish_assets(root, {js}, {}, again) &&
+        fs::exists(fs::path(root) / ts::kStaticDirName / again[0].hash / "app.js"), "store recreated");
+
+  err.clear();
+  check(ts::publish_assets(root, {(dir / "nope.js").string(), js}, {}, out, &err) &&
+        out.size() == 1 && err.find("nope.js") != std::string::npos, "missing asset skipped and named");
+
+  fs::remove_all(dir);
+  return fails == 0 ? 0 : 1;
+}
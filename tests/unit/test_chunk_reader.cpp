@@ -3,6 +3,7 @@
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <vector>
 
 namespace fs = std::filesystem;
 
@@ -21,6 +22,24 @@ int main(){
   if (lines < 2) { std::cerr << "[FAIL] expected multiple lines, got " << lines << "\n"; return 1; }
   uint64_t stat_size = fs::file_size(f);
   if (bytes == 0 || stat_size == 0) { std::cerr << "[FAIL] zero sizes\n"; return 1; }
+
+  // Two adjacent byte ranges must yield every line exactly once, whatever
+  // the split point (mid-line, on '\n', on a line start).
+  std::vector<std::string> all;
+  ts::ChunkReader full(f.string(), {});
+  (void)full.for_each_line([&](std::string_view s){ all.emplace_back(s); });
+  for (uint64_t cut = 0; cut <= stat_size; ++cut) {
+    std::vector<std::string> got;
+    ts::ChunkReader::Config a, b;
+    a.chunk_bytes = b.chunk_bytes = 7; // force lines across blocks
+    a.end_offset = cut;
+    b.begin_offset = cut;
+    if (cut > 0) { ts::ChunkReader ra(f.string(), a); (void)ra.for_each_line([&](std::string_view s){ got.emplace_back(s); }); }
+    ts::ChunkReader rb(f.string(), b);
+    (void)rb.for_each_line([&](std::string_view s){ got.emplace_back(s); });
+    if (got != all) { std::cerr << "[FAIL] range split at " << cut << " lines=" << got.size() << "\n"; return 1; }
+  }
+
   std::cout << "[PASS] lines="<<lines<<" bytes~="<<bytes<<" file_size="<<stat_size<<"\n";
   return 0;
 }
@@ -0,0 +1,57 @@
+#include "typed_scanner/config.hpp"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace fs = std::filesystem;
+
+int main(){
+  const fs::path f = fs::temp_directory_path() / "ts_test_config.toml";
+  {
+    std::ofstream out(f);
+    out << "[project]\nartifact_root = \"/tmp/ts-art\"\n"
+           "[server]\nport = 9090\n"
+           "[scanner]\nreader_threads = 3\nchunk_bytes = 1048576\narena_bytes = 4194304\n"
+           "[csv]\ndelimiter = \"\\t\"\nescape = \"\\\\\"\nnull_values = [\"-\"]\n"
+           "[jsonl]\nstrict = false\n"
+           "[stages.policy_parse]\non_error = \"strict\"\nbool_policy = [\"yes\",\"no\"]\n"
+           "[mapping]\nslug_rule = \"basename\"\n"
+           "[minio]\nbucket = \"ignored\"\n";
+  }
+
+  ts::AppConfig c;
+  std::string err;
+  if (!ts::load_config_file(f.string(), c, &err)) { std::cerr << "[FAIL] load: " << err << "\n"; return 1; }
+  if (c.artifact_root != "/tmp/ts-art" || c.server.artifact_root != "/tmp/ts-art" ||
+      c.server.port != 9090 || c.reader_threads != 3 || c.reader.chunk_bytes != (1u << 20) ||
+      c.arena_bytes != (4u << 20) || c.csv.delimiter != '\t' || c.csv.escape != '\\' ||
+      c.jsonl.strict || c.on_error != ts::ParsePolicy::OnError::Strict || c.slug_rule != "basename") {
+    std::cerr << "[FAIL] mapped values\n"; return 1;
+  }
+  auto pol = c.parse_policy();
+  if (!pol.is_null_token("-") || pol.is_null_token("NA") || pol.parse_bool("yes") != true) {
+    std::cerr << "[FAIL] policy wiring\n"; return 1;
+  }
+
+  // Overrides: typed values, bare words as strings, unknown keys rejected.
+  if (!ts::apply_config_override("scanner.chunk_bytes=65536", c, &err) || c.reader.chunk_bytes != 65536 ||
+      !ts::apply_config_override("mapping.slug_rule=keypath", c, &err) || c.slug_rule != "keypath") {
+    std::cerr << "[FAIL] override: " << err << "\n"; return 1;
+  }
+  if (ts::apply_config_override("scanner.no_such_key=1", c, &err) ||
+      ts::apply_config_override("scanner.chunk_bytes=\"big\"", c, &err)) {
+    std::cerr << "[FAIL] bad override accepted\n"; return 1;
+  }
+  if (!ts::validate_config(c).empty()) { std::cerr << "[FAIL] valid config rejected\n"; return 1; }
+
+  c.reader.chunk_bytes = 16;
+  c.csv.quote = c.csv.delimiter;
+  c.stages = {"metrics"};
+  const auto problems = ts::validate_config(c);
+  if (problems.size() != 3) { std::cerr << "[FAIL] expected 3 problems, got " << problems.size() << "\n"; return 1; }
+
+  fs::remove(f);
+  std::cout << "[PASS] config load/override/validate\n";
+  return 0;
+}
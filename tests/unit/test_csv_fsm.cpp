@@ -1,6 +1,7 @@
 #include "typed_scanner/token_csv_fsm.hpp"
 #include "typed_scanner/chunk_reader.hpp"
 #include "typed_scanner/arena.hpp"
+#include "typed_scanner/record_view.hpp"
 #include <filesystem>
 #include <iostream>
 
@@ -24,6 +25,14 @@ int main(){
 
   if (!ok) { std::cerr << "[FAIL] csv_fsm error: " << csv.error() << "\n"; return 1; }
   if (n != 6) { std::cerr << "[FAIL] expected 6 data rows, got " << n << "\n"; return 1; }
+
+  // Backslash escapes inside quotes when escape != quote.
+  ts::CsvConfig bs; bs.header = false; bs.escape = '\\';
+  ts::CsvFsm esc(bs, header, rows);
+  std::size_t nf = 0;
+  if (!esc.feed(R"(a,"x\",y",b)", [&](const ts::RecordView& rv){ nf = rv.fields()->size(); }) || nf != 3) {
+    std::cerr << "[FAIL] escaped quote split into " << nf << " fields\n"; return 1;
+  }
   std::cout << "[PASS] parsed " << n << " rows\n";
   return 0;
 }
@@ -0,0 +1,253 @@
+#include "typed_scanner/byte_source.hpp"
+#include "typed_scanner/chunk_reader.hpp"
+#include "typed_scanner/task_pool.hpp"
+#include "typed_scanner/tokenize.hpp"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifndef TS_HAVE_ZLIB
+  #define TS_HAVE_ZLIB 0
+#endif
+#ifndef TS_HAVE_ZSTD
+  #define TS_HAVE_ZSTD 0
+#endif
+#if TS_HAVE_ZLIB
+  #include <zlib.h>
+#endif
+#if TS_HAVE_ZSTD
+  #include <zstd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+static int fails = 0;
+static void check(bool ok, const std::string& what) {
+  std::cout << (ok ? "[PASS] " : "[FAIL] ") << what << "\n";
+  if (!ok) ++fails;
+}
+
+static std::string sample(int rows) {
+  std::string s = "id,name,score\n";
+  for (int i = 0; i < rows; ++i) s += std::to_string(i) + ",n" + std::to_string(i % 13) + "," + std::to_string(i * 0.5) + "\n";
+  return s;
+}
+
+static void write_file(const fs::path& p, const std::string& bytes) {
+  std::ofstream(p, std::ios::binary) << bytes;
+}
+
+// Lines as the reader sees them (small blocks so lines straddle reads).
+static bool read_lines(const fs::path& p, std::vector<std::string>& out, std::string& err,
+                       bool prefetch = true) {
+  ts::ChunkReader::Config cfg;
+  cfg.chunk_bytes = 1000;
+  cfg.decompress_thread = prefetch;
+  ts::ChunkReader r(p.string(), cfg);
+  out.clear();
+  const bool ok = r.for_each_line([&](std::string_view s){ out.emplace_back(s); });
+  err = r.error();
+  return ok;
+}
+
+static std::vector<std::string> split_lines(const std::string& s) {
+  std::vector<std::string> v;
+  std::size_t b = 0;
+  for (std::size_t i = 0; i < s.size(); ++i) {
+    if (s[i] == '\n') { v.emplace_back(s.substr(b, i - b)); b = i + 1; }
+  }
+  if (b < s.size()) v.emplace_back(s.substr(b));
+  return v;
+}
+
+#if TS_HAVE_ZLIB
+static std::string gzip(const std::string& in) {
+  z_stream zs{};
+  deflateInit2(&zs, 6, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+  std::string out(deflateBound(&zs, static_cast<uLong>(in.size())) + 32, '\0');
+  zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+  zs.avail_in = static_cast<uInt>(in.size());
+  zs.next_out = reinterpret_cast<Bytef*>(out.data());
+  zs.avail_out = static_cast<uInt>(out.size());
+  deflate(&zs, Z_FINISH);
+  out.resize(zs.total_out);
+  deflateEnd(&zs);
+  return out;
+}
+
+// BGZF block: a gzip member carrying its total size in a "BC" extra field.
+static std::string bgzf_block(const std::string& in) {
+  z_stream zs{};
+  deflateInit2(&zs, 6, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+  std::string body(deflateBound(&zs, static_cast<uLong>(in.size())) + 32, '\0');
+  zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+  zs.avail_in = static_cast<uInt>(in.size());
+  zs.next_out = reinterpret_cast<Bytef*>(body.data());
+  zs.avail_out = static_cast<uInt>(body.size());
+  deflate(&zs, Z_FINISH);
+  body.resize(zs.total_out);
+  deflateEnd(&zs);
+  auto le = [](std::string& s, std::uint32_t v, int n){ for (int i = 0; i < n; ++i) s += static_cast<char>((v >> (8 * i)) & 0xff); };
+  std::string out("\x1f\x8b\x08\x04\0\0\0\0\0\xff\x06\0BC\x02\0", 16);
+  le(out, static_cast<std::uint32_t>(18 + body.size() + 8 - 1), 2);
+  out += body;
+  le(out, static_cast<std::uint32_t>(crc32(0, reinterpret_cast<const Bytef*>(in.data()), static_cast<uInt>(in.size()))), 4);
+  le(out, static_cast<std::uint32_t>(in.size()), 4);
+  return out;
+}
+#endif
+
+#if TS_HAVE_ZSTD
+static std::string zstd(const std::string& in) {
+  std::string out(ZSTD_compressBound(in.size()), '\0');
+  out.resize(ZSTD_compress(out.data(), out.size(), in.data(), in.size(), 3));
+  return out;
+}
+#endif
+
+// Cut `in` every `frame` bytes (ignoring lines) and encode each piece.
+template <class Enc>
+static std::string framed(const std::string& in, std::size_t frame, Enc enc) {
+  std::string out;
+  for (std::size_t i = 0; i < in.size(); i += frame) out += enc(in.substr(i, frame));
+  return out;
+}
+
+// Every split of the frame table into two ranges yields each line once.
+static bool frame_splits_ok(const fs::path& p, ts::Compression c, const std::vector<std::string>& want,
+                            std::size_t& nframes) {
+  std::vector<ts::CompressedFrame> frames;
+  if (!ts::index_frames(p.string(), c, frames)) return false;
+  nframes = frames.size();
+  for (std::size_t k = 1; k < frames.size(); ++k) {
+    std::vector<std::string> got;
+    ts::ChunkReader::Config a, b;
+    a.chunk_bytes = b.chunk_bytes = 97;
+    a.decompress_thread = b.decompress_thread = false;
+    a.end_offset = b.begin_offset = frames[k].out_offset;
+    b.frame_offset = frames[k].raw_offset;
+    ts::ChunkReader ra(p.string(), a), rb(p.string(), b);
+    if (!ra.for_each_line([&](std::string_view s){ got.emplace_back(s); })) return false;
+    if (!rb.for_each_line([&](std::string_view s){ got.emplace_back(s); })) return false;
+    if (got != want) { std::cerr << "  split at frame " << k << ": " << got.size() << " lines\n"; return false; }
+  }
+  return true;
+}
+
+static bool tokenize_ranges_ok(const fs::path& p, std::uint64_t want_rows, unsigned& ranges) {
+  ts::TaskPool pool(ts::TaskPool::Config{4});
+  ts::TokenizeOptions opts;
+  opts.pool = &pool;
+  opts.min_range_bytes = 4096;
+  const ts::TokenizeStats st = ts::tokenize_file(p.string(), ts::FileFormat::CSV, opts);
+  ranges = st.ranges;
+  return st.ok && st.rows == want_rows && st.raw_bytes == fs::file_size(p);
+}
+
+int main(){
+  const fs::path dir = fs::temp_directory_path() / "ts_test_decompress";
+  fs::remove_all(dir);
+  fs::create_directories(dir);
+
+  const std::string a = sample(5000), b = sample(3000);
+  const auto want_a = split_lines(a), want_ab = split_lines(a + b);
+  std::vector<std::string> got;
+  std::string err;
+
+  // Detection: magic bytes win over the name, extension is the fallback.
+  write_file(dir / "plain.csv", a);
+  write_file(dir / "empty.csv.gz", "");
+  check(ts::detect_compression((dir / "plain.csv").string()) == ts::Compression::None, "plain detected as none");
+  check(ts::detect_compression((dir / "empty.csv.gz").string()) == ts::Compression::Gzip, "empty .gz falls back to extension");
+  check(ts::compression_from_magic(std::string("\x1f\x8b\x08", 3)) == ts::Compression::Gzip, "gzip magic");
+  check(ts::compression_from_magic(std::string("\x28\xb5\x2f\xfd", 4)) == ts::Compression::Zstd, "zstd magic");
+
+#if TS_HAVE_ZLIB
+  {
+    write_file(dir / "a.csv.gz", gzip(a));
+    write_file(dir / "mislabeled.csv", gzip(a));
+    write_file(dir / "ab.csv.gz", gzip(a) + gzip(b)); // concatenated members (pigz/bgzip)
+    check(read_lines(dir / "a.csv.gz", got, err) && got == want_a, "gzip lines match plain");
+    check(read_lines(dir / "a.csv.gz", got, err, false) && got == want_a, "gzip without prefetch thread");
+    check(read_lines(dir / "mislabeled.csv", got, err) && got == want_a, "gzip found by magic bytes");
+    check(read_lines(dir / "ab.csv.gz", got, err) && got == want_ab, "gzip multi-member");
+
+    ts::ChunkReader r((dir / "a.csv.gz").string(), {});
+    (void)r.for_each_line([](std::string_view){});
+    check(r.compression() == ts::Compression::Gzip && r.bytes_read() == a.size() &&
+          r.raw_bytes_read() == fs::file_size(dir / "a.csv.gz"), "gzip byte counters");
+
+    const std::string z = gzip(a);
+    write_file(dir / "cut.csv.gz", z.substr(0, z.size() / 2));
+    const bool ok = read_lines(dir / "cut.csv.gz", got, err);
+    check(!ok && err.find("truncated") != std::string::npos, "gzip truncated input fails: " + err);
+
+    // BGZF: frames cut mid-line, on '\n' and at line starts (frame sizes
+    // 1..15 against 17..20-byte lines), plus a large one for tokenize.
+    const std::string small = sample(40);
+    const auto want_small = split_lines(small);
+    bool splits = true;
+    std::size_t nframes = 0;
+    for (std::size_t fsz = 1; fsz < 16 && splits; ++fsz) {
+      write_file(dir / "s.csv.gz", framed(small, fsz, bgzf_block) + bgzf_block(""));
+      splits = frame_splits_ok(dir / "s.csv.gz", ts::Compression::Gzip, want_small, nframes);
+    }
+    check(splits && nframes > 16, "bgzf ranges split at every frame cover each line once");
+    std::vector<ts::CompressedFrame> frames;
+    check(!ts::index_frames((dir / "a.csv.gz").string(), ts::Compression::Gzip, frames),
+          "plain gzip has no frame index");
+    write_file(dir / "big.csv.gz", framed(a, 4000, bgzf_block) + bgzf_block(""));
+    unsigned ranges = 0;
+    const bool tok = tokenize_ranges_ok(dir / "big.csv.gz", want_a.size() - 1, ranges);
+    check(tok && ranges > 1, "bgzf tokenized in " + std::to_string(ranges) + " ranges");
+
+    ts::ChunkReader::Config ranged;
+    ranged.begin_offset = 10;
+    ts::ChunkReader rr((dir / "a.csv.gz").string(), ranged);
+    check(!rr.for_each_line([](std::string_view){}) && !rr.error().empty(), "gzip rejects byte ranges");
+  }
+#else
+  std::cout << "[SKIP] gzip (built without zlib)\n";
+#endif
+
+#if TS_HAVE_ZSTD
+  {
+    write_file(dir / "a.csv.zst", zstd(a));
+    write_file(dir / "ab.csv.zst", zstd(a) + zstd(b)); // multi-frame
+    check(read_lines(dir / "a.csv.zst", got, err) && got == want_a, "zstd lines match plain");
+    check(read_lines(dir / "ab.csv.zst", got, err) && got == want_ab, "zstd multi-frame");
+
+    const std::string small = sample(40);
+    const auto want_small = split_lines(small);
+    bool splits = true;
+    std::size_t nframes = 0;
+    for (std::size_t fsz = 1; fsz < 16 && splits; ++fsz) {
+      write_file(dir / "s.csv.zst", framed(small, fsz, zstd));
+      splits = frame_splits_ok(dir / "s.csv.zst", ts::Compression::Zstd, want_small, nframes);
+    }
+    check(splits && nframes > 16, "zstd ranges split at every frame cover each line once");
+    // A skippable frame (as used for seek tables) decodes to nothing.
+    write_file(dir / "skip.csv.zst", zstd(a) + std::string("\x50\x2a\x4d\x18\x04\0\0\0abcd", 12) + zstd(b));
+    std::vector<ts::CompressedFrame> frames;
+    check(ts::index_frames((dir / "skip.csv.zst").string(), ts::Compression::Zstd, frames) &&
+          frames.size() == 3 && frames[2].out_offset == a.size(), "zstd skippable frame indexed");
+    check(read_lines(dir / "skip.csv.zst", got, err) && got == want_ab, "zstd skippable frame ignored");
+    write_file(dir / "big.csv.zst", framed(a, 4000, zstd));
+    unsigned ranges = 0;
+    const bool tok = tokenize_ranges_ok(dir / "big.csv.zst", want_a.size() - 1, ranges);
+    check(tok && ranges > 1, "zstd tokenized in " + std::to_string(ranges) + " ranges");
+
+    const std::string z = zstd(a);
+    write_file(dir / "cut.csv.zst", z.substr(0, z.size() - 7));
+    const bool ok = read_lines(dir / "cut.csv.zst", got, err);
+    check(!ok && !err.empty(), "zstd truncated input fails: " + err);
+  }
+#else
+  std::cout << "[SKIP] zstd (built without libzstd)\n";
+#endif
+
+  fs::remove_all(dir);
+  return fails == 0 ? 0 : 1;
+}
@@ -0,0 +1,100 @@
+#include "typed_scanner/dir_watcher.hpp"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+int main(){
+  // (1) globs
+  struct { const char* pat; const char* path; bool want; } cases[] = {
+    {"**/*.csv", "a.csv", true},
+    {"**/*.csv", "x/y/a.csv", true},
+    {"**/*.csv", "a.csv.tmp", false},
+    {"*.csv", "x/a.csv", false},
+    {"**/.*", "x/.part", true},
+    {"**/.*", "x/.dir/a.csv", false},
+    {"in/??.jsonl", "in/ab.jsonl", true},
+    {"in/**", "in/a/b", true},
+  };
+  for (const auto& c : cases) {
+    if (ts::glob_match(c.pat, c.path) != c.want) {
+      std::cerr << "[FAIL] glob " << c.pat << " ~ " << c.path << "\n"; return 1;
+    }
+  }
+
+#if defined(__linux__)
+  // (2) events: debounced writes, new subdirectories, excludes, deletes.
+  const fs::path dir = fs::temp_directory_path() / "ts_test_dir_watcher";
+  fs::remove_all(dir);
+  fs::create_directories(dir);
+  { std::ofstream(dir / "old.csv") << "a\n1\n"; }
+
+  std::mutex mu;
+  std::map<std::string, int> changed, deleted;
+  ts::DirWatcher::Config cfg;
+  cfg.root = dir.string();
+  cfg.exclude = {"**/*.tmp"};
+  cfg.debounce_ms = 50;
+  ts::DirWatcher w(cfg, [&](const std::string& p, ts::DirWatcher::Event ev){
+    std::lock_guard<std::mutex> lk(mu);
+    (ev == ts::DirWatcher::Event::Changed ? changed : deleted)[fs::path(p).filename().string()]++;
+  });
+  std::string err;
+  if (!w.start(&err)) { std::cerr << "[FAIL] start: " << err << "\n"; return 1; }
+
+  for (int i = 0; i < 5; ++i) { std::ofstream(dir / "burst.csv", std::ios::app) << i << "\n"; }
+  fs::create_directories(dir / "sub");
+  std::this_thread::sleep_for(std::chrono::milliseconds(100)); // sub gets its watch
+  { std::ofstream(dir / "sub" / "deep.jsonl") << "{}\n"; }
+  { std::ofstream(dir / "skip.tmp") << "x\n"; }
+  fs::remove(dir / "old.csv");
+  std::this_thread::sleep_for(std::chrono::milliseconds(400));
+  w.stop();
+
+  std::lock_guard<std::mutex> lk(mu);
+  if (changed["burst.csv"] != 1 || changed["deep.jsonl"] != 1 || changed.count("skip.tmp") ||
+      changed["old.csv"] != 1 || deleted["old.csv"] != 1) { // initial scan, then delete
+    std::cerr << "[FAIL] events burst=" << changed["burst.csv"] << " deep=" << changed["deep.jsonl"]
+              << " old.deleted=" << deleted["old.csv"] << "\n";
+    return 1;
+  }
+  fs::remove_all(dir);
+
+  // (3) non-recursive: one watch on root, directories under it reported.
+  fs::create_directories(dir / "kept");
+  std::mutex dmu; // `mu` is still held above
+  std::map<std::string, int> dchanged, ddeleted;
+  ts::DirWatcher::Config dcfg;
+  dcfg.root = dir.string();
+  dcfg.include = {"*"};
+  dcfg.debounce_ms = 50;
+  dcfg.initial_scan = false;
+  dcfg.recursive = false;
+  ts::DirWatcher dw(dcfg, [&](const std::string& p, ts::DirWatcher::Event ev){
+    std::lock_guard<std::mutex> dlk(dmu);
+    (ev == ts::DirWatcher::Event::Changed ? dchanged : ddeleted)[fs::path(p).filename().string()]++;
+  });
+  if (!dw.start(&err)) { std::cerr << "[FAIL] start: " << err << "\n"; return 1; }
+  fs::create_directories(dir / "report1");
+  { std::ofstream(dir / "report1" / "report.html") << "x\n"; }
+  { std::ofstream(dir / "kept" / "report.html") << "x\n"; }
+  { std::ofstream(dir / "top.csv") << "x\n"; }
+  fs::remove_all(dir / "kept");
+  std::this_thread::sleep_for(std::chrono::milliseconds(400));
+  dw.stop();
+  std::lock_guard<std::mutex> dlk(dmu);
+  if (dchanged.size() != 1 || dchanged["report1"] != 1 || ddeleted.size() != 1 || ddeleted["kept"] != 1) {
+    std::cerr << "[FAIL] non-recursive events changed=" << dchanged.size() << " deleted=" << ddeleted.size() << "\n";
+    return 1;
+  }
+  fs::remove_all(dir);
+#endif
+  std::cout << "[PASS] dir watcher\n";
+  return 0;
+}
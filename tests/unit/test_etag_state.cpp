@@ -0,0 +1,56 @@
+#include "typed_scanner/etag_state.hpp"
+#include "typed_scanner/fingerprint.hpp"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace fs = std::filesystem;
+
+int main(){
+  const fs::path dir = fs::temp_directory_path() / "ts_test_etag_state";
+  fs::remove_all(dir);
+  fs::create_directories(dir);
+  const fs::path data = dir / "in.csv";
+  { std::ofstream(data, std::ios::binary) << "a,b\n1,2\n"; }
+
+  // (1) fingerprints are stable, mode-tagged and change with content.
+  std::string err;
+  const std::string full = ts::file_fingerprint(data.string(), ts::FingerprintMode::Xxh3, &err);
+  const std::string again = ts::file_fingerprint(data.string(), ts::FingerprintMode::Xxh3, &err);
+  const std::string sampled = ts::file_fingerprint(data.string(), ts::FingerprintMode::Sampled, &err);
+  if (full.empty() || full != again || full.rfind("xxh3-", 0) != 0 || sampled.rfind("sampled-", 0) != 0) {
+    std::cerr << "[FAIL] fingerprint " << full << " " << sampled << " " << err << "\n"; return 1;
+  }
+  { std::ofstream(data, std::ios::binary | std::ios::app) << "3,4\n"; }
+  if (ts::file_fingerprint(data.string(), ts::FingerprintMode::Xxh3) == full) {
+    std::cerr << "[FAIL] fingerprint unchanged after append\n"; return 1;
+  }
+  if (!ts::file_fingerprint((dir / "missing").string(), ts::FingerprintMode::Xxh3, &err).empty() || err.empty()) {
+    std::cerr << "[FAIL] missing file should fail\n"; return 1;
+  }
+
+  // (2) load/save round trip; a missing state file is empty.
+  const std::string state = (dir / ".etags").string();
+  {
+    ts::EtagState s;
+    if (!s.load(state, &err)) { std::cerr << "[FAIL] load missing: " << err << "\n"; return 1; }
+    s.set("abcd1234", full);
+    s.set("gone", "xxh3-0");
+    s.erase("gone");
+    if (!s.flush(&err) || !fs::exists(state)) { std::cerr << "[FAIL] flush: " << err << "\n"; return 1; }
+    // A clean state is not rewritten.
+    fs::remove(state);
+    s.erase("never-set");
+    if (!s.flush(&err) || fs::exists(state)) { std::cerr << "[FAIL] clean flush rewrote the file\n"; return 1; }
+    if (!s.save(&err)) { std::cerr << "[FAIL] save: " << err << "\n"; return 1; }
+  }
+  ts::EtagState s2;
+  if (!s2.load(state, &err) || !s2.matches("abcd1234", full) || s2.get("gone")) {
+    std::cerr << "[FAIL] round trip\n"; return 1;
+  }
+
+  fs::remove_all(dir);
+  std::cout << "[PASS] etag state\n";
+  return 0;
+}
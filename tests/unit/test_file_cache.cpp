@@ -0,0 +1,84 @@
+#include "typed_scanner/file_cache.hpp"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+static int fails = 0;
+static void check(bool ok, const std::string& what) {
+  std::cout << (ok ? "[PASS] " : "[FAIL] ") << what << "\n";
+  if (!ok) ++fails;
+}
+
+static void write(const std::string& path, const std::string& body) {
+  std::ofstream(path, std::ios::binary | std::ios::trunc) << body;
+}
+
+int main(){
+  const auto dir = std::filesystem::temp_directory_path() / "ts_test_file_cache";
+  std::filesystem::create_directories(dir);
+  const std::string a = (dir / "a.html").string();
+  const std::string b = (dir / "b.js").string();
+  write(a, "hello");
+  write(b, std::string(3000, 'b'));
+
+  ts::FileCache cache(ts::FileCache::Config{4096, 4096});
+  auto fa = cache.get(a);
+  check(fa && fa->body == "hello" && fa->etag.size() == 18 && fa->etag.front() == '"', "load + strong etag");
+  auto fa2 = cache.get(a);
+  check(fa2 == fa && cache.stats().hits == 1, "second get is a hit");
+
+  // A rewrite changes size/mtime and is picked up on the next get.
+  write(a, "hello, world");
+  auto fa3 = cache.get(a);
+  check(fa3 && fa3->body == "hello, world" && fa3->etag != fa->etag, "stale entry reloaded");
+  check(fa->body == "hello", "old snapshot stays valid for in-flight responses");
+
+  // LRU: b (3000) + a (12) fit; a second big file evicts the least recent.
+  (void)cache.get(b);
+  const std::string c = (dir / "c.js").string();
+  write(c, std::string(2000, 'c'));
+  (void)cache.get(a);  // a is now most recent, b least
+  (void)cache.get(c);
+  const auto st = cache.stats();
+  check(st.evictions == 1 && st.entries == 2 && st.bytes == 2012, "LRU eviction by bytes");
+
+  const std::string big = (dir / "big.bin").string();
+  write(big, std::string(5000, 'x'));
+  auto fb = cache.get(big);
+  check(fb && fb->streamed && fb->body.empty() && fb->size == 5000 && fb->path == big &&
+        cache.stats().entries == 2, "oversize files streamed, not read or cached");
+  write(big, std::string(6000, 'x'));
+  auto fb2 = cache.get(big);
+  check(fb2 && fb2->size == 6000 && fb2->etag != fb->etag, "streamed etag follows size/mtime");
+
+  std::string err;
+  check(!cache.get((dir / "missing").string(), &err) && !err.empty(), "missing file");
+  std::filesystem::remove(a);
+  check(!cache.get(a), "deleted file drops out");
+
+  ts::FileCache off(ts::FileCache::Config{0, 0});
+  check(off.get(b) && off.stats().entries == 0, "max_bytes 0 disables caching");
+
+  // Conditional requests.
+  ts::CachedFile f;
+  f.etag = "\"abc\"";
+  f.mtime_ns = 784111777LL * 1000000000;
+  f.last_modified = ts::http_date(784111777);
+  check(f.last_modified == "Sun, 06 Nov 1994 08:49:37 GMT", "http_date");
+  check(ts::not_modified(f, "\"abc\"", ""), "If-None-Match match");
+  check(ts::not_modified(f, "\"x\", W/\"abc\"", ""), "If-None-Match list, weak compare");
+  check(ts::not_modified(f, "*", ""), "If-None-Match *");
+  check(!ts::not_modified(f, "\"x\"", f.last_modified), "If-None-Match wins over If-Modified-Since");
+  check(ts::not_modified(f, "", f.last_modified), "If-Modified-Since equal");
+  check(!ts::not_modified(f, "", "Sat, 05 Nov 1994 08:49:37 GMT"), "If-Modified-Since older");
+  check(!ts::not_modified(f, "", "garbage"), "bad date ignored");
+  check(ts::range_applies(f, "") && ts::range_applies(f, " \"abc\" "), "Range without If-Range, or with the current ETag: 206");
+  check(!ts::range_applies(f, "\"old\""), "stale If-Range: whole file");
+  check(!ts::range_applies(f, "W/\"abc\""), "weak If-Range never matches");
+  check(!ts::range_applies(f, f.last_modified), "If-Range date: whole file");
+  check(!ts::not_modified(f, "", ""), "unconditional");
+
+  std::filesystem::remove_all(dir);
+  return fails == 0 ? 0 : 1;
+}
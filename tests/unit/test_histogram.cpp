@@ -0,0 +1,41 @@
+#include "typed_scanner/histogram.hpp"
+#include <cstdint>
+#include <iostream>
+
+int main(){
+  ts::LatencyHistogram a, b;
+  // 1..10000 us split across two "threads", then merged.
+  for (std::uint64_t us = 1; us <= 10000; ++us) ((us & 1) ? a : b).record(us * 1000);
+  a.merge(b);
+
+  if (a.count() != 10000) { std::cerr << "[FAIL] count=" << a.count() << "\n"; return 1; }
+  if (a.max_ns() != 10000ull * 1000) { std::cerr << "[FAIL] max=" << a.max_ns() << "\n"; return 1; }
+
+  // Log-linear buckets: every quantile within 1/32 of the exact value.
+  const double qs[] = {0.5, 0.9, 0.99, 0.999};
+  for (double q : qs) {
+    const double exact = q * 10000.0 * 1000.0;
+    const double got = double(a.value_at(q));
+    if (got < exact * (1.0 - 1.0/32) || got > exact * (1.0 + 1.0/32)) {
+      std::cerr << "[FAIL] q=" << q << " got=" << got << " exact=" << exact << "\n"; return 1;
+    }
+  }
+
+  // Bucket bounds round-trip for small (exact) and large values.
+  const std::uint64_t probes[] = {0, 31, 32, 63, 64, 65, 1000, 123456789, ~0ull};
+  for (auto v : probes) {
+    const auto i = ts::LatencyHistogram::bucket_index(v);
+    if (i >= ts::LatencyHistogram::kBuckets ||
+        v < ts::LatencyHistogram::bucket_lower(i) || v > ts::LatencyHistogram::bucket_upper(i)) {
+      std::cerr << "[FAIL] bucket bounds for " << v << "\n"; return 1;
+    }
+  }
+
+  auto s = a.summarize("t");
+  if (s.buckets.empty() || s.p50_ms <= 0.0 || s.p999_ms < s.p99_ms) {
+    std::cerr << "[FAIL] summary\n"; return 1;
+  }
+  std::cout << "[PASS] histogram p50=" << s.p50_ms << "ms p99=" << s.p99_ms
+            << "ms buckets=" << s.buckets.size() << "\n";
+  return 0;
+}
@@ -0,0 +1,143 @@
+#include "typed_scanner/json_writer.hpp"
+#include "typed_scanner/run_json.hpp"
+#include <cmath>
+#include <cstdint>
+#include <csignal>
+#include <cstdio>
+#include <fcntl.h>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <sys/resource.h>
+#include <unistd.h>
+
+static int fails = 0;
+static void check(bool ok, const std::string& what) {
+  std::cout << (ok ? "[PASS] " : "[FAIL] ") << what << "\n";
+  if (!ok) ++fails;
+}
+
+static std::string quoted(std::string_view s) {
+  std::string out;
+  ts::append_json_string(out, s);
+  return out;
+}
+
+// Everything written to an fd-backed writer, read back.
+template <class F>
+static std::string via_fd(std::size_t buf, F&& fill) {
+  std::FILE* f = std::tmpfile();
+  {
+    ts::JsonWriter w(fileno(f), buf);
+    fill(w);
+  }
+  std::string out;
+  std::rewind(f);
+  char chunk[4096];
+  std::size_t n;
+  while ((n = std::fread(chunk, 1, sizeof chunk, f)) > 0) out.append(chunk, n);
+  std::fclose(f);
+  return out;
+}
+
+int main(){
+  // --- escaping, including runs that straddle the 8-byte scan
+  check(quoted("plain") == "\"plain\"", "plain string");
+  check(quoted("a\"b\\c") == "\"a\\\"b\\\\c\"", "quote and backslash");
+  check(quoted("0123456789abcdef\n") == "\"0123456789abcdef\\n\"", "escape after two clean words");
+  check(quoted(std::string("x\x01y\x1f", 4)) == "\"x\\u0001y\\u001f\"", "control chars as \\u00XX");
+  check(quoted("\t\r\b\f") == "\"\\t\\r\\b\\f\"", "short escapes");
+  check(quoted("caf\xc3\xa9 \x7f") == "\"caf\xc3\xa9 \x7f\"", "UTF-8 and DEL pass through");
+  std::string mixed;
+  for (int i = 0; i < 64; ++i) mixed += (i % 9 == 0) ? '"' : char('a' + i % 26);
+  std::string expect = "\"";
+  for (char c : mixed) expect += c == '"' ? std::string("\\\"") : std::string(1, c);
+  check(quoted(mixed) == expect + "\"", "escapes at every offset");
+
+  // --- structure and numbers
+  std::string out;
+  {
+    ts::JsonWriter w(out);
+    w.begin_object()
+     .key("i").value(-42)
+     .key("u").value(std::numeric_limits<std::uint64_t>::max())
+     .key("d").value(0.1)
+     .key("nan").value(std::nan(""))
+     .key("inf").value(std::numeric_limits<double>::infinity())
+     .key("b").value(true)
+     .key("n").null()
+     .key("a").begin_array().value(1).value("two").begin_object().end_object().begin_array().end_array().end_array()
+     .end_object();
+  }
+  check(out == "{\"i\":-42,\"u\":18446744073709551615,\"d\":0.1,\"nan\":0,\"inf\":0,"
+               "\"b\":true,\"n\":null,\"a\":[1,\"two\",{},[]]}", "commas, nesting, to_chars numbers: " + out);
+
+  // --- fd sink matches the string sink, whatever the buffer size
+  auto doc = [](ts::JsonWriter& w){
+    w.begin_array();
+    for (int i = 0; i < 1000; ++i) w.begin_object().key("k").value(i).key("s").value("v\"al").end_object();
+    w.end_array();
+  };
+  std::string mem;
+  { ts::JsonWriter w(mem); doc(w); }
+  check(via_fd(1, doc) == mem, "fd sink, 1-byte buffer");
+  check(via_fd(64u << 10, doc) == mem, "fd sink, default buffer");
+  if (const int full = ::open("/dev/full", O_WRONLY); full >= 0) {
+    ts::JsonWriter w(full);
+    w.begin_array().end_array();
+    check(!w.flush() && !w.ok() && !w.error().empty(), "write error is reported");
+    ::close(full);
+  }
+
+  // --- run.json: spool splices the full series, sampled() stays bounded
+  ts::RunJsonPayload p;
+  p.rows = 7;
+  p.resumed_from = 123;
+  p.filename = "a\"b.csv";
+  ts::RunJsonSeriesSpool spool(100);
+  for (int i = 0; i < 5000; ++i) spool.append({double(i), 1.5, 2.0, 0.0});
+  check(spool.size() == 5000, "spool counts every point");
+  check(spool.sampled().size() <= 100 && spool.sampled().size() >= 50 &&
+        spool.sampled().front().time_ms == 0.0, "sampled copy is bounded and evenly thinned");
+
+  const std::string streamed = via_fd(4096, [&](ts::JsonWriter& w){ ts::RunJsonWriter::write(w, p, &spool); });
+  ts::RunJsonPayload full = p;
+  for (int i = 0; i < 5000; ++i) full.series.push_back({double(i), 1.5, 2.0, 0.0});
+  check(streamed == ts::RunJsonWriter::to_json(full), "streamed run.json equals to_json with the whole series");
+  check(streamed.find("\"resumed_from\":123,") != std::string::npos, "integers unchanged");
+  check(streamed.find("{\"time_ms\":4999,\"mb_s\":1.5,\"rss_mb\":2,\"allocs_per_sec\":0}]") != std::string::npos,
+        "last point closes the series");
+
+  ts::RunJsonSeriesSpool empty;
+  const std::string none = via_fd(4096, [&](ts::JsonWriter& w){ ts::RunJsonWriter::write(w, p, &empty); });
+  check(none.find("\"series\":[],") != std::string::npos, "empty spool");
+
+  // A temp file that stops taking writes (file size limit as a stand-in
+  // for a full disk): with nothing spilled yet the points stay in memory;
+  // once some were spilled, the sampled copy is written instead.
+  std::signal(SIGXFSZ, SIG_IGN);
+  rlimit old{};
+  getrlimit(RLIMIT_FSIZE, &old);
+  const auto spool_with_limit = [&](rlim_t limit, ts::RunJsonSeriesSpool& sp) {
+    rlimit lim = old;
+    lim.rlim_cur = limit;
+    setrlimit(RLIMIT_FSIZE, &lim);
+    for (int i = 0; i < 5000; ++i) sp.append({double(i), 1.5, 2.0, 0.0});
+    setrlimit(RLIMIT_FSIZE, &old);
+  };
+  ts::RunJsonSeriesSpool kept(100);
+  spool_with_limit(0, kept);
+  const std::string in_memory = via_fd(4096, [&](ts::JsonWriter& w){ ts::RunJsonWriter::write(w, p, &kept); });
+  check(in_memory == ts::RunJsonWriter::to_json(full), "first spill fails: whole series from memory");
+
+  ts::RunJsonSeriesSpool lost(100);
+  spool_with_limit(100u << 10, lost);
+  const std::string fallback = via_fd(4096, [&](ts::JsonWriter& w){ ts::RunJsonWriter::write(w, p, &lost); });
+  ts::RunJsonPayload thinned = p;
+  thinned.series = lost.sampled();
+  check(lost.size() == 5000 && fallback == ts::RunJsonWriter::to_json(thinned),
+        "later spill fails: sampled series, no leading comma");
+  check(fallback.find("[,") == std::string::npos, "no empty element");
+
+  return fails == 0 ? 0 : 1;
+}
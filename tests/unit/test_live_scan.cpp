@@ -0,0 +1,79 @@
+#include "typed_scanner/live_scan.hpp"
+#include "typed_scanner/metrics.hpp"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static int fails = 0;
+static void check(bool ok, const std::string& what) {
+  std::cout << (ok ? "[PASS] " : "[FAIL] ") << what << "\n";
+  if (!ok) ++fails;
+}
+
+using namespace std::chrono_literals;
+
+int main(){
+  // --- MetricsRegistry::live(): totals and open stages, no lock
+  {
+    ts::MetricsRegistry m;
+    const ts::StageId tok = m.register_stage("tokenize");
+    (void)m.register_stage("never");
+    std::atomic<bool> go{true};
+    std::thread writer([&]{
+      m.start_stage(tok);
+      while (go.load()) { m.add_rows(1); m.add_bytes(10); }
+      m.end_stage(tok);
+    });
+    std::this_thread::sleep_for(50ms);
+    const auto a = m.live();
+    std::this_thread::sleep_for(20ms);
+    const auto b = m.live();
+    check(a.rows > 0 && b.rows >= a.rows && b.bytes >= 10 * a.rows,
+          "live totals grow while the writer runs");
+    check(b.stages.size() == 1 && b.stages[0].name == "tokenize" && b.stages[0].duration_ms >= 50,
+          "open stage counts its elapsed time; unused stages are left out");
+    go = false;
+    writer.join();
+    const auto c = m.live();
+    const auto snap = m.snapshot(1.0, 0.0, 0.0);
+    check(c.rows == snap.rows && c.bytes == snap.bytes, "live matches snapshot once writers stop");
+    check(c.stages.size() == 1 && c.stages[0].duration_ms == snap.stages[0].duration_ms,
+          "closed stage counted once");
+  }
+
+  // --- LiveScan: publish/wait/finish
+  {
+    auto& table = ts::LiveScans::global();
+    auto s = table.begin("slug1", "a.csv");
+    check(table.find("slug1") == s && table.list().size() == 1, "registered by slug");
+
+    ts::LiveScanSample out;
+    const auto t0 = std::chrono::steady_clock::now();
+    check(s->wait(0, 30ms, out) == 0 && std::chrono::steady_clock::now() - t0 >= 25ms, "wait times out without a sample");
+
+    std::thread pub([&]{
+      std::this_thread::sleep_for(20ms);
+      s->publish({12.0, 100, 1000, 1.5, 20.0, {{"tokenize", 12}}});
+    });
+    const std::uint64_t seq = s->wait(0, 2000ms, out);
+    pub.join();
+    check(seq == 1 && out.rows == 100 && out.stage_ms.size() == 1, "wait wakes on publish");
+    check(s->wait(seq, 10ms, out) == seq, "nothing newer than seen");
+
+    std::thread fin([&]{ std::this_thread::sleep_for(20ms); s->finish(false, "boom"); });
+    (void)s->wait(seq, 2000ms, out);
+    fin.join();
+    check(s->done() && !s->ok() && s->error() == "boom", "finish wakes readers with the outcome");
+
+    auto newer = table.begin("slug1", "a.csv");
+    table.end(s); // stale entry must not drop the newer scan
+    check(table.find("slug1") == newer, "end() of a replaced scan keeps the newer one");
+    table.end(newer);
+    check(!table.find("slug1") && table.list().empty(), "ended scans leave the table");
+  }
+
+  return fails == 0 ? 0 : 1;
+}
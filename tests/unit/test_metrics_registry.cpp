@@ -0,0 +1,50 @@
+#include "typed_scanner/metrics.hpp"
+#include <iostream>
+#include <thread>
+#include <vector>
+
+int main(){
+  ts::MetricsRegistry m;
+  const ts::StageId st = m.register_stage("tokenize");
+  const ts::CounterId price = m.register_field_error("price");
+  const ts::HistogramId lat = m.register_histogram("record");
+  if (m.register_stage("tokenize") != st) { std::cerr << "[FAIL] stage id not stable\n"; return 1; }
+
+  constexpr int kThreads = 4;
+  constexpr std::uint64_t kRows = 100000;
+  std::vector<std::thread> ts_;
+  for (int t = 0; t < kThreads; ++t) {
+    ts_.emplace_back([&]{
+      m.start_stage(st);
+      for (std::uint64_t i = 0; i < kRows; ++i) {
+        m.add_row();
+        m.add_bytes(10);
+        if ((i % 100) == 0) m.add_field_error(price);
+        if ((i % 1000) == 0) m.record_latency(lat, 1000 + i);
+      }
+      m.end_stage(st);
+    });
+  }
+  // Live reads while writers run must not block them.
+  (void)m.rows();
+  for (auto& t : ts_) t.join();
+
+  m.add_field_error("qty"); // string wrapper
+  auto r = m.snapshot(1000.0, 0.0, 0.0);
+
+  bool ok = true;
+  if (r.rows != kThreads * kRows) { std::cerr << "[FAIL] rows=" << r.rows << "\n"; ok = false; }
+  if (r.bytes != kThreads * kRows * 10) { std::cerr << "[FAIL] bytes=" << r.bytes << "\n"; ok = false; }
+  if (r.errors_by_field["price"] != kThreads * (kRows / 100)) { std::cerr << "[FAIL] price errs\n"; ok = false; }
+  if (r.errors_by_field["qty"] != 1) { std::cerr << "[FAIL] qty errs\n"; ok = false; }
+  if (r.stages.size() != 1 || r.stages[0].name != "tokenize") { std::cerr << "[FAIL] stages\n"; ok = false; }
+  if (r.latencies.size() != 1 || r.latencies[0].count != kThreads * (kRows / 1000)) {
+    std::cerr << "[FAIL] latency count\n"; ok = false;
+  }
+
+  m.reset();
+  if (m.rows() != 0) { std::cerr << "[FAIL] reset\n"; ok = false; }
+  if (!ok) return 1;
+  std::cout << "[PASS] metrics registry rows=" << r.rows << " shards merged\n";
+  return 0;
+}
@@ -0,0 +1,150 @@
+#include "typed_scanner/metrics.hpp"
+#include "typed_scanner/pipeline.hpp"
+#include "typed_scanner/spsc_queue.hpp"
+#include "typed_scanner/task_pool.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+int main(){
+  // (1) SPSC ring: every item arrives once, in order, across wrap-around.
+  {
+    ts::SpscQueue<std::uint64_t> q(8);
+    const std::uint64_t n = 200000;
+    std::thread prod([&]{ for (std::uint64_t i = 0; i < n; ++i) q.push(i); q.close(); });
+    std::uint64_t expect = 0, v = 0;
+    while (q.pop(v)) { if (v != expect) break; ++expect; }
+    prod.join();
+    if (expect != n) { std::cerr << "[FAIL] spsc got " << expect << " of " << n << "\n"; return 1; }
+  }
+
+  // (2) tokenize -> policy_parse -> metrics over 4 byte ranges.
+  const fs::path f = fs::temp_directory_path() / "ts_test_pipeline.csv";
+  const int rows = 50000;
+  {
+    std::ofstream out(f, std::ios::binary);
+    out << "id,flag,when,label\n";
+    for (int i = 0; i < rows; ++i) {
+      out << i << "," << ((i & 1) ? "true" : "false") << ",2024-01-02,"
+          << (i % 1000 == 999 ? "NA" : "x") << "\n";
+    }
+    out << "oops,true,2024-01-02,x\n"; // one bad number
+  }
+
+  ts::TaskPool pool(ts::TaskPool::Config{4});
+  ts::TokenizeOptions tok;
+  tok.pool = &pool;
+  tok.min_range_bytes = 64 * 1024;
+  tok.max_ranges = 4;
+  ts::DatePolicy dp;
+  ts::BoolPolicy bp;
+  ts::PipelineOptions po;
+  po.policy.date_policy = &dp;
+  po.policy.bool_policy = &bp;
+  po.batch_rows = 512;
+
+  ts::MetricsRegistry metrics;
+  const auto res = ts::run_pipeline(f.string(), ts::FileFormat::CSV, tok, po, metrics);
+  if (!res.tok.ok || res.tok.ranges < 2 || res.tok.rows != rows + 1u) {
+    std::cerr << "[FAIL] tokenize ok=" << res.tok.ok << " ranges=" << res.tok.ranges
+              << " rows=" << res.tok.rows << " " << res.tok.error << "\n";
+    return 1;
+  }
+  if (res.columns.size() != 4 || res.columns[0].name != "id" || res.columns[0].type != "number" ||
+      res.columns[0].errors != 1 || res.columns[1].type != "bool" || res.columns[2].type != "date" ||
+      res.columns[3].nulls != rows / 1000 || res.columns[0].count != rows + 1u) {
+    std::cerr << "[FAIL] column stats\n"; return 1;
+  }
+  const auto snap = metrics.snapshot(1.0, 0.0, 0.0);
+  if (snap.errors_by_field.count("id") == 0 || snap.errors_by_field.at("id") != 1) {
+    std::cerr << "[FAIL] errors_by_field\n"; return 1;
+  }
+
+  // (3) column kinds follow file order, not which range's batch arrives
+  // first: `mixed` starts numeric in range 0 and turns to text later;
+  // `late` is null until halfway, text, then numbers near the end.
+  const fs::path fm = fs::temp_directory_path() / "ts_test_pipeline_mixed.csv";
+  const int mrows = 40000;
+  {
+    std::ofstream out(fm, std::ios::binary);
+    out << "id,mixed,late\n";
+    for (int i = 0; i < mrows; ++i) {
+      out << i << "," << (i < mrows / 4 ? std::to_string(i) : std::string("abc")) << ","
+          << (i < mrows / 2 ? "NA" : i < 3 * mrows / 4 ? "word" : "5") << "\n";
+    }
+  }
+  for (int run = 0; run < 8; ++run) {
+    ts::MetricsRegistry mm;
+    const auto mr = ts::run_pipeline(fm.string(), ts::FileFormat::CSV, tok, po, mm);
+    if (!mr.tok.ok || mr.tok.ranges < 2 || mr.columns.size() != 3 ||
+        mr.columns[1].type != "number" || mr.columns[1].errors != mrows - mrows / 4u ||
+        mr.columns[2].type != "string" || mr.columns[2].errors != 0 ||
+        mr.kinds.size() != 3 || mr.kinds[1] != ts::FieldKind::Number || mr.kinds[2] != ts::FieldKind::String) {
+      std::cerr << "[FAIL] kinds by file order, run " << run << ": ranges=" << mr.tok.ranges;
+      for (const auto& c : mr.columns) std::cerr << " " << c.name << "=" << c.type << "/" << c.errors;
+      std::cerr << "\n";
+      return 1;
+    }
+  }
+  fs::remove(fm);
+
+  // (4) strict policy aborts the scan, and the tokenizer stops reading.
+  po.policy.on_error = ts::ParsePolicy::OnError::Strict;
+  ts::MetricsRegistry m2;
+  const auto strict = ts::run_pipeline(f.string(), ts::FileFormat::CSV, tok, po, m2);
+  if (strict.tok.ok) { std::cerr << "[FAIL] strict policy did not fail\n"; return 1; }
+
+  const fs::path fs_early = fs::temp_directory_path() / "ts_test_pipeline_early.csv";
+  const int erows = 200000;
+  {
+    std::ofstream out(fs_early, std::ios::binary);
+    out << "id,v\n0,x\noops,x\n";
+    for (int i = 2; i < erows; ++i) out << i << ",x\n";
+  }
+  ts::TokenizeOptions one = tok;
+  one.max_ranges = 1;
+  one.reader.chunk_bytes = 64 * 1024;
+  ts::PipelineOptions small = po;
+  small.batch_rows = 64;
+  small.queue_batches = 1;
+  ts::MetricsRegistry m3;
+  const auto early = ts::run_pipeline(fs_early.string(), ts::FileFormat::CSV, one, small, m3);
+  if (early.tok.ok || early.tok.error.rfind("policy_parse:", 0) != 0 || early.tok.rows >= erows / 2u) {
+    std::cerr << "[FAIL] strict stop: rows=" << early.tok.rows << " error=" << early.tok.error << "\n";
+    return 1;
+  }
+  fs::remove(fs_early);
+
+  // (5) max_errors_per_field fails a non-strict scan only past the cap.
+  const fs::path fcap = fs::temp_directory_path() / "ts_test_pipeline_cap.csv";
+  {
+    std::ofstream out(fcap, std::ios::binary);
+    out << "n,s\n1,a\nbad,b\n2,c\nworse,d\nworst,e\n";
+  }
+  ts::PipelineOptions capped = po;
+  capped.policy.on_error = ts::ParsePolicy::OnError::Null;
+  capped.policy.max_errors_per_field = 2;
+  ts::MetricsRegistry m4;
+  const auto over = ts::run_pipeline(fcap.string(), ts::FileFormat::CSV, one, capped, m4);
+  if (over.tok.ok || over.tok.error.find("field 'n'") == std::string::npos ||
+      over.tok.error.find("max_errors_per_field") == std::string::npos) {
+    std::cerr << "[FAIL] cap 2 of 3 errors: ok=" << over.tok.ok << " error=" << over.tok.error << "\n";
+    return 1;
+  }
+  capped.policy.max_errors_per_field = 3;
+  ts::MetricsRegistry m5;
+  const auto under = ts::run_pipeline(fcap.string(), ts::FileFormat::CSV, one, capped, m5);
+  if (!under.tok.ok || under.columns.empty() || under.columns[0].errors != 3) {
+    std::cerr << "[FAIL] cap 3 of 3 errors: " << under.tok.error << "\n";
+    return 1;
+  }
+  fs::remove(fcap);
+
+  fs::remove(f);
+  std::cout << "[PASS] pipeline ranges=" << res.tok.ranges << " rows=" << res.tok.rows << "\n";
+  return 0;
+}
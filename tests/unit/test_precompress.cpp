@@ -0,0 +1,117 @@
+#include "typed_scanner/precompress.hpp"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef TS_HAVE_ZLIB
+  #define TS_HAVE_ZLIB 0
+#endif
+#ifndef TS_HAVE_ZSTD
+  #define TS_HAVE_ZSTD 0
+#endif
+#if TS_HAVE_ZLIB
+  #include <zlib.h>
+#endif
+#if TS_HAVE_ZSTD
+  #include <zstd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+static int fails = 0;
+static void check(bool ok, const std::string& what) {
+  std::cout << (ok ? "[PASS] " : "[FAIL] ") << what << "\n";
+  if (!ok) ++fails;
+}
+
+static std::string slurp(const fs::path& p) {
+  std::ifstream in(p, std::ios::binary);
+  std::ostringstream ss; ss << in.rdbuf();
+  return ss.str();
+}
+
+int main(){
+  using ts::Encoding;
+  {
+    const auto all = ts::accepted_encodings("gzip, deflate, br, zstd");
+    check(all == std::vector<Encoding>{Encoding::Brotli, Encoding::Zstd, Encoding::Gzip}, "server preference on ties");
+    check(ts::accepted_encodings("gzip;q=1.0, br;q=0.5") == std::vector<Encoding>{Encoding::Gzip, Encoding::Brotli}, "q-values order");
+    check(ts::accepted_encodings("*;q=0.3, br;q=0") == std::vector<Encoding>{Encoding::Zstd, Encoding::Gzip}, "* and q=0");
+    check(ts::accepted_encodings("GZIP").size() == 1, "case-insensitive");
+    check(ts::accepted_encodings("").empty() && ts::accepted_encodings("identity").empty(), "identity only");
+    check(ts::parse_encoding("br") == Encoding::Brotli && !ts::parse_encoding("deflate"), "parse_encoding");
+  }
+
+  std::string text;
+  for (int i = 0; i < 2000; ++i) text += "{\"row\":" + std::to_string(i) + ",\"name\":\"value\"}\n";
+
+#if TS_HAVE_ZLIB
+  {
+    std::string gz;
+    check(ts::compress_buffer(Encoding::Gzip, text, gz) && gz.size() < text.size() / 4, "gzip compresses");
+    std::string back(text.size(), '\0');
+    z_stream zs{};
+    inflateInit2(&zs, 15 + 16);
+    zs.next_in = reinterpret_cast<Bytef*>(gz.data());
+    zs.avail_in = static_cast<uInt>(gz.size());
+    zs.next_out = reinterpret_cast<Bytef*>(back.data());
+    zs.avail_out = static_cast<uInt>(back.size());
+    const int rc = inflate(&zs, Z_FINISH);
+    inflateEnd(&zs);
+    check(rc == Z_STREAM_END && back == text, "gzip round trip");
+  }
+#else
+  std::cout << "[SKIP] gzip (built without zlib)\n";
+#endif
+#if TS_HAVE_ZSTD
+  {
+    std::string zst;
+    check(ts::compress_buffer(Encoding::Zstd, text, zst), "zstd compresses");
+    std::string back(text.size(), '\0');
+    const std::size_t n = ZSTD_decompress(back.data(), back.size(), zst.data(), zst.size());
+    check(!ZSTD_isError(n) && n == text.size() && back == text, "zstd round trip");
+  }
+#else
+  std::cout << "[SKIP] zstd (built without libzstd)\n";
+#endif
+
+  const fs::path dir = fs::temp_directory_path() / "ts_test_precompress";
+  fs::create_directories(dir);
+  const fs::path f = dir / "report.html";
+  std::ofstream(f, std::ios::binary) << text;
+
+  std::vector<Encoding> all(std::begin(ts::kAllEncodings), std::end(ts::kAllEncodings));
+  std::string err;
+  check(ts::precompress_file(f.string(), all, &err), "precompress_file");
+  for (const Encoding e : ts::kAllEncodings) {
+    const fs::path v = f.string() + ts::encoding_suffix(e);
+    const bool have = fs::exists(v);
+    check(have == ts::encoding_available(e), std::string("variant ") + ts::encoding_suffix(e));
+    if (have) {
+      check(fs::file_size(v) < text.size() && !fs::exists(v.string() + ".tmp"), std::string("smaller, no temp ") + ts::encoding_suffix(e));
+      check(fs::last_write_time(v) >= fs::last_write_time(f), std::string("not older than source ") + ts::encoding_suffix(e));
+    }
+  }
+#if TS_HAVE_ZLIB
+  {
+    // Memoized: the same bytes elsewhere give the same variant.
+    const fs::path g = dir / "copy.html";
+    std::ofstream(g, std::ios::binary) << text;
+    check(ts::precompress_file(g.string(), all) &&
+          slurp(g.string() + ".gz") == slurp(f.string() + ".gz"), "memoized output");
+  }
+#endif
+
+  // Dropping an encoding (or shrinking below 1 KiB) removes stale variants.
+  check(ts::precompress_file(f.string(), {Encoding::Gzip}), "gzip only");
+  check(!fs::exists(f.string() + ".br") && !fs::exists(f.string() + ".zst"), "unlisted variants removed");
+  std::ofstream(f, std::ios::binary | std::ios::trunc) << "tiny";
+  check(ts::precompress_file(f.string(), all) && !fs::exists(f.string() + ".gz"), "small files are not compressed");
+
+  check(!ts::precompress_file((dir / "missing").string(), all, &err) && !err.empty(), "missing file");
+  fs::remove_all(dir);
+  return fails == 0 ? 0 : 1;
+}
@@ -0,0 +1,92 @@
+#include "typed_scanner/report_index.hpp"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace fs = std::filesystem;
+
+static int fails = 0;
+static void check(bool ok, const std::string& what) {
+  std::cout << (ok ? "[PASS] " : "[FAIL] ") << what << "\n";
+  if (!ok) ++fails;
+}
+
+static void make_report(const fs::path& root, const std::string& slug, int age_s) {
+  fs::create_directories(root / slug);
+  const fs::path f = root / slug / "report.html";
+  std::ofstream(f) << "<html>" << slug << "</html>";
+  fs::last_write_time(f, fs::file_time_type::clock::now() - std::chrono::seconds(age_s));
+}
+
+int main(){
+  const fs::path root = fs::temp_directory_path() / "ts_test_report_index";
+  fs::remove_all(root);
+
+  ts::ReportIndex missing((root / "nope").string());
+  check(missing.rescan() && missing.size() == 0, "missing root is empty");
+
+  make_report(root, "bravo", 30);
+  make_report(root, "alpha", 10);
+  make_report(root, "charlie", 20);
+  fs::create_directories(root / "no-report");   // a scan that never rendered
+  fs::create_directories(root / ".hidden");
+  std::ofstream(root / ".etags") << "x";
+
+  ts::ReportIndex idx(root.string());
+  check(idx.rescan() && idx.size() == 3, "rescan lists report dirs only");
+
+  ts::ReportIndex::Query q;
+  auto pg = idx.page(q);
+  check(pg.total == 3 && pg.items.size() == 3 && pg.items[0].slug == "alpha" && pg.items[2].slug == "charlie",
+        "sorted by name");
+  q.sort = ts::ReportIndex::Sort::Time;
+  q.desc = true;
+  pg = idx.page(q);
+  check(pg.items[0].slug == "alpha" && pg.items[1].slug == "charlie" && pg.items[2].slug == "bravo",
+        "newest first");
+  q.offset = 1;
+  q.limit = 1;
+  pg = idx.page(q);
+  check(pg.total == 3 && pg.items.size() == 1 && pg.items[0].slug == "charlie", "offset/limit");
+  q.offset = 7;
+  check(idx.page(q).items.empty(), "offset past the end");
+
+  // Incremental updates bump the generation only when something changed.
+  const auto g0 = idx.generation();
+  idx.update("alpha");
+  check(idx.generation() == g0, "unchanged update is a no-op");
+  make_report(root, "delta", 0);
+  idx.update("delta");
+  check(idx.size() == 4 && idx.generation() > g0, "update adds");
+  fs::remove_all(root / "bravo");
+  idx.update("bravo");
+  check(idx.size() == 3, "update drops removed report");
+  idx.update("../etc");
+  idx.update(".hidden");
+  check(idx.size() == 3, "non-slugs ignored");
+
+  // External change picked up by revalidate() via the root mtime.
+  const auto g1 = idx.generation();
+  idx.revalidate();
+  check(idx.generation() == g1, "revalidate without change keeps generation");
+  make_report(root, "echo", 0);
+  fs::last_write_time(root, fs::file_time_type::clock::now() + std::chrono::seconds(5));
+  idx.revalidate();
+  check(idx.size() == 4 && idx.generation() > g1, "revalidate rescans after root change");
+
+  // A directory announced before its report.html waits as pending.
+  fs::create_directories(root / "foxtrot");
+  idx.update("foxtrot");
+  check(idx.size() == 4, "report dir without report.html not listed yet");
+  make_report(root, "foxtrot", 0);
+  idx.recheck_pending();
+  check(idx.size() == 5, "pending dir listed once its report.html appears");
+  const auto g2 = idx.generation();
+  idx.recheck_pending();
+  check(idx.generation() == g2, "listed dir is no longer pending");
+
+  fs::remove_all(root);
+  return fails == 0 ? 0 : 1;
+}
@@ -0,0 +1,112 @@
+#include "typed_scanner/checkpoint.hpp"
+#include "typed_scanner/etag_state.hpp"
+#include "typed_scanner/scan_job.hpp"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace fs = std::filesystem;
+
+static std::string slurp(const fs::path& p) {
+  std::ifstream in(p, std::ios::binary);
+  std::ostringstream ss;
+  ss << in.rdbuf();
+  return ss.str();
+}
+
+static void append(const fs::path& p, int from, int to, const char* tail = "") {
+  std::ofstream out(p, std::ios::binary | std::ios::app);
+  for (int i = from; i < to; ++i) out << i << ",x" << (i % 7) << "\n";
+  out << tail;
+}
+
+int main(){
+  const fs::path dir = fs::temp_directory_path() / "ts_test_resume";
+  fs::remove_all(dir);
+  fs::create_directories(dir);
+  const fs::path data = dir / "grow.csv";
+  { std::ofstream(data, std::ios::binary) << "id,label\n"; }
+  append(data, 0, 1000);
+
+  ts::DatePolicy dp;
+  ts::BoolPolicy bp;
+  ts::ScanOptions opts;
+  opts.artifact_root = (dir / "art").string();
+  opts.pipeline.policy.date_policy = &dp;
+  opts.pipeline.policy.bool_policy = &bp;
+  opts.sync.resume_appends = true;
+
+  auto r1 = ts::scan_file(data.string(), opts);
+  const fs::path slug_dir = dir / "art" / r1.slug;
+  ts::ScanCheckpoint cp;
+  if (!r1.ok() || r1.rows != 1000 || !ts::load_checkpoint((slug_dir / "checkpoint.txt").string(), cp) ||
+      cp.rows != 1000 || cp.offset != fs::file_size(data) || cp.columns.size() != 2) {
+    std::cerr << "[FAIL] first scan rows=" << r1.rows << " " << r1.error << "\n"; return 1;
+  }
+
+  // (1) appended lines are resumed; the unterminated last line waits.
+  append(data, 1000, 1500, "1500,par");
+  const auto r2 = ts::scan_file(data.string(), opts);
+  const std::string run2 = slurp(slug_dir / "run.json");
+  if (!r2.ok() || r2.rows != 1500 ||
+      run2.find("\"resumed_from\":" + std::to_string(cp.offset)) == std::string::npos) {
+    std::cerr << "[FAIL] resume rows=" << r2.rows << " " << r2.error << "\n"; return 1;
+  }
+  if (!ts::load_checkpoint((slug_dir / "checkpoint.txt").string(), cp) || cp.rows != 1500 ||
+      cp.columns[0].count != 1500 || cp.columns[0].max != 1499.0 || cp.columns[0].type != "number") {
+    std::cerr << "[FAIL] merged checkpoint\n"; return 1;
+  }
+
+  // (2) finishing the partial line picks it up.
+  { std::ofstream(data, std::ios::binary | std::ios::app) << "tial\n"; }
+  const auto r3 = ts::scan_file(data.string(), opts);
+  if (!r3.ok() || r3.rows != 1501) { std::cerr << "[FAIL] partial line rows=" << r3.rows << "\n"; return 1; }
+
+  // (3) a rewritten prefix falls back to a full scan.
+  {
+    std::string body = slurp(data);
+    body[body.find("0,x0")] = '9';
+    std::ofstream(data, std::ios::binary | std::ios::trunc) << body;
+  }
+  append(data, 1501, 1600);
+  const auto r4 = ts::scan_file(data.string(), opts);
+  const std::string run4 = slurp(slug_dir / "run.json");
+  if (!r4.ok() || r4.rows != 1600 || run4.find("\"resumed_from\":0") == std::string::npos) {
+    std::cerr << "[FAIL] prefix change rows=" << r4.rows << "\n"; return 1;
+  }
+
+  // (4) with etags on, a resumed file is named by its size and head/tail
+  // blocks instead of a full hash; unchanged, it is skipped.
+  ts::EtagState etags;
+  opts.sync.etags = &etags;
+  append(data, 1600, 1700);
+  const auto r5 = ts::scan_file(data.string(), opts);
+  const auto e5 = etags.get(r5.slug);
+  if (!r5.ok() || r5.rows != 1700 || !e5 || e5->rfind("append-", 0) != 0) {
+    std::cerr << "[FAIL] append etag rows=" << r5.rows << " etag=" << e5.value_or("") << "\n"; return 1;
+  }
+  const auto r6 = ts::scan_file(data.string(), opts);
+  if (r6.status != ts::ScanResult::Status::Skipped) { std::cerr << "[FAIL] unchanged resumed file rescanned\n"; return 1; }
+  append(data, 1700, 1701);
+  const auto r7 = ts::scan_file(data.string(), opts);
+  if (!r7.ok() || r7.rows != 1701 || etags.get(r7.slug) == e5) {
+    std::cerr << "[FAIL] grown file after append etag rows=" << r7.rows << "\n"; return 1;
+  }
+
+  // (5) a full scan keeps an unterminated last line and leaves no
+  // checkpoint (its rows would count that line twice on resume).
+  opts.sync.etags = nullptr;
+  const fs::path open_end = dir / "open.csv";
+  { std::ofstream(open_end, std::ios::binary) << "id,label\n"; }
+  append(open_end, 0, 10, "10,last");
+  const auto r8 = ts::scan_file(open_end.string(), opts);
+  if (!r8.ok() || r8.rows != 11 || fs::exists(dir / "art" / r8.slug / "checkpoint.txt")) {
+    std::cerr << "[FAIL] unterminated full scan rows=" << r8.rows << "\n"; return 1;
+  }
+
+  fs::remove_all(dir);
+  std::cout << "[PASS] resume rows=" << r7.rows << "\n";
+  return 0;
+}
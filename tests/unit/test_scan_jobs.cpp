@@ -0,0 +1,245 @@
+#include "typed_scanner/etag_state.hpp"
+#include "typed_scanner/scan_jobs.hpp"
+#include "typed_scanner/task_pool.hpp"
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+static int fails = 0;
+static void check(bool ok, const std::string& what) {
+  std::cout << (ok ? "[PASS] " : "[FAIL] ") << what << "\n";
+  if (!ok) ++fails;
+}
+
+static bool wait_state(ts::ScanJobs& jobs, std::uint64_t id, ts::ScanJobState want) {
+  for (int i = 0; i < 2000; ++i) {
+    ts::ScanJobInfo j;
+    if (jobs.get(id, j) && j.state == want) return true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return false;
+}
+
+int main(){
+  std::signal(SIGPIPE, SIG_IGN); // the cancelled FIFO reader may close first
+  const fs::path root = fs::temp_directory_path() / ("ts_scan_jobs_" + std::to_string(::getpid()));
+  fs::remove_all(root);
+  fs::create_directories(root / "in");
+  const std::string csv = (root / "in" / "small.csv").string();
+  {
+    std::ofstream f(csv);
+    f << "id,name\n";
+    for (int i = 0; i < 100; ++i) f << i << ",n" << i << "\n";
+  }
+
+  ts::TaskPool::Config pcfg;
+  pcfg.threads = 2;
+  ts::TaskPool pool(pcfg);
+
+  ts::ScanOptions base;
+  base.artifact_root = (root / "out").string();
+  base.sniff = false;
+  base.report.precompress.clear();
+
+  // --- a local path and an upload run to completion
+  {
+    ts::EtagState etags;
+    const std::string etag_file = (root / "out" / ".etags").string();
+    etags.load(etag_file);
+    ts::ScanOptions synced = base;
+    synced.sync.etags = &etags;
+    ts::ScanJobs::Config cfg;
+    ts::ScanJobs jobs(cfg, synced, {}, &pool);
+
+    ts::ScanJobInfo a;
+    ts::ScanJobs::Request ra;
+    ra.path = csv;
+    check(jobs.submit(ra, &a) == ts::ScanJobs::Submit::Ok && a.id != 0 && a.slug == ts::make_scan_slug(csv, base.slug_mode, base.slug_len),
+          "path job accepted with its report slug");
+
+    int fd = -1;
+    std::string spool;
+    check(jobs.create_spool("upload.csv", fd, spool) && spool.size() > 4 && spool.substr(spool.size() - 4) == ".csv",
+          "spool file keeps the upload's extension");
+    const std::string body = "x,y\n1,2\n3,4\n";
+    check(::write(fd, body.data(), body.size()) == static_cast<ssize_t>(body.size()), "spool written");
+    ::close(fd);
+    ts::ScanJobInfo b;
+    ts::ScanJobs::Request rb;
+    rb.path = spool;
+    rb.name = "upload.csv";
+    rb.bytes = body.size();
+    rb.spooled = true;
+    check(jobs.submit(rb, &b) == ts::ScanJobs::Submit::Ok && b.name == "upload.csv", "upload accepted");
+
+    jobs.wait_idle();
+    ts::ScanJobInfo ja, jb;
+    check(jobs.get(a.id, ja) && ja.state == ts::ScanJobState::Done && ja.rows == 100, "path job done with its rows");
+    check(jobs.get(b.id, jb) && jb.state == ts::ScanJobState::Done && jb.rows == 2, "upload job done with its rows");
+    check(fs::exists(fs::path(base.artifact_root) / a.slug / "run.json") &&
+          fs::exists(fs::path(base.artifact_root) / b.slug / "run.json"), "reports written");
+    check(!fs::exists(spool), "spool file removed after the scan");
+    check(etags.get(a.slug).has_value() && fs::exists(etag_file), "etags flushed once the queue drained");
+    const auto all = jobs.list();
+    check(all.size() == 2 && all[0].id == b.id, "list() is newest first");
+
+    // A stream job reads the pipe while it is being written; the writer
+    // blocks whenever the pipe is full.
+    int fds[2];
+    check(::pipe2(fds, O_CLOEXEC) == 0, "pipe created");
+    ts::ScanJobs::Request rs;
+    rs.path = "/dev/fd/" + std::to_string(fds[0]);
+    rs.name = "stream.csv";
+    rs.stream_fd = fds[0];
+    rs.format = ts::FileFormat::CSV;
+    ts::ScanJobInfo s;
+    check(jobs.submit(rs, &s) == ts::ScanJobs::Submit::Ok && s.slug == ts::make_scan_slug("stream.csv", base.slug_mode, base.slug_len),
+          "stream job started under the upload's slug");
+    std::string block = "a,b\n";
+    for (int i = 0; i < 4096; ++i) block += std::to_string(i) + ",xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx\n";
+    bool wrote = ::write(fds[1], block.data(), 4) == 4; // header once
+    for (int round = 0; round < 64 && wrote; ++round) { // ~12 MiB, far above the pipe buffer
+      const char* d = block.data() + 4;
+      std::size_t n = block.size() - 4;
+      while (n > 0) {
+        const ssize_t w = ::write(fds[1], d, n);
+        if (w <= 0) { wrote = false; break; }
+        d += w;
+        n -= static_cast<std::size_t>(w);
+      }
+    }
+    ::close(fds[1]);
+    ts::ScanJobInfo js;
+    check(wrote && jobs.wait(s.id, js) && js.state == ts::ScanJobState::Done && js.rows == 64u * 4096u,
+          "stream job sees every row written to the pipe");
+    check(js.name == "stream.csv" && fs::exists(fs::path(base.artifact_root) / s.slug / "run.json"), "stream report written");
+    check(::fcntl(fds[0], F_GETFD) == -1 && errno == EBADF, "stream job closed its read end");
+
+    ts::ScanJobs::Request bad;
+    bad.path = (root / "in" / "missing.csv").string();
+    std::string err;
+    check(jobs.submit(bad, nullptr, &err) == ts::ScanJobs::Submit::Invalid && !err.empty(), "missing file is invalid");
+  }
+
+  // --- budget, queued cancel, running cancel (a FIFO holds the scan open)
+  {
+    const std::string fifo = (root / "in" / "slow.csv").string();
+    check(::mkfifo(fifo.c_str(), 0600) == 0, "fifo created");
+    ts::ScanJobs::Config cfg;
+    cfg.scheduler.max_parallel = 1;
+    cfg.scheduler.max_inflight_bytes = 100;
+    cfg.history = 2;
+    ts::ScanJobs jobs(cfg, base, {}, &pool);
+
+    ts::ScanJobInfo a;
+    ts::ScanJobs::Request ra;
+    ra.path = fifo;
+    ra.bytes = 80;
+    ra.format = ts::FileFormat::CSV;
+    check(jobs.submit(ra, &a) == ts::ScanJobs::Submit::Ok, "fifo job accepted");
+    check(wait_state(jobs, a.id, ts::ScanJobState::Running), "fifo job running");
+
+    ts::ScanJobs::Request rb;
+    rb.path = csv;
+    check(!jobs.admits(30) && jobs.submit(rb) == ts::ScanJobs::Submit::Busy, "over budget: Busy");
+    int sfd[2];
+    check(::pipe2(sfd, O_CLOEXEC) == 0, "second pipe created");
+    ts::ScanJobs::Request rs;
+    rs.path = "/dev/fd/" + std::to_string(sfd[0]);
+    rs.stream_fd = sfd[0];
+    rs.check_budget = false;
+    check(jobs.submit(rs) == ts::ScanJobs::Submit::Busy && ::fcntl(sfd[0], F_GETFD) == -1,
+          "stream job without a free slot: Busy, never queued, fd closed");
+    ::close(sfd[1]);
+    rb.check_budget = false;
+    ts::ScanJobInfo b;
+    check(jobs.submit(rb, &b) == ts::ScanJobs::Submit::Ok && b.state == ts::ScanJobState::Queued,
+          "watcher-style submit bypasses the budget");
+    check(jobs.cancel(b.id) && wait_state(jobs, b.id, ts::ScanJobState::Cancelled), "queued job cancelled at once");
+    check(!jobs.cancel(b.id), "finished job cannot be cancelled again");
+
+    check(jobs.cancel(a.id), "running job flagged");
+    {
+      std::ofstream w(fifo); // unblocks the reader's open()
+      for (int i = 0; i < 1000; ++i) w << i << ",v\n";
+    }
+    jobs.wait_idle();
+    ts::ScanJobInfo ja;
+    check(jobs.get(a.id, ja) && ja.state == ts::ScanJobState::Cancelled && ja.error == "cancelled",
+          "running job stops as cancelled");
+    check(!fs::exists(fs::path(base.artifact_root) / a.slug / "run.json"), "cancelled scan writes no report");
+    check(jobs.admits(1000), "idle queue admits anything");
+
+    ts::ScanJobs::Request rc;
+    rc.path = csv;
+    ts::ScanJobInfo c;
+    check(jobs.submit(rc, &c) == ts::ScanJobs::Submit::Ok, "accepted after the queue drained");
+    jobs.wait_idle();
+    ts::ScanJobInfo gone;
+    check(!jobs.get(b.id, gone) && jobs.list().size() == 2, "history keeps the newest finished jobs");
+    jobs.shutdown();
+    check(jobs.submit(rc) == ts::ScanJobs::Submit::Invalid, "submit after shutdown is invalid");
+  }
+
+  // --- a stream job needs a worker, not just a slot: with the pool busy
+  // it is Busy instead of leaving the writer blocked on the pipe, and it
+  // gives its slot back at once.
+  {
+    ts::TaskPool::Config one;
+    one.threads = 1;
+    ts::TaskPool busy_pool(one);
+    std::atomic<bool> release{false};
+    busy_pool.submit([&]{ while (!release.load()) std::this_thread::sleep_for(std::chrono::milliseconds(1)); });
+    ts::ScanJobs::Config cfg;
+    cfg.scheduler.max_parallel = 1;
+    cfg.stream_start_ms = 50;
+    ts::ScanJobs jobs(cfg, base, {}, &busy_pool);
+    auto stream_req = [](int fd) {
+      ts::ScanJobs::Request rs;
+      rs.path = "/dev/fd/" + std::to_string(fd);
+      rs.stream_fd = fd;
+      rs.format = ts::FileFormat::CSV;
+      return rs;
+    };
+    int fds[2];
+    check(::pipe2(fds, O_CLOEXEC) == 0, "third pipe created");
+    ts::ScanJobInfo late;
+    std::string err;
+    check(jobs.submit(stream_req(fds[0]), &late, &err) == ts::ScanJobs::Submit::Busy && !err.empty(),
+          "stream job with no free worker: Busy");
+    ts::ScanJobInfo jl;
+    check(jobs.get(late.id, jl) && jl.state == ts::ScanJobState::Cancelled, "refused stream listed as cancelled");
+    check(::fcntl(fds[0], F_GETFD) == -1 && errno == EBADF, "refused stream closed its read end at once");
+    ::close(fds[1]);
+
+    // The slot is free again: still no worker, but not "no free scan slot".
+    check(::pipe2(fds, O_CLOEXEC) == 0, "fourth pipe created");
+    err.clear();
+    check(jobs.submit(stream_req(fds[0]), nullptr, &err) == ts::ScanJobs::Submit::Busy &&
+          err.find("max_parallel") == std::string::npos, "refused stream released its slot");
+    ::close(fds[1]);
+
+    release.store(true);
+    check(::pipe2(fds, O_CLOEXEC) == 0, "fifth pipe created");
+    ts::ScanJobInfo next;
+    check(jobs.submit(stream_req(fds[0]), &next) == ts::ScanJobs::Submit::Ok, "next stream starts once a worker is free");
+    const std::string body = "a,b\n1,2\n3,4\n";
+    check(::write(fds[1], body.data(), body.size()) == static_cast<ssize_t>(body.size()), "stream written");
+    ::close(fds[1]);
+    check(jobs.wait(next.id, next) && next.state == ts::ScanJobState::Done && next.rows == 2, "next stream done");
+  }
+
+  fs::remove_all(root);
+  return fails == 0 ? 0 : 1;
+}
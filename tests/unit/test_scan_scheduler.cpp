@@ -0,0 +1,148 @@
+#include "typed_scanner/scan_scheduler.hpp"
+#include "typed_scanner/task_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+int main(){
+  bool ok = true;
+  ts::TaskPool::Config pcfg;
+  pcfg.threads = 4;
+  ts::TaskPool pool(pcfg);
+
+  // Budget: never more than 100 bytes in flight; the 500-byte file runs alone.
+  {
+    std::atomic<std::uint64_t> inflight{0}, peak{0};
+    std::atomic<int> running{0};
+    bool alone = true;
+    std::mutex mu;
+    std::vector<std::string> done;
+
+    ts::ScanScheduler::Config cfg;
+    cfg.max_parallel = 4;
+    cfg.max_inflight_bytes = 100;
+    ts::ScanScheduler sched(cfg, [&](const std::string& path){
+      const std::uint64_t sz = std::stoull(path);
+      const auto now = inflight += sz;
+      const int r = ++running;
+      std::uint64_t p = peak.load();
+      while (now > p && !peak.compare_exchange_weak(p, now)) {}
+      if (sz > cfg.max_inflight_bytes && r != 1) alone = false;
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+      --running;
+      inflight -= sz;
+      ts::ScanResult res;
+      res.path = path;
+      return res;
+    }, [&](const ts::ScanResult& r){
+      std::lock_guard<std::mutex> lk(mu);
+      done.push_back(r.path);
+    }, &pool);
+
+    for (int i = 0; i < 20; ++i) sched.submit(std::to_string(10 + i), 10 + i);
+    sched.submit("500", 500);
+    sched.wait_idle();
+
+    const auto st = sched.stats();
+    if (done.size() != 21 || st.completed != 21) { std::cerr << "[FAIL] completed=" << st.completed << "\n"; ok = false; }
+    if (!alone) { std::cerr << "[FAIL] oversize file shared the budget\n"; ok = false; }
+    // Only the lone oversize file may exceed the budget.
+    if (peak.load() > 500 || st.peak_inflight_bytes > 500) { std::cerr << "[FAIL] peak=" << peak.load() << "\n"; ok = false; }
+    if (st.peak_running < 2) { std::cerr << "[FAIL] never ran in parallel\n"; ok = false; }
+  }
+
+  // One worker: largest first.
+  {
+    std::vector<std::string> order;
+    std::atomic<bool> gate{false}, started{false};
+    ts::ScanScheduler::Config cfg;
+    cfg.max_parallel = 1;
+    ts::ScanScheduler sched(cfg, [&](const std::string& path){
+      started = true;
+      while (!gate.load()) std::this_thread::yield(); // hold until all submitted
+      order.push_back(path);
+      ts::ScanResult res;
+      res.path = path;
+      return res;
+    }, {}, &pool);
+    sched.submit("first", 1);
+    while (!started.load()) std::this_thread::yield();
+    sched.submit("small", 5);
+    sched.submit("big", 500);
+    sched.submit("mid", 50);
+    gate = true;
+    sched.wait_idle();
+    const std::vector<std::string> want{"first", "big", "mid", "small"};
+    if (order != want) { std::cerr << "[FAIL] order\n"; ok = false; }
+  }
+
+  // Tickets: a queued file can be cancelled, a running one cannot.
+  {
+    std::atomic<bool> gate{false}, started{false};
+    std::vector<std::uint64_t> seen;
+    ts::ScanScheduler::Config cfg;
+    cfg.max_parallel = 1;
+    ts::ScanScheduler sched(cfg, [&](const std::string& path, ts::ScanScheduler::Ticket t){
+      started = true;
+      while (!gate.load()) std::this_thread::yield();
+      seen.push_back(t);
+      ts::ScanResult res;
+      res.path = path;
+      return res;
+    }, {}, &pool);
+    const auto a = sched.submit("a", 10);
+    while (!started.load()) std::this_thread::yield();
+    const auto b = sched.submit("b", 20);
+    const auto c = sched.submit("c", 30);
+    if (a == 0 || a == b || b == c) { std::cerr << "[FAIL] tickets\n"; ok = false; }
+    if (sched.queued_bytes() != 60) { std::cerr << "[FAIL] queued_bytes=" << sched.queued_bytes() << "\n"; ok = false; }
+    if (sched.cancel(a) || !sched.cancel(b) || sched.cancel(b)) { std::cerr << "[FAIL] cancel\n"; ok = false; }
+    if (sched.try_start("d", 1) != 0) { std::cerr << "[FAIL] try_start without a free slot\n"; ok = false; }
+    gate = true;
+    sched.wait_idle();
+    const std::vector<std::uint64_t> want{a, c};
+    if (seen != want || sched.stats().cancelled != 1) { std::cerr << "[FAIL] cancelled file ran\n"; ok = false; }
+    if (sched.queued_bytes() != 0) { std::cerr << "[FAIL] bytes left queued\n"; ok = false; }
+    const auto e = sched.try_start("e", 1000);
+    sched.wait_idle();
+    if (e == 0 || seen.back() != e) { std::cerr << "[FAIL] try_start on an idle scheduler\n"; ok = false; }
+    sched.shutdown();
+    if (sched.submit("late", 1) != 0) { std::cerr << "[FAIL] submit after shutdown\n"; ok = false; }
+  }
+
+  // A started file whose pool task has not begun can still be cancelled;
+  // its slot and bytes come back at once and it never scans.
+  {
+    ts::TaskPool::Config one;
+    one.threads = 1;
+    ts::TaskPool busy(one);
+    std::atomic<bool> release{false};
+    busy.submit([&]{ while (!release.load()) std::this_thread::yield(); });
+    std::atomic<int> scans{0};
+    ts::ScanScheduler::Config cfg;
+    cfg.max_parallel = 1;
+    ts::ScanScheduler sched(cfg, [&](const std::string& path){
+      ++scans;
+      ts::ScanResult res;
+      res.path = path;
+      return res;
+    }, {}, &busy);
+    const auto t = sched.try_start("waiting", 50);
+    if (t == 0 || !sched.cancel(t) || sched.queued_bytes() != 0) { std::cerr << "[FAIL] cancel before a worker\n"; ok = false; }
+    const auto u = sched.try_start("next", 5);
+    release = true;
+    sched.wait_idle();
+    if (u == 0 || scans.load() != 1 || sched.stats().cancelled != 1) {
+      std::cerr << "[FAIL] slot after cancel scans=" << scans.load() << "\n"; ok = false;
+    }
+  }
+
+  if (!ok) return 1;
+  std::cout << "[PASS] scan scheduler budget + largest-first ordering + cancel + try_start\n";
+  return 0;
+}
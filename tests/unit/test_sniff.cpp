@@ -0,0 +1,126 @@
+#include "typed_scanner/arena.hpp"
+#include "typed_scanner/chunk_reader.hpp"
+#include "typed_scanner/record_view.hpp"
+#include "typed_scanner/sniff.hpp"
+#include "typed_scanner/token_csv_fsm.hpp"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static int fails = 0;
+static void check(bool ok, const std::string& what) {
+  std::cout << (ok ? "[PASS] " : "[FAIL] ") << what << "\n";
+  if (!ok) ++fails;
+}
+
+static std::string table(char delim, int rows, const char* eol = "\n") {
+  std::string s = std::string("id") + delim + "name" + delim + "score" + eol;
+  for (int i = 0; i < rows; ++i) {
+    s += std::to_string(i) + delim + "n" + std::to_string(i % 7) + delim + std::to_string(i * 1.5) + eol;
+  }
+  return s;
+}
+
+// Fields of every line through the CSV tokenizer.
+static std::vector<std::vector<std::string>> parse(const std::string& text, const ts::CsvConfig& cfg) {
+  ts::Arena ha(4096), ra(1 << 16);
+  ts::CsvFsm fsm(cfg, ha, ra);
+  std::vector<std::vector<std::string>> rows;
+  std::size_t b = 0;
+  while (b < text.size()) {
+    std::size_t e = text.find('\n', b);
+    if (e == std::string::npos) e = text.size();
+    (void)fsm.feed(std::string_view(text).substr(b, e - b), [&](const ts::RecordView& rv){
+      std::vector<std::string> f;
+      for (std::size_t i = 0; i < rv.size(); ++i) f.emplace_back(rv.at(i));
+      rows.push_back(std::move(f));
+    });
+    b = e + 1;
+  }
+  return rows;
+}
+
+int main(){
+  for (const char d : {',', '\t', '|', ';'}) {
+    const ts::Dialect dl = ts::sniff_dialect(table(d, 50), true);
+    check(dl.format == ts::FileFormat::CSV && dl.delimiter == d && dl.header && dl.confidence == 1.0,
+          std::string("delimiter ") + (d == '\t' ? "\\t" : std::string(1, d)));
+  }
+  {
+    // Commas inside quotes do not count; ';' splits every line the same way.
+    const std::string s = "city;note\n\"Paris\";\"a, b, c\"\n\"Rome\";\"x\"\n\"Oslo\";\"y, z\"\n";
+    const ts::Dialect dl = ts::sniff_dialect(s, true);
+    check(dl.delimiter == ';' && dl.quote == '"', "quoted delimiters ignored");
+  }
+  {
+    const ts::Dialect dl = ts::sniff_dialect("'a b'|'c'\n'd'|'e f'\n'g'|'h'\n", true, true);
+    check(dl.delimiter == '|' && dl.quote == '\'', "single-quote dialect");
+  }
+  {
+    const ts::Dialect no_hdr = ts::sniff_dialect("1,2.5,3\n4,5,6\n7,8,9\n", true);
+    check(!no_hdr.header, "numeric first row is data");
+    const ts::Dialect names = ts::sniff_dialect("a,b\nx,y\nz,w\n", true);
+    check(names.header, "distinct text over text is a header");
+    const ts::Dialect repeat = ts::sniff_dialect("a,b\na,y\nz,w\n", true);
+    check(!repeat.header, "a repeated first row is data");
+    check(ts::sniff_dialect("a,b\n", true, false).header == false, "one row uses the fallback");
+  }
+  {
+    const ts::Dialect bom = ts::sniff_dialect("\xEF\xBB\xBF" + table(',', 5, "\r\n"), true);
+    check(bom.bom && bom.line_ending == "crlf" && bom.header, "BOM + CRLF");
+    check(ts::sniff_dialect("a,b\r\n1,2\n", true).line_ending == "mixed", "mixed line endings");
+    check(ts::sniff_dialect("a,b\r1,2\r3,4\r", true).line_ending == "cr", "CR line endings");
+  }
+  {
+    const ts::Dialect j = ts::sniff_dialect("{\"a\":1}\n{\"a\":2}\n\n{\"a\":3}\n", true);
+    check(j.format == ts::FileFormat::JSONL && j.confidence == 1.0, "jsonl");
+    const ts::Dialect half = ts::sniff_dialect("{\"a\":1}\nnot json\n", true);
+    check(half.format == ts::FileFormat::JSONL && half.confidence < ts::kSniffMinConfidence, "broken jsonl is not confident");
+  }
+  {
+    // Prose and binary are not confidently anything.
+    check(ts::sniff_dialect("just some words\nand more words\n", true).confidence < ts::kSniffMinConfidence, "one column");
+    check(ts::sniff_dialect(std::string("ab\0cd\n", 6), true).format == ts::FileFormat::Unknown, "binary");
+    // The partial last line of a sample is not judged.
+    const ts::Dialect cut = ts::sniff_dialect("a,b\n1,2\n3,4\n5", false);
+    check(cut.confidence == 1.0, "partial last line ignored");
+  }
+  {
+    ts::CsvConfig cfg;
+    ts::Dialect dl;
+    dl.delimiter = '\t';
+    dl.quote = '\'';
+    dl.header = false;
+    ts::apply_dialect(dl, cfg);
+    check(cfg.delimiter == '\t' && cfg.quote == '\'' && cfg.escape == '\'' && !cfg.header, "apply_dialect");
+  }
+  {
+    // The memchr fast path and the quoted FSM split alike.
+    ts::CsvConfig cfg;
+    cfg.header = false;
+    const auto rows = parse("a,,b\n\"a\",\"\",\"b\"\n,\n", cfg);
+    check(rows.size() == 3 && rows[0] == rows[1] && rows[0] == std::vector<std::string>{"a", "", "b"} &&
+          rows[2] == std::vector<std::string>{"", ""}, "fast path matches FSM");
+  }
+  {
+    const auto dir = std::filesystem::temp_directory_path() / "ts_test_sniff";
+    std::filesystem::create_directories(dir);
+    const std::string path = (dir / "data.txt").string();
+    { std::ofstream(path, std::ios::binary) << "\xEF\xBB\xBF" << table('\t', 3000); }
+    ts::Dialect dl;
+    std::string err;
+    check(ts::sniff_file(path, dl, true, &err) && dl.format == ts::FileFormat::CSV &&
+          dl.delimiter == '\t' && dl.bom && dl.confidence == 1.0, "sniff_file samples the head");
+
+    // ChunkReader drops the BOM, so the header's first name is clean.
+    ts::ChunkReader r(path);
+    std::string first;
+    (void)r.for_each_line([&](std::string_view l){ if (first.empty()) first.assign(l); });
+    check(first.rfind("id\t", 0) == 0, "BOM stripped from the first line");
+    check(!ts::sniff_file((dir / "missing").string(), dl, true, &err) && !err.empty(), "missing file");
+    std::filesystem::remove_all(dir);
+  }
+  return fails == 0 ? 0 : 1;
+}
@@ -0,0 +1,114 @@
+#include "typed_scanner/chunk_reader.hpp"
+#include "typed_scanner/path_utils.hpp"
+#include "typed_scanner/tokenize.hpp"
+#include <algorithm>
+#include <csignal>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#ifndef TS_HAVE_ZLIB
+  #define TS_HAVE_ZLIB 0
+#endif
+#if TS_HAVE_ZLIB
+  #include <zlib.h>
+#endif
+
+static int fails = 0;
+static void check(bool ok, const std::string& what) {
+  std::cout << (ok ? "[PASS] " : "[FAIL] ") << what << "\n";
+  if (!ok) ++fails;
+}
+
+// A pipe fed by a writer thread, read through /dev/fd/N like `--scan=<(cmd)`.
+struct Pipe {
+  int fd[2] = {-1, -1};
+  std::thread writer;
+  explicit Pipe(std::string bytes) {
+    if (::pipe(fd) != 0) return;
+    writer = std::thread([this, bytes = std::move(bytes)]{
+      for (std::size_t off = 0; off < bytes.size();) {
+        const ssize_t n = ::write(fd[1], bytes.data() + off, std::min<std::size_t>(bytes.size() - off, 4093));
+        if (n <= 0) break;
+        off += static_cast<std::size_t>(n);
+      }
+      ::close(fd[1]);
+    });
+  }
+  ~Pipe() {
+    ::close(fd[0]); // a reader that stopped early must not leave the writer blocked
+    if (writer.joinable()) writer.join();
+  }
+  std::string path() const { return "/dev/fd/" + std::to_string(fd[0]); }
+};
+
+static std::string sample(int rows) {
+  std::string s = "id,name\n";
+  for (int i = 0; i < rows; ++i) s += std::to_string(i) + ",n" + std::to_string(i % 7) + "\n";
+  return s;
+}
+
+int main(){
+  std::signal(SIGPIPE, SIG_IGN);
+  check(ts::sniff_format("{\"a\":1}") == ts::FileFormat::JSONL, "sniff jsonl");
+  check(ts::sniff_format("\xEF\xBB\xBF  {\"a\":1}") == ts::FileFormat::JSONL, "sniff jsonl after BOM");
+  check(ts::sniff_format("a,b,c") == ts::FileFormat::CSV, "sniff csv");
+  check(ts::sniff_format(" \r") == ts::FileFormat::Unknown, "sniff blank");
+  check(ts::parse_format("ndjson") == ts::FileFormat::JSONL && ts::parse_format("xml") == ts::FileFormat::Unknown,
+        "parse --format");
+  check(ts::is_stream_path("-") && !ts::is_stream_path("tests/unit/test_stream_input.cpp"), "stream paths");
+
+  const std::string data = sample(20000);
+  {
+    Pipe p(data);
+    check(ts::is_stream_path(p.path()), "pipe is a stream");
+    ts::ChunkReader::Config cfg;
+    cfg.chunk_bytes = 1000;
+    ts::ChunkReader r(p.path(), cfg);
+    std::uint64_t lines = 0;
+    const bool ok = r.for_each_line([&](std::string_view){ ++lines; });
+    check(ok && lines == 20001 && r.bytes_read() == data.size(), "plain pipe read to EOF");
+  }
+  {
+    Pipe p(data);
+    ts::ChunkReader::Config cfg;
+    cfg.begin_offset = 10;
+    ts::ChunkReader r(p.path(), cfg);
+    check(!r.for_each_line([](std::string_view){}) && !r.error().empty(), "pipe rejects byte ranges");
+  }
+  {
+    // Format and size come from the stream itself.
+    Pipe p("\n{\"a\":1,\"b\":\"x\"}\n{\"a\":2,\"b\":\"y\"}\n");
+    const ts::TokenizeStats st = ts::tokenize_file(p.path(), ts::FileFormat::Unknown, {});
+    check(st.ok && st.rows == 2 && st.format == ts::FileFormat::JSONL && st.ranges == 1, "jsonl sniffed from pipe");
+  }
+  {
+    const std::string probe = "tests/unit/test_stream_input.cpp";
+    const ts::TokenizeStats st = ts::tokenize_file(probe, ts::FileFormat::Unknown, {});
+    check(!st.ok, "regular files are not sniffed");
+  }
+#if TS_HAVE_ZLIB
+  {
+    std::string gz(compressBound(static_cast<uLong>(data.size())) + 64, '\0');
+    z_stream zs{};
+    deflateInit2(&zs, 6, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    zs.avail_in = static_cast<uInt>(data.size());
+    zs.next_out = reinterpret_cast<Bytef*>(gz.data());
+    zs.avail_out = static_cast<uInt>(gz.size());
+    deflate(&zs, Z_FINISH);
+    gz.resize(zs.total_out);
+    deflateEnd(&zs);
+
+    Pipe p(gz);
+    const ts::TokenizeStats st = ts::tokenize_file(p.path(), ts::FileFormat::Unknown, {});
+    check(st.ok && st.rows == 20000 && st.compression == ts::Compression::Gzip &&
+          st.bytes == data.size() && st.raw_bytes == gz.size(), "gzip pipe: magic replayed, sizes counted");
+  }
+#else
+  std::cout << "[SKIP] gzip pipe (built without zlib)\n";
+#endif
+  return fails == 0 ? 0 : 1;
+}
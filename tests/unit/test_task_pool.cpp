@@ -0,0 +1,101 @@
+#include "typed_scanner/task_pool.hpp"
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// Recursive fork/join: every level waits on a worker, exercising helping.
+static std::uint64_t fib(ts::TaskPool& pool, int n) {
+  if (n < 12) { return n < 2 ? n : fib(pool, n - 1) + fib(pool, n - 2); }
+  std::uint64_t a = 0, b = 0;
+  ts::TaskGroup g(pool);
+  g.run([&]{ a = fib(pool, n - 1); });
+  b = fib(pool, n - 2);
+  g.wait();
+  return a + b;
+}
+
+int main(){
+  bool ok = true;
+  ts::TaskPool::Config cfg;
+  cfg.threads = 4;
+  ts::TaskPool pool(cfg);
+  if (pool.size() != 4) { std::cerr << "[FAIL] size=" << pool.size() << "\n"; ok = false; }
+  if (pool.worker_index() != -1) { std::cerr << "[FAIL] main is not a worker\n"; ok = false; }
+
+  // parallel_for covers each index exactly once.
+  std::vector<std::atomic<int>> hits(10000);
+  ts::parallel_for(pool, hits.size(), [&](std::size_t i){ hits[i].fetch_add(1); });
+  for (auto& h : hits) if (h.load() != 1) { std::cerr << "[FAIL] parallel_for coverage\n"; ok = false; break; }
+
+  // Nested groups (deque growth + stealing).
+  const std::uint64_t f = fib(pool, 25);
+  if (f != 75025) { std::cerr << "[FAIL] fib(25)=" << f << "\n"; ok = false; }
+
+  // Concurrent external submitters.
+  std::atomic<int> sum{0};
+  {
+    std::vector<std::thread> ext;
+    for (int t = 0; t < 3; ++t) {
+      ext.emplace_back([&]{
+        for (int i = 0; i < 1000; ++i) pool.submit([&]{ sum.fetch_add(1); });
+      });
+    }
+    for (auto& t : ext) t.join();
+  }
+  // Plain submits have no join handle: drain by helping.
+  while (sum.load() != 3000) { if (!pool.try_run_one()) std::this_thread::yield(); }
+
+  // A waiter runs its own group's tasks, never unrelated pool work.
+  {
+    ts::TaskPool::Config one;
+    one.threads = 1;
+    ts::TaskPool p1(one);
+    std::atomic<bool> release{false}, other_done{false};
+    std::thread::id other_on;
+    p1.submit([&]{ while (!release.load()) std::this_thread::yield(); }); // holds the only worker
+    p1.submit([&]{ other_on = std::this_thread::get_id(); other_done.store(true); });
+    ts::TaskGroup g(p1);
+    g.run([&]{ release.store(true); });
+    g.wait();
+    while (!other_done.load()) std::this_thread::yield();
+    if (other_on == std::this_thread::get_id()) { std::cerr << "[FAIL] wait ran an unrelated task\n"; ok = false; }
+  }
+
+  // SerialTask: concurrent schedule()/help() never overlap passes, and the
+  // last schedule() is always followed by a pass that sees its work.
+  {
+    std::atomic<int> produced{0}, inside{0};
+    int consumed = 0;
+    bool overlap = false;
+    ts::TaskGroup g(pool);
+    ts::SerialTask st(g, [&]{
+      if (inside.fetch_add(1) != 0) overlap = true;
+      consumed = produced.load();
+      inside.fetch_sub(1);
+      return consumed == 3000;
+    });
+    std::vector<std::thread> ext;
+    for (int t = 0; t < 3; ++t) {
+      ext.emplace_back([&, t]{
+        for (int i = 0; i < 1000; ++i) {
+          produced.fetch_add(1);
+          if ((i + t) % 7 == 0) (void)st.help();
+          else st.schedule();
+        }
+        st.schedule();
+      });
+    }
+    for (auto& t : ext) t.join();
+    g.wait();
+    if (overlap || !st.finished() || consumed != 3000) {
+      std::cerr << "[FAIL] serial task overlap=" << overlap << " consumed=" << consumed << "\n";
+      ok = false;
+    }
+  }
+
+  if (!ok) return 1;
+  std::cout << "[PASS] task pool parallel_for, nested groups, external submit, group-only waits, serial tasks\n";
+  return 0;
+}
@@ -0,0 +1,75 @@
+#include "typed_scanner/mustache_renderer.hpp"
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static int fails = 0;
+static void check(bool ok, const std::string& what) {
+  std::cout << (ok ? "[PASS] " : "[FAIL] ") << what << "\n";
+  if (!ok) ++fails;
+}
+
+static void write(const fs::path& p, const std::string& body) {
+  std::ofstream(p, std::ios::binary | std::ios::trunc) << body;
+}
+
+int main(){
+  const fs::path dir = fs::temp_directory_path() / "ts_test_template_cache";
+  fs::remove_all(dir);
+  fs::create_directories(dir / "partials");
+  write(dir / "page.mustache", "<h1>{{> head}}</h1><p>{{{ctx}}}</p>{{> missing}}");
+  write(dir / "partials" / "head.mustache", "Title");
+
+  ts::MustacheRenderer::Config cfg;
+  cfg.template_dir = dir.string();
+  cfg.partials_dir = (dir / "partials").string();
+  ts::MustacheRenderer r(cfg);
+
+  std::string out;
+  check(r.render_to_string("page.mustache", "42", out) && out.find("<h1>Title</h1><p>42</p>") == 0,
+        "renders with partial");
+  check(r.error().find("partial not found") != std::string::npos, "missing partial reported");
+  check(r.render_to_string("page.mustache", "43", out) && out.find("<p>43</p>") != std::string::npos &&
+        r.error().find("partial not found") != std::string::npos, "cached render, same warnings");
+
+  // Editing a partial (or creating a missing one) invalidates the cache.
+  write(dir / "partials" / "head.mustache", "New title!");
+  check(r.render_to_string("page.mustache", "1", out) && out.find("<h1>New title!</h1>") == 0,
+        "partial edit picked up");
+  write(dir / "partials" / "missing.mustache", "<footer/>");
+  check(r.render_to_string("page.mustache", "1", out) && out.find("<footer/>") != std::string::npos &&
+        r.error().empty(), "new partial picked up");
+  write(dir / "page.mustache", "v2 {{{ctx}}}");
+  check(r.render_to_string("page.mustache", "x", out) && out == "v2 x", "template edit picked up");
+
+  // Many threads, one renderer each, sharing the cache.
+  std::atomic<int> bad{0};
+  std::vector<std::thread> th;
+  for (int t = 0; t < 8; ++t) {
+    th.emplace_back([&, t]{
+      ts::MustacheRenderer mine(cfg);
+      std::string o;
+      for (int i = 0; i < 200; ++i) {
+        const std::string ctx = std::to_string(t * 1000 + i);
+        if (!mine.render_to_string("page.mustache", ctx, o) || o != "v2 " + ctx) ++bad;
+      }
+    });
+  }
+  for (auto& t : th) t.join();
+  check(bad == 0, "concurrent renders");
+
+  cfg.cache_templates = false;
+  ts::MustacheRenderer uncached(cfg);
+  check(uncached.render_to_string("page.mustache", "y", out) && out == "v2 y", "cache off");
+  check(!r.render_to_string("nope.mustache", "", out) && !r.error().empty(), "missing template");
+
+  fs::remove_all(dir);
+  return fails == 0 ? 0 : 1;
+}
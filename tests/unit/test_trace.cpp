@@ -0,0 +1,95 @@
+#include "typed_scanner/trace.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+
+namespace fs = std::filesystem;
+
+static int fails = 0;
+static void check(bool ok, const std::string& what) {
+  std::cout << (ok ? "[PASS] " : "[FAIL] ") << what << "\n";
+  if (!ok) ++fails;
+}
+
+static std::string slurp(const fs::path& p) {
+  std::ifstream in(p, std::ios::binary);
+  std::stringstream ss;
+  ss << in.rdbuf();
+  return ss.str();
+}
+
+static void emit(const char* name) {
+  const std::uint64_t t = ts::trace::detail::now_ns();
+  ts::trace::detail::emit(name, "scan", t, t + 1000);
+}
+
+static std::size_t at(const std::string& json, const char* name) {
+  return json.find("\"name\":\"" + std::string(name) + "\"");
+}
+
+// Every name present, in this order.
+static bool in_order(const std::string& json, std::initializer_list<const char*> names) {
+  std::size_t last = 0;
+  for (const char* n : names) {
+    const std::size_t pos = at(json, n);
+    if (pos == std::string::npos || pos < last) return false;
+    last = pos;
+  }
+  return true;
+}
+
+int main() {
+  const fs::path dir = fs::temp_directory_path() / "ts_test_trace";
+  fs::remove_all(dir);
+  ts::trace::clear();
+
+  // Two scans interleaved on one thread, as side-by-side scans share pool
+  // workers.
+  const std::uint32_t a = ts::trace::new_scan_id();
+  const std::uint32_t b = ts::trace::new_scan_id();
+  check(a != 0 && b != 0 && a != b, "scan ids are distinct and non-zero");
+  const std::pair<std::uint32_t, const char*> order[] = {{a, "a1"}, {b, "b1"}, {a, "a2"}, {b, "b2"}, {b, "b3"}};
+  for (const auto& [scan, name] : order) {
+    ts::trace::ScanTag tag(scan);
+    check(ts::trace::current_scan() == scan, std::string("tagged ") + name);
+    emit(name);
+  }
+  check(ts::trace::current_scan() == 0, "tag restored");
+
+  std::string err;
+  // (1) writing scan a outputs only a's events.
+  check(ts::trace::write_chrome_json((dir / "a.json").string(), &err, a), "write a: " + err);
+  const std::string ja = slurp(dir / "a.json");
+  check(in_order(ja, {"a1", "a2"}), "a's events, in order");
+  check(at(ja, "b1") == std::string::npos && at(ja, "b2") == std::string::npos &&
+        at(ja, "b3") == std::string::npos, "no events of b");
+
+  // (2) b's events survived the write, in order, and (3) a second write
+  // returns them; a's are gone.
+  check(ts::trace::write_chrome_json((dir / "b.json").string(), &err, b), "write b: " + err);
+  const std::string jb = slurp(dir / "b.json");
+  check(in_order(jb, {"b1", "b2", "b3"}), "b's events kept in order");
+  check(at(jb, "a1") == std::string::npos && at(jb, "a2") == std::string::npos, "a's events were dropped");
+
+  check(ts::trace::write_chrome_json((dir / "again.json").string(), &err, b), "write b again: " + err);
+  check(at(slurp(dir / "again.json"), "b1") == std::string::npos, "b's events drained by its write");
+
+  // clear() drops every scan's events.
+  {
+    ts::trace::ScanTag tag(a);
+    emit("c1");
+  }
+  emit("c2");
+  ts::trace::clear();
+  check(ts::trace::write_chrome_json((dir / "all.json").string(), &err), "write all: " + err);
+  const std::string jall = slurp(dir / "all.json");
+  check(at(jall, "c1") == std::string::npos && at(jall, "c2") == std::string::npos, "clear drops everything");
+
+  fs::remove_all(dir);
+  return fails == 0 ? 0 : 1;
+}
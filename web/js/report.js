@@ -282,6 +282,23 @@ function charts(current, baseline){
     }
   }, "#chart-stages");
 
+  // Latency distributions (log-linear histogram buckets) — remove if empty
+  const latRows = Object.entries(current.latency || {}).flatMap(([name, h]) =>
+    (h.buckets || []).map(b => ({ name, le_ms: Number(b.le_ms) || 0, count: Number(b.count) || 0 }))
+  ).filter(r => r.le_ms > 0);
+  VL_SAFE({
+    $schema: "https://vega.github.io/schema/vega-lite/v5.json",
+    height: 240,
+    data: { values: latRows },
+    mark: { type: "line", interpolate: "step-after", point: { filled: true, size: 24 } },
+    encoding: {
+      x: { field: "le_ms", type: "quantitative", title: "Latency (ms, log)", scale: { type: "log" } },
+      y: { field: "count", type: "quantitative", title: "Count", scale: { nice: true } },
+      color: { field: "name", type: "nominal", title: "histogram" },
+      tooltip: [{field:"name"}, {field:"le_ms", type:"quantitative", title:"≤ ms"}, {field:"count", type:"quantitative"}]
+    }
+  }, "#chart-latency");
+
   // Errors by field — remove if empty
   const errs = Object.entries(current.errors_by_field || {}).map(([field, cnt]) => ({
     field, value: Number(cnt) || 0
@@ -365,10 +382,34 @@ function tables(current){
   const stageT = document.querySelector('#tbl-stage tbody');
   if (stageT) stageT.innerHTML = stageRows || `<tr><td colspan="3" class="muted">No stage timings.</td></tr>`;
 
+  const ms3 = (n) => fmt.num(n, 3);
+  const latT = document.querySelector('#tbl-latency tbody');
+  const latTbl = Object.entries(current.latency || {}).map(([name, h]) =>
+    `<tr><td>${name}</td><td class="num">${fmt.int(h.count)}</td><td class="num">${ms3(h.p50_ms)}</td>` +
+    `<td class="num">${ms3(h.p90_ms)}</td><td class="num">${ms3(h.p99_ms)}</td>` +
+    `<td class="num">${ms3(h.p999_ms)}</td><td class="num">${ms3(h.max_ms)}</td></tr>`
+  ).join('');
+  if (latT) latT.innerHTML = latTbl || `<tr><td colspan="7" class="muted">No latency histograms.</td></tr>`;
+
+  const bytes = Number(current.bytes) || 0;
+  const ctrRows = (current.stage_counters || []).map(c => {
+    const cpb = bytes > 0 ? (Number(c.cycles) || 0) / bytes : 0;
+    return `<tr><td>${c.stage}</td><td class="num">${fmt.int(c.cycles)}</td><td class="num">${fmt.num(c.ipc)}</td>` +
+           `<td class="num">${fmt.int(c.branch_misses)}</td><td class="num">${fmt.int(c.llc_misses)}</td>` +
+           `<td class="num">${fmt.num(cpb)}</td></tr>`;
+  }).join('');
+  const ctrT = document.querySelector('#tbl-stage-counters tbody');
+  if (ctrT) ctrT.innerHTML = ctrRows || `<tr><td colspan="6" class="muted">Hardware counters not collected (run with --perf).</td></tr>`;
+
+  // One row per column when the metrics stage ran; else per-field error counts.
   const errsMap = current.errors_by_field || {};
-  const errRows = Object.keys(errsMap).length
-    ? Object.entries(errsMap).map(([f,c]) => `<tr><td>${f}</td><td class="num">${fmt.int(c)}</td></tr>`).join('')
-    : `<tr><td colspan="2" class="muted">No errors recorded.</td></tr>`;
+  const cols = current.columns || [];
+  const errRows = cols.length
+    ? cols.map(c => `<tr><td>${c.name}</td><td>${c.type}</td><td class="num">${fmt.int(c.nulls)}</td>` +
+                    `<td class="num">${fmt.int(c.errors)}</td></tr>`).join('')
+    : Object.keys(errsMap).length
+    ? Object.entries(errsMap).map(([f,c]) => `<tr><td>${f}</td><td class="muted">—</td><td class="num">—</td><td class="num">${fmt.int(c)}</td></tr>`).join('')
+    : `<tr><td colspan="4" class="muted">No errors recorded.</td></tr>`;
   const errsT = document.querySelector('#tbl-errors tbody');
   if (errsT) errsT.innerHTML = errRows;
 
@@ -399,7 +440,7 @@ function vegaReady(){
 
 function redrawCharts(state){
   const ids = [
-    "#chart-throughput","#chart-rss","#chart-allocs","#chart-stages",
+    "#chart-throughput","#chart-rss","#chart-allocs","#chart-stages","#chart-latency",
     "#chart-errors","#chart-format",
     "#chart-compare-tokens","#chart-compare-mbs","#chart-compare-lat","#chart-compare-rss"
   ];
@@ -407,6 +448,46 @@ function redrawCharts(state){
   charts(state.current, state.baseline);
 }
 
+// Live page of an in-flight scan (/scans/<slug>): fold the server's progress
+// events into `state.current`, repaint at most once a second, and move on
+// to the finished report when the scan is done.
+function followLive(live, state){
+  if (!window.EventSource) { showError("live progress needs EventSource; reload when the scan is done"); return; }
+  const cur = state.current;
+  cur.series = [];
+  cur.stage_times = [];
+  let timer = null;
+  const repaint = () => {
+    timer = null;
+    try { mountKPIs(cur, null); tables(cur); } catch(e){ showError("Live update failed: " + (e?.message||e)); }
+    if (vegaReady()) { try { redrawCharts(state); } catch(e){ showError("Charts failed: " + (e?.message||e)); } }
+  };
+  const es = new EventSource(live.events);
+  es.onmessage = (m) => {
+    let s;
+    try { s = JSON.parse(m.data); } catch { return; }
+    const sec = (Number(s.time_ms) || 0) / 1000;
+    cur.rows = s.rows;
+    cur.bytes = s.bytes;
+    cur.wall_time_ms = s.time_ms;
+    cur.throughput_mb_s = sec > 0 ? (s.bytes / 1048576) / sec : 0;
+    cur.tokens_per_sec = sec > 0 ? s.rows / sec : 0;
+    cur.peak_rss_mb = Math.max(cur.peak_rss_mb || 0, s.rss_mb || 0);
+    cur.series.push({ time_ms: s.time_ms, mb_s: s.mb_s, rss_mb: s.rss_mb, allocs_per_sec: 0 });
+    // Long scans: keep every other point rather than an ever-growing chart.
+    if (cur.series.length > 2000) cur.series = cur.series.filter((_, i) => i % 2 === 0);
+    cur.stage_times = s.stages || [];
+    if (!timer) timer = setTimeout(repaint, 1000);
+  };
+  es.addEventListener('done', (m) => {
+    es.close();
+    let d = {};
+    try { d = JSON.parse(m.data); } catch {}
+    if (d.ok) location.replace(d.report || live.report);
+    else showError("Scan failed: " + (d.error || "see the server log"));
+  });
+}
+
 async function boot(){
   const ctx = await getCtx();
   const current  = ctx?.compare?.after  ?? ctx ?? {};
@@ -428,6 +509,7 @@ async function boot(){
 
   try { mountKPIs(current, baseline); } catch(e){ showError("KPIs failed: " + (e?.message||e)); }
   try { tables(current); }             catch(e){ showError("Tables failed: " + (e?.message||e)); }
+  if (ctx && ctx.live) followLive(ctx.live, state);
 
   // Wait for Vega libs
   let tries = 0;